@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "bar_aggregator.hpp"
+
+namespace CryptoTradingInfra {
+
+std::optional<BarSpec> BarSpec::Parse(const std::string& text)
+{
+    size_t digits = 0;
+    double value;
+    try {
+        value = std::stod(text, &digits);
+    } catch (...) {
+        return std::nullopt;
+    }
+    if (!(value > 0)) {
+        return std::nullopt;
+    }
+
+    auto unit = text.substr(digits);
+    if (unit == "v") {
+        return BarSpec { Kind::VOLUME, 0, value };
+    }
+
+    double nanoseconds;
+    if (unit == "ms") {
+        nanoseconds = 1e6;
+    } else if (unit == "s") {
+        nanoseconds = 1e9;
+    } else if (unit == "m") {
+        nanoseconds = 60e9;
+    } else if (unit == "h") {
+        nanoseconds = 3600e9;
+    } else {
+        return std::nullopt;
+    }
+
+    auto interval = static_cast<uint64_t>(std::llround(value * nanoseconds));
+    if (interval == 0) {
+        return std::nullopt;
+    }
+    return BarSpec { Kind::TIME, interval, 0 };
+}
+
+std::string BarSpec::name() const
+{
+    std::ostringstream text;
+    if (kind == Kind::VOLUME) {
+        text << volume << "v";
+    } else if (interval % 60000000000 == 0) {
+        text << interval / 60000000000 << "m";
+    } else if (interval % 1000000000 == 0) {
+        text << interval / 1000000000 << "s";
+    } else {
+        text << interval / 1e6 << "ms";
+    }
+    return text.str();
+}
+
+BarAggregator::BarAggregator(InstrumentId instrument, const std::vector<BarSpec>& specs, BarRing *out)
+    : instrument(instrument), specsNum(std::min(specs.size(), MAX_BAR_SPECS)), out(out)
+{
+    std::copy(specs.begin(), specs.begin() + specsNum, this->specs.begin());
+}
+
+void BarAggregator::complete(size_t spec)
+{
+    active[spec] = false;
+    history[completed % BAR_HISTORY] = open[spec];
+    ++completed;
+    if (out != nullptr && !out->push(open[spec])) {
+        ++dropped;
+    }
+}
+
+void BarAggregator::add(size_t spec, uint64_t timestamp, Price price, Size size)
+{
+    auto& bar = open[spec];
+    if (!active[spec]) {
+        auto start = timestamp;
+        if (specs[spec].kind == BarSpec::Kind::TIME) {
+            start -= timestamp % specs[spec].interval;
+        }
+        bar = Bar { instrument, static_cast<uint32_t>(spec), start, timestamp, price, price, price, price, 0, 0, 0 };
+        active[spec] = true;
+    }
+
+    bar.end = timestamp;
+    bar.high = std::max(bar.high, price);
+    bar.low = std::min(bar.low, price);
+    bar.close = price;
+    bar.volume += size;
+    bar.notional += price * size;
+    ++bar.trades;
+}
+
+void BarAggregator::onTrade(const TradeEvent& trade)
+{
+    advance(trade.timestamp);
+
+    for (size_t spec = 0; spec < specsNum; ++spec) {
+        if (specs[spec].kind == BarSpec::Kind::TIME) {
+            add(spec, trade.timestamp, trade.price, trade.size);
+            continue;
+        }
+
+        // a trade filling more than what is left of a volume bar goes on into the next ones
+        auto left = trade.size;
+        while (left > 0) {
+            auto room = specs[spec].volume - (active[spec] ? open[spec].volume : 0);
+            auto taken = std::min(left, room);
+            add(spec, trade.timestamp, trade.price, taken);
+            left -= taken;
+            if (taken == room) {
+                complete(spec);
+            }
+        }
+    }
+}
+
+void BarAggregator::advance(uint64_t timestamp)
+{
+    for (size_t spec = 0; spec < specsNum; ++spec) {
+        if (active[spec] && specs[spec].kind == BarSpec::Kind::TIME &&
+            timestamp >= open[spec].start + specs[spec].interval) {
+            complete(spec);
+        }
+    }
+}
+
+const Bar *BarAggregator::last(size_t back) const
+{
+    if (back >= completed || back >= BAR_HISTORY) {
+        return nullptr;
+    }
+    return &history[(completed - 1 - back) % BAR_HISTORY];
+}
+
+} // namespace CryptoTradingInfra
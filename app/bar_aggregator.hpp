@@ -0,0 +1,115 @@
+#ifndef CRYPTO_TRADING_INFRA_BAR_AGGREGATOR
+#define CRYPTO_TRADING_INFRA_BAR_AGGREGATOR
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "engine_events.hpp"
+#include "market_update.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+
+// kinds of bars built at once for every instrument
+constexpr size_t MAX_BAR_SPECS = 4;
+// completed bars every instrument keeps for itself
+constexpr size_t BAR_HISTORY = 64;
+// completed bars waiting for downstream readers, per shard
+constexpr size_t BAR_RING_SIZE = 16384;
+
+struct BarSpec {
+    enum class Kind : uint8_t {
+        // a bar per interval of trade timestamps, aligned on multiples of it
+        TIME,
+        // a bar per volume traded, trades crossing the boundary are split between both bars
+        VOLUME,
+    };
+
+    Kind kind;
+    uint64_t interval; // nanoseconds
+    Size volume;
+
+    // "250ms", "1s", "1m", "1h" for time bars, "100v" for volume bars, nullopt if text is none of these
+    static std::optional<BarSpec> Parse(const std::string& text);
+    std::string name() const;
+};
+
+struct Bar {
+    InstrumentId instrument;
+    // index of the spec the bar was built for
+    uint32_t spec;
+    // start of the interval for time bars, time of the first trade for volume bars
+    uint64_t start;
+    // time of the last trade
+    uint64_t end;
+    Price open;
+    Price high;
+    Price low;
+    Price close;
+    Size volume;
+    double notional;
+    uint32_t trades;
+
+    Price vwap() const
+    {
+        return notional / volume;
+    }
+};
+
+using BarRing = Utils::ConcurrentRingBuffer<Bar, BAR_RING_SIZE>;
+
+/*
+ * Builds bars of every spec out of the trades of one instrument. Bars being built and the last completed
+ * ones live in fixed arrays, so nothing is allocated once the aggregator exists. Completed bars are pushed
+ * to a ring shared by the instruments of a shard, and counted as dropped when nobody drains it.
+ *
+ * A time bar is completed by the first trade or timestamp seen past its interval, intervals without trades
+ * yield no bar.
+ */
+class BarAggregator
+{
+    InstrumentId instrument;
+    std::array<BarSpec, MAX_BAR_SPECS> specs;
+    size_t specsNum;
+    BarRing *out;
+
+    std::array<Bar, MAX_BAR_SPECS> open;
+    std::array<bool, MAX_BAR_SPECS> active {};
+
+    std::array<Bar, BAR_HISTORY> history;
+    uint64_t completed = 0;
+    uint64_t dropped = 0;
+
+    void complete(size_t spec);
+    void add(size_t spec, uint64_t timestamp, Price price, Size size);
+
+public:
+    // specs beyond MAX_BAR_SPECS are ignored, out may be nullptr if only the history is of interest
+    BarAggregator(InstrumentId instrument, const std::vector<BarSpec>& specs, BarRing *out);
+
+    void onTrade(const TradeEvent& trade);
+
+    // completes the time bars whose interval ended before timestamp
+    void advance(uint64_t timestamp);
+
+    uint64_t barsCompleted() const
+    {
+        return completed;
+    }
+
+    uint64_t barsDropped() const
+    {
+        return dropped;
+    }
+
+    // back-th last completed bar, 0 being the latest, nullptr if it is no longer or not yet there
+    const Bar *last(size_t back = 0) const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,259 @@
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+#include "checkpoint.hpp"
+
+namespace CryptoTradingInfra {
+
+namespace {
+
+uint64_t Fnv1a(const char *data, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+char *PutLevels(char *out, const std::vector<BookState::Item>& levels)
+{
+    for (const auto& [price, size] : levels) {
+        CheckpointLevel level { price, size };
+        std::memcpy(out, &level, sizeof(level));
+        out += sizeof(level);
+    }
+    return out;
+}
+
+// returns nullptr if the levels do not fit before end
+const char *GetLevels(const char *in, const char *end, uint32_t count, std::vector<BookState::Item>& levels)
+{
+    if (static_cast<size_t>(end - in) / sizeof(CheckpointLevel) < count) {
+        return nullptr;
+    }
+    levels.clear();
+    levels.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        CheckpointLevel level;
+        std::memcpy(&level, in, sizeof(level));
+        levels.emplace_back(level.price, level.size);
+        in += sizeof(level);
+    }
+    return in;
+}
+
+} // namespace
+
+bool WriteCheckpoint(const std::string& path, const std::vector<InstrumentState>& states, uint64_t number)
+{
+    size_t length = sizeof(CheckpointHeader);
+    for (const auto& state : states) {
+        auto levels = state.bids.size() + state.asks.size() + state.engineBids.size() + state.engineAsks.size();
+        length += sizeof(CheckpointEntry) + levels * sizeof(CheckpointLevel);
+    }
+
+    auto temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return false;
+    }
+    if (ftruncate(fd, length) < 0) {
+        perror("ftruncate");
+        close(fd);
+        return false;
+    }
+    auto mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    auto begin = static_cast<char *>(mapped);
+    auto out = begin + sizeof(CheckpointHeader);
+    for (const auto& state : states) {
+        CheckpointEntry entry { state.instrument,
+                                0,
+                                state.sequence,
+                                static_cast<uint32_t>(state.bids.size()),
+                                static_cast<uint32_t>(state.asks.size()),
+                                static_cast<uint32_t>(state.engineBids.size()),
+                                static_cast<uint32_t>(state.engineAsks.size()) };
+        std::memcpy(out, &entry, sizeof(entry));
+        out += sizeof(entry);
+        out = PutLevels(out, state.bids);
+        out = PutLevels(out, state.asks);
+        out = PutLevels(out, state.engineBids);
+        out = PutLevels(out, state.engineAsks);
+    }
+
+    CheckpointHeader header { CHECKPOINT_MAGIC,
+                              CHECKPOINT_VERSION,
+                              0,
+                              number,
+                              static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                        std::chrono::system_clock::now().time_since_epoch())
+                                                        .count()),
+                              states.size(),
+                              length - sizeof(CheckpointHeader),
+                              Fnv1a(begin + sizeof(CheckpointHeader), length - sizeof(CheckpointHeader)) };
+    std::memcpy(begin, &header, sizeof(header));
+    munmap(mapped, length);
+
+    // a reader only ever maps a complete checkpoint, the previous one or this one
+    if (rename(temporary.c_str(), path.c_str()) < 0) {
+        perror("rename");
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReadCheckpoint(const std::string& path, std::vector<InstrumentState>& states, uint64_t& number)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open");
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(CheckpointHeader)) {
+        std::fprintf(stderr, "%s: not a checkpoint\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    size_t length = info.st_size;
+    auto mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    auto begin = static_cast<const char *>(mapped);
+    auto end = begin + length;
+    CheckpointHeader header;
+    std::memcpy(&header, begin, sizeof(header));
+    bool valid = header.magic == CHECKPOINT_MAGIC && header.version == CHECKPOINT_VERSION &&
+                 header.length == length - sizeof(header) &&
+                 header.checksum == Fnv1a(begin + sizeof(header), header.length);
+
+    states.clear();
+    auto in = begin + sizeof(header);
+    for (uint64_t i = 0; valid && i < header.instruments; ++i) {
+        CheckpointEntry entry;
+        if (static_cast<size_t>(end - in) < sizeof(entry)) {
+            valid = false;
+            break;
+        }
+        std::memcpy(&entry, in, sizeof(entry));
+        in += sizeof(entry);
+
+        InstrumentState state;
+        state.instrument = entry.instrument;
+        state.sequence = entry.sequence;
+        in = GetLevels(in, end, entry.bids, state.bids);
+        in = in != nullptr ? GetLevels(in, end, entry.asks, state.asks) : nullptr;
+        in = in != nullptr ? GetLevels(in, end, entry.engineBids, state.engineBids) : nullptr;
+        in = in != nullptr ? GetLevels(in, end, entry.engineAsks, state.engineAsks) : nullptr;
+        valid = in != nullptr;
+        if (valid) {
+            states.push_back(std::move(state));
+        }
+    }
+    munmap(mapped, length);
+
+    if (!valid) {
+        std::fprintf(stderr, "%s: corrupted or incompatible checkpoint\n", path.c_str());
+        states.clear();
+        return false;
+    }
+    number = header.number;
+    return true;
+}
+
+Checkpointer::Checkpointer(const InstrumentRegistry& registry, std::string path, std::chrono::nanoseconds interval,
+                           uint64_t number)
+    : registry(registry), path(std::move(path)), interval(interval), number(number)
+{
+}
+
+std::unique_ptr<Checkpointer> Checkpointer::Create(const InstrumentRegistry& registry, const std::string& path,
+                                                   std::chrono::nanoseconds interval, uint64_t restored)
+{
+    auto checkpointer = std::unique_ptr<Checkpointer>(new Checkpointer(registry, path, interval, restored));
+    // fails early on a path that cannot be written, rather than every interval
+    if (!checkpointer->take()) {
+        return nullptr;
+    }
+    checkpointer->thread = std::thread(&Checkpointer::run, checkpointer.get());
+    return checkpointer;
+}
+
+Checkpointer::~Checkpointer()
+{
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+        take();
+    }
+}
+
+void Checkpointer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wakeup.wait_for(lock, interval, [this]() { return stopping; })) {
+        lock.unlock();
+        take();
+        lock.lock();
+    }
+}
+
+bool Checkpointer::take()
+{
+    auto states = registry.states();
+    std::lock_guard<std::mutex> lock(writing);
+    // an instrument left out of this round keeps what the last checkpoint holds for it
+    std::unordered_set<InstrumentId> read;
+    for (const auto& state : states) {
+        read.insert(state.instrument);
+    }
+    for (const auto& state : written) {
+        if (read.count(state.instrument) == 0) {
+            states.push_back(state);
+        }
+    }
+    if (!WriteCheckpoint(path, states, number + 1)) {
+        return false;
+    }
+    written = std::move(states);
+    ++number;
+    ++taken;
+    return true;
+}
+
+uint64_t Checkpointer::checkpointsTaken()
+{
+    std::lock_guard<std::mutex> lock(writing);
+    return taken;
+}
+
+uint64_t Checkpointer::lastNumber()
+{
+    std::lock_guard<std::mutex> lock(writing);
+    return number;
+}
+
+} // namespace CryptoTradingInfra
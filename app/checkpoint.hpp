@@ -0,0 +1,112 @@
+#ifndef CRYPTO_TRADING_INFRA_CHECKPOINT
+#define CRYPTO_TRADING_INFRA_CHECKPOINT
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "instrument_registry.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr uint64_t CHECKPOINT_MAGIC = 0x54504b4f4f42; // "BOOKPT"
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+constexpr auto DEFAULT_CHECKPOINT_INTERVAL = std::chrono::seconds(1);
+
+/*
+ * A checkpoint file starts with this header, followed by a CheckpointEntry per instrument, each one followed
+ * by the levels it counts in this order: bids and asks of the order book, then bids and asks resting in the
+ * trading engine, all from the best one on. Numbers are in host order, a checkpoint is meant to be read back
+ * on the machine that wrote it.
+ */
+struct CheckpointHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t resv;
+    // numbers the checkpoints written by a process from 1 on
+    uint64_t number;
+    // nanoseconds since the epoch
+    uint64_t timestamp;
+    uint64_t instruments;
+    // bytes following the header
+    uint64_t length;
+    // FNV-1a of the bytes following the header
+    uint64_t checksum;
+};
+
+struct CheckpointEntry {
+    InstrumentId instrument;
+    uint32_t resv;
+    uint64_t sequence;
+    uint32_t bids;
+    uint32_t asks;
+    uint32_t engineBids;
+    uint32_t engineAsks;
+};
+
+struct CheckpointLevel {
+    Price price;
+    Size size;
+};
+
+// writes a checkpoint of states next to path and moves it over path once complete, returns false on failure
+bool WriteCheckpoint(const std::string& path, const std::vector<InstrumentState>& states, uint64_t number);
+
+// returns false if path holds no complete checkpoint of this layout
+bool ReadCheckpoint(const std::string& path, std::vector<InstrumentState>& states, uint64_t& number);
+
+/*
+ * Writes checkpoints of every book of a registry into a memory mapped file every interval, from a thread of
+ * its own. States are copied from the published versions of the books, so shards keep applying updates while
+ * a checkpoint is taken. A checkpoint is written next to the file and renamed over it, so a crash while
+ * writing leaves the previous one in place.
+ */
+class Checkpointer
+{
+    const InstrumentRegistry& registry;
+    std::string path;
+    std::chrono::nanoseconds interval;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    // serializes checkpoints taken by the thread and by callers of take()
+    std::mutex writing;
+    uint64_t number;
+    uint64_t taken = 0;
+    // what the last checkpoint holds, instruments whose state could not be read are written with it again
+    std::vector<InstrumentState> written;
+    std::thread thread;
+
+    Checkpointer(const InstrumentRegistry& registry, std::string path, std::chrono::nanoseconds interval,
+                 uint64_t number);
+
+    void run();
+
+public:
+    // numbering goes on from the checkpoint the registry was restored from, if any
+    static std::unique_ptr<Checkpointer> Create(const InstrumentRegistry& registry, const std::string& path,
+                                                std::chrono::nanoseconds interval = DEFAULT_CHECKPOINT_INTERVAL,
+                                                uint64_t restored = 0);
+    // takes a last checkpoint, so it is best destroyed once the shards have stopped
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // writes a checkpoint right away, returns false on failure
+    bool take();
+
+    uint64_t checkpointsTaken();
+    // number of the last checkpoint written
+    uint64_t lastNumber();
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
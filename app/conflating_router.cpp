@@ -0,0 +1,272 @@
+#include <algorithm>
+
+#include "conflating_router.hpp"
+#include "perf_counters.hpp"
+
+namespace CryptoTradingInfra {
+
+namespace {
+
+// whether update only changes a level, so it may be merged with the other changes of the level, rather than
+// being an order of an account or carrying a time in force of its own
+bool Conflatable(const MarketUpdate& update)
+{
+    return update.account == NO_ACCOUNT &&
+           (update.flags & (MarketUpdate::IMMEDIATE_OR_CANCEL | MarketUpdate::TIMED)) == 0;
+}
+
+} // namespace
+
+ConflatingRouter::ConflatingRouter(InstrumentRegistry& registry, size_t highWaterMark, SnapshotRecovery *recovery)
+    : registry(registry), highWaterMark(highWaterMark), staging(registry.shardsNum()), recovery(recovery)
+{
+}
+
+bool ConflatingRouter::forward(const MarketUpdate& update)
+{
+    if (!registry.route(update)) {
+        return false;
+    }
+    ++stats.routed;
+    return true;
+}
+
+void ConflatingRouter::stage(Staging& lane, const MarketUpdate& update)
+{
+    ++stats.staged;
+    bool entry = true;
+    if (!Conflatable(update)) {
+        lane.order.push_back({ {}, update, update.sequence });
+    } else {
+        LevelKey key { update.instrument, update.side, update.price };
+        auto [it, inserted] = lane.levels.try_emplace(key, Level { false, false, 0, 0, update.timestamp });
+        if (inserted) {
+            lane.order.push_back({ key, std::nullopt, update.sequence });
+        } else {
+            ++stats.conflated;
+            entry = false;
+        }
+
+        auto& level = it->second;
+        if (update.size == 0 || (update.flags & MarketUpdate::SNAPSHOT) != 0) {
+            // whatever was added before is removed along with the level, a snapshot level then sets it anew
+            level.reset = true;
+            level.snapshot = (update.flags & MarketUpdate::SNAPSHOT) != 0;
+            level.base = update.size;
+            level.delta = 0;
+        } else {
+            level.delta += update.size;
+        }
+        level.timestamp = update.timestamp;
+    }
+
+    if (entry) {
+        ++backlogged;
+    }
+    if (update.sequence != 0) {
+        auto& pending = lane.pending[update.instrument];
+        if (entry) {
+            pending.firsts.push_back(update.sequence);
+        }
+        pending.last = update.sequence;
+    }
+}
+
+// sequence the book of the instrument of staged holds every update up to once it is flushed: those before the
+// next entry staged for the instrument, or all of them when it is the last one
+uint64_t ConflatingRouter::applied(const Staging& lane, const Staged& staged) const
+{
+    if (staged.sequence == 0) {
+        return 0;
+    }
+    const auto& pending = lane.pending.at(staged.update ? staged.update->instrument : staged.key.instrument);
+    return pending.firsts.size() > 1 ? pending.firsts[1] - 1 : pending.last;
+}
+
+void ConflatingRouter::settle(Staging& lane, const Staged& staged)
+{
+    if (staged.sequence == 0) {
+        return;
+    }
+    auto it = lane.pending.find(staged.update ? staged.update->instrument : staged.key.instrument);
+    it->second.firsts.pop_front();
+    if (it->second.firsts.empty()) {
+        lane.pending.erase(it);
+    }
+}
+
+void ConflatingRouter::flush(size_t shard)
+{
+    auto& lane = staging[shard];
+    if (lane.order.empty() || registry.shard(shard).occupancy() >= highWaterMark / 2) {
+        return;
+    }
+
+    size_t flushed = 0;
+    for (; flushed < lane.order.size(); ++flushed) {
+        const auto& staged = lane.order[flushed];
+        auto sequence = applied(lane, staged);
+        if (staged.update) {
+            auto update = *staged.update;
+            update.sequence = sequence;
+            if (!forward(update)) {
+                break;
+            }
+            settle(lane, staged);
+            continue;
+        }
+
+        const auto& key = staged.key;
+        auto& level = lane.levels.at(key);
+
+        if (level.reset) {
+            // a snapshot level replaces the level, and is no market event the engine would match
+            uint8_t flags = level.snapshot ? MarketUpdate::SNAPSHOT : 0;
+            if (!forward(MarketUpdate(key.side, key.price, level.base, level.timestamp, key.instrument,
+                                      sequence, flags))) {
+                break;
+            }
+            level.reset = false;
+        }
+        if (level.delta != 0 &&
+            !forward(MarketUpdate(key.side, key.price, level.delta, level.timestamp, key.instrument, sequence))) {
+            break;
+        }
+        lane.levels.erase(key);
+        settle(lane, staged);
+    }
+
+    lane.order.erase(lane.order.begin(), lane.order.begin() + flushed);
+    backlogged -= flushed;
+}
+
+void ConflatingRouter::dispatch(const MarketUpdate& update)
+{
+    auto shard = registry.shardOf(update.instrument);
+    auto& lane = staging[shard];
+
+    // once a lane has staged levels everything goes through staging, so no update overtakes a staged one
+    flush(shard);
+    if (lane.order.empty() && registry.shard(shard).occupancy() < highWaterMark && forward(update)) {
+        return;
+    }
+    stage(lane, update);
+}
+
+// returns false when update must not be dispatched, either because it was seen already or because it is held
+// back until the book of its instrument is recovered
+bool ConflatingRouter::sequenced(const MarketUpdate& update)
+{
+    auto& book = sequencing[update.instrument];
+    if (book.recovering) {
+        book.held.push_back(update);
+        return false;
+    }
+    if (update.sequence == 1 && book.last > 1) {
+        // the feed started over, the book is left for it to rebuild
+        book.last = 1;
+        return true;
+    }
+    if (update.sequence <= book.last) {
+        return false;
+    }
+
+    auto expected = book.last + 1;
+    if (update.sequence == expected) {
+        book.last = update.sequence;
+        return true;
+    }
+
+    // an instrument first seen past its first update needs a snapshot just as well, but how many updates it
+    // missed is unknown
+    if (book.last != 0) {
+        stats.gaps += update.sequence - expected;
+    }
+    if (recovery == nullptr) {
+        book.last = update.sequence;
+        return true;
+    }
+
+    book.recovering = true;
+    book.held.push_back(update);
+    ++pendingRecoveries;
+    ++stats.recoveries;
+    recovery->request(update.instrument);
+    return false;
+}
+
+// sends the snapshot down the lane of its instrument followed by the updates held back, returns false if the
+// lane has no room for all of them yet
+bool ConflatingRouter::restore(const BookSnapshot& snapshot)
+{
+    auto shard = registry.shardOf(snapshot.instrument);
+    auto& book = sequencing[snapshot.instrument];
+
+    // updates staged before the gap have to reach the book before it is rebuilt
+    flush(shard);
+    auto needed = 1 + snapshot.bids.size() + snapshot.asks.size() + book.held.size();
+    auto room = InstrumentShard::Lane::capacity() - registry.shard(shard).occupancy();
+    if (!staging[shard].order.empty() || room < needed) {
+        return false;
+    }
+
+    // only this thread pushes to the lane, so the room seen above cannot shrink
+    forward(MarketUpdate(MarketUpdate::Side::BID, 0, 0, 0, snapshot.instrument, snapshot.sequence,
+                         MarketUpdate::CLEAR_BOOK));
+    for (const auto& [price, size] : snapshot.bids) {
+        forward(MarketUpdate(MarketUpdate::Side::BID, price, size, 0, snapshot.instrument, snapshot.sequence,
+                             MarketUpdate::SNAPSHOT));
+    }
+    for (const auto& [price, size] : snapshot.asks) {
+        forward(MarketUpdate(MarketUpdate::Side::ASK, price, size, 0, snapshot.instrument, snapshot.sequence,
+                             MarketUpdate::SNAPSHOT));
+    }
+
+    book.last = snapshot.sequence;
+    book.recovering = false;
+    --pendingRecoveries;
+
+    // a gap right after the snapshot starts another recovery, holding back the rest again
+    auto held = std::move(book.held);
+    book.held.clear();
+    for (const auto& update : held) {
+        if (sequenced(update)) {
+            forward(update);
+        }
+    }
+    return true;
+}
+
+void ConflatingRouter::recover()
+{
+    if (pendingRecoveries == 0 || (!recovery->collect(snapshots) && snapshots.empty())) {
+        return;
+    }
+
+    auto waiting = std::remove_if(snapshots.begin(), snapshots.end(),
+                                  [this](const BookSnapshot& snapshot) { return restore(snapshot); });
+    snapshots.erase(waiting, snapshots.end());
+}
+
+void ConflatingRouter::route(const MarketUpdate& update)
+{
+    Utils::PerfRegion region(Utils::PERF_ENQUEUE);
+    recover();
+    if (update.sequence != 0 && !sequenced(update)) {
+        return;
+    }
+    dispatch(update);
+}
+
+void ConflatingRouter::drain()
+{
+    recover();
+    if (backlogged == 0) {
+        return;
+    }
+    for (size_t shard = 0; shard < staging.size(); ++shard) {
+        flush(shard);
+    }
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,155 @@
+#ifndef CRYPTO_TRADING_INFRA_CONFLATING_ROUTER
+#define CRYPTO_TRADING_INFRA_CONFLATING_ROUTER
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "book_state.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "snapshot_recovery.hpp"
+
+namespace CryptoTradingInfra {
+
+// lanes fuller than this are considered overloaded
+constexpr size_t DEFAULT_HIGH_WATER_MARK = InstrumentShard::Lane::capacity() / 4 * 3;
+
+/*
+ * Routes updates to the shards of a registry without ever blocking the receiver. Once the lane of a shard
+ * holds more than highWaterMark updates, further updates for it are merged per level in a staging table
+ * owned by the caller's thread instead. Staged levels are flushed in the order they were first staged as
+ * soon as the lane drains below half the mark.
+ *
+ * Book updates add to a level while a size of 0 removes it, so a staged level keeps whether it was removed
+ * and what was added after that, a snapshot level setting it to its size and reaching the shard as a snapshot
+ * level still. This is all it takes to bring the book to the same state, only the intermediate states are
+ * lost. Orders of accounts are no level changes to merge, the risk gate checks and charges each of them on
+ * its own, and neither are IMMEDIATE_OR_CANCEL or TIMED orders, whose time in force belongs to the order, so
+ * they are staged as they came in and flushed in their turn.
+ *
+ * A merged level is newer than the levels staged after it, so what is flushed carries the sequence up to
+ * which its instrument then has every update, rather than its own. The book, and any checkpoint of it, never
+ * claims a sequence before the updates staged for it reached it.
+ *
+ * Sequenced updates are checked for gaps per instrument on the way. Given a SnapshotRecovery, an instrument
+ * missing updates has its later updates held back while a snapshot of its book is fetched. The book is then
+ * rebuilt from the snapshot through its lane, and the updates held back replayed from the snapshot's sequence
+ * on, while every other instrument keeps flowing. Without one, gaps are only counted. An instrument numbering
+ * its updates from 1 again belongs to a feed that started over, and is sequenced from there on.
+ */
+class ConflatingRouter
+{
+public:
+    struct Stats {
+        uint64_t routed;
+        uint64_t staged;
+        uint64_t conflated;
+        uint64_t gaps;
+        uint64_t recoveries;
+    };
+
+private:
+    struct Level {
+        // removed before delta was added, or set to base by a snapshot level when snapshot is
+        bool reset;
+        bool snapshot;
+        Size base;
+        Size delta;
+        uint64_t timestamp;
+    };
+
+    // a level merged in levels, or an update that must reach the shard as it came in
+    struct Staged {
+        LevelKey key;
+        std::optional<MarketUpdate> update;
+        // of the first update staged in it, 0 if unsequenced
+        uint64_t sequence;
+    };
+
+    // first sequence of every entry staged for an instrument, in the order they are flushed, and the last one
+    struct Pending {
+        std::deque<uint64_t> firsts;
+        uint64_t last = 0;
+    };
+
+    struct Staging {
+        std::vector<Staged> order;
+        std::unordered_map<LevelKey, Level, LevelKeyHash> levels;
+        std::unordered_map<InstrumentId, Pending> pending;
+    };
+
+    struct Sequencing {
+        uint64_t last = 0;
+        bool recovering = false;
+        std::vector<MarketUpdate> held;
+    };
+
+    InstrumentRegistry& registry;
+    size_t highWaterMark;
+    std::vector<Staging> staging;
+    size_t backlogged = 0;
+
+    SnapshotRecovery *recovery;
+    std::unordered_map<InstrumentId, Sequencing> sequencing;
+    // fetched and waiting for room in their lane
+    std::vector<BookSnapshot> snapshots;
+    size_t pendingRecoveries = 0;
+
+    Stats stats {};
+
+    bool forward(const MarketUpdate& update);
+    void stage(Staging& lane, const MarketUpdate& update);
+    uint64_t applied(const Staging& lane, const Staged& staged) const;
+    void settle(Staging& lane, const Staged& staged);
+    void flush(size_t shard);
+    void dispatch(const MarketUpdate& update);
+
+    bool sequenced(const MarketUpdate& update);
+    bool restore(const BookSnapshot& snapshot);
+    void recover();
+
+public:
+    explicit ConflatingRouter(InstrumentRegistry& registry, size_t highWaterMark = DEFAULT_HIGH_WATER_MARK,
+                              SnapshotRecovery *recovery = nullptr);
+
+    ConflatingRouter(const ConflatingRouter&) = delete;
+    ConflatingRouter& operator=(const ConflatingRouter&) = delete;
+
+    void route(const MarketUpdate& update);
+
+    // the book of instrument already holds the updates up to sequence, as after a warm start; earlier updates
+    // are skipped and a gap past it is recovered like any other
+    void resume(InstrumentId instrument, uint64_t sequence)
+    {
+        sequencing[instrument].last = sequence;
+    }
+
+    // flushes whatever lanes have room for and applies the snapshots fetched, meant to be called whenever the
+    // caller is idle
+    void drain();
+
+    // levels staged and not flushed yet
+    size_t backlog() const
+    {
+        return backlogged;
+    }
+
+    // instruments whose updates are held back until their book is recovered
+    size_t recovering() const
+    {
+        return pendingRecoveries;
+    }
+
+    const Stats& statistics() const
+    {
+        return stats;
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market_update_feed.hpp"
+#include "venue_consolidator.hpp"
+
+/*
+ * Books of the same instruments traded on several venues, consolidated into one: every port is the feed of a
+ * venue, received on a thread of its own, and the best bid and ask across venues are followed as the books of
+ * every venue change. Built as consolidated_book.
+ */
+
+std::atomic<bool> g_runFlag { true };
+void SignalHandler(int signum)
+{
+    std::cout << "\nSignal (" << signum << ") received, shutting down.\n" << std::flush;
+    g_runFlag.store(false);
+}
+
+int main(int argc, char *argv[])
+{
+    auto isValidUdpPort = [](int port) { return port >= 49152 && port <= 65535; };
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " UDP_PORT [UDP_PORT...] [--depth N] [--nbbo]\n";
+        std::cerr << "Every UDP_PORT is the feed of a venue, numbered from 0 in the order given, up to "
+                  << CryptoTradingInfra::MAX_VENUES << " of them. UDP_PORT must be between 49152 and 65535.\n";
+        std::cerr << "With --depth, the top N consolidated levels of every instrument are printed on shutdown "
+                  << "(default is 5).\n";
+        std::cerr << "With --nbbo, every change of the best bid or ask across venues is printed as it happens.\n"
+                  << std::flush;
+    };
+
+    std::vector<uint16_t> ports;
+    size_t depth = 5;
+    bool printNbbo = false;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--depth" && i + 1 < argc) {
+                auto parsed = std::stoi(argv[++i]);
+                if (parsed <= 0) {
+                    std::cerr << "Error: The depth must be positive.\n" << std::flush;
+                    return 1;
+                }
+                depth = static_cast<size_t>(parsed);
+            } else if (arg == "--nbbo") {
+                printNbbo = true;
+            } else {
+                auto parsed = std::stoi(arg);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                ports.push_back(static_cast<uint16_t>(parsed));
+            }
+        } catch (...) {
+            usage();
+            return 1;
+        }
+    }
+    if (ports.empty() || ports.size() > CryptoTradingInfra::MAX_VENUES) {
+        usage();
+        return 1;
+    }
+
+    CryptoTradingInfra::NbboSubscriber subscriber;
+    if (printNbbo) {
+        subscriber = [](const CryptoTradingInfra::NbboEvent& nbbo) {
+            std::cout << "NBBO of " << nbbo.instrument << " at " << nbbo.timestamp << ": ";
+            if (nbbo.bid) {
+                std::cout << nbbo.bid->price << " @" << nbbo.bid->size << " on venue "
+                          << static_cast<int>(nbbo.bid->venue);
+            } else {
+                std::cout << "no bid";
+            }
+            std::cout << " / ";
+            if (nbbo.ask) {
+                std::cout << nbbo.ask->price << " @" << nbbo.ask->size << " on venue "
+                          << static_cast<int>(nbbo.ask->venue);
+            } else {
+                std::cout << "no ask";
+            }
+            std::cout << "\n";
+        };
+    }
+    CryptoTradingInfra::VenueConsolidator consolidator(ports.size(), subscriber);
+
+    std::signal(SIGINT, SignalHandler);
+    std::cout << "Consolidating " << ports.size() << " venues. Press Ctrl+C to stop...\n" << std::flush;
+
+    // a receiver per venue, so a busy venue never holds the others back
+    std::vector<CryptoTradingInfra::PacketStats> stats(ports.size());
+    std::vector<std::unique_ptr<CryptoTradingInfra::FeedArbiter>> arbiters;
+    std::vector<std::thread> receivers;
+    for (size_t venue = 0; venue < ports.size(); ++venue) {
+        arbiters.push_back(std::make_unique<CryptoTradingInfra::FeedArbiter>());
+        receivers.emplace_back([&, venue]() {
+            auto id = static_cast<CryptoTradingInfra::VenueId>(venue);
+            CryptoTradingInfra::ReceiveMarketUpdate(g_runFlag, { ports[venue] }, stats[venue], *arbiters[venue],
+                                                    [&](const auto& update) { consolidator.enqueue(id, update); });
+        });
+    }
+
+    consolidator.run(g_runFlag);
+
+    for (auto& receiver : receivers) {
+        receiver.join();
+    }
+
+    // printing stats
+    for (size_t venue = 0; venue < ports.size(); ++venue) {
+        auto id = static_cast<CryptoTradingInfra::VenueId>(venue);
+        std::cout << "======Venue " << venue << " on port " << ports[venue] << "======" << std::endl;
+        stats[venue].print();
+        CryptoTradingInfra::PrintFeedLines({ ports[venue] }, *arbiters[venue]);
+        std::cout << "MarketUpdates applied: " << consolidator.updatesApplied(id) << ", dropped with the lane full: "
+                  << consolidator.updatesDropped(id) << std::endl;
+    }
+    std::cout << "NBBO changes: " << consolidator.nbboChangesNum() << std::endl;
+    std::cout << "Instruments: " << consolidator.instrumentsNum() << std::endl;
+    consolidator.print(depth);
+}
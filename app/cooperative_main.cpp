@@ -0,0 +1,126 @@
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sched.h>
+
+#include "cooperative_pipeline.hpp"
+#include "market_update_feed.hpp"
+#include "perf_counters.hpp"
+
+#if __cplusplus < 202002L
+#error "C++20 standard support required."
+#endif
+
+/*
+ * The engine on a single thread: receive, book apply and match run as coroutines taking turns, see
+ * CooperativePipeline. Built with -DCOOPERATIVE_PIPELINE=ON as trading_engine_coop.
+ */
+
+std::atomic<bool> g_runFlag { true };
+void SignalHandler(int signum)
+{
+    std::cout << "\nSignal (" << signum << ") received, shutting down.\n" << std::flush;
+    g_runFlag.store(false);
+}
+
+int main(int argc, char *argv[])
+{
+    auto isValidUdpPort = [](int port) { return port >= 49152 && port <= 65535; };
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " [UDP_PORT] [--line-b UDP_PORT] [--cpu CORE] [--depth PREFIX] "
+                  << "[--vwap-size SIZE] [--perf]\n";
+        std::cerr << "UDP_PORT must be between 49152 and 65535 (default is 49152).\n";
+        std::cerr << "With --line-b, the same feed is also received on a second port and the first copy of every "
+                  << "packet is taken.\n";
+        std::cerr << "With --cpu, the thread running every stage is pinned to CORE.\n";
+        std::cerr << "With --depth, the top " << CryptoTradingInfra::DEFAULT_DEPTH_LEVELS << " levels of every "
+                  << "order book are published into the shared memory segment PREFIX_<instrument id>, along with "
+                  << "microprice, imbalance and the VWAP of taking SIZE from either side (default is "
+                  << CryptoTradingInfra::DEFAULT_VWAP_SIZE << ").\n";
+        std::cerr << "With --perf, hardware counters of the receive, book apply and match stages are reported on "
+                  << "shutdown.\n" << std::flush;
+    };
+
+    std::vector<uint16_t> lines { 49152 };
+    int cpu = -1;
+    std::string depthPrefix;
+    CryptoTradingInfra::Size vwapSize = CryptoTradingInfra::DEFAULT_VWAP_SIZE;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--line-b" && i + 1 < argc) {
+                auto parsed = std::stoi(argv[++i]);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines.resize(2);
+                lines[1] = static_cast<uint16_t>(parsed);
+            } else if (arg == "--cpu" && i + 1 < argc) {
+                cpu = std::stoi(argv[++i]);
+                if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                    std::cerr << "Error: No such core.\n" << std::flush;
+                    return 1;
+                }
+            } else if (arg == "--perf") {
+                CryptoTradingInfra::Utils::PerfMonitor::Global().enable();
+            } else if (arg == "--depth" && i + 1 < argc) {
+                depthPrefix = argv[++i];
+            } else if (arg == "--vwap-size" && i + 1 < argc) {
+                vwapSize = std::stod(argv[++i]);
+                if (!(vwapSize > 0)) {
+                    std::cerr << "Error: The VWAP size must be positive.\n" << std::flush;
+                    return 1;
+                }
+            } else {
+                auto parsed = std::stoi(arg);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines[0] = static_cast<uint16_t>(parsed);
+            }
+        } catch (...) {
+            usage();
+            return 1;
+        }
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+            perror("sched_setaffinity");
+            return 1;
+        }
+    }
+
+    auto pipeline = CryptoTradingInfra::CooperativePipeline::Create(lines, depthPrefix, vwapSize);
+    if (!pipeline) {
+        return 1;
+    }
+
+    std::signal(SIGINT, SignalHandler);
+    std::cout << "Engine running its stages cooperatively on one thread";
+    if (cpu >= 0) {
+        std::cout << " pinned to core " << cpu;
+    }
+    std::cout << ". Press Ctrl+C to stop...\n" << std::flush;
+
+    pipeline->run(g_runFlag);
+
+    auto stats = pipeline->packetStats();
+    stats.print();
+    CryptoTradingInfra::PrintFeedLines(lines, pipeline->feedArbiter());
+    std::cout << "Total MarketUpdates processed: " << pipeline->updatesProcessed() << " (" << pipeline->updatesMatched()
+              << " matched)" << std::endl;
+    std::cout << "Instruments: " << pipeline->instrumentsNum() << std::endl;
+    if (CryptoTradingInfra::Utils::PerfMonitor::Global().enabled()) {
+        CryptoTradingInfra::Utils::PerfMonitor::Global().print(std::cout);
+    }
+    pipeline->print();
+}
@@ -0,0 +1,155 @@
+#include "cooperative_pipeline.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "perf_counters.hpp"
+
+namespace CryptoTradingInfra {
+
+CooperativePipeline::CooperativePipeline(const std::vector<uint16_t>& lines, std::vector<int> sockets,
+                                         const std::string& depthPrefix, Size vwapSize)
+    : lines(lines), sockets(std::move(sockets)), depthPrefix(depthPrefix), vwapSize(vwapSize)
+{
+}
+
+std::unique_ptr<CooperativePipeline> CooperativePipeline::Create(const std::vector<uint16_t>& lines,
+                                                                 const std::string& depthPrefix, Size vwapSize)
+{
+    if (lines.empty() || lines.size() > Utils::MAX_ARBITRATED_LINES) {
+        std::cerr << "Between 1 and " << Utils::MAX_ARBITRATED_LINES << " feed lines are supported.\n" << std::flush;
+        return nullptr;
+    }
+
+    std::vector<int> sockets;
+    for (auto port : lines) {
+        auto sockfd = OpenFeedLine(port);
+        if (sockfd < 0) {
+            for (auto opened : sockets) {
+                close(opened);
+            }
+            return nullptr;
+        }
+        sockets.push_back(sockfd);
+    }
+    return std::unique_ptr<CooperativePipeline>(new CooperativePipeline(lines, std::move(sockets), depthPrefix,
+                                                                        vwapSize));
+}
+
+CooperativePipeline::~CooperativePipeline()
+{
+    for (auto sockfd : sockets) {
+        close(sockfd);
+    }
+}
+
+Instrument& CooperativePipeline::instrument(InstrumentId id)
+{
+    auto& instrument = instruments[id];
+    if (!instrument) {
+        instrument = std::make_unique<Instrument>();
+        instrument->analytics = BookAnalytics<>(vwapSize);
+        if (!depthPrefix.empty()) {
+            // the books are still served without it, readers only see the segment missing
+            instrument->depth = DepthPublisher<>::Create(DepthSegmentName(depthPrefix, id), id);
+        }
+    }
+    return *instrument;
+}
+
+Utils::Coroutine CooperativePipeline::receive(std::atomic<bool>& runFlag)
+{
+    alignas(MarketUpdate) char buffer[std::max(MAX_SIZE_BATCH_MARKET_UPDATE, MAX_SIZE_FEED_MESSAGES)];
+    auto deliver = [this](const MarketUpdate& update) { received.push(update); };
+    while (runFlag.load(std::memory_order_relaxed)) {
+        bool busy = false;
+        for (size_t line = 0; line < sockets.size(); ++line) {
+            // a packet is only taken off the socket once all of its updates fit
+            if (received.capacity() - received.occupancy() < COOPERATIVE_PACKET_UPDATES) {
+                break;
+            }
+            auto length = recv(sockets[line], buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (length < 0) {
+                continue;
+            }
+            busy = true;
+
+            Utils::PerfRegion region(Utils::PERF_RECEIVE);
+            if (!DeliverPacket(buffer, length, line, stats, arbiter, deliver)) {
+                ++stats.packetsDiscarded;
+            }
+        }
+
+        // the thread is only given up when every stage ran dry
+        if (!busy && received.empty() && applied.empty()) {
+            std::this_thread::yield();
+        }
+        co_await Utils::Yield();
+    }
+    receiving = false;
+}
+
+Utils::Coroutine CooperativePipeline::applyBooks()
+{
+    EventHandler events;
+    while (receiving || !received.empty()) {
+        MarketUpdate update;
+        for (size_t i = 0; i < COOPERATIVE_BATCH && !applied.full() && received.pop(update); ++i) {
+            auto& books = instrument(update.instrument);
+            if (books.applyBook(update.instrument, update, events)) {
+                applied.push(Applied { &books, update });
+            }
+            processed.store(processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        co_await Utils::Yield();
+    }
+    applying = false;
+}
+
+Utils::Coroutine CooperativePipeline::match()
+{
+    EventHandler events;
+    while (applying || !applied.empty()) {
+        Applied next;
+        for (size_t i = 0; i < COOPERATIVE_BATCH && applied.pop(next); ++i) {
+            next.instrument->match(next.update, events);
+            matched.store(matched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        co_await Utils::Yield();
+    }
+}
+
+void CooperativePipeline::run(std::atomic<bool>& runFlag)
+{
+    receiving = true;
+    applying = true;
+
+    Utils::CooperativeScheduler scheduler;
+    scheduler.spawn(receive(runFlag));
+    scheduler.spawn(applyBooks());
+    scheduler.spawn(match());
+    scheduler.run();
+}
+
+const Instrument *CooperativePipeline::find(InstrumentId id) const
+{
+    auto it = instruments.find(id);
+    return it != instruments.end() ? it->second.get() : nullptr;
+}
+
+void CooperativePipeline::print(size_t depth) const
+{
+    for (const auto& [id, instrument] : instruments) {
+        std::cout << "======Instrument " << id << "======" << std::endl;
+        instrument->orderBook.print(depth);
+        const auto& features = instrument->analytics.features();
+        std::cout << "Microprice: " << features.microprice << ", imbalance: " << features.imbalance
+                  << ", VWAP to " << vwapSize << ": " << features.bidVwap << " / " << features.askVwap << std::endl;
+        instrument->tradingEngine.print(depth);
+    }
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,118 @@
+#ifndef CRYPTO_TRADING_INFRA_COOPERATIVE_PIPELINE
+#define CRYPTO_TRADING_INFRA_COOPERATIVE_PIPELINE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "book_analytics.hpp"
+#include "coroutine.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "market_update_feed.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr size_t COOPERATIVE_QUEUE_SIZE = 8192;
+// most updates a stage takes from its queue before yielding to the next one
+constexpr size_t COOPERATIVE_BATCH = 64;
+// most updates a packet can carry: MarketUpdate packets carry MAX_COUNT_MARKET_UPDATE, and every message
+// of a feed messages packet, none of which is smaller than a byte, carries one update at most
+constexpr size_t COOPERATIVE_PACKET_UPDATES = MAX_SIZE_FEED_MESSAGES;
+
+/*
+ * Receives updates and applies them to books and engines on the calling thread alone, for boxes with no cores
+ * to spare for a receiver and shard threads. Receive, book apply and match are coroutines taking turns on the
+ * thread, handing updates to one another through queues nothing but that thread touches, so no cache line
+ * moves between cores and no atomic is taken on the way. A stage yields when its input is empty, when the
+ * queue after it is full, or after COOPERATIVE_BATCH updates, so an update received is applied and matched
+ * within the same round of the stages.
+ *
+ * Books are the ones of the shards, only they are never read by another thread while the pipeline runs.
+ */
+class CooperativePipeline
+{
+    // an update applied to the book of instrument, waiting to be matched by its engine
+    struct Applied {
+        Instrument *instrument;
+        MarketUpdate update;
+    };
+
+    std::vector<uint16_t> lines;
+    std::vector<int> sockets;
+    std::string depthPrefix;
+    Size vwapSize;
+    std::unordered_map<InstrumentId, std::unique_ptr<Instrument>> instruments;
+
+    Utils::LocalRingBuffer<MarketUpdate, COOPERATIVE_QUEUE_SIZE> received;
+    Utils::LocalRingBuffer<Applied, COOPERATIVE_QUEUE_SIZE> applied;
+    // set by a stage returning, those after it return once they emptied their queue
+    bool receiving = false;
+    bool applying = false;
+
+    PacketStats stats {};
+    FeedArbiter arbiter;
+    // only written by the pipeline thread, read by anyone for statistics
+    std::atomic<uint64_t> processed { 0 };
+    std::atomic<uint64_t> matched { 0 };
+
+    CooperativePipeline(const std::vector<uint16_t>& lines, std::vector<int> sockets, const std::string& depthPrefix,
+                        Size vwapSize);
+
+    Instrument& instrument(InstrumentId id);
+
+    Utils::Coroutine receive(std::atomic<bool>& runFlag);
+    Utils::Coroutine applyBooks();
+    Utils::Coroutine match();
+
+public:
+    // opens every line, nullptr if one of them cannot be; books publish their depth when depthPrefix is set
+    static std::unique_ptr<CooperativePipeline> Create(const std::vector<uint16_t>& lines,
+                                                       const std::string& depthPrefix = {},
+                                                       Size vwapSize = DEFAULT_VWAP_SIZE);
+    ~CooperativePipeline();
+
+    CooperativePipeline(const CooperativePipeline&) = delete;
+    CooperativePipeline& operator=(const CooperativePipeline&) = delete;
+
+    // runs every stage until runFlag is cleared, then until what was received is matched
+    void run(std::atomic<bool>& runFlag);
+
+    uint64_t updatesProcessed() const
+    {
+        return processed.load(std::memory_order_relaxed);
+    }
+
+    uint64_t updatesMatched() const
+    {
+        return matched.load(std::memory_order_relaxed);
+    }
+
+    // only once run() returned
+    const Instrument *find(InstrumentId id) const;
+    size_t instrumentsNum() const
+    {
+        return instruments.size();
+    }
+
+    const PacketStats& packetStats() const
+    {
+        return stats;
+    }
+
+    const FeedArbiter& feedArbiter() const
+    {
+        return arbiter;
+    }
+
+    void print(size_t depth = 5) const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "delta_feed.hpp"
+
+namespace CryptoTradingInfra {
+
+DeltaFeed::DeltaFeed(int sockfd, const sockaddr_in& destination, std::chrono::nanoseconds interval, uint16_t stream)
+    : sockfd(sockfd), destination(destination), stream(static_cast<uint64_t>(stream) << DELTA_STREAM_SHIFT),
+      interval(interval), lastFlush(std::chrono::steady_clock::now()),
+      buffers(DELTA_BATCH_PACKETS * MAX_SIZE_BATCH_MARKET_UPDATE)
+{
+}
+
+std::unique_ptr<DeltaFeed> DeltaFeed::Create(const sockaddr_in& destination, std::chrono::nanoseconds interval,
+                                             uint16_t stream)
+{
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return nullptr;
+    }
+    return std::unique_ptr<DeltaFeed>(new DeltaFeed(sockfd, destination, interval, stream));
+}
+
+DeltaFeed::~DeltaFeed()
+{
+    close(sockfd);
+}
+
+void DeltaFeed::stage(InstrumentId instrument, const LevelUpdate& level, uint64_t timestamp)
+{
+    ++stats.deltas;
+
+    auto [it, inserted] = staged.try_emplace(LevelKey { instrument, level.side, level.price }, pending.size());
+    if (inserted) {
+        pending.emplace_back(level.side, level.price, level.size, timestamp, instrument);
+        return;
+    }
+
+    auto& delta = pending[it->second];
+    delta.size = level.size;
+    delta.timestamp = timestamp;
+    ++stats.conflated;
+}
+
+// packs pending deltas from `from` on into up to DELTA_BATCH_PACKETS packets, returns how many deltas were sent
+size_t DeltaFeed::send(size_t from)
+{
+    iovec iovs[DELTA_BATCH_PACKETS];
+    size_t counts[DELTA_BATCH_PACKETS];
+
+    size_t packets = 0;
+    for (auto next = from; packets < DELTA_BATCH_PACKETS && next < pending.size(); ++packets) {
+        auto packet = reinterpret_cast<MarketUpdatePacket *>(&buffers[packets * MAX_SIZE_BATCH_MARKET_UPDATE]);
+        auto count = std::min<size_t>(MAX_COUNT_MARKET_UPDATE, pending.size() - next);
+
+        packet->header.protocol = PROTOCOL_BOOK_DELTA;
+        packet->header.count = count;
+        // packets the socket does not take are packed again next time, so the sequence has no holes
+        packet->header.sequence = stream | (stats.packets + packets);
+        packet->header.hton();
+        for (size_t i = 0; i < count; ++i) {
+            packet->updates[i] = pending[next + i];
+            packet->updates[i].hton();
+        }
+
+        iovs[packets].iov_base = packet;
+        iovs[packets].iov_len = sizeof(MarketUpdateHeader) + count * sizeof(MarketUpdate);
+        counts[packets] = count;
+        next += count;
+    }
+
+#ifdef __linux__
+    mmsghdr msgs[DELTA_BATCH_PACKETS] {};
+    for (size_t i = 0; i < packets; ++i) {
+        msgs[i].msg_hdr.msg_name = &destination;
+        msgs[i].msg_hdr.msg_namelen = sizeof(destination);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int sent = sendmmsg(sockfd, msgs, packets, MSG_DONTWAIT);
+#else
+    int sent = 0;
+    while (static_cast<size_t>(sent) < packets &&
+           sendto(sockfd, iovs[sent].iov_base, iovs[sent].iov_len, MSG_DONTWAIT,
+                  reinterpret_cast<const sockaddr *>(&destination), sizeof(destination)) >= 0) {
+        ++sent;
+    }
+    if (sent == 0 && packets > 0) {
+        sent = -1;
+    }
+#endif
+
+    if (sent < 0) {
+        // the socket is full, everything stays staged for the next flush
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            perror("sendmmsg");
+        }
+        return 0;
+    }
+
+    size_t deltas = 0;
+    for (auto i = 0; i < sent; ++i) {
+        deltas += counts[i];
+    }
+    stats.packets += sent;
+    stats.sent += deltas;
+    return deltas;
+}
+
+void DeltaFeed::flush()
+{
+    lastFlush = std::chrono::steady_clock::now();
+
+    size_t done = 0;
+    while (done < pending.size()) {
+        auto attempted = std::min(pending.size() - done, DELTA_BATCH_PACKETS * MAX_COUNT_MARKET_UPDATE);
+        auto sent = send(done);
+        done += sent;
+        if (sent < attempted) {
+            break;
+        }
+    }
+
+    if (done == pending.size()) {
+        pending.clear();
+        staged.clear();
+        return;
+    }
+
+    // what is left keeps its order and is conflated further until the socket drains
+    pending.erase(pending.begin(), pending.begin() + done);
+    staged.clear();
+    for (size_t i = 0; i < pending.size(); ++i) {
+        const auto& delta = pending[i];
+        staged.emplace(LevelKey { delta.instrument, delta.side, delta.price }, i);
+    }
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,107 @@
+#ifndef CRYPTO_TRADING_INFRA_DELTA_FEED
+#define CRYPTO_TRADING_INFRA_DELTA_FEED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+
+#include "book_state.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr auto DEFAULT_DELTA_INTERVAL = std::chrono::microseconds(1000);
+
+// packets handed to the kernel in a single sendmmsg
+constexpr size_t DELTA_BATCH_PACKETS = 32;
+
+// the sequence of a delta packet carries the stream of the feed that sent it from this bit on, and the number
+// of the packet within that stream below it
+constexpr unsigned DELTA_STREAM_SHIFT = 48;
+
+inline uint16_t DeltaStream(uint64_t sequence)
+{
+    return static_cast<uint16_t>(sequence >> DELTA_STREAM_SHIFT);
+}
+
+inline uint64_t DeltaPacket(uint64_t sequence)
+{
+    return sequence & ((uint64_t { 1 } << DELTA_STREAM_SHIFT) - 1);
+}
+
+/*
+ * Outbound UDP feed of the level changes applied to order books. Every change is staged in a table keyed by
+ * instrument, side and price, so a level changing several times within a flush interval only goes out once
+ * with its latest size. Whatever the socket cannot take right away stays staged and keeps being conflated,
+ * so a slow subscriber gets fewer, coarser updates rather than a growing backlog.
+ *
+ * Deltas are sent as MarketUpdate packets under PROTOCOL_BOOK_DELTA, numbered from 0 in the order they are
+ * sent within the stream of the feed. Not thread safe, every shard owns one with a stream of its own, so the
+ * feeds of all shards may share a subscriber, which follows the sequence of every stream apart.
+ */
+class DeltaFeed
+{
+public:
+    struct Stats {
+        uint64_t deltas;
+        uint64_t conflated;
+        uint64_t sent;
+        uint64_t packets;
+    };
+
+private:
+    int sockfd;
+    sockaddr_in destination;
+    uint64_t stream;
+    std::chrono::nanoseconds interval;
+    std::chrono::steady_clock::time_point lastFlush;
+
+    // deltas in the order their level first changed, and where each staged level sits among them
+    std::vector<MarketUpdate> pending;
+    std::unordered_map<LevelKey, size_t, LevelKeyHash> staged;
+    std::vector<char> buffers;
+
+    Stats stats {};
+
+    DeltaFeed(int sockfd, const sockaddr_in& destination, std::chrono::nanoseconds interval, uint16_t stream);
+
+    size_t send(size_t from);
+
+public:
+    // returns nullptr if the socket cannot be created
+    static std::unique_ptr<DeltaFeed> Create(const sockaddr_in& destination,
+                                             std::chrono::nanoseconds interval = DEFAULT_DELTA_INTERVAL,
+                                             uint16_t stream = 0);
+    ~DeltaFeed();
+
+    DeltaFeed(const DeltaFeed&) = delete;
+    DeltaFeed& operator=(const DeltaFeed&) = delete;
+
+    void stage(InstrumentId instrument, const LevelUpdate& level, uint64_t timestamp);
+
+    bool due(std::chrono::steady_clock::time_point now) const
+    {
+        return !pending.empty() && now - lastFlush >= interval;
+    }
+
+    // sends everything staged the socket accepts without blocking
+    void flush();
+
+    size_t backlog() const
+    {
+        return pending.size();
+    }
+
+    const Stats& statistics() const
+    {
+        return stats;
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CRYPTO_TRADING_INFRA_ENGINE_EVENTS
+#define CRYPTO_TRADING_INFRA_ENGINE_EVENTS
+
+#include <cstddef>
+#include <cstdint>
+
+#include "book_state.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+
+// a level of an order book changed, size being what is left at it
+struct BookEvent {
+    InstrumentId instrument;
+    uint64_t timestamp;
+    LevelUpdate level;
+};
+
+// the engine matched an update, side being the one of the aggressor
+struct TradeEvent {
+    InstrumentId instrument;
+    uint64_t timestamp;
+    MarketUpdate::Side side;
+    Price price;
+    Size size;
+};
+
+// best bid or ask of an order book changed in price or size, a size of 0 meaning the side is empty
+struct BboEvent {
+    InstrumentId instrument;
+    uint64_t timestamp;
+    BookState::Item bid;
+    BookState::Item ask;
+};
+
+/*
+ * Events are delivered to handlers bound at compile time: whatever applies updates is a template on the
+ * handler type and calls its members directly, so they inline into the apply loop. Handlers derive from
+ * EventHandler and hide the members of the events they subscribe to, the others costing nothing.
+ */
+struct EventHandler {
+    void onBook(const BookEvent&)
+    {
+    }
+
+    void onTrade(const TradeEvent&)
+    {
+    }
+
+    void onBbo(const BboEvent&)
+    {
+    }
+};
+
+// events of a batch of updates, in the order they happened within each kind
+template <typename T>
+struct EventSpan {
+    const T *data;
+    size_t size;
+
+    const T *begin() const
+    {
+        return data;
+    }
+
+    const T *end() const
+    {
+        return data + size;
+    }
+};
+
+struct EventBatch {
+    EventSpan<BookEvent> books;
+    EventSpan<TradeEvent> trades;
+    EventSpan<BboEvent> bbos;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
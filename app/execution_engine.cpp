@@ -1,6 +1,6 @@
-#include <memory>
-#include <thread>
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include "execution_engine.hpp"
 #include "market_update.hpp"
@@ -8,96 +8,241 @@
 
 namespace CryptoTradingInfra {
 
-TradingEngine::TradingEngine()
-{
-    std::atomic_store(&bookState, std::make_shared<BookState>());
-}
-
 void TradingEngine::print(int depth) const
 {
     std::cout << "===TradingEngine===" << std::endl;
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    state->print(depth);
+    bookState.read()->print(depth);
+    if (expiredOrders() > 0) {
+        std::cout << "Expired orders: " << expiredOrders() << ", " << expiredSize() << " left resting" << std::endl;
+    }
 }
 
 std::optional<BookState::Item> TradingEngine::bestBid() const
 {
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    return state->bestBid();
+    return bookState.read()->bestBid();
 }
 
 std::optional<BookState::Item> TradingEngine::bestAsk() const
 {
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    return state->bestAsk();
+    return bookState.read()->bestAsk();
 }
 
-void TradingEngine::match(const MarketUpdate& update)
+void TradingEngine::restore(const std::vector<BookState::Item>& bids, const std::vector<BookState::Item>& asks)
 {
-    while (true) {
-        auto oldState = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-        auto newState = std::make_shared<BookState>(*oldState);
-
-        std::vector<MarketUpdate> trades;
-
-        MarketUpdate::Side side = update.side;
-        Price price = update.price;
-        Size remaining = update.size;
-
-        if (side == MarketUpdate::Side::BID) {
-            while (remaining > 0 && !newState->empty<MarketUpdate::Side::ASK>() &&
-                   newState->bestAsk()->first <= price) {
-                Price askPrice = newState->bestAsk()->first;
-                Size askSize = newState->bestAsk()->second;
-
-                Size traded = std::min(remaining, askSize);
-                trades.emplace_back(MarketUpdate::Side::BID, askPrice, traded);
-
-                if (traded == askSize) {
-                    newState->updateState<MarketUpdate::Side::ASK>(askPrice, 0);
-                } else {
-                    newState->updateState<MarketUpdate::Side::ASK>(askPrice, -traded);
-                }
-                remaining -= traded;
-            }
+    bookState.update([&](BookState& newState) {
+        const BookState empty(newState.tickSize());
+        newState = empty;
+        for (const auto& [price, size] : bids) {
+            newState.updateState<MarketUpdate::Side::BID>(price, size);
+        }
+        for (const auto& [price, size] : asks) {
+            newState.updateState<MarketUpdate::Side::ASK>(price, size);
+        }
+    });
+
+    expiries.clear(expiries.now());
+    orders.clear();
+    freeOrders.clear();
+    for (auto& sideQueues : queues) {
+        sideQueues.clear();
+    }
+    expired.clear();
+}
+
+void TradingEngine::expire(uint64_t now)
+{
+    if (expiries.empty()) {
+        return;
+    }
+    advance(now);
+    if (!expired.empty()) {
+        bookState.update([&](BookState& newState) { Sweep(newState, expired); });
+        expired.clear();
+    }
+}
 
-            if (remaining > 0) {
-                newState->updateState<MarketUpdate::Side::BID>(price, remaining);
+void TradingEngine::Sweep(BookState& state, const std::vector<LevelUpdate>& levels)
+{
+    for (const auto& level : levels) {
+        if (level.side == MarketUpdate::Side::BID) {
+            state.updateState<MarketUpdate::Side::BID>(level.price, -level.size);
+        } else {
+            state.updateState<MarketUpdate::Side::ASK>(level.price, -level.size);
+        }
+    }
+}
+
+void TradingEngine::advance(uint64_t timestamp)
+{
+    expiries.advance(timestamp / ORDER_EXPIRY_TICK, [&](uint32_t index) {
+        auto& order = orders[index];
+        order.expiry = Utils::TimingWheel<uint32_t>::NONE;
+        expired.push_back({ order.side, order.price, order.remaining });
+        expiredOrdersNum.store(expiredOrdersNum.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        expiredSizeNum.store(expiredSizeNum.load(std::memory_order_relaxed) + order.remaining,
+                             std::memory_order_relaxed);
+        // stays queued until trades reach it, with nothing left
+        order.remaining = 0;
+
+        auto& sideQueues = queues[static_cast<size_t>(order.side)];
+        auto queue = sideQueues.find(order.price);
+        if (queue != sideQueues.end() && --queue->second.timed == 0) {
+            drop(order.side, queue);
+        }
+    });
+}
+
+void TradingEngine::settle(const MarketUpdate& update, const std::vector<TradeEvent>& trades, Size level)
+{
+    auto opposite = update.side == MarketUpdate::Side::BID ? MarketUpdate::Side::ASK : MarketUpdate::Side::BID;
+    Size rested = update.size;
+    for (const auto& trade : trades) {
+        consume(opposite, trade.price, trade.size);
+        rested -= trade.size;
+    }
+    expired.clear();
+    if (level == 0 || rested <= 0) {
+        return;
+    }
+
+    auto& sideQueues = queues[static_cast<size_t>(update.side)];
+    auto queue = sideQueues.find(update.price);
+    auto ahead = level - rested;
+    // the level left the book since, evicted as the worst one, along with the orders queued there
+    if (queue != sideQueues.end() && ahead <= 0) {
+        drop(update.side, queue);
+        queue = sideQueues.end();
+    }
+
+    if ((update.flags & MarketUpdate::TIMED) && lifetime != 0) {
+        if (queue == sideQueues.end()) {
+            queue = sideQueues.emplace(update.price, LevelQueue {}).first;
+            if (ahead > 0) {
+                queue->second.segments.push_back({ NO_ORDER, ahead });
             }
+        }
+        auto index = allocate({ update.side, update.price, rested, Utils::TimingWheel<uint32_t>::NONE });
+        auto due = (update.timestamp + lifetime + ORDER_EXPIRY_TICK - 1) / ORDER_EXPIRY_TICK;
+        orders[index].expiry = expiries.schedule(due, index);
+        queue->second.segments.push_back({ index, 0 });
+        ++queue->second.timed;
+    } else if (queue != sideQueues.end()) {
+        auto& segments = queue->second.segments;
+        if (!segments.empty() && segments.back().order == NO_ORDER) {
+            segments.back().size += rested;
         } else {
-            while (remaining > 0 && !newState->empty<MarketUpdate::Side::BID>() &&
-                   newState->bestBid()->first >= price) {
-                Price bidPrice = newState->bestBid()->first;
-                Size bidSize = newState->bestBid()->second;
-
-                Size traded = std::min(remaining, bidSize);
-                trades.emplace_back(MarketUpdate::Side::ASK, bidPrice, traded);
-
-                if (traded == bidSize) {
-                    newState->updateState<MarketUpdate::Side::BID>(bidPrice, 0);
-                } else {
-                    newState->updateState<MarketUpdate::Side::BID>(bidPrice, -traded);
-                }
-                remaining -= traded;
+            segments.push_back({ NO_ORDER, rested });
+        }
+    }
+}
+
+void TradingEngine::consume(MarketUpdate::Side side, Price price, Size size)
+{
+    auto& sideQueues = queues[static_cast<size_t>(side)];
+    auto queue = sideQueues.find(price);
+    if (queue == sideQueues.end()) {
+        return;
+    }
+
+    auto& segments = queue->second.segments;
+    while (size > 0 && !segments.empty()) {
+        auto& segment = segments.front();
+        auto& left = segment.order == NO_ORDER ? segment.size : orders[segment.order].remaining;
+        auto taken = std::min(left, size);
+        left -= taken;
+        size -= taken;
+        if (left > 0) {
+            break;
+        }
+        if (segment.order != NO_ORDER) {
+            auto& order = orders[segment.order];
+            // filled before it expired
+            if (order.expiry != Utils::TimingWheel<uint32_t>::NONE) {
+                expiries.cancel(order.expiry);
+                --queue->second.timed;
             }
+            freeOrders.push_back(segment.order);
+        }
+        segments.pop_front();
+    }
+    if (queue->second.timed == 0) {
+        drop(side, queue);
+    }
+}
 
-            if (remaining > 0) {
-                newState->updateState<MarketUpdate::Side::ASK>(price, remaining);
+void TradingEngine::drop(MarketUpdate::Side side, std::unordered_map<Price, LevelQueue>::iterator queue)
+{
+    for (const auto& segment : queue->second.segments) {
+        if (segment.order == NO_ORDER) {
+            continue;
+        }
+        auto& order = orders[segment.order];
+        if (order.expiry != Utils::TimingWheel<uint32_t>::NONE) {
+            expiries.cancel(order.expiry);
+        }
+        freeOrders.push_back(segment.order);
+    }
+    queues[static_cast<size_t>(side)].erase(queue);
+}
+
+uint32_t TradingEngine::allocate(const TimedOrder& order)
+{
+    if (!freeOrders.empty()) {
+        auto index = freeOrders.back();
+        freeOrders.pop_back();
+        orders[index] = order;
+        return index;
+    }
+    orders.push_back(order);
+    return static_cast<uint32_t>(orders.size() - 1);
+}
+
+Size TradingEngine::Cross(BookState& state, const MarketUpdate& update, std::vector<TradeEvent>& trades)
+{
+    MarketUpdate::Side side = update.side;
+    Price price = update.price;
+    Size remaining = update.size;
+
+    if (side == MarketUpdate::Side::BID) {
+        while (remaining > 0 && !state.empty<MarketUpdate::Side::ASK>() && state.bestAsk()->first <= price) {
+            Price askPrice = state.bestAsk()->first;
+            Size askSize = state.bestAsk()->second;
+
+            Size traded = std::min(remaining, askSize);
+            trades.push_back({ update.instrument, update.timestamp, MarketUpdate::Side::BID, askPrice, traded });
+
+            if (traded == askSize) {
+                state.updateState<MarketUpdate::Side::ASK>(askPrice, 0);
+            } else {
+                state.updateState<MarketUpdate::Side::ASK>(askPrice, -traded);
             }
+            remaining -= traded;
         }
 
-        if (std::atomic_compare_exchange_weak_explicit(&bookState, &oldState, newState, std::memory_order_release,
-                                                       std::memory_order_acquire)) {
-            if (onTrade) {
-                for (const auto& trade : trades) {
-                    onTrade(trade.side, trade.price, trade.size);
-                }
+        if (remaining > 0 && (update.flags & MarketUpdate::IMMEDIATE_OR_CANCEL) == 0) {
+            return state.updateState<MarketUpdate::Side::BID>(price, remaining);
+        }
+    } else {
+        while (remaining > 0 && !state.empty<MarketUpdate::Side::BID>() && state.bestBid()->first >= price) {
+            Price bidPrice = state.bestBid()->first;
+            Size bidSize = state.bestBid()->second;
+
+            Size traded = std::min(remaining, bidSize);
+            trades.push_back({ update.instrument, update.timestamp, MarketUpdate::Side::ASK, bidPrice, traded });
+
+            if (traded == bidSize) {
+                state.updateState<MarketUpdate::Side::BID>(bidPrice, 0);
+            } else {
+                state.updateState<MarketUpdate::Side::BID>(bidPrice, -traded);
             }
-            break;
+            remaining -= traded;
         }
 
-        std::this_thread::yield();
+        if (remaining > 0 && (update.flags & MarketUpdate::IMMEDIATE_OR_CANCEL) == 0) {
+            return state.updateState<MarketUpdate::Side::ASK>(price, remaining);
+        }
     }
+    return 0;
 }
 
 } // namespace CryptoTradingInfra
@@ -1,28 +1,210 @@
 #ifndef CRYPTO_TRADING_INFRA_EXECUTION_ENGINE
 #define CRYPTO_TRADING_INFRA_EXECUTION_ENGINE
 
-#include <memory>
-#include <functional>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
+#include "engine_events.hpp"
+#include "epoch_snapshot.hpp"
 #include "market_update.hpp"
 #include "order_book.hpp"
+#include "timing_wheel.hpp"
 
 namespace CryptoTradingInfra {
 
+// nanoseconds of update timestamps a tick of the expiry wheel lasts, orders expire up to a tick late
+constexpr uint64_t ORDER_EXPIRY_TICK = 1000;
+
+/*
+ * Resting orders of an instrument, matched as updates come in. Orders flagged TIMED expire once the order
+ * lifetime has passed after the timestamp they rested at, time going by the timestamps of the updates
+ * matched. Their expiries wait in a timing wheel, cancelled as soon as an order is filled, and those due
+ * by an update are swept out of the book in the same version the update is matched in.
+ *
+ * The book keeps sizes per level rather than orders, so levels holding timed orders keep a queue of what
+ * rests there in the order it came in, trades taking from its front, which tells how much of a timed
+ * order is left once it expires. Levels without timed orders keep nothing besides their size. Like the
+ * book, queues and expiries are only touched by the thread matching updates.
+ */
 class TradingEngine {
 private:
-    std::shared_ptr<BookState> bookState;
+    static constexpr uint32_t NO_ORDER = UINT32_MAX;
 
-    using TradeHandler = std::function<void(MarketUpdate::Side, Price, Size)>;
-    TradeHandler onTrade;
+    struct TimedOrder {
+        MarketUpdate::Side side;
+        Price price;
+        Size remaining;
+        Utils::TimingWheel<uint32_t>::Handle expiry;
+    };
 
-public:
-    TradingEngine();
+    // quantity resting at a level, of a timed order or of any number of others
+    struct Segment {
+        uint32_t order;
+        Size size;
+    };
+
+    struct LevelQueue {
+        std::deque<Segment> segments;
+        // timed orders not filled nor expired yet, the queue is dropped once there are none
+        size_t timed = 0;
+    };
+
+    Utils::EpochSnapshot<BookState> bookState;
+
+    uint64_t lifetime = 0;
+    Utils::TimingWheel<uint32_t> expiries;
+    std::vector<TimedOrder> orders;
+    std::vector<uint32_t> freeOrders;
+    // per side, indexed by MarketUpdate::Side
+    std::unordered_map<Price, LevelQueue> queues[2];
+    // what expired since the last version, swept out of the book with the next one
+    std::vector<LevelUpdate> expired;
+    // written by the thread matching updates alone, readable from any other
+    std::atomic<uint64_t> expiredOrdersNum { 0 };
+    std::atomic<Size> expiredSizeNum { 0 };
+
+    // crosses update against state, appending the trades to trades, and rests what is left of it unless update
+    // is IMMEDIATE_OR_CANCEL; returns the size of the level it rested at, 0 if nothing rested
+    static Size Cross(BookState& state, const MarketUpdate& update, std::vector<TradeEvent>& trades);
+
+    // takes expired levels off state, down to nothing at most
+    static void Sweep(BookState& state, const std::vector<LevelUpdate>& levels);
 
+    bool timing() const
+    {
+        return lifetime != 0 || !expiries.empty();
+    }
+
+    // moves the expiries due by timestamp into expired
+    void advance(uint64_t timestamp);
+
+    // follows update matched in queues, trades taking from the front of the levels they hit and what rested at
+    // level joining the back of it
+    void settle(const MarketUpdate& update, const std::vector<TradeEvent>& trades, Size level);
+
+    void consume(MarketUpdate::Side side, Price price, Size size);
+    void drop(MarketUpdate::Side side, std::unordered_map<Price, LevelQueue>::iterator queue);
+    uint32_t allocate(const TimedOrder& order);
+
+public:
     std::optional<BookState::Item> bestBid() const;
     std::optional<BookState::Item> bestAsk() const;
 
-    void match(const MarketUpdate& update);
+    // inspect is invoked on the latest version of the resting orders, which stays pinned until it returns
+    template <typename F>
+    auto read(F&& inspect) const
+    {
+        auto state = bookState.read();
+        return inspect(*state);
+    }
+
+    // replaces the resting orders with bids and asks, as kept by a checkpoint, none of them timed
+    void restore(const std::vector<BookState::Item>& bids, const std::vector<BookState::Item>& asks);
+
+    // nanoseconds TIMED orders rest for, 0 leaving those matched from now on resting until traded
+    void setOrderLifetime(uint64_t nanoseconds)
+    {
+        lifetime = nanoseconds;
+    }
+
+    uint64_t orderLifetime() const
+    {
+        return lifetime;
+    }
+
+    // sweeps out what expired by now, for callers driving expiries with a clock of the timebase of updates
+    // rather than waiting for the next update
+    void expire(uint64_t now);
+
+    // timed orders resting, neither filled nor expired yet
+    size_t pendingExpiries() const
+    {
+        return expiries.size();
+    }
+
+    uint64_t expiredOrders() const
+    {
+        return expiredOrdersNum.load(std::memory_order_relaxed);
+    }
+
+    // what was left of them when they expired
+    Size expiredSize() const
+    {
+        return expiredSizeNum.load(std::memory_order_relaxed);
+    }
+
+    // handler gets a TradeEvent per trade, once the book of the engine is updated
+    template <typename Handler>
+    void match(const MarketUpdate& update, Handler& handler)
+    {
+        auto timed = timing();
+        if (timed) {
+            advance(update.timestamp);
+        }
+
+        // the update may be retried under contention, trades are only delivered for the one that went through
+        thread_local std::vector<TradeEvent> trades;
+        Size level = 0;
+        bookState.update([&](BookState& newState) {
+            trades.clear();
+            Sweep(newState, expired);
+            level = Cross(newState, update, trades);
+        });
+        if (timed) {
+            settle(update, trades, level);
+        }
+
+        for (const auto& trade : trades) {
+            handler.onTrade(trade);
+        }
+    }
+
+    void match(const MarketUpdate& update)
+    {
+        EventHandler none;
+        match(update, none);
+    }
+
+    // matches updates in order as a single new version of the book, skipping the SNAPSHOT and CLEAR_BOOK ones
+    // an order book rebuilds from
+    template <typename Handler>
+    void match(const MarketUpdate *updates, size_t count, Handler& handler)
+    {
+        // expiries are due between updates, which then each get a version of their own
+        if (timing()) {
+            for (size_t i = 0; i < count; ++i) {
+                if ((updates[i].flags & (MarketUpdate::SNAPSHOT | MarketUpdate::CLEAR_BOOK)) == 0) {
+                    match(updates[i], handler);
+                }
+            }
+            return;
+        }
+
+        thread_local std::vector<TradeEvent> trades;
+        bookState.update([&](BookState& newState) {
+            trades.clear();
+            for (size_t i = 0; i < count; ++i) {
+                if ((updates[i].flags & (MarketUpdate::SNAPSHOT | MarketUpdate::CLEAR_BOOK)) == 0) {
+                    Cross(newState, updates[i], trades);
+                }
+            }
+        });
+
+        for (const auto& trade : trades) {
+            handler.onTrade(trade);
+        }
+    }
+
+    void match(const MarketUpdate *updates, size_t count)
+    {
+        EventHandler none;
+        match(updates, count, none);
+    }
 
     void print(int depth = 5) const;
 };
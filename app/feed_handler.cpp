@@ -0,0 +1,123 @@
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market_update_feed.hpp"
+#include "snapshot_service.hpp"
+
+#if __cplusplus < 201703L
+#error "C++17 standard support required."
+#endif
+
+/*
+ * Standalone feed handler, receiving MarketUpdates from the network and publishing them into one shared memory
+ * ring per consumer process. Consumers may be restarted at will while ingestion keeps going: updates meant for
+ * a ring nobody drains are dropped and counted once the ring is full.
+ */
+
+std::atomic<bool> g_runFlag { true };
+void SignalHandler(int signum)
+{
+    std::cout << "\nSignal (" << signum << ") received, shutting down.\n" << std::flush;
+    g_runFlag.store(false);
+}
+
+int main(int argc, char *argv[])
+{
+    auto isValidUdpPort = [](int port) { return port >= 49152 && port <= 65535; };
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " [UDP_PORT] [--line-b UDP_PORT] [--shm NAME]... [--snapshots ENDPOINT]\n";
+        std::cerr << "UDP_PORT must be between 49152 and 65535 (default is 49152).\n";
+        std::cerr << "With --line-b, the same feed is also received on a second port and the first copy of every "
+                  << "packet is taken.\n";
+        std::cerr << "Every update is published into each shared memory ring NAME given (default is "
+                  << CryptoTradingInfra::DEFAULT_FEED_NAME << ").\n";
+        std::cerr << "With --snapshots, books are kept for every instrument and served as snapshots at ENDPOINT, "
+                  << "either IPv4:PORT or a unix socket path, to engines started with --recovery.\n" << std::flush;
+    };
+
+    std::vector<uint16_t> lines { 49152 };
+    std::vector<std::string> feedNames;
+    std::string snapshotEndpoint;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--line-b" && i + 1 < argc) {
+                auto parsed = std::stoi(argv[++i]);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines.resize(2);
+                lines[1] = static_cast<uint16_t>(parsed);
+            } else if (arg == "--snapshots" && i + 1 < argc) {
+                snapshotEndpoint = argv[++i];
+            } else if (arg == "--shm" && i + 1 < argc) {
+                feedNames.emplace_back(argv[++i]);
+            } else {
+                auto parsed = std::stoi(arg);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines[0] = static_cast<uint16_t>(parsed);
+            }
+        } catch (...) {
+            usage();
+            return 1;
+        }
+    }
+    if (feedNames.empty()) {
+        feedNames.emplace_back(CryptoTradingInfra::DEFAULT_FEED_NAME);
+    }
+
+    std::vector<std::unique_ptr<CryptoTradingInfra::FeedRing>> feeds;
+    for (const auto& name : feedNames) {
+        auto feed = CryptoTradingInfra::FeedRing::Create(name);
+        if (!feed) {
+            return 1;
+        }
+        std::cout << "Publishing MarketUpdates to " << name << "\n" << std::flush;
+        feeds.push_back(std::move(feed));
+    }
+
+    CryptoTradingInfra::SnapshotCache books;
+    std::unique_ptr<CryptoTradingInfra::SnapshotServer> snapshots;
+    if (!snapshotEndpoint.empty()) {
+        snapshots = CryptoTradingInfra::SnapshotServer::Create(
+            snapshotEndpoint, [&](CryptoTradingInfra::InstrumentId id) { return books.snapshot(id); });
+        if (!snapshots) {
+            return 1;
+        }
+        std::cout << "Serving book snapshots at " << snapshotEndpoint << "\n" << std::flush;
+    }
+
+    std::signal(SIGINT, SignalHandler);
+    std::cout << "Feed handler running. Press Ctrl+C to stop...\n" << std::flush;
+
+    CryptoTradingInfra::PacketStats stats {};
+    CryptoTradingInfra::FeedArbiter arbiter;
+    std::vector<uint64_t> updatesDropped(feeds.size(), 0);
+    CryptoTradingInfra::ReceiveMarketUpdate(g_runFlag, lines, stats, arbiter, [&](const auto& update) {
+        if (snapshots) {
+            books.apply(update);
+        }
+        for (size_t i = 0; i < feeds.size(); ++i) {
+            if (!feeds[i]->push(update)) {
+                ++updatesDropped[i];
+            }
+        }
+    });
+
+    stats.print();
+    CryptoTradingInfra::PrintFeedLines(lines, arbiter);
+    for (size_t i = 0; i < feeds.size(); ++i) {
+        std::cout << "MarketUpdates dropped by " << feeds[i]->segmentName() << ": " << updatesDropped[i] << "\n";
+    }
+    std::cout << std::flush;
+}
@@ -0,0 +1,302 @@
+#include <iostream>
+#include <iterator>
+
+#include "instrument_registry.hpp"
+
+namespace CryptoTradingInfra {
+
+struct InstrumentShard::Events : EventHandler {
+    InstrumentShard& shard;
+
+    void onBook(const BookEvent& event)
+    {
+        if (shard.deltas) {
+            shard.deltas->stage(event.instrument, event.level, event.timestamp);
+        }
+        if (shard.subscriber) {
+            shard.books.push_back(event);
+        }
+    }
+
+    void onTrade(const TradeEvent& event)
+    {
+        if (shard.subscriber) {
+            shard.trades.push_back(event);
+        }
+    }
+
+    void onBbo(const BboEvent& event)
+    {
+        if (shard.subscriber) {
+            shard.bbos.push_back(event);
+        }
+    }
+};
+
+InstrumentShard::InstrumentShard(const ShardConfig& config, uint16_t index)
+    : depthPrefix(config.depthPrefix), vwapSize(config.vwapSize), barSpecs(config.bars), riskLimits(config.risk),
+      orderLifetime(config.orderLifetime), subscriber(config.events)
+{
+    if (!barSpecs.empty()) {
+        completedBars = std::make_unique<BarRing>();
+    }
+    if (riskLimits) {
+        rejectedOrders = std::make_unique<RejectRing>();
+    }
+    if (config.deltas) {
+        // the books are still served without it, subscribers only see no deltas
+        deltas = DeltaFeed::Create(*config.deltas, config.deltaInterval, index);
+    }
+    if (subscriber) {
+        // an update causes a few events at most, batches are not expected to grow past this
+        books.reserve(EVENT_BATCH_UPDATES * 4);
+        trades.reserve(EVENT_BATCH_UPDATES * 4);
+        bbos.reserve(EVENT_BATCH_UPDATES);
+    }
+}
+
+std::optional<InstrumentState> Instrument::state(InstrumentId id) const
+{
+    // versions are persistent, so taking both of them under the lock only costs a reference to each and the
+    // levels are copied once a read saw no update
+    std::optional<BookState> book;
+    std::optional<BookState> engine;
+    auto read = lock.tryRead(
+        [&]() {
+            orderBook.read([&](const BookState& version) { book.emplace(version); });
+            tradingEngine.read([&](const BookState& version) { engine.emplace(version); });
+        },
+        STATE_READ_ATTEMPTS);
+    if (!read) {
+        return std::nullopt;
+    }
+
+    InstrumentState state;
+    state.instrument = id;
+    state.sequence = book->sequence;
+    state.bids.assign(book->bidsNAsks.bids.begin(), book->bidsNAsks.bids.end());
+    state.asks.assign(book->bidsNAsks.asks.begin(), book->bidsNAsks.asks.end());
+    state.engineBids.assign(engine->bidsNAsks.bids.begin(), engine->bidsNAsks.bids.end());
+    state.engineAsks.assign(engine->bidsNAsks.asks.begin(), engine->bidsNAsks.asks.end());
+    return state;
+}
+
+Instrument& InstrumentShard::instrument(InstrumentId id)
+{
+    auto& instrument = instruments[id];
+    if (!instrument) {
+        instrument = std::make_unique<Instrument>();
+        instrument->analytics = BookAnalytics<>(vwapSize);
+        instrument->tradingEngine.setOrderLifetime(orderLifetime);
+        if (!depthPrefix.empty()) {
+            // the books are still served without it, readers only see the segment missing
+            instrument->depth = DepthPublisher<>::Create(DepthSegmentName(depthPrefix, id), id);
+        }
+        if (!barSpecs.empty()) {
+            instrument->bars = std::make_unique<BarAggregator>(id, barSpecs, completedBars.get());
+        }
+        if (riskLimits) {
+            instrument->risk = std::make_unique<RiskGate>(id, *riskLimits, rejectedOrders.get());
+        }
+
+        std::lock_guard<std::mutex> lock(publishedMutex);
+        published.emplace_back(id, instrument.get());
+    }
+    return *instrument;
+}
+
+void InstrumentShard::apply(const MarketUpdate& update)
+{
+    Events events { {}, *this };
+    instrument(update.instrument).apply(update.instrument, update, events);
+
+    // single writer, a plain store is enough to publish the counter
+    processed.store(processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void InstrumentShard::flushDeltas()
+{
+    if (deltas && deltas->due(std::chrono::steady_clock::now())) {
+        deltas->flush();
+    }
+}
+
+void InstrumentShard::deliverEvents()
+{
+    if (books.empty() && trades.empty() && bbos.empty()) {
+        return;
+    }
+
+    subscriber(EventBatch { { books.data(), books.size() }, { trades.data(), trades.size() },
+                            { bbos.data(), bbos.size() } });
+    books.clear();
+    trades.clear();
+    bbos.clear();
+}
+
+void InstrumentShard::run(std::atomic<bool>& runFlag)
+{
+    uint64_t applied = 0;
+    while (runFlag.load(std::memory_order_relaxed)) {
+        MarketUpdate update;
+        if (lane.pop(update)) {
+            apply(update);
+            ++applied;
+            if (applied % DELTA_CHECK_PERIOD == 0) {
+                flushDeltas();
+            }
+            if (applied % EVENT_BATCH_UPDATES == 0) {
+                deliverEvents();
+            }
+        } else {
+            // the lane ran dry, whatever came in is delivered before waiting for more
+            deliverEvents();
+            flushDeltas();
+            std::this_thread::yield();
+        }
+    }
+
+    deliverEvents();
+    if (deltas) {
+        deltas->flush();
+    }
+}
+
+const Instrument *InstrumentShard::find(InstrumentId id) const
+{
+    auto it = instruments.find(id);
+    return it != instruments.end() ? it->second.get() : nullptr;
+}
+
+size_t InstrumentShard::instrumentsNum() const
+{
+    return instruments.size();
+}
+
+std::vector<InstrumentState> InstrumentShard::states() const
+{
+    std::vector<std::pair<InstrumentId, const Instrument *>> current;
+    {
+        std::lock_guard<std::mutex> lock(publishedMutex);
+        current = published;
+    }
+
+    std::vector<InstrumentState> states;
+    states.reserve(current.size());
+    for (const auto& [id, instrument] : current) {
+        // one whose books changed under every read is left to the next round
+        if (auto state = instrument->state(id)) {
+            states.push_back(std::move(*state));
+        }
+    }
+    return states;
+}
+
+void InstrumentShard::restore(const InstrumentState& state)
+{
+    auto& restored = instrument(state.instrument);
+    Events events { {}, *this };
+    restored.apply(state.instrument,
+                   MarketUpdate(MarketUpdate::Side::BID, 0, 0, 0, state.instrument, state.sequence,
+                                MarketUpdate::CLEAR_BOOK),
+                   events);
+    for (const auto& [price, size] : state.bids) {
+        restored.apply(state.instrument,
+                       MarketUpdate(MarketUpdate::Side::BID, price, size, 0, state.instrument, state.sequence,
+                                    MarketUpdate::SNAPSHOT),
+                       events);
+    }
+    for (const auto& [price, size] : state.asks) {
+        restored.apply(state.instrument,
+                       MarketUpdate(MarketUpdate::Side::ASK, price, size, 0, state.instrument, state.sequence,
+                                    MarketUpdate::SNAPSHOT),
+                       events);
+    }
+    restored.tradingEngine.restore(state.engineBids, state.engineAsks);
+}
+
+void InstrumentShard::print(size_t depth) const
+{
+    for (const auto& [id, instrument] : instruments) {
+        std::cout << "======Instrument " << id << "======" << std::endl;
+        instrument->orderBook.print(depth);
+        const auto& features = instrument->analytics.features();
+        std::cout << "Microprice: " << features.microprice << ", imbalance: " << features.imbalance
+                  << ", VWAP to " << vwapSize << ": " << features.bidVwap << " / " << features.askVwap << std::endl;
+        instrument->tradingEngine.print(depth);
+        if (instrument->risk) {
+            instrument->risk->print(std::cout);
+        }
+        for (size_t back = 0; instrument->bars && back < barSpecs.size(); ++back) {
+            auto bar = instrument->bars->last(back);
+            if (bar == nullptr) {
+                break;
+            }
+            std::cout << "Bar " << barSpecs[bar->spec].name() << " at " << bar->start << ": O " << bar->open
+                      << " H " << bar->high << " L " << bar->low << " C " << bar->close << " V " << bar->volume
+                      << " VWAP " << bar->vwap() << " (" << bar->trades << " trades)" << std::endl;
+        }
+    }
+}
+
+InstrumentRegistry::InstrumentRegistry(size_t shardsNum, const ShardConfig& config)
+{
+    shards.reserve(shardsNum);
+    for (size_t i = 0; i < shardsNum; ++i) {
+        shards.push_back(std::make_unique<InstrumentShard>(config, static_cast<uint16_t>(i)));
+    }
+}
+
+InstrumentRegistry::~InstrumentRegistry()
+{
+    join();
+}
+
+void InstrumentRegistry::start(std::atomic<bool>& runFlag)
+{
+    for (auto& shard : shards) {
+        threads.emplace_back(&InstrumentShard::run, shard.get(), std::ref(runFlag));
+    }
+}
+
+void InstrumentRegistry::join()
+{
+    for (auto& t : threads) {
+        t.join();
+    }
+    threads.clear();
+}
+
+const Instrument *InstrumentRegistry::find(InstrumentId id) const
+{
+    return shards[shardOf(id)]->find(id);
+}
+
+uint64_t InstrumentRegistry::updatesProcessed() const
+{
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard->updatesProcessed();
+    }
+    return total;
+}
+
+std::vector<InstrumentState> InstrumentRegistry::states() const
+{
+    std::vector<InstrumentState> states;
+    for (const auto& shard : shards) {
+        auto shardStates = shard->states();
+        states.insert(states.end(), std::make_move_iterator(shardStates.begin()),
+                      std::make_move_iterator(shardStates.end()));
+    }
+    return states;
+}
+
+void InstrumentRegistry::print(size_t depth) const
+{
+    for (const auto& shard : shards) {
+        shard->print(depth);
+    }
+}
+
+} // namespace CryptoTradingInfra
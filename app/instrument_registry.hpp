@@ -0,0 +1,353 @@
+#ifndef CRYPTO_TRADING_INFRA_INSTRUMENT_REGISTRY
+#define CRYPTO_TRADING_INFRA_INSTRUMENT_REGISTRY
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bar_aggregator.hpp"
+#include "book_analytics.hpp"
+#include "delta_feed.hpp"
+#include "depth_publisher.hpp"
+#include "engine_events.hpp"
+#include "execution_engine.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "perf_counters.hpp"
+#include "ring_buffer.hpp"
+#include "risk_gate.hpp"
+#include "seqlock.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr size_t DEFAULT_LANE_SIZE = 262144;
+constexpr size_t DEFAULT_SHARDS_NUM = 4;
+
+// how many updates a busy shard applies between two looks at the clock for flushing deltas
+constexpr uint64_t DELTA_CHECK_PERIOD = 64;
+// most updates whose events are delivered to a subscriber in a single batch
+constexpr uint64_t EVENT_BATCH_UPDATES = 64;
+// most reads of the books of an instrument that may see an update applied before the state of the instrument
+// is given up on for the time being
+constexpr uint64_t STATE_READ_ATTEMPTS = 1024;
+
+// invoked by the thread of a shard with the events of the updates it just applied, the spans only live
+// for the duration of the call
+using EventSubscriber = std::function<void(const EventBatch& batch)>;
+
+// outputs every shard produces besides its books, all of them disabled by default
+struct ShardConfig {
+    // depth of every order book is published into the shared memory segment named after it and the instrument id
+    std::string depthPrefix;
+    // level changes of every order book are sent there, see DeltaFeed
+    std::optional<sockaddr_in> deltas;
+    std::chrono::nanoseconds deltaInterval = DEFAULT_DELTA_INTERVAL;
+    // size the VWAP of every book is computed for
+    Size vwapSize = DEFAULT_VWAP_SIZE;
+    // bars built out of the trades of every instrument, none by default
+    std::vector<BarSpec> bars;
+    // orders of accounts are checked against these before reaching the books, none are by default
+    std::optional<RiskLimits> risk;
+    // nanoseconds TIMED orders rest in the trading engine for, 0 leaving them resting until traded
+    uint64_t orderLifetime = 0;
+    // gets the events of every book, in batches, so it costs one indirect call per batch rather than per event
+    EventSubscriber events;
+};
+
+// books of an instrument as of the update numbered sequence, as kept by checkpoints
+struct InstrumentState {
+    InstrumentId instrument = 0;
+    // 0 when the feed does not sequence the updates of the instrument
+    uint64_t sequence = 0;
+    std::vector<BookState::Item> bids;
+    std::vector<BookState::Item> asks;
+    // orders resting in the trading engine
+    std::vector<BookState::Item> engineBids;
+    std::vector<BookState::Item> engineAsks;
+};
+
+struct Instrument {
+    OrderBook orderBook;
+    // follows orderBook update by update, so features are as fresh as the book
+    BookAnalytics<> analytics;
+    TradingEngine tradingEngine;
+    // only set when depth is published for other processes
+    std::unique_ptr<DepthPublisher<>> depth;
+    // only set when bars are built, fed with the trades of tradingEngine
+    std::unique_ptr<BarAggregator> bars;
+    // only set when orders of accounts are risk checked
+    std::unique_ptr<RiskGate> risk;
+
+    // ties the versions of both books together, so they can be read as of the same update from any thread; the
+    // version of orderBook holds the sequence of that update
+    Utils::SeqLock lock;
+
+    // applies update to the books of instrument id, handler getting every event it causes
+    template <typename Handler>
+    void apply(InstrumentId id, const MarketUpdate& update, Handler& handler)
+    {
+        lock.write([&]() {
+            if (applyBook(id, update, handler)) {
+                match(update, handler);
+            }
+        });
+    }
+
+    // the two halves of apply, for pipelines running them as stages of their own; without the lock, so only
+    // when no other thread reads the books. Returns whether update is a market event tradingEngine must match.
+    template <typename Handler>
+    bool applyBook(InstrumentId id, const MarketUpdate& update, Handler& handler)
+    {
+        // orders of accounts go through the risk gate first, those it rejects reach neither book
+        if (risk && update.account != NO_ACCOUNT && !admit(update)) {
+            return false;
+        }
+
+        Utils::PerfRegion region(Utils::PERF_BOOK_APPLY);
+        if (update.flags & MarketUpdate::CLEAR_BOOK) {
+            for (const auto& level : orderBook.clear(update.sequence)) {
+                publish(id, level, update.timestamp, handler);
+            }
+            return false;
+        }
+        publish(id, orderBook.updateOrderBook(update), update.timestamp, handler);
+        // levels of a snapshot rebuild the book, they are no market event to trade on
+        return (update.flags & MarketUpdate::SNAPSHOT) == 0;
+    }
+
+    template <typename Handler>
+    void match(const MarketUpdate& update, Handler& handler)
+    {
+        Utils::PerfRegion region(Utils::PERF_MATCH);
+        if (bars) {
+            bars->advance(update.timestamp);
+        }
+        Trades<Handler> trades { {}, bars.get(), risk.get(), update.account, handler };
+        tradingEngine.match(update, trades);
+    }
+
+    // both books and the sequence they are at, copied from their published versions so the thread applying
+    // updates never waits for it; nullopt when updates kept being applied during every read of them
+    std::optional<InstrumentState> state(InstrumentId id) const;
+
+private:
+    // hands trades to the bars and the position of the account trading before handler
+    template <typename Handler>
+    struct Trades : EventHandler {
+        BarAggregator *bars;
+        RiskGate *risk;
+        AccountId account;
+        Handler& handler;
+
+        void onTrade(const TradeEvent& trade)
+        {
+            if (bars != nullptr) {
+                bars->onTrade(trade);
+            }
+            if (risk != nullptr && account != NO_ACCOUNT) {
+                risk->onFill(account, trade.side, trade.size);
+            }
+            handler.onTrade(trade);
+        }
+    };
+
+    bool admit(const MarketUpdate& order)
+    {
+        Utils::PerfRegion region(Utils::PERF_RISK_CHECK);
+        auto reason = risk->check(order, Best<MarketUpdate::Side::BID>(), Best<MarketUpdate::Side::ASK>());
+        if (reason != RiskReject::NONE) {
+            risk->reject(order, reason);
+            return false;
+        }
+        return true;
+    }
+
+    template <MarketUpdate::Side Side>
+    BookState::Item Best() const
+    {
+        return analytics.count<Side>() > 0 ? analytics.level<Side>(0) : BookState::Item(0, 0);
+    }
+
+    template <typename Handler>
+    void publish(InstrumentId id, const LevelUpdate& level, uint64_t timestamp, Handler& handler)
+    {
+        auto change = analytics.apply(level, orderBook);
+        if (depth) {
+            depth->publish(analytics, change);
+        }
+
+        handler.onBook({ id, timestamp, level });
+        if (change.changed && change.from == 0) {
+            handler.onBbo({ id, timestamp, Best<MarketUpdate::Side::BID>(), Best<MarketUpdate::Side::ASK>() });
+        }
+    }
+};
+
+/*
+ * A shard owns the books of every instrument routed to it and its thread is the only one touching them,
+ * so no state is shared between shards. Updates reach a shard through its own lane, and the books of an
+ * instrument are created the first time one of its updates is applied. An update flagged CLEAR_BOOK empties
+ * the book, so it can be rebuilt from the SNAPSHOT levels following it.
+ */
+class InstrumentShard
+{
+public:
+    using Lane = Utils::ConcurrentRingBuffer<MarketUpdate, DEFAULT_LANE_SIZE>;
+
+private:
+    Lane lane;
+    std::unordered_map<InstrumentId, std::unique_ptr<Instrument>> instruments;
+    std::string depthPrefix;
+    Size vwapSize;
+    std::vector<BarSpec> barSpecs;
+    std::unique_ptr<BarRing> completedBars;
+    std::optional<RiskLimits> riskLimits;
+    std::unique_ptr<RejectRing> rejectedOrders;
+    uint64_t orderLifetime;
+    std::unique_ptr<DeltaFeed> deltas;
+
+    // events gathered for the subscriber since the last batch was delivered
+    EventSubscriber subscriber;
+    std::vector<BookEvent> books;
+    std::vector<TradeEvent> trades;
+    std::vector<BboEvent> bbos;
+
+    // instruments as they get created, so other threads can reach them without touching the map
+    mutable std::mutex publishedMutex;
+    std::vector<std::pair<InstrumentId, const Instrument *>> published;
+
+    // only written by the shard thread, read by anyone for statistics
+    CACHE_LINE_ALIGNED std::atomic<uint64_t> processed { 0 };
+
+    // what the shard itself does with the events of its books
+    struct Events;
+
+    Instrument& instrument(InstrumentId id);
+    void apply(const MarketUpdate& update);
+    void flushDeltas();
+    void deliverEvents();
+
+public:
+    // index numbers the shard among those of its registry, its deltas going out in the stream of that number
+    explicit InstrumentShard(const ShardConfig& config = {}, uint16_t index = 0);
+
+    InstrumentShard(const InstrumentShard&) = delete;
+    InstrumentShard& operator=(const InstrumentShard&) = delete;
+
+    bool enqueue(const MarketUpdate& update)
+    {
+        return lane.push(update);
+    }
+
+    // updates waiting in the lane, only a snapshot
+    size_t occupancy() const
+    {
+        return lane.occupancy();
+    }
+
+    void run(std::atomic<bool>& runFlag);
+
+    uint64_t updatesProcessed() const
+    {
+        return processed.load(std::memory_order_relaxed);
+    }
+
+    // the books are owned by the shard thread, only look them up from it or once it has stopped
+    const Instrument *find(InstrumentId id) const;
+    size_t instrumentsNum() const;
+
+    // state of every instrument of the shard, safe to take from any thread while the shard runs, but those
+    // whose state could not be read are left out
+    std::vector<InstrumentState> states() const;
+    // rebuilds the books of an instrument, only before the shard runs
+    void restore(const InstrumentState& state);
+
+    // bars completed by the instruments of the shard, nullptr unless bars are built; any thread may drain it
+    BarRing *bars()
+    {
+        return completedBars.get();
+    }
+
+    // orders the risk gates of the shard rejected, nullptr unless orders are risk checked; any thread may drain it
+    RejectRing *rejects()
+    {
+        return rejectedOrders.get();
+    }
+
+    // nullptr unless deltas are sent, same restrictions as the books
+    const DeltaFeed *deltaFeed() const
+    {
+        return deltas.get();
+    }
+
+    void print(size_t depth) const;
+};
+
+/*
+ * Registry of every instrument handled by the engine, split into shards by instrument id. Each shard is
+ * driven by its own thread, so the engine scales with cores as long as instruments are spread evenly.
+ */
+class InstrumentRegistry
+{
+    std::vector<std::unique_ptr<InstrumentShard>> shards;
+    std::vector<std::thread> threads;
+
+public:
+    explicit InstrumentRegistry(size_t shardsNum = DEFAULT_SHARDS_NUM, const ShardConfig& config = {});
+    ~InstrumentRegistry();
+
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    size_t shardsNum() const
+    {
+        return shards.size();
+    }
+
+    size_t shardOf(InstrumentId id) const
+    {
+        return id % shards.size();
+    }
+
+    InstrumentShard& shard(size_t index)
+    {
+        return *shards[index];
+    }
+
+    // returns false when the lane of the instrument's shard is full
+    bool route(const MarketUpdate& update)
+    {
+        return shards[shardOf(update.instrument)]->enqueue(update);
+    }
+
+    // spawns one thread per shard, they keep running until runFlag is cleared and join() is called
+    void start(std::atomic<bool>& runFlag);
+    void join();
+
+    const Instrument *find(InstrumentId id) const;
+    uint64_t updatesProcessed() const;
+
+    // states of every instrument, safe to take from any thread while the shards run, but those whose state
+    // could not be read are left out
+    std::vector<InstrumentState> states() const;
+    // only before the shards are started
+    void restore(const InstrumentState& state)
+    {
+        shards[shardOf(state.instrument)]->restore(state);
+    }
+
+    void print(size_t depth = 5) const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
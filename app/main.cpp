@@ -1,21 +1,24 @@
+#include <chrono>
 #include <cstdint>
 #include <ostream>
 #include <string>
 #include <atomic>
 #include <iostream>
-#include <numeric>
 #include <thread>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <unistd.h>
 #include <cassert>
 #include <csignal>
+#include <memory>
+#include <sstream>
+#include <vector>
 
-#include "math.hpp"
+#include "checkpoint.hpp"
+#include "conflating_router.hpp"
+#include "event_log.hpp"
+#include "instrument_registry.hpp"
+#include "market_update_feed.hpp"
 #include "network.hpp"
-#include "ring_buffer.hpp"
-#include "order_book.hpp"
-#include "execution_engine.hpp"
+#include "perf_counters.hpp"
+#include "snapshot_recovery.hpp"
 
 #if __cplusplus < 201703L
 #error "C++17 standard support required."
@@ -23,110 +26,31 @@
 
 namespace CryptoTradingInfra {
 
-constexpr std::size_t BUFFER_SIZE = 4096000;
-
-using OrderBookBuffer = Utils::ConcurrentRingBuffer<MarketUpdate, BUFFER_SIZE>;
-using TradingEngineBuffer = Utils::ConcurrentRingBuffer<MarketUpdate, BUFFER_SIZE>;
-
-OrderBook g_orderBook;
-TradingEngine g_tradingEngine;
-
-struct PacketStats {
-    uint64_t packetsRecv;
-    uint64_t packetsEnqued;
-    uint64_t packetsDiscarded;
-
-    void print()
-    {
-        std::cout << "Total packets received: " << packetsRecv << "\n"
-                  << "Total packets enqued: " << packetsEnqued << "\n"
-                  << "Total packets Discarded: " << packetsDiscarded << "\n"
-                  << std::flush;
-    }
-};
-
-void ReceiveMarketUpdate(std::atomic<bool>& runFlag, OrderBookBuffer& orderBookBuffer,
-                         TradingEngineBuffer& tradingEngineBuffer, uint16_t port, PacketStats& stats)
-{
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return;
-    }
-
-    sockaddr_in addr {};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port);
-
-    if (bind(sockfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
-        perror("bind");
-        close(sockfd);
-        return;
-    }
-
-    std::cout << "Port " << port << " is listening\n" << std::flush;
-
-    char buffer[MAX_SIZE_BATCH_MARKET_UPDATE];
-    while (runFlag.load(std::memory_order_relaxed)) {
-        auto received = recv(sockfd, buffer, sizeof(buffer), MSG_DONTWAIT);
-        if (received < sizeof(MarketUpdateHeader)) {
-            ++stats.packetsDiscarded;
-            std::this_thread::yield();
-            continue;
-        }
-
-        auto packet = reinterpret_cast<MarketUpdatePacket *>(buffer);
-        auto header = &packet->header;
-        header->ntoh();
-        if (header->protocol != PROTOCOL_MARKET_UPDATE || header->count > MAX_COUNT_MARKET_UPDATE ||
-            received != sizeof(MarketUpdateHeader) + header->count * sizeof(MarketUpdate)) {
-            ++stats.packetsDiscarded;
-            std::this_thread::yield();
-            continue;
-        }
-
-        ++stats.packetsRecv;
-
-        for (auto i = 0; i < header->count; ++i) {
-            packet->updates[i].ntoh();
-            const auto& update = packet->updates[i];
-            while (!orderBookBuffer.emplace(update.side, update.price, update.size, update.timestamp)) {
-                std::this_thread::yield();
-            }
-            while (!tradingEngineBuffer.emplace(update.side, update.price, update.size, update.timestamp)) {
-                std::this_thread::yield();
-            }
-            ++stats.packetsEnqued;
-        }
-    }
-    close(sockfd);
-}
-
-void Publish2OrderBook(std::atomic<bool>& runFlag, OrderBookBuffer& orderBookBuffer, uint64_t& updatesProcessed)
+// applies updates published by a feed handler process into the ring instead of receiving them from the network,
+// attaching again to the ring of a feed handler that restarted once the old one is drained
+void ConsumeFeed(std::atomic<bool>& runFlag, std::unique_ptr<FeedRing>& feed, ConflatingRouter& router,
+                 uint64_t& updatesConsumed)
 {
+    auto checked = std::chrono::steady_clock::now();
     while (runFlag.load(std::memory_order_relaxed)) {
         MarketUpdate update;
-        if (orderBookBuffer.pop(update)) {
-            ++updatesProcessed;
-            g_orderBook.updateOrderBook(update);
-        } else {
+        if (!feed->pop(update)) {
+            router.drain();
+            auto now = std::chrono::steady_clock::now();
+            if (now - checked >= FEED_CHECK_INTERVAL) {
+                checked = now;
+                auto ring = feed->replaced() ? FeedRing::Attach(feed->segmentName()) : nullptr;
+                if (ring) {
+                    feed = std::move(ring);
+                    std::cout << "Attached again to " << feed->segmentName() << "\n" << std::flush;
+                }
+            }
             std::this_thread::yield();
+            continue;
         }
-    }
-}
 
-void Publish2TradingEngine(std::atomic<bool>& runFlag, TradingEngineBuffer& tradingEngineBuffer,
-                           uint64_t& tradesProcessed)
-{
-    while (runFlag.load(std::memory_order_relaxed)) {
-        MarketUpdate update;
-        if (tradingEngineBuffer.pop(update)) {
-            ++tradesProcessed;
-            g_tradingEngine.match(update);
-        } else {
-            std::this_thread::yield();
-        }
+        router.route(update);
+        ++updatesConsumed;
     }
 }
 
@@ -142,67 +66,317 @@ void SignalHandler(int signum)
 int main(int argc, char *argv[])
 {
     auto isValidUdpPort = [](int port) { return port >= 49152 && port <= 65535; };
-    uint16_t port = 49152;
-    if (argc >= 2) {
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " [UDP_PORT] [--line-b UDP_PORT] [--shards N] [--shm NAME] "
+                  << "[--depth PREFIX] [--vwap-size SIZE] [--bars SPEC[,SPEC...]] [--deltas ADDRESS:PORT] "
+                  << "[--recovery ENDPOINT] [--log PATH] [--checkpoint PATH [--warm-start]] [--risk LIMITS] "
+                  << "[--order-lifetime DURATION] [--perf]\n";
+        std::cerr << "UDP_PORT must be between 49152 and 65535 (default is 49152).\n";
+        std::cerr << "With --line-b, the same feed is also received on a second port and the first copy of every "
+                  << "packet is taken.\n";
+        std::cerr << "N is the number of shards instruments are spread across, each run by its own thread "
+                  << "(default is " << CryptoTradingInfra::DEFAULT_SHARDS_NUM << ").\n";
+        std::cerr << "With --shm, updates are consumed from the shared memory ring NAME filled by a feed_handler "
+                  << "process instead of being received on UDP_PORT, the ring being attached to again whenever "
+                  << "the feed_handler restarts.\n";
+        std::cerr << "With --depth, the top " << CryptoTradingInfra::DEFAULT_DEPTH_LEVELS << " levels of every "
+                  << "order book are published into the shared memory segment PREFIX_<instrument id>, along with "
+                  << "microprice, imbalance and the VWAP of taking SIZE from either side (default is "
+                  << CryptoTradingInfra::DEFAULT_VWAP_SIZE << ").\n";
+        std::cerr << "With --bars, bars are built out of the trades of every instrument, SPEC being an interval such "
+                  << "as 250ms, 1s or 1m for time bars or a volume such as 100v for volume bars, up to "
+                  << CryptoTradingInfra::MAX_BAR_SPECS << " of them.\n";
+        std::cerr << "With --deltas, level changes of every order book are sent over UDP to ADDRESS:PORT, "
+                  << "conflated per level every millisecond.\n";
+        std::cerr << "With --recovery, books missing sequenced updates are rebuilt from snapshots fetched from the "
+                  << "server at ENDPOINT, either IPv4:PORT or a unix socket path.\n";
+        std::cerr << "With --log, trades and changes of the best bid or ask of every instrument are appended to the "
+                  << "file at PATH by a background thread.\n";
+        std::cerr << "With --checkpoint, every book is written to the file at PATH every second and on shutdown, and "
+                  << "--warm-start resumes from the books found there instead of starting empty.\n";
+        std::cerr << "With --risk, orders of accounts are checked against LIMITS before reaching the books, LIMITS "
+                  << "being comma separated size=, band=, position=, notional= and rate= limits, such as "
+                  << "size=10,band=0.05,position=100,notional=1e6,rate=1000.\n";
+        std::cerr << "With --order-lifetime, orders flagged TIMED expire from the trading engine DURATION after they "
+                  << "rested by update timestamps, DURATION being an interval such as 250ms, 1s or 1m.\n";
+        std::cerr << "With --perf, hardware counters of the receive, enqueue, risk check, book apply and match stages "
+                  << "are reported on shutdown.\n" << std::flush;
+    };
+
+    std::vector<uint16_t> lines { 49152 };
+    size_t shardsNum = CryptoTradingInfra::DEFAULT_SHARDS_NUM;
+    std::string feedName;
+    std::string recoveryEndpoint;
+    std::string logPath;
+    std::string checkpointPath;
+    bool warmStart = false;
+    CryptoTradingInfra::ShardConfig config;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
         try {
-            auto parsed = std::stoi(argv[1]);
-            if (!isValidUdpPort(parsed)) {
-                std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
-                return 1;
+            if (arg == "--line-b" && i + 1 < argc) {
+                auto parsed = std::stoi(argv[++i]);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines.resize(2);
+                lines[1] = static_cast<uint16_t>(parsed);
+            } else if (arg == "--shards" && i + 1 < argc) {
+                auto parsed = std::stoi(argv[++i]);
+                if (parsed <= 0) {
+                    std::cerr << "Error: At least one shard is required.\n" << std::flush;
+                    return 1;
+                }
+                shardsNum = static_cast<size_t>(parsed);
+            } else if (arg == "--recovery" && i + 1 < argc) {
+                recoveryEndpoint = argv[++i];
+            } else if (arg == "--checkpoint" && i + 1 < argc) {
+                checkpointPath = argv[++i];
+            } else if (arg == "--warm-start") {
+                warmStart = true;
+            } else if (arg == "--risk" && i + 1 < argc) {
+                config.risk = CryptoTradingInfra::RiskLimits::Parse(argv[++i]);
+                if (!config.risk) {
+                    std::cerr << "Error: Risk limits are comma separated size=, band=, position=, notional= and "
+                              << "rate= limits, all of them positive.\n" << std::flush;
+                    return 1;
+                }
+            } else if (arg == "--order-lifetime" && i + 1 < argc) {
+                auto lifetime = CryptoTradingInfra::BarSpec::Parse(argv[++i]);
+                if (!lifetime || lifetime->kind != CryptoTradingInfra::BarSpec::Kind::TIME) {
+                    std::cerr << "Error: The order lifetime is an interval such as 250ms, 1s or 1m.\n" << std::flush;
+                    return 1;
+                }
+                config.orderLifetime = lifetime->interval;
+            } else if (arg == "--perf") {
+                CryptoTradingInfra::Utils::PerfMonitor::Global().enable();
+            } else if (arg == "--log" && i + 1 < argc) {
+                logPath = argv[++i];
+            } else if (arg == "--shm" && i + 1 < argc) {
+                feedName = argv[++i];
+            } else if (arg == "--depth" && i + 1 < argc) {
+                config.depthPrefix = argv[++i];
+            } else if (arg == "--vwap-size" && i + 1 < argc) {
+                config.vwapSize = std::stod(argv[++i]);
+                if (!(config.vwapSize > 0)) {
+                    std::cerr << "Error: The VWAP size must be positive.\n" << std::flush;
+                    return 1;
+                }
+            } else if (arg == "--bars" && i + 1 < argc) {
+                std::stringstream specs(argv[++i]);
+                std::string text;
+                while (std::getline(specs, text, ',')) {
+                    auto spec = CryptoTradingInfra::BarSpec::Parse(text);
+                    if (!spec || config.bars.size() == CryptoTradingInfra::MAX_BAR_SPECS) {
+                        std::cerr << "Error: Bars are up to " << CryptoTradingInfra::MAX_BAR_SPECS
+                                  << " comma separated intervals or volumes.\n" << std::flush;
+                        return 1;
+                    }
+                    config.bars.push_back(*spec);
+                }
+            } else if (arg == "--deltas" && i + 1 < argc) {
+                sockaddr_in deltas;
+                if (!CryptoTradingInfra::Utils::Network::ParseAddress(argv[++i], deltas)) {
+                    std::cerr << "Error: Deltas must be sent to an IPv4 ADDRESS:PORT.\n" << std::flush;
+                    return 1;
+                }
+                config.deltas = deltas;
+            } else {
+                auto parsed = std::stoi(arg);
+                if (!isValidUdpPort(parsed)) {
+                    std::cerr << "Error: You should choose a port between 49152 and 65535.\n" << std::flush;
+                    return 1;
+                }
+                lines[0] = static_cast<uint16_t>(parsed);
             }
-            port = static_cast<uint16_t>(parsed);
         } catch (...) {
-            std::cerr << "Usage: " << argv[0] << " [UDP_PORT]\n";
-            std::cerr << "UDP_PORT must be between 49152 and 65535 (default is 49152).\n" << std::flush;
+            usage();
+            return 1;
+        }
+    }
+
+    if (warmStart && checkpointPath.empty()) {
+        std::cerr << "Error: --warm-start needs the --checkpoint to start from.\n" << std::flush;
+        return 1;
+    }
+
+    std::unique_ptr<CryptoTradingInfra::SnapshotRecovery> recovery;
+    if (!recoveryEndpoint.empty()) {
+        recovery = CryptoTradingInfra::SnapshotRecovery::Create(recoveryEndpoint);
+        if (!recovery) {
+            return 1;
+        }
+        std::cout << "Recovering gaps from snapshots served at " << recoveryEndpoint << "\n" << std::flush;
+    }
+
+    // shard threads only hand records to the log, which must therefore outlive the registry
+    std::unique_ptr<CryptoTradingInfra::Utils::EventLog> log;
+    if (!logPath.empty()) {
+        log = CryptoTradingInfra::Utils::EventLog::Create(logPath);
+        if (!log) {
             return 1;
         }
+        auto trade = log->format("trade of instrument {}: {} @{}, aggressor side {} (0 ask, 1 bid)");
+        auto bbo = log->format("BBO of instrument {}: {} @{} / {} @{}");
+        config.events = [log = log.get(), trade, bbo](const CryptoTradingInfra::EventBatch& batch) {
+            for (const auto& event : batch.trades) {
+                log->write(trade, event.instrument, event.size, event.price, event.side);
+            }
+            for (const auto& event : batch.bbos) {
+                log->write(bbo, event.instrument, event.bid.second, event.bid.first, event.ask.second,
+                           event.ask.first);
+            }
+        };
+        std::cout << "Logging events to " << logPath << "\n" << std::flush;
     }
 
     std::signal(SIGINT, SignalHandler);
-    std::cout << "Engine running. Press Ctrl+C to stop...\n" << std::flush;
+    std::cout << "Engine running with " << shardsNum << " shards. Press Ctrl+C to stop...\n" << std::flush;
+
+    CryptoTradingInfra::InstrumentRegistry registry(shardsNum, config);
+
+    // the books are restored before the shards run, the feed then catches up from the sequence of each of them
+    std::vector<CryptoTradingInfra::InstrumentState> restored;
+    uint64_t restoredNumber = 0;
+    if (warmStart) {
+        auto start = std::chrono::steady_clock::now();
+        if (CryptoTradingInfra::ReadCheckpoint(checkpointPath, restored, restoredNumber)) {
+            for (const auto& state : restored) {
+                registry.restore(state);
+            }
+            std::cout << "Warm start from checkpoint " << restoredNumber << ": " << restored.size()
+                      << " instruments restored in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << "ms\n" << std::flush;
+        } else {
+            std::cout << "Starting with empty books, no checkpoint to resume from\n" << std::flush;
+        }
+    }
 
-    CryptoTradingInfra::OrderBookBuffer orderBookBuffer;
-    constexpr int orderBookPublishersNum = 4;
-    std::vector<std::thread> orderBookPublishers;
-    uint64_t updatesProcessed[orderBookPublishersNum] = { 0 };
-    for (auto i = 0; i < orderBookPublishersNum; ++i) {
-        orderBookPublishers.emplace_back(CryptoTradingInfra::Publish2OrderBook, std::ref(g_runFlag),
-                                         std::ref(orderBookBuffer), std::ref(updatesProcessed[i]));
+    std::unique_ptr<CryptoTradingInfra::Checkpointer> checkpoints;
+    if (!checkpointPath.empty()) {
+        checkpoints = CryptoTradingInfra::Checkpointer::Create(registry, checkpointPath,
+                                                               CryptoTradingInfra::DEFAULT_CHECKPOINT_INTERVAL,
+                                                               restoredNumber);
+        if (!checkpoints) {
+            return 1;
+        }
     }
+    registry.start(g_runFlag);
 
-    CryptoTradingInfra::TradingEngineBuffer tradingEngineBuffer;
-    constexpr int tradingEnginePublishersNum = 4;
-    std::vector<std::thread> tradingEnginePublishers;
-    uint64_t tradesProcessed[tradingEnginePublishersNum] = { 0 };
-    for (auto i = 0; i < tradingEnginePublishersNum; ++i) {
-        tradingEnginePublishers.emplace_back(CryptoTradingInfra::Publish2TradingEngine, std::ref(g_runFlag),
-                                             std::ref(tradingEngineBuffer), std::ref(tradesProcessed[i]));
+    std::unique_ptr<CryptoTradingInfra::FeedRing> feed;
+    if (!feedName.empty()) {
+        feed = CryptoTradingInfra::FeedRing::Attach(feedName);
+        if (!feed) {
+            g_runFlag.store(false);
+            registry.join();
+            return 1;
+        }
+        std::cout << "Consuming MarketUpdates from " << feedName << "\n" << std::flush;
     }
 
     CryptoTradingInfra::PacketStats stats { 0 };
-    std::thread marketUpdatesReceiver(CryptoTradingInfra::ReceiveMarketUpdate, std::ref(g_runFlag),
-                                      std::ref(orderBookBuffer), std::ref(tradingEngineBuffer), port, std::ref(stats));
+    CryptoTradingInfra::FeedArbiter arbiter;
+    CryptoTradingInfra::ConflatingRouter router(registry, CryptoTradingInfra::DEFAULT_HIGH_WATER_MARK, recovery.get());
+    for (const auto& state : restored) {
+        router.resume(state.instrument, state.sequence);
+    }
+    uint64_t updatesConsumed = 0;
+    std::thread marketUpdatesReceiver;
+    if (feed) {
+        marketUpdatesReceiver = std::thread(CryptoTradingInfra::ConsumeFeed, std::ref(g_runFlag), std::ref(feed),
+                                            std::ref(router), std::ref(updatesConsumed));
+    } else {
+        // the receiver never waits for the shards, overloaded lanes get conflated updates instead
+        marketUpdatesReceiver = std::thread([&]() {
+            CryptoTradingInfra::ReceiveMarketUpdate(
+                g_runFlag, lines, stats, arbiter, [&](const auto& update) { router.route(update); },
+                [&]() { router.drain(); });
+        });
+    }
 
+    // stands in for downstream readers of the bars, which only get counted here
+    uint64_t barsRead = 0;
+    auto readBars = [&]() {
+        for (size_t i = 0; i < registry.shardsNum(); ++i) {
+            CryptoTradingInfra::Bar bar;
+            while (registry.shard(i).bars() != nullptr && registry.shard(i).bars()->pop(bar)) {
+                ++barsRead;
+            }
+        }
+    };
+
+    // stands in for downstream readers of the rejects, which get counted by reason
+    uint64_t rejectsRead[static_cast<size_t>(CryptoTradingInfra::RiskReject::REASONS)] = {};
+    auto readRejects = [&]() {
+        for (size_t i = 0; i < registry.shardsNum(); ++i) {
+            CryptoTradingInfra::RejectEvent reject;
+            while (registry.shard(i).rejects() != nullptr && registry.shard(i).rejects()->pop(reject)) {
+                ++rejectsRead[static_cast<size_t>(reject.reason)];
+            }
+        }
+    };
 
     while (g_runFlag.load()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        readBars();
+        readRejects();
     }
 
     marketUpdatesReceiver.join();
-    for (auto& t : orderBookPublishers) {
-        t.join();
-    }
-
-    for (auto& t : tradingEnginePublishers) {
-        t.join();
+    registry.join();
+    readBars();
+    readRejects();
+    if (checkpoints) {
+        auto taken = checkpoints->checkpointsTaken();
+        // its last checkpoint holds the books as the shards left them
+        checkpoints.reset();
+        std::cout << "Total checkpoints written to " << checkpointPath << ": " << taken + 1 << std::endl;
     }
 
     // printing stats
-    stats.print();
-    auto totalUpdatesProcessed = std::accumulate(updatesProcessed, updatesProcessed + orderBookPublishersNum, 0);
-    auto totalTradesProcessed = std::accumulate(tradesProcessed, tradesProcessed + tradingEnginePublishersNum, 0);
-    std::cout << "Total MarketUpdates processed: " << totalUpdatesProcessed << std::endl;
-    std::cout << "Total Trades processed:        " << totalTradesProcessed << std::endl;
-    CryptoTradingInfra::g_orderBook.print();
-    CryptoTradingInfra::g_tradingEngine.print();
+    if (feed) {
+        std::cout << "Total MarketUpdates consumed from " << feedName << ": " << updatesConsumed << std::endl;
+    } else {
+        stats.print();
+        CryptoTradingInfra::PrintFeedLines(lines, arbiter);
+    }
+    const auto& conflation = router.statistics();
+    std::cout << "Total MarketUpdates conflated: " << conflation.conflated << " (" << conflation.staged
+              << " staged under overload, " << router.backlog() << " levels left staged)" << std::endl;
+    std::cout << "Total MarketUpdates missed: " << conflation.gaps << " (" << conflation.recoveries
+              << " recoveries from snapshots, " << router.recovering() << " still in progress)" << std::endl;
+    std::cout << "Total MarketUpdates processed: " << registry.updatesProcessed() << std::endl;
+    if (!config.bars.empty()) {
+        std::cout << "Total bars completed: " << barsRead << std::endl;
+    }
+    if (config.risk) {
+        uint64_t rejected = 0;
+        std::ostringstream reasons;
+        for (size_t reason = 1; reason < static_cast<size_t>(CryptoTradingInfra::RiskReject::REASONS); ++reason) {
+            rejected += rejectsRead[reason];
+            reasons << (reason == 1 ? "" : ", ") << rejectsRead[reason] << " "
+                    << CryptoTradingInfra::RISK_REJECT_NAMES[reason];
+        }
+        std::cout << "Total orders rejected: " << rejected << " (" << reasons.str() << ")" << std::endl;
+    }
+    if (log) {
+        std::cout << "Total events logged: " << log->written() << " (" << log->dropped() << " dropped)" << std::endl;
+    }
+    for (size_t i = 0; i < registry.shardsNum(); ++i) {
+        const auto& shard = registry.shard(i);
+        std::cout << "Shard " << i << ": " << shard.instrumentsNum() << " instruments, " << shard.updatesProcessed()
+                  << " MarketUpdates processed" << std::endl;
+        if (auto deltas = shard.deltaFeed()) {
+            const auto& stats = deltas->statistics();
+            std::cout << "    deltas: " << stats.deltas << " staged, " << stats.conflated << " conflated, "
+                      << stats.sent << " sent in " << stats.packets << " packets, " << deltas->backlog() << " left"
+                      << std::endl;
+        }
+    }
+    if (CryptoTradingInfra::Utils::PerfMonitor::Global().enabled()) {
+        CryptoTradingInfra::Utils::PerfMonitor::Global().print(std::cout);
+    }
+    registry.print();
 }
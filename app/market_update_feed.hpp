@@ -0,0 +1,214 @@
+#ifndef CRYPTO_TRADING_INFRA_MARKET_UPDATE_FEED
+#define CRYPTO_TRADING_INFRA_MARKET_UPDATE_FEED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "feed_messages.hpp"
+#include "market_update.hpp"
+#include "perf_counters.hpp"
+#include "sequence_arbiter.hpp"
+#include "shm_ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+
+// ring shared between the feed handler and engine processes, both sides must agree on its size
+constexpr size_t FEED_RING_SIZE = 262144;
+constexpr const char *DEFAULT_FEED_NAME = "/crypto_trading_infra_feed";
+// how often a consumer finding the ring empty checks whether the feed handler restarted with a new one
+constexpr auto FEED_CHECK_INTERVAL = std::chrono::seconds(1);
+
+using FeedRing = Utils::SharedRingBuffer<MarketUpdate, FEED_RING_SIZE>;
+
+struct PacketStats {
+    uint64_t packetsRecv;
+    uint64_t packetsEnqued;
+    uint64_t packetsDiscarded;
+    uint64_t tradesRecv;
+
+    void print()
+    {
+        std::cout << "Total packets received: " << packetsRecv << "\n"
+                  << "Total packets enqued: " << packetsEnqued << "\n"
+                  << "Total packets Discarded: " << packetsDiscarded << "\n"
+                  << "Total trades received: " << tradesRecv << "\n"
+                  << std::flush;
+    }
+};
+
+using FeedArbiter = Utils::SequenceArbiter<>;
+
+// returns a non-blocking UDP socket bound to port, -1 on failure
+inline int OpenFeedLine(uint16_t port)
+{
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+
+    if (bind(sockfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        perror("bind");
+        close(sockfd);
+        return -1;
+    }
+
+    std::cout << "Port " << port << " is listening\n" << std::flush;
+    return sockfd;
+}
+
+// converts the header of a received packet to host byte order, returns nullptr if it is not a valid packet
+inline MarketUpdatePacket *ParseMarketUpdatePacket(char *buffer, ssize_t received)
+{
+    if (received < static_cast<ssize_t>(sizeof(MarketUpdateHeader))) {
+        return nullptr;
+    }
+
+    auto packet = reinterpret_cast<MarketUpdatePacket *>(buffer);
+    auto header = &packet->header;
+    header->ntoh();
+    if (header->protocol != PROTOCOL_MARKET_UPDATE || header->count > MAX_COUNT_MARKET_UPDATE ||
+        received != static_cast<ssize_t>(sizeof(MarketUpdateHeader) + header->count * sizeof(MarketUpdate))) {
+        return nullptr;
+    }
+    return packet;
+}
+
+// hands every update of a received packet, in either format, to deliver unless arbiter has seen the packet
+// already, returns false if it is not a valid packet
+template <typename Deliver>
+bool DeliverPacket(char *buffer, ssize_t received, size_t line, PacketStats& stats, FeedArbiter& arbiter,
+                   Deliver& deliver)
+{
+    FeedMessagesHeader header;
+    if (ParseFeedMessagesHeader(buffer, received, header)) {
+        ++stats.packetsRecv;
+        if (!arbiter.accept(line, header.sequence)) {
+            return true;
+        }
+
+        auto count = [&](const MarketUpdate& update) {
+            deliver(update);
+            ++stats.packetsEnqued;
+        };
+        FeedMessages::Translator<decltype(count)> translator(header, count);
+        auto handled = FeedMessages::Codec::DispatchAll(buffer + FeedMessages::HEADER_SIZE,
+                                                        received - FeedMessages::HEADER_SIZE, header.count,
+                                                        translator);
+        stats.tradesRecv += translator.trades;
+        // what came before a truncated or unknown message is delivered already, the rest is lost
+        return handled == header.count;
+    }
+
+    auto packet = ParseMarketUpdatePacket(buffer, received);
+    if (packet == nullptr) {
+        return false;
+    }
+
+    ++stats.packetsRecv;
+    if (!arbiter.accept(line, packet->header.sequence)) {
+        return true;
+    }
+
+    for (auto i = 0; i < packet->header.count; ++i) {
+        packet->updates[i].ntoh();
+        deliver(packet->updates[i]);
+        ++stats.packetsEnqued;
+    }
+    return true;
+}
+
+/*
+ * Receives MarketUpdate and feed message packets on every port in lines and hands every update, in host byte
+ * order, to deliver. Lines are redundant copies of the same feed: the first copy of a sequence number to arrive
+ * is delivered, later ones are dropped by arbiter, which also keeps track of gaps and of how often each line
+ * won. idle is invoked whenever no line has anything to receive.
+ *
+ * All lines are polled from the calling thread, so updates are delivered in arrival order.
+ */
+template <typename Deliver, typename Idle>
+void ReceiveMarketUpdate(std::atomic<bool>& runFlag, const std::vector<uint16_t>& lines, PacketStats& stats,
+                         FeedArbiter& arbiter, Deliver&& deliver, Idle&& idle)
+{
+    if (lines.empty() || lines.size() > Utils::MAX_ARBITRATED_LINES) {
+        std::cerr << "Between 1 and " << Utils::MAX_ARBITRATED_LINES << " feed lines are supported.\n" << std::flush;
+        return;
+    }
+
+    std::vector<int> sockets;
+    for (auto port : lines) {
+        auto sockfd = OpenFeedLine(port);
+        if (sockfd < 0) {
+            for (auto opened : sockets) {
+                close(opened);
+            }
+            return;
+        }
+        sockets.push_back(sockfd);
+    }
+
+    alignas(MarketUpdate) char buffer[std::max(MAX_SIZE_BATCH_MARKET_UPDATE, MAX_SIZE_FEED_MESSAGES)];
+    while (runFlag.load(std::memory_order_relaxed)) {
+        bool busy = false;
+        for (size_t line = 0; line < sockets.size(); ++line) {
+            auto received = recv(sockets[line], buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (received < 0) {
+                continue;
+            }
+            busy = true;
+
+            // what deliver takes is charged to the stages it runs
+            Utils::PerfRegion region(Utils::PERF_RECEIVE);
+            if (!DeliverPacket(buffer, received, line, stats, arbiter, deliver)) {
+                ++stats.packetsDiscarded;
+            }
+        }
+
+        if (!busy) {
+            idle();
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto sockfd : sockets) {
+        close(sockfd);
+    }
+}
+
+template <typename Deliver>
+void ReceiveMarketUpdate(std::atomic<bool>& runFlag, const std::vector<uint16_t>& lines, PacketStats& stats,
+                         FeedArbiter& arbiter, Deliver&& deliver)
+{
+    ReceiveMarketUpdate(runFlag, lines, stats, arbiter, std::forward<Deliver>(deliver), []() {});
+}
+
+inline void PrintFeedLines(const std::vector<uint16_t>& lines, const FeedArbiter& arbiter)
+{
+    std::cout << "Packets missing on every line: " << arbiter.gaps() << ", feed started over "
+              << arbiter.restarts() << " times\n";
+    for (size_t line = 0; line < lines.size(); ++line) {
+        auto stats = arbiter.line(line);
+        std::cout << "Line " << static_cast<char>('A' + line) << " (port " << lines[line] << "): " << stats.won
+                  << " packets first, " << stats.duplicates << " duplicates, " << stats.stale << " stale\n";
+    }
+    std::cout << std::flush;
+}
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,66 @@
+#include <sstream>
+
+#include "risk_gate.hpp"
+
+namespace CryptoTradingInfra {
+
+std::optional<RiskLimits> RiskLimits::Parse(const std::string& text)
+{
+    RiskLimits limits;
+    std::stringstream specs(text);
+    std::string spec;
+    size_t parsed = 0;
+    while (std::getline(specs, spec, ',')) {
+        auto equals = spec.find('=');
+        if (equals == std::string::npos) {
+            return std::nullopt;
+        }
+        auto key = spec.substr(0, equals);
+        size_t digits = 0;
+        double value;
+        try {
+            value = std::stod(spec.substr(equals + 1), &digits);
+        } catch (...) {
+            return std::nullopt;
+        }
+        if (digits != spec.size() - equals - 1 || !(value > 0)) {
+            return std::nullopt;
+        }
+
+        if (key == "size") {
+            limits.maxOrderSize = value;
+        } else if (key == "band") {
+            limits.priceBand = value;
+        } else if (key == "position") {
+            limits.maxPosition = value;
+        } else if (key == "notional") {
+            limits.maxNotional = value;
+        } else if (key == "rate") {
+            limits.ordersPerSecond = value;
+        } else {
+            return std::nullopt;
+        }
+        ++parsed;
+    }
+    if (parsed == 0) {
+        return std::nullopt;
+    }
+    return limits;
+}
+
+void RiskGate::print(std::ostream& out) const
+{
+    for (AccountId id = 1; id < RISK_ACCOUNTS; ++id) {
+        if (accepted(id) == 0 && rejected(id) == 0) {
+            continue;
+        }
+        out << "Account " << id << ": position " << position(id) << ", " << accepted(id) << " orders accepted, "
+            << rejected(id) << " rejected\n";
+    }
+    if (rejectsDropped() > 0) {
+        out << rejectsDropped() << " rejects dropped, nobody drained them\n";
+    }
+    out << std::flush;
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,215 @@
+#ifndef CRYPTO_TRADING_INFRA_RISK_GATE
+#define CRYPTO_TRADING_INFRA_RISK_GATE
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "book_state.hpp"
+#include "market_update.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+
+// accounts every instrument keeps risk for, ids going from 1 to RISK_ACCOUNTS - 1
+constexpr size_t RISK_ACCOUNTS = 256;
+// rejected orders waiting for downstream readers, per shard
+constexpr size_t REJECT_RING_SIZE = 16384;
+
+// limits every account is held to on every instrument, none by default
+struct RiskLimits {
+    static constexpr double NONE = std::numeric_limits<double>::infinity();
+
+    Size maxOrderSize = NONE;
+    // fraction orders may be priced beyond the best bid and ask by, 0.05 letting them through either by 5%
+    double priceBand = NONE;
+    // largest position, long or short, the account would be left with if the order filled in full
+    Size maxPosition = NONE;
+    // largest value of that position at the price of the order
+    double maxNotional = NONE;
+    // orders per second of update timestamps, in bursts of up to as many orders
+    double ordersPerSecond = NONE;
+
+    // comma separated limits such as "size=10,band=0.05,position=100,notional=1e6,rate=1000", nullopt if text
+    // holds anything else or a limit that is not positive
+    static std::optional<RiskLimits> Parse(const std::string& text);
+};
+
+enum class RiskReject : uint8_t {
+    NONE,
+    // account id beyond RISK_ACCOUNTS
+    ACCOUNT,
+    ORDER_SIZE,
+    PRICE_BAND,
+    POSITION,
+    NOTIONAL,
+    RATE,
+    REASONS,
+};
+
+constexpr const char *RISK_REJECT_NAMES[static_cast<size_t>(RiskReject::REASONS)] = {
+    "none", "account", "order size", "price band", "position", "notional", "rate"
+};
+
+// an order the risk gate kept from the books
+struct RejectEvent {
+    InstrumentId instrument;
+    AccountId account;
+    RiskReject reason;
+    MarketUpdate::Side side;
+    uint64_t timestamp;
+    Price price;
+    Size size;
+};
+
+using RejectRing = Utils::ConcurrentRingBuffer<RejectEvent, REJECT_RING_SIZE>;
+
+/*
+ * Pre-trade checks of the orders of one instrument, run by the thread applying its updates before an order
+ * reaches the books. A check is a handful of comparisons against the account's own counters and the best bid
+ * and ask, with no lock, allocation or system call. Positions follow the trades of the engine, the aggressor
+ * being the account of the order. Each account has its counters on a cache line of its own, written by the
+ * applying thread alone and readable from any other. Rejected orders go to a ring shared by the instruments
+ * of a shard and are counted as dropped when nobody drains it, so rejecting never waits.
+ *
+ * Limits hold per instrument: positions of an account on different instruments are not netted. Orders left
+ * resting in the engine are not attributed to their account, only what they traded when they came in.
+ */
+class RiskGate
+{
+    struct CACHE_LINE_ALIGNED Account {
+        std::atomic<Size> position { 0 };
+        std::atomic<uint64_t> accepted { 0 };
+        std::atomic<uint64_t> rejected { 0 };
+        // token bucket of the rate limit, only touched by the applying thread
+        double tokens = 0;
+        uint64_t refilled = 0;
+        bool started = false;
+    };
+
+    InstrumentId instrument;
+    RiskLimits limits;
+    std::unique_ptr<Account[]> accounts;
+    RejectRing *out;
+    std::atomic<uint64_t> dropped { 0 };
+
+    static void Increment(std::atomic<uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // takes a token for an order sent at timestamp, the bucket refilling at the rate limit up to a second of it
+    bool take(Account& account, uint64_t timestamp)
+    {
+        if (!account.started) {
+            account.started = true;
+            account.tokens = limits.ordersPerSecond;
+        } else if (timestamp > account.refilled) {
+            account.tokens = std::min(limits.ordersPerSecond,
+                                      account.tokens + (timestamp - account.refilled) * limits.ordersPerSecond / 1e9);
+        }
+        account.refilled = std::max(account.refilled, timestamp);
+        if (account.tokens < 1) {
+            return false;
+        }
+        account.tokens -= 1;
+        return true;
+    }
+
+public:
+    // rejects go to out, unless it is nullptr
+    RiskGate(InstrumentId instrument, const RiskLimits& limits, RejectRing *out = nullptr)
+        : instrument(instrument), limits(limits), accounts(new Account[RISK_ACCOUNTS]), out(out)
+    {
+    }
+
+    RiskGate(const RiskGate&) = delete;
+    RiskGate& operator=(const RiskGate&) = delete;
+
+    // whether order may reach the books with the best bid and ask as they are, a reason to reject it otherwise;
+    // only the applying thread may check
+    RiskReject check(const MarketUpdate& order, BookState::Item bid, BookState::Item ask)
+    {
+        if (order.account >= RISK_ACCOUNTS) {
+            return RiskReject::ACCOUNT;
+        }
+        auto& account = accounts[order.account];
+        auto reason = RiskReject::NONE;
+        auto position = account.position.load(std::memory_order_relaxed) +
+                        (order.side == MarketUpdate::Side::BID ? order.size : -order.size);
+        if (order.size > limits.maxOrderSize) {
+            reason = RiskReject::ORDER_SIZE;
+        } else if ((bid.second > 0 && order.price < bid.first * (1 - limits.priceBand)) ||
+                   (ask.second > 0 && order.price > ask.first * (1 + limits.priceBand))) {
+            reason = RiskReject::PRICE_BAND;
+        } else if (std::fabs(position) > limits.maxPosition) {
+            reason = RiskReject::POSITION;
+        } else if (std::fabs(position) * order.price > limits.maxNotional) {
+            reason = RiskReject::NOTIONAL;
+        } else if (limits.ordersPerSecond != RiskLimits::NONE && !take(account, order.timestamp)) {
+            reason = RiskReject::RATE;
+        }
+        Increment(reason == RiskReject::NONE ? account.accepted : account.rejected);
+        return reason;
+    }
+
+    // hands order to the readers of rejects
+    void reject(const MarketUpdate& order, RiskReject reason)
+    {
+        if (out == nullptr || !out->push(RejectEvent { instrument, order.account, reason, order.side, order.timestamp,
+                                                       order.price, order.size })) {
+            Increment(dropped);
+        }
+    }
+
+    // account traded size as the aggressor on side
+    void onFill(AccountId id, MarketUpdate::Side side, Size size)
+    {
+        if (id < RISK_ACCOUNTS) {
+            auto& position = accounts[id].position;
+            position.store(position.load(std::memory_order_relaxed) + (side == MarketUpdate::Side::BID ? size : -size),
+                           std::memory_order_relaxed);
+        }
+    }
+
+    const RiskLimits& riskLimits() const
+    {
+        return limits;
+    }
+
+    // counters of an account, safe to read from any thread
+    Size position(AccountId id) const
+    {
+        return id < RISK_ACCOUNTS ? accounts[id].position.load(std::memory_order_relaxed) : 0;
+    }
+
+    uint64_t accepted(AccountId id) const
+    {
+        return id < RISK_ACCOUNTS ? accounts[id].accepted.load(std::memory_order_relaxed) : 0;
+    }
+
+    uint64_t rejected(AccountId id) const
+    {
+        return id < RISK_ACCOUNTS ? accounts[id].rejected.load(std::memory_order_relaxed) : 0;
+    }
+
+    // rejects that found the ring full
+    uint64_t rejectsDropped() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    // accounts that sent orders, with their position and counts
+    void print(std::ostream& out) const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
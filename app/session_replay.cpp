@@ -0,0 +1,127 @@
+#include "session_replay.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "engine_events.hpp"
+#include "tick_store.hpp"
+
+namespace CryptoTradingInfra {
+
+namespace {
+
+// updates a capture is read by at once
+constexpr size_t CAPTURE_BATCH = 4096;
+
+struct TradeCounter : EventHandler {
+    ReplayResult& result;
+
+    explicit TradeCounter(ReplayResult& result) : result(result)
+    {
+    }
+
+    void onTrade(const TradeEvent& trade)
+    {
+        ++result.trades;
+        result.volume += trade.size;
+    }
+};
+
+bool IsTickStore(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    TickStoreHeader header {};
+    return file.read(reinterpret_cast<char *>(&header), sizeof(header)) && header.magic == TICK_STORE_MAGIC;
+}
+
+} // namespace
+
+void SessionReplay::apply(const MarketUpdate *updates, size_t count)
+{
+    TradeCounter trades(stats);
+    size_t begin = 0;
+    for (size_t i = 1; i <= count; ++i) {
+        if (i < count && updates[i].instrument == updates[begin].instrument) {
+            continue;
+        }
+        auto& instrument = books[updates[begin].instrument];
+        if (!instrument) {
+            instrument = std::make_unique<Books>();
+        }
+        instrument->orderBook.updateOrderBook(updates + begin, i - begin);
+        instrument->tradingEngine.match(updates + begin, i - begin, trades);
+        begin = i;
+    }
+    stats.updates += count;
+}
+
+bool SessionReplay::replayStore(const ReplayJob& job)
+{
+    auto reader = TickStoreReader::Open(job.path);
+    if (!reader) {
+        return false;
+    }
+    if (!reader->replay([&](const MarketUpdate *updates, size_t count) { apply(updates, count); }, job.from, job.to)) {
+        std::fprintf(stderr, "%s: damaged chunk\n", job.path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SessionReplay::replayCapture(const ReplayJob& job)
+{
+    std::ifstream capture(job.path, std::ios::binary);
+    if (!capture) {
+        std::fprintf(stderr, "%s: cannot be opened\n", job.path.c_str());
+        return false;
+    }
+
+    std::vector<MarketUpdate> batch(CAPTURE_BATCH);
+    bool whole = true;
+    while (capture) {
+        capture.read(reinterpret_cast<char *>(batch.data()), batch.size() * sizeof(MarketUpdate));
+        auto count = static_cast<size_t>(capture.gcount()) / sizeof(MarketUpdate);
+        // batches are read whole records at a time, only the end of a capture cut short leaves bytes over
+        whole = whole && static_cast<size_t>(capture.gcount()) % sizeof(MarketUpdate) == 0;
+
+        // the updates within range are moved to the front, keeping their order
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].ntoh();
+            if (batch[i].timestamp >= job.from && batch[i].timestamp <= job.to) {
+                batch[kept++] = batch[i];
+            }
+        }
+        apply(batch.data(), kept);
+    }
+    if (!whole) {
+        std::fprintf(stderr, "%s: ends within an update\n", job.path.c_str());
+    }
+    return whole;
+}
+
+ReplayResult SessionReplay::run(const ReplayJob& job)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto complete = IsTickStore(job.path) ? replayStore(job) : replayCapture(job);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    stats.instruments = books.size();
+    stats.seconds += elapsed.count();
+    stats.complete = complete;
+    return stats;
+}
+
+void SessionReplay::print() const
+{
+    for (const auto& [id, instrument] : books) {
+        std::cout << "Instrument " << id << ":\n";
+        instrument->orderBook.print();
+        instrument->tradingEngine.print();
+    }
+}
+
+} // namespace CryptoTradingInfra
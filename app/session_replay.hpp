@@ -0,0 +1,68 @@
+#ifndef CRYPTO_TRADING_INFRA_SESSION_REPLAY
+#define CRYPTO_TRADING_INFRA_SESSION_REPLAY
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "execution_engine.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+
+namespace CryptoTradingInfra {
+
+// the updates timestamped within [from, to] of a tick store or of a capture of MarketUpdates in network byte order
+struct ReplayJob {
+    std::string path;
+    uint64_t from = 0;
+    uint64_t to = std::numeric_limits<uint64_t>::max();
+};
+
+struct ReplayResult {
+    uint64_t updates = 0;
+    size_t instruments = 0;
+    uint64_t trades = 0;
+    Size volume = 0;
+    double seconds = 0;
+    // false if the file could not be read to the end
+    bool complete = false;
+};
+
+/*
+ * Replays a recorded session through an OrderBook and a TradingEngine per instrument owned by the replay alone,
+ * so any number of sessions can be replayed side by side. Runs of updates of the same instrument are applied as
+ * one batch.
+ */
+class SessionReplay
+{
+    struct Books {
+        OrderBook orderBook;
+        TradingEngine tradingEngine;
+    };
+
+    std::map<InstrumentId, std::unique_ptr<Books>> books;
+    ReplayResult stats;
+
+    void apply(const MarketUpdate *updates, size_t count);
+    bool replayStore(const ReplayJob& job);
+    bool replayCapture(const ReplayJob& job);
+
+public:
+    // tells tick stores from captures by their header
+    ReplayResult run(const ReplayJob& job);
+
+    const ReplayResult& result() const
+    {
+        return stats;
+    }
+
+    // books and engines of every instrument
+    void print() const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
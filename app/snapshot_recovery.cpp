@@ -0,0 +1,85 @@
+#include <iterator>
+
+#include "snapshot_recovery.hpp"
+
+namespace CryptoTradingInfra {
+
+SnapshotRecovery::SnapshotRecovery(std::unique_ptr<SnapshotClient> client) : client(std::move(client))
+{
+    worker = std::thread(&SnapshotRecovery::run, this);
+}
+
+std::unique_ptr<SnapshotRecovery> SnapshotRecovery::Create(const std::string& endpoint)
+{
+    auto client = SnapshotClient::Create(endpoint);
+    if (!client) {
+        return nullptr;
+    }
+    return std::unique_ptr<SnapshotRecovery>(new SnapshotRecovery(std::move(client)));
+}
+
+SnapshotRecovery::~SnapshotRecovery()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    worker.join();
+}
+
+void SnapshotRecovery::request(InstrumentId instrument)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(instrument);
+    }
+    ++requested;
+    wakeup.notify_one();
+}
+
+bool SnapshotRecovery::collect(std::vector<BookSnapshot>& snapshots)
+{
+    if (ready.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    collected += fetched.size();
+    snapshots.insert(snapshots.end(), std::make_move_iterator(fetched.begin()), std::make_move_iterator(fetched.end()));
+    fetched.clear();
+    ready.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void SnapshotRecovery::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this]() { return stopping || !requests.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        auto instrument = requests.front();
+        requests.pop_front();
+        lock.unlock();
+
+        BookSnapshot snapshot;
+        bool done = client->fetch(instrument, snapshot);
+        if (!done) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(SNAPSHOT_RETRY_INTERVAL);
+        }
+
+        lock.lock();
+        if (done) {
+            fetched.push_back(std::move(snapshot));
+            ready.store(fetched.size(), std::memory_order_release);
+        } else {
+            requests.push_back(instrument);
+        }
+    }
+}
+
+} // namespace CryptoTradingInfra
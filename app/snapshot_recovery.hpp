@@ -0,0 +1,79 @@
+#ifndef CRYPTO_TRADING_INFRA_SNAPSHOT_RECOVERY
+#define CRYPTO_TRADING_INFRA_SNAPSHOT_RECOVERY
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market_update.hpp"
+#include "snapshot_service.hpp"
+
+namespace CryptoTradingInfra {
+
+// pause before asking again once the snapshot server could not be reached
+constexpr auto SNAPSHOT_RETRY_INTERVAL = std::chrono::milliseconds(10);
+
+/*
+ * Fetches book snapshots from a SnapshotServer on a thread of its own, so the thread requesting them never
+ * waits on the network. A snapshot that cannot be fetched is asked for again until it is.
+ */
+class SnapshotRecovery
+{
+public:
+    struct Stats {
+        uint64_t requested;
+        uint64_t fetched;
+        uint64_t failures;
+    };
+
+private:
+    std::unique_ptr<SnapshotClient> client;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<InstrumentId> requests;
+    std::vector<BookSnapshot> fetched;
+    bool stopping = false;
+
+    // lets the requesting thread skip the mutex while nothing was fetched
+    std::atomic<size_t> ready { 0 };
+    std::atomic<uint64_t> failures { 0 };
+    uint64_t requested = 0;
+    uint64_t collected = 0;
+
+    std::thread worker;
+
+    explicit SnapshotRecovery(std::unique_ptr<SnapshotClient> client);
+
+    void run();
+
+public:
+    // endpoint is "IPv4:PORT" or a unix socket path, returns nullptr if it is neither
+    static std::unique_ptr<SnapshotRecovery> Create(const std::string& endpoint);
+    ~SnapshotRecovery();
+
+    SnapshotRecovery(const SnapshotRecovery&) = delete;
+    SnapshotRecovery& operator=(const SnapshotRecovery&) = delete;
+
+    void request(InstrumentId instrument);
+
+    // moves the snapshots fetched since the last call to the back of snapshots, returns false if there were none
+    bool collect(std::vector<BookSnapshot>& snapshots);
+
+    // only meant to be called from the requesting thread
+    Stats statistics() const
+    {
+        return { requested, collected, failures.load(std::memory_order_relaxed) };
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
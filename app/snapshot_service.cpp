@@ -0,0 +1,317 @@
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "network.hpp"
+#include "snapshot_service.hpp"
+
+namespace CryptoTradingInfra {
+
+namespace {
+
+// how long the server thread waits for a connection before checking whether it should stop
+constexpr int SERVER_POLL_MS = 100;
+
+bool SendAll(int sockfd, const void *data, size_t length)
+{
+    auto bytes = static_cast<const char *>(data);
+    while (length > 0) {
+        auto sent = send(sockfd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+bool ReceiveAll(int sockfd, void *data, size_t length)
+{
+    auto bytes = static_cast<char *>(data);
+    while (length > 0) {
+        auto received = recv(sockfd, bytes, length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        length -= received;
+    }
+    return true;
+}
+
+void PackLevels(const std::vector<BookState::Item>& levels, std::vector<SnapshotLevel>& packed)
+{
+    for (const auto& [price, size] : levels) {
+        packed.push_back({ Utils::Network::Hton64(price), Utils::Network::Hton64(size) });
+    }
+}
+
+bool ReceiveLevels(int sockfd, uint32_t count, std::vector<BookState::Item>& levels)
+{
+    std::vector<SnapshotLevel> packed(count);
+    if (!ReceiveAll(sockfd, packed.data(), count * sizeof(SnapshotLevel))) {
+        return false;
+    }
+    levels.clear();
+    for (const auto& level : packed) {
+        levels.emplace_back(Utils::Network::Ntoh64(level.price), Utils::Network::Ntoh64(level.size));
+    }
+    return true;
+}
+
+} // namespace
+
+void SnapshotCache::apply(const MarketUpdate& update)
+{
+    Book *book;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = books[update.instrument];
+        if (!entry) {
+            entry = std::make_unique<Book>();
+        }
+        book = entry.get();
+    }
+
+    book->lock.write([&]() {
+        book->orderBook.updateOrderBook(update);
+        book->sequence.store(update.sequence, std::memory_order_relaxed);
+    });
+}
+
+BookSnapshot SnapshotCache::snapshot(InstrumentId instrument) const
+{
+    BookSnapshot snapshot;
+    snapshot.instrument = instrument;
+
+    const Book *book;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = books.find(instrument);
+        if (it == books.end()) {
+            return snapshot;
+        }
+        book = it->second.get();
+    }
+
+    book->lock.read([&]() {
+        snapshot.sequence = book->sequence.load(std::memory_order_relaxed);
+        book->orderBook.read([&](const BookState& state) {
+            snapshot.bids.clear();
+            snapshot.asks.clear();
+            for (const auto& [price, size] : state.bidsNAsks.bids) {
+                snapshot.bids.emplace_back(price, size);
+            }
+            for (const auto& [price, size] : state.bidsNAsks.asks) {
+                snapshot.asks.emplace_back(price, size);
+            }
+        });
+    });
+    return snapshot;
+}
+
+SnapshotServer::SnapshotServer(int listenfd, std::string unixPath, Provider provider)
+    : listenfd(listenfd), unixPath(std::move(unixPath)), provider(std::move(provider))
+{
+    thread = std::thread(&SnapshotServer::serve, this);
+}
+
+std::unique_ptr<SnapshotServer> SnapshotServer::Create(const std::string& endpoint, Provider provider)
+{
+    sockaddr_storage addr;
+    socklen_t length;
+    if (!Utils::Network::ParseEndpoint(endpoint, addr, length)) {
+        std::cerr << "Snapshot endpoint " << endpoint << " is neither IPv4:PORT nor a unix socket path\n"
+                  << std::flush;
+        return nullptr;
+    }
+
+    int listenfd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (listenfd < 0) {
+        perror("socket");
+        return nullptr;
+    }
+
+    std::string unixPath;
+    if (addr.ss_family == AF_UNIX) {
+        // a socket file left behind by a previous run would make bind fail
+        unixPath = endpoint;
+        unlink(unixPath.c_str());
+    } else {
+        int reuse = 1;
+        setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+
+    if (bind(listenfd, reinterpret_cast<sockaddr *>(&addr), length) < 0 || listen(listenfd, SOMAXCONN) < 0) {
+        perror("bind");
+        close(listenfd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<SnapshotServer>(new SnapshotServer(listenfd, std::move(unixPath), std::move(provider)));
+}
+
+SnapshotServer::~SnapshotServer()
+{
+    running.store(false);
+    thread.join();
+    close(listenfd);
+    if (!unixPath.empty()) {
+        unlink(unixPath.c_str());
+    }
+}
+
+// serves one request, returns false once the connection should be closed
+bool SnapshotServer::answer(int sockfd)
+{
+    SnapshotRequest request;
+    if (!ReceiveAll(sockfd, &request, sizeof(request))) {
+        return false;
+    }
+    request.ntoh();
+    if (request.protocol != PROTOCOL_SNAPSHOT_REQUEST) {
+        return false;
+    }
+
+    auto snapshot = provider(request.instrument);
+
+    SnapshotHeader header { PROTOCOL_SNAPSHOT, 0, request.instrument, snapshot.sequence,
+                            static_cast<uint32_t>(snapshot.bids.size()), static_cast<uint32_t>(snapshot.asks.size()) };
+    header.hton();
+
+    std::vector<SnapshotLevel> levels;
+    levels.reserve(snapshot.bids.size() + snapshot.asks.size());
+    PackLevels(snapshot.bids, levels);
+    PackLevels(snapshot.asks, levels);
+
+    return SendAll(sockfd, &header, sizeof(header)) &&
+           SendAll(sockfd, levels.data(), levels.size() * sizeof(SnapshotLevel));
+}
+
+void SnapshotServer::serve()
+{
+    std::vector<pollfd> fds { { listenfd, POLLIN, 0 } };
+    while (running.load(std::memory_order_relaxed)) {
+        if (poll(fds.data(), fds.size(), SERVER_POLL_MS) <= 0) {
+            continue;
+        }
+
+        for (size_t i = fds.size(); i-- > 1;) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) == 0 || !answer(fds[i].fd)) {
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int sockfd = accept(listenfd, nullptr, nullptr);
+            if (sockfd >= 0) {
+                fds.push_back({ sockfd, POLLIN, 0 });
+            }
+        }
+    }
+
+    for (size_t i = 1; i < fds.size(); ++i) {
+        close(fds[i].fd);
+    }
+}
+
+SnapshotClient::SnapshotClient(const sockaddr_storage& endpoint, socklen_t length, std::chrono::milliseconds timeout)
+    : endpoint(endpoint), length(length), timeout(timeout)
+{
+}
+
+std::unique_ptr<SnapshotClient> SnapshotClient::Create(const std::string& endpoint, std::chrono::milliseconds timeout)
+{
+    sockaddr_storage addr;
+    socklen_t length;
+    if (!Utils::Network::ParseEndpoint(endpoint, addr, length)) {
+        std::cerr << "Snapshot endpoint " << endpoint << " is neither IPv4:PORT nor a unix socket path\n"
+                  << std::flush;
+        return nullptr;
+    }
+    return std::make_unique<SnapshotClient>(addr, length, timeout);
+}
+
+SnapshotClient::~SnapshotClient()
+{
+    disconnect();
+}
+
+bool SnapshotClient::connect()
+{
+    if (sockfd >= 0) {
+        return true;
+    }
+
+    sockfd = socket(endpoint.ss_family, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return false;
+    }
+
+    timeval tv {};
+    tv.tv_sec = timeout.count() / 1000;
+    tv.tv_usec = (timeout.count() % 1000) * 1000;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (::connect(sockfd, reinterpret_cast<const sockaddr *>(&endpoint), length) < 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotClient::disconnect()
+{
+    if (sockfd >= 0) {
+        close(sockfd);
+        sockfd = -1;
+    }
+}
+
+bool SnapshotClient::fetch(InstrumentId instrument, BookSnapshot& snapshot)
+{
+    if (!connect()) {
+        return false;
+    }
+
+    SnapshotRequest request { PROTOCOL_SNAPSHOT_REQUEST, 0, instrument };
+    request.hton();
+
+    SnapshotHeader header;
+    if (!SendAll(sockfd, &request, sizeof(request)) || !ReceiveAll(sockfd, &header, sizeof(header))) {
+        disconnect();
+        return false;
+    }
+
+    header.ntoh();
+    if (header.protocol != PROTOCOL_SNAPSHOT || header.instrument != instrument ||
+        header.bids > MAX_SNAPSHOT_LEVELS || header.asks > MAX_SNAPSHOT_LEVELS ||
+        !ReceiveLevels(sockfd, header.bids, snapshot.bids) || !ReceiveLevels(sockfd, header.asks, snapshot.asks)) {
+        // whatever is left of the answer would be taken for the next one
+        disconnect();
+        return false;
+    }
+
+    snapshot.instrument = instrument;
+    snapshot.sequence = header.sequence;
+    return true;
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,171 @@
+#ifndef CRYPTO_TRADING_INFRA_SNAPSHOT_SERVICE
+#define CRYPTO_TRADING_INFRA_SNAPSHOT_SERVICE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+
+#include "book_state.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "seqlock.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr uint16_t PROTOCOL_SNAPSHOT_REQUEST = 0x6668;
+constexpr uint16_t PROTOCOL_SNAPSHOT = 0x6669;
+
+// a snapshot announcing more levels than this is taken as garbage
+constexpr uint32_t MAX_SNAPSHOT_LEVELS = 1 << 20;
+constexpr auto DEFAULT_SNAPSHOT_TIMEOUT = std::chrono::milliseconds(500);
+
+#pragma pack(1)
+struct SnapshotRequest {
+    uint16_t protocol;
+    uint16_t resv;
+    InstrumentId instrument;
+
+    void hton()
+    {
+        protocol = htons(protocol);
+        instrument = htonl(instrument);
+    }
+
+    void ntoh()
+    {
+        protocol = ntohs(protocol);
+        instrument = ntohl(instrument);
+    }
+};
+
+// followed by bids then asks levels, both from the best one on
+struct SnapshotHeader {
+    uint16_t protocol;
+    uint16_t resv;
+    InstrumentId instrument;
+    uint64_t sequence;
+    uint32_t bids;
+    uint32_t asks;
+
+    void hton()
+    {
+        protocol = htons(protocol);
+        instrument = htonl(instrument);
+        sequence = Utils::Network::Hton64(sequence);
+        bids = htonl(bids);
+        asks = htonl(asks);
+    }
+
+    void ntoh()
+    {
+        protocol = ntohs(protocol);
+        instrument = ntohl(instrument);
+        sequence = Utils::Network::Ntoh64(sequence);
+        bids = ntohl(bids);
+        asks = ntohl(asks);
+    }
+};
+
+struct SnapshotLevel {
+    Price price;
+    Size size;
+};
+#pragma pack()
+
+struct BookSnapshot {
+    InstrumentId instrument = 0;
+    // sequence of the last update included, 0 for a book nothing happened to yet
+    uint64_t sequence = 0;
+    std::vector<BookState::Item> bids;
+    std::vector<BookState::Item> asks;
+};
+
+/*
+ * Books of every instrument along with the sequence of the last update applied, kept by whoever serves
+ * snapshots. Updates are applied by a single thread, snapshots may be taken from any other.
+ */
+class SnapshotCache
+{
+    struct Book {
+        Utils::SeqLock lock;
+        OrderBook orderBook;
+        std::atomic<uint64_t> sequence { 0 };
+    };
+
+    // only guards the map, books are read under their seqlock
+    mutable std::mutex mutex;
+    std::unordered_map<InstrumentId, std::unique_ptr<Book>> books;
+
+public:
+    void apply(const MarketUpdate& update);
+    BookSnapshot snapshot(InstrumentId instrument) const;
+};
+
+/*
+ * Serves book snapshots over a stream socket, either TCP or unix domain. A client sends a SnapshotRequest
+ * and gets a SnapshotHeader followed by the levels back, as many times as it likes over one connection.
+ * Every connection is handled by the single thread of the server.
+ */
+class SnapshotServer
+{
+public:
+    using Provider = std::function<BookSnapshot(InstrumentId)>;
+
+private:
+    int listenfd;
+    std::string unixPath;
+    Provider provider;
+    std::atomic<bool> running { true };
+    std::thread thread;
+
+    SnapshotServer(int listenfd, std::string unixPath, Provider provider);
+
+    void serve();
+    bool answer(int sockfd);
+
+public:
+    // endpoint is "IPv4:PORT" or a unix socket path, returns nullptr if it cannot be listened on
+    static std::unique_ptr<SnapshotServer> Create(const std::string& endpoint, Provider provider);
+    ~SnapshotServer();
+
+    SnapshotServer(const SnapshotServer&) = delete;
+    SnapshotServer& operator=(const SnapshotServer&) = delete;
+};
+
+// blocking client of a SnapshotServer, reconnecting whenever the connection was lost
+class SnapshotClient
+{
+    sockaddr_storage endpoint;
+    socklen_t length;
+    std::chrono::milliseconds timeout;
+    int sockfd = -1;
+
+    bool connect();
+    void disconnect();
+
+public:
+    SnapshotClient(const sockaddr_storage& endpoint, socklen_t length,
+                   std::chrono::milliseconds timeout = DEFAULT_SNAPSHOT_TIMEOUT);
+    // returns nullptr if endpoint is neither "IPv4:PORT" nor a unix socket path
+    static std::unique_ptr<SnapshotClient> Create(const std::string& endpoint,
+                                                  std::chrono::milliseconds timeout = DEFAULT_SNAPSHOT_TIMEOUT);
+    ~SnapshotClient();
+
+    SnapshotClient(const SnapshotClient&) = delete;
+    SnapshotClient& operator=(const SnapshotClient&) = delete;
+
+    // returns false if the server cannot be reached, does not answer in time or answers garbage
+    bool fetch(InstrumentId instrument, BookSnapshot& snapshot);
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "market_update.hpp"
+#include "session_replay.hpp"
+#include "tick_store.hpp"
+#include "work_stealing_pool.hpp"
+
+#if __cplusplus < 201703L
+#error "C++17 standard support required."
+#endif
+
+/*
+ * Converts captures of MarketUpdates into tick stores and replays them through books and engines, one session or
+ * many of them in parallel. A capture is MarketUpdates one after another, in network byte order as they come off
+ * the wire.
+ */
+
+namespace {
+
+using namespace CryptoTradingInfra;
+
+int Convert(const std::string& capturePath, const std::string& storePath)
+{
+    std::ifstream capture(capturePath, std::ios::binary);
+    if (!capture) {
+        std::cerr << "Error: cannot open " << capturePath << "\n" << std::flush;
+        return 1;
+    }
+    auto store = TickStoreWriter::Create(storePath);
+    if (!store) {
+        return 1;
+    }
+
+    MarketUpdate update;
+    while (capture.read(reinterpret_cast<char *>(&update), sizeof(update))) {
+        update.ntoh();
+        if (!store->append(update)) {
+            return 1;
+        }
+    }
+    if (capture.gcount() != 0) {
+        std::cerr << "Warning: " << capture.gcount() << " trailing bytes of " << capturePath << " ignored\n";
+    }
+    auto updates = store->updatesWritten();
+    if (!store->close()) {
+        return 1;
+    }
+
+    auto reader = TickStoreReader::Open(storePath);
+    if (!reader) {
+        return 1;
+    }
+    auto ratio = static_cast<double>(updates * sizeof(MarketUpdate)) / reader->bytes();
+    std::cout << updates << " MarketUpdates stored in " << reader->bytes() << " bytes, " << ratio
+              << "x smaller than the capture.\n" << std::flush;
+    return 0;
+}
+
+int Info(const std::string& storePath)
+{
+    auto reader = TickStoreReader::Open(storePath);
+    if (!reader) {
+        return 1;
+    }
+    std::cout << storePath << ": " << reader->updates() << " MarketUpdates in " << reader->chunks() << " chunks, "
+              << reader->bytes() << " bytes\n";
+    if (reader->chunks() > 0) {
+        auto from = reader->chunk(0).minTime;
+        auto to = reader->chunk(0).maxTime;
+        for (size_t i = 1; i < reader->chunks(); ++i) {
+            from = std::min(from, reader->chunk(i).minTime);
+            to = std::max(to, reader->chunk(i).maxTime);
+        }
+        std::cout << "Timestamps from " << from << " to " << to << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
+
+int Replay(const ReplayJob& job)
+{
+    SessionReplay replay;
+    auto result = replay.run(job);
+    if (!result.complete) {
+        return 1;
+    }
+    replay.print();
+    std::cout << result.updates << " MarketUpdates of " << result.instruments << " instruments replayed in "
+              << result.seconds << " s, " << result.updates / result.seconds << " updates/s, " << result.trades
+              << " trades.\n" << std::flush;
+    return 0;
+}
+
+// PATH or PATH@FROM,TO
+ReplayJob ParseJob(const std::string& spec)
+{
+    ReplayJob job;
+    auto at = spec.rfind('@');
+    auto comma = spec.find(',', at == std::string::npos ? spec.size() : at);
+    if (at == std::string::npos || comma == std::string::npos) {
+        job.path = spec;
+        return job;
+    }
+    job.path = spec.substr(0, at);
+    job.from = std::stoull(spec.substr(at + 1, comma - at - 1));
+    job.to = std::stoull(spec.substr(comma + 1));
+    return job;
+}
+
+int Batch(const std::vector<ReplayJob>& jobs, size_t threads)
+{
+    std::vector<ReplayResult> results(jobs.size());
+    auto start = std::chrono::steady_clock::now();
+    uint64_t stolen;
+    {
+        Utils::WorkStealingPool pool(threads);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            pool.submit([&, i]() { results[i] = SessionReplay().run(jobs[i]); });
+        }
+        pool.wait();
+        stolen = pool.stolen();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    ReplayResult total;
+    size_t failed = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const auto& result = results[i];
+        std::cout << jobs[i].path;
+        if (jobs[i].from != 0 || jobs[i].to != UINT64_MAX) {
+            std::cout << "@" << jobs[i].from << "," << jobs[i].to;
+        }
+        std::cout << ": " << (result.complete ? "" : "incomplete, ") << result.updates << " updates of "
+                  << result.instruments << " instruments, " << result.trades << " trades of " << result.volume
+                  << ", " << result.seconds << " s, " << result.updates / result.seconds << " updates/s\n";
+        failed += !result.complete;
+        total.updates += result.updates;
+        total.trades += result.trades;
+        total.volume += result.volume;
+        total.seconds += result.seconds;
+    }
+    std::cout << jobs.size() << " sessions replayed on " << threads << " threads in " << elapsed.count() << " s ("
+              << total.seconds << " s of replay, " << stolen << " jobs stolen): " << total.updates << " updates, "
+              << total.updates / elapsed.count() << " updates/s, " << total.trades << " trades of " << total.volume
+              << ".\n" << std::flush;
+    return failed == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " convert CAPTURE STORE\n";
+        std::cerr << "       " << argv[0] << " info STORE\n";
+        std::cerr << "       " << argv[0] << " replay SESSION [FROM TO]\n";
+        std::cerr << "       " << argv[0] << " batch [--threads N] SESSION[@FROM,TO]...\n";
+        std::cerr << "CAPTURE holds MarketUpdates in network byte order, one after another, and a SESSION is either a "
+                  << "STORE or a CAPTURE.\n";
+        std::cerr << "replay applies the updates timestamped from FROM to TO to books and engines of their "
+                  << "instruments.\n";
+        std::cerr << "batch replays every SESSION through books of its own on a pool of N threads (default is one per "
+                  << "core).\n" << std::flush;
+    };
+
+    std::string command = argc > 1 ? argv[1] : "";
+    try {
+        if (command == "convert" && argc == 4) {
+            return Convert(argv[2], argv[3]);
+        } else if (command == "info" && argc == 3) {
+            return Info(argv[2]);
+        } else if (command == "replay" && (argc == 3 || argc == 5)) {
+            auto from = argc == 5 ? std::stoull(argv[3]) : 0;
+            auto to = argc == 5 ? std::stoull(argv[4]) : UINT64_MAX;
+            return Replay({ argv[2], from, to });
+        } else if (command == "batch") {
+            auto threads = Utils::WorkStealingPool::DefaultThreads();
+            std::vector<ReplayJob> jobs;
+            for (auto i = 2; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--threads" && i + 1 < argc) {
+                    threads = std::stoul(argv[++i]);
+                } else {
+                    jobs.push_back(ParseJob(arg));
+                }
+            }
+            if (!jobs.empty() && threads > 0) {
+                return Batch(jobs, threads);
+            }
+        }
+    } catch (...) {
+    }
+    usage();
+    return 1;
+}
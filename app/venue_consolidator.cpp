@@ -0,0 +1,92 @@
+#include "venue_consolidator.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace CryptoTradingInfra {
+
+VenueConsolidator::VenueConsolidator(size_t venuesNum, NbboSubscriber subscriber)
+    : venuesNum(std::min(venuesNum, MAX_VENUES)), subscriber(std::move(subscriber))
+{
+    for (size_t venue = 0; venue < this->venuesNum; ++venue) {
+        venues[venue] = std::make_unique<Venue>();
+    }
+}
+
+VenueConsolidator::Instrument& VenueConsolidator::instrument(InstrumentId id)
+{
+    auto& instrument = instruments[id];
+    if (!instrument) {
+        instrument = std::make_unique<Instrument>();
+        for (size_t venue = 0; venue < venuesNum; ++venue) {
+            instrument->venues[venue] = std::make_unique<VenueBook>();
+            instrument->book.subscribe(static_cast<VenueId>(venue), instrument->venues[venue]->analytics);
+        }
+    }
+    return *instrument;
+}
+
+void VenueConsolidator::apply(VenueId venue, const MarketUpdate& update)
+{
+    auto& instrument = this->instrument(update.instrument);
+    auto& book = *instrument.venues[venue];
+    bool nbbo = false;
+    if (update.flags & MarketUpdate::CLEAR_BOOK) {
+        book.orderBook.clear();
+        book.analytics.reset(book.orderBook);
+        auto bid = instrument.book.bestBid();
+        auto ask = instrument.book.bestAsk();
+        instrument.book.reset(venue);
+        nbbo = !(bid == instrument.book.bestBid() && ask == instrument.book.bestAsk());
+    } else {
+        auto change = book.analytics.apply(book.orderBook.updateOrderBook(update), book.orderBook);
+        nbbo = instrument.book.apply(venue, change);
+    }
+
+    if (nbbo) {
+        ++nbboChanges;
+        if (subscriber) {
+            subscriber({ update.instrument, update.timestamp, instrument.book.bestBid(), instrument.book.bestAsk() });
+        }
+    }
+    // single writer, a plain store is enough to publish the counter
+    venues[venue]->applied.store(venues[venue]->applied.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+}
+
+void VenueConsolidator::run(std::atomic<bool>& runFlag)
+{
+    while (runFlag.load(std::memory_order_relaxed)) {
+        bool busy = false;
+        for (size_t venue = 0; venue < venuesNum; ++venue) {
+            MarketUpdate update;
+            if (venues[venue]->lane.pop(update)) {
+                apply(static_cast<VenueId>(venue), update);
+                busy = true;
+            }
+        }
+        if (!busy) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+const VenueConsolidator::Instrument *VenueConsolidator::find(InstrumentId id) const
+{
+    auto it = instruments.find(id);
+    return it == instruments.end() ? nullptr : it->second.get();
+}
+
+void VenueConsolidator::print(size_t depth) const
+{
+    for (const auto& [id, instrument] : instruments) {
+        std::cout << "======Instrument " << id << " across " << venuesNum << " venues======" << std::endl;
+        instrument->book.print(std::cout, depth);
+        std::cout << "NBBO changes: " << instrument->book.bboChanges() << ", depth merged "
+                  << instrument->book.depthMerges() << " times" << std::endl;
+    }
+}
+
+} // namespace CryptoTradingInfra
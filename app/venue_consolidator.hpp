@@ -0,0 +1,132 @@
+#ifndef CRYPTO_TRADING_INFRA_VENUE_CONSOLIDATOR
+#define CRYPTO_TRADING_INFRA_VENUE_CONSOLIDATOR
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include "book_analytics.hpp"
+#include "consolidated_book.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr size_t VENUE_LANE_SIZE = 65536;
+
+// best bid and ask of an instrument across venues, the venue of each included
+struct NbboEvent {
+    InstrumentId instrument;
+    uint64_t timestamp;
+    std::optional<VenueLevel> bid;
+    std::optional<VenueLevel> ask;
+};
+
+using NbboSubscriber = std::function<void(const NbboEvent&)>;
+
+/*
+ * Keeps the books of every instrument as traded on each of several venues, along with the book consolidated
+ * across them. The receiver of every venue pushes its updates into a lane of the venue's own and never waits,
+ * an update finding the lane full is dropped and counted. A single thread drains every lane, applies each
+ * update to the book of its venue and hands the change on to the consolidated book straight away, so the
+ * best bid and ask across venues move with the update that moved them and nothing else is waited for.
+ *
+ * Every book, consolidated or not, belongs to the thread running run: find and print are for that thread, or
+ * for after it stopped.
+ */
+class VenueConsolidator
+{
+public:
+    using Lane = Utils::ConcurrentRingBuffer<MarketUpdate, VENUE_LANE_SIZE>;
+
+    // the book of an instrument on a venue
+    struct VenueBook {
+        OrderBook orderBook;
+        BookAnalytics<> analytics;
+    };
+
+    struct Instrument {
+        std::unique_ptr<VenueBook> venues[MAX_VENUES];
+        ConsolidatedBook<> book;
+    };
+
+private:
+    struct Venue {
+        Lane lane;
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> applied { 0 };
+        // only written by the receiver of the venue
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> dropped { 0 };
+    };
+
+    std::unique_ptr<Venue> venues[MAX_VENUES];
+    size_t venuesNum;
+    std::unordered_map<InstrumentId, std::unique_ptr<Instrument>> instruments;
+    NbboSubscriber subscriber;
+    uint64_t nbboChanges = 0;
+
+    Instrument& instrument(InstrumentId id);
+
+public:
+    // venues are numbered from 0 to venuesNum - 1, at most MAX_VENUES of them, and every method taking a venue
+    // expects one below venuesCount(), nothing being there to look up for the others
+    explicit VenueConsolidator(size_t venuesNum, NbboSubscriber subscriber = {});
+
+    VenueConsolidator(const VenueConsolidator&) = delete;
+    VenueConsolidator& operator=(const VenueConsolidator&) = delete;
+
+    size_t venuesCount() const
+    {
+        return venuesNum;
+    }
+
+    // from the receiver of venue only, false when the update had to be dropped, venue below venuesCount()
+    bool enqueue(VenueId venue, const MarketUpdate& update)
+    {
+        if (!venues[venue]->lane.push(update)) {
+            venues[venue]->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // applies update of venue to its book and the consolidated one, the subscriber getting the NBBO if it moved,
+    // venue below venuesCount()
+    void apply(VenueId venue, const MarketUpdate& update);
+
+    // drains the lanes of every venue in turn until runFlag is cleared
+    void run(std::atomic<bool>& runFlag);
+
+    const Instrument *find(InstrumentId id) const;
+
+    // venue below venuesCount(), as for updatesDropped
+    uint64_t updatesApplied(VenueId venue) const
+    {
+        return venues[venue]->applied.load(std::memory_order_relaxed);
+    }
+
+    uint64_t updatesDropped(VenueId venue) const
+    {
+        return venues[venue]->dropped.load(std::memory_order_relaxed);
+    }
+
+    uint64_t nbboChangesNum() const
+    {
+        return nbboChanges;
+    }
+
+    size_t instrumentsNum() const
+    {
+        return instruments.size();
+    }
+
+    void print(size_t depth = 5) const;
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
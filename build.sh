@@ -3,10 +3,11 @@ set -e
 
 RUN_TESTS="OFF"
 RUN_BENCHMARKS="OFF"
+COOPERATIVE_PIPELINE="OFF"
 PROJECT_ROOT=$(realpath $(dirname "${BASH_SOURCE[0]}"))
 
 parse_args() {
-    while getopts ":tb" opt; do
+    while getopts ":tbc" opt; do
         case $opt in
             t)
                 RUN_TESTS="ON"
@@ -14,6 +15,9 @@ parse_args() {
             b)
                 RUN_BENCHMARKS="ON"
                 ;;
+            c)
+                COOPERATIVE_PIPELINE="ON"
+                ;;
             *)
                 echo "Invalid option: -$OPTARG" >&2
                 exit 1
@@ -49,7 +53,8 @@ detect_os_and_toolchain() {
 }
 
 build() {
-    cmake .. -DCMAKE_TOOLCHAIN_FILE=${TOOLCHAIN_FILE} -DRUN_TESTS=${RUN_TESTS} -DRUN_BENCHMARKS=${RUN_BENCHMARKS}
+    cmake .. -DCMAKE_TOOLCHAIN_FILE=${TOOLCHAIN_FILE} -DRUN_TESTS=${RUN_TESTS} -DRUN_BENCHMARKS=${RUN_BENCHMARKS} \
+        -DCOOPERATIVE_PIPELINE=${COOPERATIVE_PIPELINE}
     make -j $JOBS
 }
 
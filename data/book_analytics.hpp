@@ -0,0 +1,330 @@
+#ifndef CRYPTO_TRADING_INFRA_BOOK_ANALYTICS
+#define CRYPTO_TRADING_INFRA_BOOK_ANALYTICS
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "book_state.hpp"
+#include "crc32c.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+
+namespace CryptoTradingInfra {
+
+// levels of each side analytics are computed over and depth is published for
+constexpr size_t DEFAULT_DEPTH_LEVELS = 10;
+// size the published VWAP is computed for when none is configured
+constexpr Size DEFAULT_VWAP_SIZE = 10;
+
+// features of the top levels of a book, prices are NaN while they cannot be computed
+struct BookFeatures {
+    // best prices weighted by the size on the other side, leaning towards the side about to be depleted
+    Price microprice = std::numeric_limits<Price>::quiet_NaN();
+    // (bid depth - ask depth) / (bid depth + ask depth) over the top levels, 0 while both sides are empty
+    double imbalance = 0;
+    Size bidDepth = 0;
+    Size askDepth = 0;
+    // average price selling and buying the VWAP size would get, NaN if the top levels cannot fill it
+    Price bidVwap = std::numeric_limits<Price>::quiet_NaN();
+    Price askVwap = std::numeric_limits<Price>::quiet_NaN();
+    // CRC-32C of the price and size of every top level of each side from the best one down, and of both of them
+    uint32_t bidChecksum = 0;
+    uint32_t askChecksum = 0;
+    uint32_t checksum = 0;
+};
+
+/*
+ * Features of the top Levels levels of an OrderBook, kept up to date with every LevelUpdate applied to it.
+ * Both sides are held in arrays along with the cumulative size and notional down to each level. A change
+ * only rewrites the slots from the level it touched on, and leaves everything alone when it happens below
+ * the top levels, so features cost about as much as the update of the book itself. The book is only read
+ * when a level has to be pulled up from below the top ones.
+ *
+ * Only the thread applying updates to the book may apply them here.
+ */
+template <size_t Levels = DEFAULT_DEPTH_LEVELS>
+class BookAnalytics
+{
+    // deeper levels could be evicted from a shallow book without the analytics hearing of it
+    static_assert(Levels < BookState::MAX_DEPTH, "BookAnalytics must track fewer levels than a book keeps");
+
+public:
+    // slots [from, to) of side were rewritten, changed is false when the update fell below the top levels
+    struct Change {
+        MarketUpdate::Side side;
+        size_t from;
+        size_t to;
+        bool changed;
+    };
+
+private:
+    struct Side {
+        alignas(16) Price prices[Levels];
+        alignas(16) Size sizes[Levels];
+        // sum of sizes, and of sizes times prices, from the best level down to each one
+        alignas(16) Size depth[Levels];
+        alignas(16) double notional[Levels];
+        // checksum of the levels from the best one down to each one
+        uint32_t checksums[Levels];
+        size_t count = 0;
+    };
+
+    Side bids;
+    Side asks;
+    Size vwapSize;
+    BookFeatures current;
+
+    // recomputes the cumulative sums of slots [from, to) from the ones above
+    static void Accumulate(Side& side, size_t from, size_t to)
+    {
+        auto depth = from > 0 ? side.depth[from - 1] : 0.0;
+        auto notional = from > 0 ? side.notional[from - 1] : 0.0;
+        auto i = from;
+#ifdef __SSE2__
+        // two levels at a time, [a, b] turning into [carry + a, carry + a + b]
+        auto carryDepth = _mm_set1_pd(depth);
+        auto carryNotional = _mm_set1_pd(notional);
+        for (; i + 2 <= to; i += 2) {
+            auto sizes = _mm_loadu_pd(side.sizes + i);
+            auto values = _mm_mul_pd(_mm_loadu_pd(side.prices + i), sizes);
+            sizes = _mm_add_pd(sizes, _mm_unpacklo_pd(_mm_setzero_pd(), sizes));
+            values = _mm_add_pd(values, _mm_unpacklo_pd(_mm_setzero_pd(), values));
+            sizes = _mm_add_pd(sizes, carryDepth);
+            values = _mm_add_pd(values, carryNotional);
+            _mm_storeu_pd(side.depth + i, sizes);
+            _mm_storeu_pd(side.notional + i, values);
+            carryDepth = _mm_unpackhi_pd(sizes, sizes);
+            carryNotional = _mm_unpackhi_pd(values, values);
+        }
+        depth = _mm_cvtsd_f64(carryDepth);
+        notional = _mm_cvtsd_f64(carryNotional);
+#endif
+        for (; i < to; ++i) {
+            depth += side.sizes[i];
+            notional += side.sizes[i] * side.prices[i];
+            side.depth[i] = depth;
+            side.notional[i] = notional;
+        }
+    }
+
+    // extends the checksums of slots [from, to) from the one above, which is all a change has to recompute
+    static void Chain(Side& side, size_t from, size_t to)
+    {
+        auto checksum = from > 0 ? side.checksums[from - 1] : 0;
+        for (auto i = from; i < to; ++i) {
+            checksum = LevelChecksum(side.prices[i], side.sizes[i], checksum);
+            side.checksums[i] = checksum;
+        }
+    }
+
+    static uint32_t LevelChecksum(Price price, Size size, uint32_t checksum)
+    {
+        Price level[2] = { price, size };
+        return Utils::Crc32c(level, sizeof(level), checksum);
+    }
+
+    static uint32_t Combine(uint32_t bids, uint32_t asks)
+    {
+        uint32_t sides[2] = { bids, asks };
+        return Utils::Crc32c(sides, sizeof(sides));
+    }
+
+    static Size Depth(const Side& side)
+    {
+        return side.count > 0 ? side.depth[side.count - 1] : 0;
+    }
+
+    static Price Vwap(const Side& side, Size size)
+    {
+        if (size <= 0 || Depth(side) < size) {
+            return std::numeric_limits<Price>::quiet_NaN();
+        }
+        // first level at which size is filled, the levels above it are taken whole
+        auto level = std::lower_bound(side.depth, side.depth + side.count, size) - side.depth;
+        auto above = level > 0 ? side.depth[level - 1] : 0.0;
+        auto notionalAbove = level > 0 ? side.notional[level - 1] : 0.0;
+        return (notionalAbove + (size - above) * side.prices[level]) / size;
+    }
+
+    void refresh()
+    {
+        current.bidDepth = Depth(bids);
+        current.askDepth = Depth(asks);
+        auto total = current.bidDepth + current.askDepth;
+        current.imbalance = total > 0 ? (current.bidDepth - current.askDepth) / total : 0;
+
+        if (bids.count > 0 && asks.count > 0) {
+            current.microprice = (bids.prices[0] * asks.sizes[0] + asks.prices[0] * bids.sizes[0]) /
+                                 (bids.sizes[0] + asks.sizes[0]);
+        } else {
+            current.microprice = std::numeric_limits<Price>::quiet_NaN();
+        }
+        current.bidVwap = Vwap(bids, vwapSize);
+        current.askVwap = Vwap(asks, vwapSize);
+
+        current.bidChecksum = bids.count > 0 ? bids.checksums[bids.count - 1] : 0;
+        current.askChecksum = asks.count > 0 ? asks.checksums[asks.count - 1] : 0;
+        current.checksum = Combine(current.bidChecksum, current.askChecksum);
+    }
+
+    template <MarketUpdate::Side S>
+    Change apply(Price price, Size size, const OrderBook& book)
+    {
+        constexpr bool isBid = S == MarketUpdate::Side::BID;
+        auto& side = isBid ? bids : asks;
+        auto& count = side.count;
+
+        size_t pos = std::find_if(side.prices, side.prices + count,
+                                  [&](Price level) { return isBid ? level <= price : level >= price; }) -
+                     side.prices;
+        bool present = pos < count && side.prices[pos] == price;
+
+        size_t to;
+        if (present && size != 0) {
+            side.sizes[pos] = size;
+            to = pos + 1;
+        } else if (present) {
+            std::copy(side.prices + pos + 1, side.prices + count, side.prices + pos);
+            std::copy(side.sizes + pos + 1, side.sizes + count, side.sizes + pos);
+            --count;
+            // the level right below the top ones moves up, it is already in the book
+            if (count == Levels - 1) {
+                auto next = book.read([](const BookState& state) { return state.level<S>(Levels - 1); });
+                if (next) {
+                    side.prices[count] = next->first;
+                    side.sizes[count++] = next->second;
+                }
+            }
+            to = count;
+        } else if (size != 0 && pos < Levels) {
+            auto last = std::min(count, Levels - 1);
+            std::copy_backward(side.prices + pos, side.prices + last, side.prices + last + 1);
+            std::copy_backward(side.sizes + pos, side.sizes + last, side.sizes + last + 1);
+            side.prices[pos] = price;
+            side.sizes[pos] = size;
+            count = std::min(count + 1, Levels);
+            to = count;
+        } else {
+            return { S, pos, pos, false };
+        }
+
+        // cumulative sums and checksums above pos are untouched
+        Accumulate(side, pos, count);
+        Chain(side, pos, count);
+        refresh();
+        return { S, pos, to, true };
+    }
+
+    template <MarketUpdate::Side S>
+    const Side& sideOf() const
+    {
+        return S == MarketUpdate::Side::BID ? bids : asks;
+    }
+
+public:
+    explicit BookAnalytics(Size vwapSize = DEFAULT_VWAP_SIZE) : vwapSize(vwapSize)
+    {
+        refresh();
+    }
+
+    // level is what OrderBook::updateOrderBook returned for the update just applied to book
+    Change apply(const LevelUpdate& level, const OrderBook& book)
+    {
+        if (level.side == MarketUpdate::Side::BID) {
+            return apply<MarketUpdate::Side::BID>(level.price, level.size, book);
+        }
+        return apply<MarketUpdate::Side::ASK>(level.price, level.size, book);
+    }
+
+    // recomputes everything from the top levels of book
+    void reset(const OrderBook& book)
+    {
+        book.read([&](const BookState& state) {
+            bids.count = 0;
+            for (const auto& [price, size] : state.bidsNAsks.bids) {
+                if (bids.count == Levels) {
+                    break;
+                }
+                bids.prices[bids.count] = price;
+                bids.sizes[bids.count++] = size;
+            }
+            asks.count = 0;
+            for (const auto& [price, size] : state.bidsNAsks.asks) {
+                if (asks.count == Levels) {
+                    break;
+                }
+                asks.prices[asks.count] = price;
+                asks.sizes[asks.count++] = size;
+            }
+        });
+        Accumulate(bids, 0, bids.count);
+        Accumulate(asks, 0, asks.count);
+        Chain(bids, 0, bids.count);
+        Chain(asks, 0, asks.count);
+        refresh();
+    }
+
+    // checksum of the top levels of a whole book, for whoever keeps one of its own to check it against features()
+    static uint32_t Checksum(const BookState& state)
+    {
+        uint32_t sides[2] = { 0, 0 };
+        size_t count = 0;
+        for (const auto& [price, size] : state.bidsNAsks.bids) {
+            if (count++ == Levels) {
+                break;
+            }
+            sides[0] = LevelChecksum(price, size, sides[0]);
+        }
+        count = 0;
+        for (const auto& [price, size] : state.bidsNAsks.asks) {
+            if (count++ == Levels) {
+                break;
+            }
+            sides[1] = LevelChecksum(price, size, sides[1]);
+        }
+        return Combine(sides[0], sides[1]);
+    }
+
+    const BookFeatures& features() const
+    {
+        return current;
+    }
+
+    template <MarketUpdate::Side S>
+    size_t count() const
+    {
+        return sideOf<S>().count;
+    }
+
+    // index from the best level on, below count<S>()
+    template <MarketUpdate::Side S>
+    BookState::Item level(size_t index) const
+    {
+        const auto& side = sideOf<S>();
+        return { side.prices[index], side.sizes[index] };
+    }
+
+    // size resting at the levels above and at index
+    template <MarketUpdate::Side S>
+    Size depth(size_t index) const
+    {
+        return sideOf<S>().depth[index];
+    }
+
+    // average price of taking size from side S, NaN if its top levels cannot fill it
+    template <MarketUpdate::Side S>
+    Price vwap(Size size) const
+    {
+        return Vwap(sideOf<S>(), size);
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef CRYPTO_TRADING_INFRA_BOOK_STATE
+#define CRYPTO_TRADING_INFRA_BOOK_STATE
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "market_update.hpp"
+#include "persistent_map.hpp"
+#include "tick_ladder.hpp"
+
+#ifndef CRYPTO_TRADING_INFRA_BOOK_DEPTH
+#define CRYPTO_TRADING_INFRA_BOOK_DEPTH 100
+#endif
+
+#ifndef CRYPTO_TRADING_INFRA_TICK_SIZE
+#define CRYPTO_TRADING_INFRA_TICK_SIZE 0.01
+#endif
+
+namespace CryptoTradingInfra {
+
+constexpr size_t DEFAULT_BOOK_DEPTH = CRYPTO_TRADING_INFRA_BOOK_DEPTH;
+constexpr Price DEFAULT_TICK_SIZE = CRYPTO_TRADING_INFRA_TICK_SIZE;
+
+// from this depth on each side is kept in a tick ladder instead of a sorted map
+constexpr size_t DEEP_BOOK_DEPTH = 1024;
+
+// outcome of an update on a single level, size is what is left at price and 0 once the level is gone
+struct LevelUpdate {
+    MarketUpdate::Side side;
+    Price price;
+    Size size;
+};
+
+// identifies a level across the books of every instrument
+struct LevelKey {
+    InstrumentId instrument;
+    MarketUpdate::Side side;
+    Price price;
+
+    bool operator==(const LevelKey& other) const
+    {
+        return instrument == other.instrument && side == other.side && price == other.price;
+    }
+};
+
+struct LevelKeyHash {
+    size_t operator()(const LevelKey& key) const
+    {
+        auto level = (static_cast<size_t>(key.instrument) << 1) | static_cast<size_t>(key.side);
+        return std::hash<Price> {}(key.price) ^ (level * 0x9e3779b97f4a7c15);
+    }
+};
+
+/*
+ * Levels of both sides of a book, holding up to Depth levels per side.
+ *
+ * Shallow books keep each side in a persistent sorted map, any price is accepted and the worst level is
+ * dropped once a side grows beyond Depth, dropped levels being counted rather than lost silently. Deep books
+ * keep each side in a tick ladder spanning Depth ticks of DEFAULT_TICK_SIZE (or the tick size given at
+ * construction) around the best level, and the levels further behind in a sorted map beside it, so no
+ * level is ever dropped.
+ */
+template <size_t Depth>
+class BasicBookState
+{
+public:
+    static constexpr size_t MAX_DEPTH = Depth;
+    static constexpr bool DEEP = Depth >= DEEP_BOOK_DEPTH;
+
+    using Item = std::pair<Price, Size>;
+    // both sides are persistent, copying the state shares every level with the original
+    using Bids = std::conditional_t<DEEP, Utils::TickLadder<Depth, true>,
+                                    Utils::PersistentSortedMap<Item::first_type, Item::second_type, std::greater<>>>;
+    using Asks = std::conditional_t<DEEP, Utils::TickLadder<Depth, false>,
+                                    Utils::PersistentSortedMap<Item::first_type, Item::second_type, std::less<>>>;
+
+private:
+    size_t dropped = 0;
+
+    template <MarketUpdate::Side Side>
+    using Chosen = std::conditional_t<Side == MarketUpdate::Side::BID, Bids, Asks>;
+
+    template <MarketUpdate::Side Side>
+    std::optional<Item> Best() const
+    {
+        const Chosen<Side>& side = bidsNAsks;
+        return side.front();
+    }
+
+    static Bids MakeBids(Price tickSize)
+    {
+        if constexpr (DEEP) {
+            return Bids(tickSize);
+        } else {
+            return Bids();
+        }
+    }
+
+    static Asks MakeAsks(Price tickSize)
+    {
+        if constexpr (DEEP) {
+            return Asks(tickSize);
+        } else {
+            return Asks();
+        }
+    }
+
+public:
+    struct BidsNAsks {
+        Bids bids;
+        Asks asks;
+
+        operator Bids&()
+        {
+            return bids;
+        }
+
+        operator Asks&()
+        {
+            return asks;
+        }
+
+        operator const Bids&() const
+        {
+            return bids;
+        }
+
+        operator const Asks&() const
+        {
+            return asks;
+        }
+    } bidsNAsks;
+
+    // sequence of the last update applied to this version, 0 while the feed does not sequence them
+    uint64_t sequence = 0;
+
+    explicit BasicBookState(Price tickSize = DEFAULT_TICK_SIZE)
+        : bidsNAsks { MakeBids(tickSize), MakeAsks(tickSize) }
+    {
+    }
+
+    BasicBookState(const BasicBookState& other) = default;
+    BasicBookState& operator=(const BasicBookState& other) = default;
+
+    // It is not allowed to move by design, thread should make a copy of the instance first
+    // if it wishes to perform an update
+    BasicBookState(BasicBookState&& other) = delete;
+    BasicBookState& operator=(BasicBookState&& other) = delete;
+
+    // returns the size left at price once updated
+    template <MarketUpdate::Side Side>
+    Size updateState(Price price, Size size)
+    {
+        Chosen<Side>& side = bidsNAsks;
+
+        // when size is 0, it's meant to remove the price level in the book
+        if (size == 0.0) {
+            side.erase(price);
+            return 0;
+        }
+
+        auto level = side.find(price);
+        auto updated = (level != nullptr ? *level : 0) + size;
+        // taking off more than the level holds leaves nothing either
+        if (updated <= 0) {
+            side.erase(price);
+            return 0;
+        }
+        side.assign(price, updated);
+        if constexpr (!DEEP) {
+            if (side.size() > MAX_DEPTH) {
+                auto worst = side.back()->first;
+                side.erase(worst);
+                ++dropped;
+                if (worst == price) {
+                    return 0;
+                }
+            }
+        }
+        return updated;
+    }
+
+    template <MarketUpdate::Side Side>
+    bool empty() const
+    {
+        const Chosen<Side>& side = bidsNAsks;
+        return side.empty();
+    }
+
+    // level at index from the best one on, walks the side so it is meant for the first few levels
+    template <MarketUpdate::Side Side>
+    std::optional<Item> level(size_t index) const
+    {
+        const Chosen<Side>& side = bidsNAsks;
+        for (const auto& [price, size] : side) {
+            if (index-- == 0) {
+                return Item(price, size);
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Item> bestBid() const
+    {
+        return Best<MarketUpdate::Side::BID>();
+    }
+
+    std::optional<Item> bestAsk() const
+    {
+        return Best<MarketUpdate::Side::ASK>();
+    }
+
+    // tick size of the ladders, shallow books keep no grid and report the default
+    Price tickSize() const
+    {
+        if constexpr (DEEP) {
+            return bidsNAsks.bids.tick();
+        } else {
+            return DEFAULT_TICK_SIZE;
+        }
+    }
+
+    // levels evicted since the book was created, always 0 for deep books
+    size_t droppedLevels() const
+    {
+        return dropped;
+    }
+
+    void print(size_t depth) const
+    {
+        depth = std::min(depth, MAX_DEPTH);
+
+        std::cout << "Asks:\n";
+        size_t count = 0;
+        for (const auto& [price, size] : bidsNAsks.asks) {
+            if (count++ >= depth) {
+                break;
+            }
+            std::cout << price << " @" << size << "\n";
+        }
+        std::cout << "Bids:\n";
+        count = 0;
+        for (const auto& [price, size] : bidsNAsks.bids) {
+            if (count++ >= depth) {
+                break;
+            }
+            std::cout << price << " @" << size << "\n";
+        }
+        if (dropped > 0) {
+            std::cout << "Dropped levels: " << dropped << "\n";
+        }
+    }
+};
+
+using BookState = BasicBookState<DEFAULT_BOOK_DEPTH>;
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef CRYPTO_TRADING_INFRA_CONSOLIDATED_BOOK
+#define CRYPTO_TRADING_INFRA_CONSOLIDATED_BOOK
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+
+#include "book_analytics.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+
+// venues a consolidated book follows at most, a power of 2 for the tournament trees over them
+constexpr size_t MAX_VENUES = 16;
+
+using VenueId = uint8_t;
+constexpr VenueId NO_VENUE = 0xff;
+
+// a level of the book of a venue
+struct VenueLevel {
+    Price price;
+    Size size;
+    VenueId venue;
+
+    bool operator==(const VenueLevel& other) const
+    {
+        return price == other.price && size == other.size && venue == other.venue;
+    }
+};
+
+/*
+ * Book of an instrument consolidated across the venues trading it, following the top levels BookAnalytics
+ * keeps of every venue's OrderBook rather than copying the books. It is told about every change applied to
+ * the analytics of a venue and only does something when the change reaches what it consolidates.
+ *
+ * The best bid and ask across venues are the winners of a tournament tree per side over the best levels of
+ * every venue, a change of the best level of a venue replaying the log2(MAX_VENUES) matches on its path to
+ * the root, so the NBBO is as fresh as the book of the venue it comes from. Ties go to the larger size, then
+ * to the lower venue id. The merged depth, the best Levels levels of every venue in price order with
+ * the venue they rest on, is merged again through a heap over venues only when a venue changed one of the
+ * levels it contributes to it, or the one right after them.
+ *
+ * Owned by the thread applying the updates of every venue of the instrument, like the books it follows.
+ */
+template <size_t Levels = DEFAULT_DEPTH_LEVELS>
+class ConsolidatedBook
+{
+public:
+    using Analytics = BookAnalytics<Levels>;
+
+private:
+    static constexpr size_t SIDES = 2;
+
+    struct Side {
+        // best level of every venue, NO_VENUE once empty
+        VenueLevel tops[MAX_VENUES];
+        // winner of every match, node 1 being the root and the venues the leaves from MAX_VENUES on
+        VenueId tree[2 * MAX_VENUES];
+        VenueLevel depth[Levels];
+        size_t count = 0;
+        // levels of every venue within depth
+        size_t contributed[MAX_VENUES] = {};
+    };
+
+    const Analytics *venues[MAX_VENUES] = {};
+    Side sides[SIDES];
+    uint64_t merges = 0;
+    uint64_t nbboChanges = 0;
+
+    template <MarketUpdate::Side S>
+    static bool Better(const VenueLevel& level, const VenueLevel& other)
+    {
+        if (other.venue == NO_VENUE) {
+            return level.venue != NO_VENUE;
+        }
+        if (level.venue == NO_VENUE) {
+            return false;
+        }
+        if (level.price != other.price) {
+            return S == MarketUpdate::Side::BID ? level.price > other.price : level.price < other.price;
+        }
+        if (level.size != other.size) {
+            return level.size > other.size;
+        }
+        return level.venue < other.venue;
+    }
+
+    template <MarketUpdate::Side S>
+    Side& sideOf()
+    {
+        return sides[static_cast<size_t>(S)];
+    }
+
+    template <MarketUpdate::Side S>
+    const Side& sideOf() const
+    {
+        return sides[static_cast<size_t>(S)];
+    }
+
+    template <MarketUpdate::Side S>
+    VenueLevel Level(VenueId venue, size_t index) const
+    {
+        auto [price, size] = venues[venue]->template level<S>(index);
+        return { price, size, venue };
+    }
+
+    // replays the matches from the leaf of venue up, returns whether the winner changed
+    template <MarketUpdate::Side S>
+    bool replay(VenueId venue)
+    {
+        auto& side = sideOf<S>();
+        auto winner = side.tree[1];
+        auto& top = side.tops[venue];
+        if (venues[venue] != nullptr && venues[venue]->template count<S>() > 0) {
+            top = Level<S>(venue, 0);
+        } else {
+            top = { 0, 0, NO_VENUE };
+        }
+
+        auto node = MAX_VENUES + venue;
+        side.tree[node] = top.venue;
+        for (node /= 2; node > 0; node /= 2) {
+            auto left = side.tree[2 * node];
+            auto right = side.tree[2 * node + 1];
+            auto leftTop = left == NO_VENUE ? VenueLevel { 0, 0, NO_VENUE } : side.tops[left];
+            auto rightTop = right == NO_VENUE ? VenueLevel { 0, 0, NO_VENUE } : side.tops[right];
+            side.tree[node] = Better<S>(rightTop, leftTop) ? right : left;
+        }
+        return side.tree[1] != winner || venue == side.tree[1];
+    }
+
+    // merges the top levels of every venue into depth, the best ones of the venues waiting in a heap
+    template <MarketUpdate::Side S>
+    void merge()
+    {
+        auto& side = sideOf<S>();
+        VenueLevel heads[MAX_VENUES];
+        size_t heapSize = 0;
+        auto worse = [](const VenueLevel& level, const VenueLevel& other) { return Better<S>(other, level); };
+        for (size_t venue = 0; venue < MAX_VENUES; ++venue) {
+            side.contributed[venue] = 0;
+            if (venues[venue] != nullptr && venues[venue]->template count<S>() > 0) {
+                heads[heapSize++] = Level<S>(static_cast<VenueId>(venue), 0);
+            }
+        }
+        std::make_heap(heads, heads + heapSize, worse);
+
+        side.count = 0;
+        while (side.count < Levels && heapSize > 0) {
+            std::pop_heap(heads, heads + heapSize, worse);
+            auto best = heads[--heapSize];
+            side.depth[side.count++] = best;
+            auto next = ++side.contributed[best.venue];
+            if (next < venues[best.venue]->template count<S>()) {
+                heads[heapSize++] = Level<S>(best.venue, next);
+                std::push_heap(heads, heads + heapSize, worse);
+            }
+        }
+        ++merges;
+    }
+
+    template <MarketUpdate::Side S>
+    bool apply(VenueId venue, size_t from)
+    {
+        auto& side = sideOf<S>();
+        auto nbbo = from == 0 && replay<S>(venue);
+        // levels below those of venue in depth and the next one stay out of it
+        if (from <= side.contributed[venue]) {
+            merge<S>();
+        }
+        return nbbo;
+    }
+
+public:
+    ConsolidatedBook()
+    {
+        for (auto& side : sides) {
+            std::fill(std::begin(side.tree), std::end(side.tree), NO_VENUE);
+            std::fill(std::begin(side.tops), std::end(side.tops), VenueLevel { 0, 0, NO_VENUE });
+        }
+    }
+
+    // follows the book of venue through its analytics, which must outlive the consolidated book
+    void subscribe(VenueId venue, const Analytics& analytics)
+    {
+        venues[venue] = &analytics;
+        reset(venue);
+    }
+
+    // the analytics of venue just applied change, returns whether the best bid or ask across venues changed
+    bool apply(VenueId venue, const typename Analytics::Change& change)
+    {
+        if (!change.changed) {
+            return false;
+        }
+        auto nbbo = change.side == MarketUpdate::Side::BID ? apply<MarketUpdate::Side::BID>(venue, change.from)
+                                                            : apply<MarketUpdate::Side::ASK>(venue, change.from);
+        if (nbbo) {
+            ++nbboChanges;
+        }
+        return nbbo;
+    }
+
+    // the analytics of venue were reset, as when its book is cleared
+    void reset(VenueId venue)
+    {
+        replay<MarketUpdate::Side::BID>(venue);
+        replay<MarketUpdate::Side::ASK>(venue);
+        merge<MarketUpdate::Side::BID>();
+        merge<MarketUpdate::Side::ASK>();
+    }
+
+    // best level across venues, and the venue it rests on
+    template <MarketUpdate::Side S>
+    std::optional<VenueLevel> best() const
+    {
+        auto winner = sideOf<S>().tree[1];
+        if (winner == NO_VENUE) {
+            return std::nullopt;
+        }
+        return sideOf<S>().tops[winner];
+    }
+
+    std::optional<VenueLevel> bestBid() const
+    {
+        return best<MarketUpdate::Side::BID>();
+    }
+
+    std::optional<VenueLevel> bestAsk() const
+    {
+        return best<MarketUpdate::Side::ASK>();
+    }
+
+    // levels in the merged depth of side S
+    template <MarketUpdate::Side S>
+    size_t count() const
+    {
+        return sideOf<S>().count;
+    }
+
+    // index from the best level across venues on, below count<S>()
+    template <MarketUpdate::Side S>
+    const VenueLevel& level(size_t index) const
+    {
+        return sideOf<S>().depth[index];
+    }
+
+    // times the depth of either side was merged again
+    uint64_t depthMerges() const
+    {
+        return merges;
+    }
+
+    // changes of the best bid or ask across venues
+    uint64_t bboChanges() const
+    {
+        return nbboChanges;
+    }
+
+    void print(std::ostream& out, size_t depth = 5) const
+    {
+        out << "Asks:\n";
+        for (size_t i = 0; i < std::min(depth, count<MarketUpdate::Side::ASK>()); ++i) {
+            const auto& level = this->level<MarketUpdate::Side::ASK>(i);
+            out << level.price << " @" << level.size << " on venue " << static_cast<int>(level.venue) << "\n";
+        }
+        out << "Bids:\n";
+        for (size_t i = 0; i < std::min(depth, count<MarketUpdate::Side::BID>()); ++i) {
+            const auto& level = this->level<MarketUpdate::Side::BID>(i);
+            out << level.price << " @" << level.size << " on venue " << static_cast<int>(level.venue) << "\n";
+        }
+        out << std::flush;
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
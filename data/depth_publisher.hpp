@@ -0,0 +1,252 @@
+#ifndef CRYPTO_TRADING_INFRA_DEPTH_PUBLISHER
+#define CRYPTO_TRADING_INFRA_DEPTH_PUBLISHER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "book_analytics.hpp"
+#include "book_state.hpp"
+#include "market_update.hpp"
+#include "ring_buffer.hpp"
+#include "seqlock.hpp"
+#include "shared_memory.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr uint64_t DEPTH_MAGIC = 0x4854504544495443; // "CTIDEPTH"
+constexpr uint32_t DEPTH_VERSION = 3;
+
+/*
+ * Fixed layout of a depth segment, shared by the publisher and every reader. Levels are atomics accessed
+ * with relaxed ordering under the seqlock, any change to the layout must come with a new DEPTH_VERSION.
+ */
+template <size_t Levels>
+struct DepthRegion {
+    struct Level {
+        std::atomic<Price> price;
+        std::atomic<Size> size;
+    };
+
+    struct Side {
+        std::atomic<uint32_t> count;
+        Level levels[Levels];
+    };
+
+    struct Features {
+        std::atomic<Price> microprice;
+        std::atomic<double> imbalance;
+        std::atomic<Size> bidDepth;
+        std::atomic<Size> askDepth;
+        std::atomic<Price> bidVwap;
+        std::atomic<Price> askVwap;
+        std::atomic<uint32_t> bidChecksum;
+        std::atomic<uint32_t> askChecksum;
+        std::atomic<uint32_t> checksum;
+    };
+
+    std::atomic<uint64_t> magic; // stored last by the publisher, the segment is not usable before
+    uint32_t version;
+    uint32_t levels;
+    InstrumentId instrument;
+    CACHE_LINE_ALIGNED Utils::SeqLock lock;
+    Side bids;
+    Side asks;
+    Features features;
+};
+
+// segment the depth of instrument is published into, prefix follows shm_open rules
+inline std::string DepthSegmentName(const std::string& prefix, InstrumentId instrument)
+{
+    return prefix + "_" + std::to_string(instrument);
+}
+
+template <size_t Levels>
+struct DepthSnapshot {
+    // number of changes published before this snapshot was taken
+    uint64_t version = 0;
+    size_t bidCount = 0;
+    size_t askCount = 0;
+    std::array<BookState::Item, Levels> bids;
+    std::array<BookState::Item, Levels> asks;
+    BookFeatures features;
+};
+
+/*
+ * Publishes the top Levels levels of both sides of an OrderBook, along with the features computed over them,
+ * into a shared memory segment. It follows the BookAnalytics of the book, so only the slots an update moved
+ * are rewritten.
+ *
+ * Only the thread applying updates to the book may publish.
+ */
+template <size_t Levels = DEFAULT_DEPTH_LEVELS>
+class DepthPublisher
+{
+    using Region = DepthRegion<Levels>;
+    using Analytics = BookAnalytics<Levels>;
+
+    std::unique_ptr<Utils::SharedMemory> segment;
+    Region *region;
+
+    explicit DepthPublisher(std::unique_ptr<Utils::SharedMemory> segment)
+        : segment(std::move(segment)), region(static_cast<Region *>(this->segment->data()))
+    {
+    }
+
+    template <MarketUpdate::Side Side>
+    static void Store(typename Region::Side& shared, const Analytics& analytics, size_t from, size_t to)
+    {
+        for (auto i = from; i < to; ++i) {
+            auto [price, size] = analytics.template level<Side>(i);
+            shared.levels[i].price.store(price, std::memory_order_relaxed);
+            shared.levels[i].size.store(size, std::memory_order_relaxed);
+        }
+        shared.count.store(analytics.template count<Side>(), std::memory_order_relaxed);
+    }
+
+    static void Store(typename Region::Features& shared, const BookFeatures& features)
+    {
+        shared.microprice.store(features.microprice, std::memory_order_relaxed);
+        shared.imbalance.store(features.imbalance, std::memory_order_relaxed);
+        shared.bidDepth.store(features.bidDepth, std::memory_order_relaxed);
+        shared.askDepth.store(features.askDepth, std::memory_order_relaxed);
+        shared.bidVwap.store(features.bidVwap, std::memory_order_relaxed);
+        shared.askVwap.store(features.askVwap, std::memory_order_relaxed);
+        shared.bidChecksum.store(features.bidChecksum, std::memory_order_relaxed);
+        shared.askChecksum.store(features.askChecksum, std::memory_order_relaxed);
+        shared.checksum.store(features.checksum, std::memory_order_relaxed);
+    }
+
+public:
+    // returns nullptr on failure, the book must still be empty
+    static std::unique_ptr<DepthPublisher> Create(const std::string& name, InstrumentId instrument)
+    {
+        auto segment = Utils::SharedMemory::Create(name, sizeof(Region));
+        if (!segment) {
+            return nullptr;
+        }
+
+        auto publisher = std::unique_ptr<DepthPublisher>(new DepthPublisher(std::move(segment)));
+        auto region = new (publisher->region) Region {};
+        region->version = DEPTH_VERSION;
+        region->levels = Levels;
+        region->instrument = instrument;
+        // features of an empty book
+        Store(region->features, Analytics().features());
+        region->magic.store(DEPTH_MAGIC, std::memory_order_release);
+        return publisher;
+    }
+
+    DepthPublisher(const DepthPublisher&) = delete;
+    DepthPublisher& operator=(const DepthPublisher&) = delete;
+
+    // change is what analytics returned for the update just applied to it
+    void publish(const Analytics& analytics, const typename Analytics::Change& change)
+    {
+        if (!change.changed) {
+            return;
+        }
+
+        region->lock.write([&]() {
+            if (change.side == MarketUpdate::Side::BID) {
+                Store<MarketUpdate::Side::BID>(region->bids, analytics, change.from, change.to);
+            } else {
+                Store<MarketUpdate::Side::ASK>(region->asks, analytics, change.from, change.to);
+            }
+            Store(region->features, analytics.features());
+        });
+    }
+
+    const std::string& segmentName() const
+    {
+        return segment->segmentName();
+    }
+};
+
+/*
+ * Reader of a segment filled by a DepthPublisher, possibly from another process. Reading never blocks the
+ * publisher and never touches anything but the segment.
+ */
+template <size_t Levels = DEFAULT_DEPTH_LEVELS>
+class DepthReader
+{
+    using Region = DepthRegion<Levels>;
+
+    std::unique_ptr<Utils::SharedMemory> segment;
+    const Region *region;
+
+    explicit DepthReader(std::unique_ptr<Utils::SharedMemory> segment)
+        : segment(std::move(segment)), region(static_cast<const Region *>(this->segment->data()))
+    {
+    }
+
+    static void Load(const typename Region::Features& shared, BookFeatures& features)
+    {
+        features.microprice = shared.microprice.load(std::memory_order_relaxed);
+        features.imbalance = shared.imbalance.load(std::memory_order_relaxed);
+        features.bidDepth = shared.bidDepth.load(std::memory_order_relaxed);
+        features.askDepth = shared.askDepth.load(std::memory_order_relaxed);
+        features.bidVwap = shared.bidVwap.load(std::memory_order_relaxed);
+        features.askVwap = shared.askVwap.load(std::memory_order_relaxed);
+        features.bidChecksum = shared.bidChecksum.load(std::memory_order_relaxed);
+        features.askChecksum = shared.askChecksum.load(std::memory_order_relaxed);
+        features.checksum = shared.checksum.load(std::memory_order_relaxed);
+    }
+
+    static size_t Load(const typename Region::Side& shared, std::array<BookState::Item, Levels>& levels)
+    {
+        size_t count = std::min<size_t>(shared.count.load(std::memory_order_relaxed), Levels);
+        for (size_t i = 0; i < count; ++i) {
+            levels[i].first = shared.levels[i].price.load(std::memory_order_relaxed);
+            levels[i].second = shared.levels[i].size.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+public:
+    // returns nullptr if the segment does not exist or was created with another layout
+    static std::unique_ptr<DepthReader> Attach(const std::string& name)
+    {
+        auto segment = Utils::SharedMemory::Attach(name, sizeof(Region));
+        if (!segment) {
+            return nullptr;
+        }
+
+        auto reader = std::unique_ptr<DepthReader>(new DepthReader(std::move(segment)));
+        auto region = reader->region;
+        if (region->magic.load(std::memory_order_acquire) != DEPTH_MAGIC || region->version != DEPTH_VERSION ||
+            region->levels != Levels) {
+            std::cerr << "Shared memory segment " << name << " is not ready or has an incompatible layout\n"
+                      << std::flush;
+            return nullptr;
+        }
+        return reader;
+    }
+
+    DepthReader(const DepthReader&) = delete;
+    DepthReader& operator=(const DepthReader&) = delete;
+
+    InstrumentId instrument() const
+    {
+        return region->instrument;
+    }
+
+    void read(DepthSnapshot<Levels>& snapshot) const
+    {
+        snapshot.version = region->lock.read([&]() {
+            snapshot.bidCount = Load(region->bids, snapshot.bids);
+            snapshot.askCount = Load(region->asks, snapshot.asks);
+            Load(region->features, snapshot.features);
+        });
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef CRYPTO_TRADING_INFRA_FEED_MESSAGES
+#define CRYPTO_TRADING_INFRA_FEED_MESSAGES
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <arpa/inet.h>
+
+#include "market_update.hpp"
+#include "wire_schema.hpp"
+
+namespace CryptoTradingInfra {
+
+/*
+ * Compact feed of order book events. A packet is a FeedMessagesHeader followed by count messages, each one
+ * a byte of type then its fields, big endian and unpadded. Times are nanoseconds after the timestamp of the
+ * header and prices a number of ticks away from its base price, so most messages take under 30 bytes where a
+ * MarketUpdate takes 40.
+ */
+constexpr uint16_t PROTOCOL_FEED_MESSAGES = 0x666A;
+// keeps a packet within a single Ethernet frame
+constexpr size_t MAX_SIZE_FEED_MESSAGES = 1400;
+
+struct FeedMessagesHeader {
+    uint16_t protocol;
+    uint16_t count;
+    // numbers the packets of a feed, as MarketUpdateHeader does
+    uint64_t sequence;
+    uint64_t timestamp;
+    Price basePrice;
+    Price tickSize;
+
+    using Schema = Utils::Wire::Fields<&FeedMessagesHeader::protocol, &FeedMessagesHeader::count,
+                                       &FeedMessagesHeader::sequence, &FeedMessagesHeader::timestamp,
+                                       &FeedMessagesHeader::basePrice, &FeedMessagesHeader::tickSize>;
+};
+
+namespace FeedMessages {
+
+using Side = MarketUpdate::Side;
+
+// sent when there is nothing else to send, so receivers can tell a quiet feed from a dead one
+struct Heartbeat {
+    static constexpr uint8_t TYPE = 0;
+
+    uint32_t timeOffset;
+
+    using Schema = Utils::Wire::Fields<&Heartbeat::timeOffset>;
+};
+
+// size is added to the level at price
+struct AddOrder {
+    static constexpr uint8_t TYPE = 1;
+
+    uint32_t timeOffset;
+    InstrumentId instrument;
+    uint64_t sequence;
+    Side side;
+    int32_t priceOffset;
+    Size size;
+
+    using Schema = Utils::Wire::Fields<&AddOrder::timeOffset, &AddOrder::instrument, &AddOrder::sequence,
+                                       &AddOrder::side, &AddOrder::priceOffset, &AddOrder::size>;
+};
+
+// size is taken off the level at price
+struct CancelOrder {
+    static constexpr uint8_t TYPE = 2;
+
+    uint32_t timeOffset;
+    InstrumentId instrument;
+    uint64_t sequence;
+    Side side;
+    int32_t priceOffset;
+    Size size;
+
+    using Schema = Utils::Wire::Fields<&CancelOrder::timeOffset, &CancelOrder::instrument, &CancelOrder::sequence,
+                                       &CancelOrder::side, &CancelOrder::priceOffset, &CancelOrder::size>;
+};
+
+// an order resting at price went from oldSize to newSize
+struct ModifyOrder {
+    static constexpr uint8_t TYPE = 3;
+
+    uint32_t timeOffset;
+    InstrumentId instrument;
+    uint64_t sequence;
+    Side side;
+    int32_t priceOffset;
+    Size oldSize;
+    Size newSize;
+
+    using Schema = Utils::Wire::Fields<&ModifyOrder::timeOffset, &ModifyOrder::instrument, &ModifyOrder::sequence,
+                                       &ModifyOrder::side, &ModifyOrder::priceOffset, &ModifyOrder::oldSize,
+                                       &ModifyOrder::newSize>;
+};
+
+// side is the one of the aggressor, trades are not sequenced as the book changes they cause are sent apart
+struct Trade {
+    static constexpr uint8_t TYPE = 4;
+
+    uint32_t timeOffset;
+    InstrumentId instrument;
+    Side side;
+    int32_t priceOffset;
+    Size size;
+
+    using Schema = Utils::Wire::Fields<&Trade::timeOffset, &Trade::instrument, &Trade::side, &Trade::priceOffset,
+                                       &Trade::size>;
+};
+
+// the level at price holds size, whatever it held before; price is absolute as snapshots span the whole book
+struct SnapshotLevel {
+    static constexpr uint8_t TYPE = 5;
+
+    uint32_t timeOffset;
+    InstrumentId instrument;
+    uint64_t sequence;
+    Side side;
+    Price price;
+    Size size;
+
+    using Schema = Utils::Wire::Fields<&SnapshotLevel::timeOffset, &SnapshotLevel::instrument,
+                                       &SnapshotLevel::sequence, &SnapshotLevel::side, &SnapshotLevel::price,
+                                       &SnapshotLevel::size>;
+};
+
+using Codec = Utils::Wire::Dispatcher<Heartbeat, AddOrder, CancelOrder, ModifyOrder, Trade, SnapshotLevel>;
+
+constexpr size_t HEADER_SIZE = Utils::Wire::WireSize<FeedMessagesHeader>();
+
+static_assert(HEADER_SIZE == 36, "FeedMessagesHeader is not packed");
+static_assert(Utils::Wire::WireSize<AddOrder>() == 29, "AddOrder is not packed");
+static_assert(Utils::Wire::WireSize<ModifyOrder>() == 37, "ModifyOrder is not packed");
+static_assert(Codec::MAX_TAGGED_SIZE < sizeof(MarketUpdate), "Messages are meant to be smaller than MarketUpdate");
+
+/*
+ * Turns messages into the MarketUpdates the engine works on. Adds, cancels and modifies become changes of the
+ * size of a level, a snapshot level a SNAPSHOT update replacing it. Messages that leave the book as it was,
+ * such as an add of nothing, are not delivered since a size of 0 would remove the level; feeds are expected
+ * not to send them. Trades are only counted for now.
+ */
+template <typename Deliver>
+class Translator
+{
+    const FeedMessagesHeader& header;
+    Deliver& deliver;
+
+    uint64_t Time(uint32_t offset) const
+    {
+        return header.timestamp + offset;
+    }
+
+    Price PriceOf(int32_t offset) const
+    {
+        return header.basePrice + offset * header.tickSize;
+    }
+
+    template <typename Message>
+    void change(const Message& message, Size size)
+    {
+        if (size != 0) {
+            deliver(MarketUpdate(message.side, PriceOf(message.priceOffset), size, Time(message.timeOffset),
+                                 message.instrument, message.sequence));
+        }
+    }
+
+public:
+    uint64_t trades = 0;
+
+    Translator(const FeedMessagesHeader& header, Deliver& deliver) : header(header), deliver(deliver)
+    {
+    }
+
+    void operator()(const Heartbeat&)
+    {
+    }
+
+    void operator()(const AddOrder& message)
+    {
+        change(message, message.size);
+    }
+
+    void operator()(const CancelOrder& message)
+    {
+        change(message, -message.size);
+    }
+
+    void operator()(const ModifyOrder& message)
+    {
+        change(message, message.newSize - message.oldSize);
+    }
+
+    void operator()(const Trade&)
+    {
+        ++trades;
+    }
+
+    void operator()(const SnapshotLevel& message)
+    {
+        deliver(MarketUpdate(message.side, message.price, message.size, Time(message.timeOffset), message.instrument,
+                             message.sequence, MarketUpdate::SNAPSHOT));
+    }
+};
+
+} // namespace FeedMessages
+
+// decodes the header of a received packet, returns false if it is not a packet of messages
+inline bool ParseFeedMessagesHeader(const char *buffer, size_t received, FeedMessagesHeader& header)
+{
+    if (received < FeedMessages::HEADER_SIZE || received > MAX_SIZE_FEED_MESSAGES) {
+        return false;
+    }
+
+    uint16_t protocol;
+    std::memcpy(&protocol, buffer, sizeof(protocol));
+    if (ntohs(protocol) != PROTOCOL_FEED_MESSAGES) {
+        return false;
+    }
+
+    Utils::Wire::Decode(buffer, header);
+    return true;
+}
+
+// builds a packet of messages in place, the header being written once the packet is complete
+class FeedMessagesWriter
+{
+    FeedMessagesHeader header;
+    char *buffer;
+    char *end;
+    char *next;
+
+public:
+    // buffer must hold MAX_SIZE_FEED_MESSAGES bytes
+    FeedMessagesWriter(char *buffer, uint64_t sequence, uint64_t timestamp, Price basePrice, Price tickSize)
+        : header { PROTOCOL_FEED_MESSAGES, 0, sequence, timestamp, basePrice, tickSize }, buffer(buffer),
+          end(buffer + MAX_SIZE_FEED_MESSAGES), next(buffer + FeedMessages::HEADER_SIZE)
+    {
+    }
+
+    // returns false, leaving the packet as it was, if message does not fit
+    template <typename Message>
+    bool append(const Message& message)
+    {
+        if (end - next < static_cast<ptrdiff_t>(1 + Utils::Wire::WireSize<Message>())) {
+            return false;
+        }
+        next = Utils::Wire::EncodeTagged(message, next);
+        ++header.count;
+        return true;
+    }
+
+    uint16_t count() const
+    {
+        return header.count;
+    }
+
+    // writes the header, returns the length of the packet
+    size_t finish()
+    {
+        Utils::Wire::Encode(header, buffer);
+        return next - buffer;
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -11,25 +11,35 @@ namespace CryptoTradingInfra {
 
 using Price = double;
 using Size = double;
+using InstrumentId = uint32_t;
+// account an order is sent for, market data carrying none
+using AccountId = uint16_t;
+constexpr AccountId NO_ACCOUNT = 0;
 
 #pragma pack(1)
 constexpr uint16_t PROTOCOL_MARKET_UPDATE = 0x6666;
+// same layout as market updates, size being what is left at the level rather than a change
+constexpr uint16_t PROTOCOL_BOOK_DELTA = 0x6667;
 constexpr uint16_t MAX_COUNT_MARKET_UPDATE = 20;
 
 struct MarketUpdateHeader {
     uint16_t protocol;
     uint16_t count;
+    // numbers the packets of a feed, so lost and duplicate packets can be told apart
+    uint64_t sequence;
 
     void hton()
     {
         protocol = htons(protocol);
         count = htons(count);
+        sequence = Utils::Network::Hton64(sequence);
     }
 
     void ntoh()
     {
         protocol = ntohs(protocol);
         count = ntohs(count);
+        sequence = Utils::Network::Ntoh64(sequence);
     }
 };
 
@@ -39,20 +49,46 @@ struct MarketUpdate {
         BID = 1,
     };
 
+    // CLEAR_BOOK and SNAPSHOT rebuild books: they are set on the receiving side on updates it generates,
+    // MarketUpdate feeds leave them 0, and updates carrying either never reach the TradingEngine.
+    // IMMEDIATE_OR_CANCEL and TIMED are the time in force of an order, set by the feed and only looked at by the
+    // TradingEngine, so they mean nothing next to the other two. An order flagged with neither rests until
+    // traded, and one flagged with both is IMMEDIATE_OR_CANCEL, as nothing of it is left resting to expire.
+    enum Flags : uint8_t {
+        // the book of the instrument is emptied, nothing else in the update is used
+        CLEAR_BOOK = 1 << 0,
+        // a level of a snapshot rather than a market event, size replaces what the level held
+        SNAPSHOT = 1 << 1,
+        // what does not trade right away is cancelled rather than left resting in the TradingEngine
+        IMMEDIATE_OR_CANCEL = 1 << 2,
+        // what is left resting expires once the order lifetime of the TradingEngine has passed
+        TIMED = 1 << 3,
+    };
+
     uint64_t timestamp;
     Price price;
     Size size;
     Side side;
-    char resv[sizeof(uint64_t) - sizeof(side)];
+    uint8_t flags;
+    // in what used to be padding, so feeds sending none leave it NO_ACCOUNT
+    AccountId account;
+    InstrumentId instrument;
+    // numbers the updates of each instrument from 1 on, 0 when the feed does not sequence them
+    uint64_t sequence;
 
     MarketUpdate() = default;
 
-    MarketUpdate(Side side, Price price, Size size, uint64_t timestamp = 0) : resv{0}
+    MarketUpdate(Side side, Price price, Size size, uint64_t timestamp = 0, InstrumentId instrument = 0,
+                 uint64_t sequence = 0, uint8_t flags = 0)
+        : account(NO_ACCOUNT)
     {
         this->timestamp = timestamp;
         this->price = price;
         this->size = size;
         this->side = side;
+        this->flags = flags;
+        this->instrument = instrument;
+        this->sequence = sequence;
     }
 
     void hton()
@@ -60,6 +96,9 @@ struct MarketUpdate {
         timestamp = Utils::Network::Hton64(timestamp);
         price = Utils::Network::Hton64(price);
         size = Utils::Network::Hton64(size);
+        account = htons(account);
+        instrument = htonl(instrument);
+        sequence = Utils::Network::Hton64(sequence);
     }
 
     void ntoh()
@@ -67,6 +106,9 @@ struct MarketUpdate {
         timestamp = Utils::Network::Ntoh64(timestamp);
         price = Utils::Network::Ntoh64(price);
         size = Utils::Network::Ntoh64(size);
+        account = ntohs(account);
+        instrument = ntohl(instrument);
+        sequence = Utils::Network::Ntoh64(sequence);
     }
 };
 
@@ -1,156 +1,106 @@
 #include "order_book.hpp"
 
 #include <cstddef>
-#include <memory>
-#include <atomic>
 #include <optional>
 #include <iostream>
-#include <thread>
-#include <utility>
-#include <type_traits>
+#include <vector>
 
 #include "market_update.hpp"
 
 namespace CryptoTradingInfra {
 
-BookState::BidsNAsks::operator Bids&()
-{
-    return bids;
-}
-
-BookState::BidsNAsks::operator Asks&()
-{
-    return asks;
-}
-
-BookState::BidsNAsks::operator const Bids&() const
-{
-    return bids;
-}
+namespace {
 
-BookState::BidsNAsks::operator const Asks&() const
+void Sequence(BookState& state, uint64_t sequence)
 {
-    return asks;
-}
-
-template <MarketUpdate::Side Side>
-void BookState::updateState(Price price, Size size)
-{
-    using Chosen = std::conditional_t<Side == MarketUpdate::Side::BID, Bids, Asks>;
-    Chosen& side = bidsNAsks;
-
-    // when size is 0, it's meant to remove the price level in the book
-    if (size == 0.0) {
-        side.erase(price);
-    } else {
-        side[price] += size;
-    }
-
-    if (side.size() > MAX_DEPTH) {
-        side.erase(std::prev(side.end()));
+    if (sequence != 0) {
+        state.sequence = sequence;
     }
 }
 
-template <MarketUpdate::Side Side>
-bool BookState::empty() const
+// drops every level, the book stays at the sequence it was
+void Empty(BookState& state)
 {
-    using Chosen = std::conditional_t<Side == MarketUpdate::Side::BID, Bids, Asks>;
-    const Chosen& side = bidsNAsks;
-    return side.empty();
+    const BookState empty(state.tickSize());
+    auto sequence = state.sequence;
+    state = empty;
+    state.sequence = sequence;
 }
 
-template <MarketUpdate::Side Side>
-std::optional<std::pair<Price, Size>> BookState::Best() const
+Size Apply(BookState& state, const MarketUpdate& update)
 {
-    if (empty<Side>()) {
-        return std::nullopt;
+    Sequence(state, update.sequence);
+    // a snapshot level replaces whatever the level held
+    bool replace = (update.flags & MarketUpdate::SNAPSHOT) != 0;
+    if (update.side == MarketUpdate::Side::BID) {
+        if (replace) {
+            state.updateState<MarketUpdate::Side::BID>(update.price, 0);
+        }
+        return state.updateState<MarketUpdate::Side::BID>(update.price, update.size);
     }
-
-    using Chosen = std::conditional_t<Side == MarketUpdate::Side::BID, Bids, Asks>;
-    const Chosen& side = bidsNAsks;
-    auto best = side.begin();
-    return std::make_pair(best->first, best->second);
+    if (replace) {
+        state.updateState<MarketUpdate::Side::ASK>(update.price, 0);
+    }
+    return state.updateState<MarketUpdate::Side::ASK>(update.price, update.size);
 }
 
-std::optional<BookState::Item> BookState::bestBid() const
-{
-    return Best<MarketUpdate::Side::BID>();
-}
+} // namespace
 
-std::optional<BookState::Item> BookState::bestAsk() const
+LevelUpdate OrderBook::updateOrderBook(const MarketUpdate& update)
 {
-    return Best<MarketUpdate::Side::ASK>();
+    LevelUpdate level { update.side, update.price, 0 };
+    bookState.update([&](BookState& state) {
+        level.size = Apply(state, update);
+    });
+    return level;
 }
 
-void BookState::print(size_t depth) const
+void OrderBook::updateOrderBook(const MarketUpdate *updates, size_t count)
 {
-    depth = std::min(depth, MAX_DEPTH);
-
-    std::cout << "Asks:\n";
-    int count = 0;
-    for (auto& [price, size] : bidsNAsks.asks) {
-        std::cout << price << " @" << size << "\n";
-        if (++count >= depth) {
-            break;
+    // readers only ever see the book before or after the whole batch, which costs one copy instead of count
+    bookState.update([&](BookState& state) {
+        for (size_t i = 0; i < count; ++i) {
+            if (updates[i].flags & MarketUpdate::CLEAR_BOOK) {
+                Empty(state);
+                Sequence(state, updates[i].sequence);
+            } else {
+                Apply(state, updates[i]);
+            }
         }
-    }
-    std::cout << "Bids:\n";
-    count = 0;
-    for (auto& [price, size] : bidsNAsks.bids) {
-        std::cout << price << " @" << size << "\n";
-        if (++count >= depth) {
-            break;
-        }
-    }
+    });
 }
 
-OrderBook::OrderBook()
+std::vector<LevelUpdate> OrderBook::clear(uint64_t sequence)
 {
-    std::atomic_store(&bookState, std::make_shared<BookState>());
-}
-
-void OrderBook::updateOrderBook(const MarketUpdate& update)
-{
-    while (true) {
-        auto oldState = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-        auto newState = std::make_shared<BookState>(*oldState);
-
-        MarketUpdate::Side side = update.side;
-        Price price = update.price;
-        Size remaining = update.size;
-
-        if (side == MarketUpdate::Side::BID) {
-            newState->updateState<MarketUpdate::Side::BID>(update.price, update.size);
-        } else {
-            newState->updateState<MarketUpdate::Side::ASK>(update.price, update.size);
+    std::vector<LevelUpdate> removed;
+    bookState.update([&](BookState& state) {
+        removed.clear();
+        for (const auto& [price, size] : state.bidsNAsks.bids) {
+            removed.push_back({ MarketUpdate::Side::BID, price, 0 });
         }
-
-        if (std::atomic_compare_exchange_weak_explicit(&bookState, &oldState, newState, std::memory_order_release,
-                                                       std::memory_order_acquire)) {
-            break;
+        for (const auto& [price, size] : state.bidsNAsks.asks) {
+            removed.push_back({ MarketUpdate::Side::ASK, price, 0 });
         }
-
-        std::this_thread::yield();
-    }
+        Empty(state);
+        Sequence(state, sequence);
+    });
+    return removed;
 }
 
 std::optional<BookState::Item> OrderBook::bestBid() const
 {
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    return state->bestBid();
+    return bookState.read()->bestBid();
 }
 
 std::optional<BookState::Item> OrderBook::bestAsk() const
 {
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    return state->bestAsk();
+    return bookState.read()->bestAsk();
 }
 
 void OrderBook::print(size_t depth) const
 {
     std::cout << "====OrderBook====" << std::endl;
-    auto state = std::atomic_load_explicit(&bookState, std::memory_order_acquire);
-    state->print(depth);
+    bookState.read()->print(depth);
 }
 
 } // namespace CryptoTradingInfra
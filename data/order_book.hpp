@@ -2,69 +2,36 @@
 #define CRYPTO_TRADING_INFRA_ORDER_BOOK
 
 #include <cstddef>
-#include <functional>
-#include <map>
-#include <memory>
+#include <cstdint>
 #include <optional>
-#include <utility>
+#include <vector>
 
+#include "book_state.hpp"
+#include "epoch_snapshot.hpp"
 #include "market_update.hpp"
 
 namespace CryptoTradingInfra {
 
-class BookState
-{
-    static constexpr size_t MAX_DEPTH = 100;
-
-    template <MarketUpdate::Side Side>
-    std::optional<std::pair<Price, Size>> Best() const;
-public:
-    using Item = std::pair<Price, Size>;
-    using Bids = std::map<Item::first_type, Item::second_type, std::greater<>>;
-    using Asks = std::map<Item::first_type, Item::second_type, std::less<>>;
-
-    struct BidsNAsks {
-        Bids bids;
-        Asks asks;
-
-        operator Bids&();
-        operator Asks&();
-
-        operator const Bids&() const;
-        operator const Asks&() const;
-    } bidsNAsks;
-
-    BookState() = default;
-
-    BookState(const BookState& other) = default;
-    BookState& operator=(const BookState& other) = default;
-
-    // It is not allowed to move by design, thread should make a copy of the instance first
-    // if it wishes to perform an update
-    BookState(BookState&& other) = delete;
-    BookState& operator=(BookState&& other) = delete;
-
-    template <MarketUpdate::Side Side>
-    void updateState(Price price, Size size);
-
-    template <MarketUpdate::Side Side>
-    bool empty() const;
-
-    std::optional<Item> bestBid() const;
-    std::optional<Item> bestAsk() const;
-
-    void print(size_t depth) const;
-};
-
 class OrderBook
 {
 private:
-    std::shared_ptr<BookState> bookState;
+    Utils::EpochSnapshot<BookState> bookState;
 
 public:
-    OrderBook();
-
-    void updateOrderBook(const MarketUpdate& update);
+    LevelUpdate updateOrderBook(const MarketUpdate& update);
+    // applies updates in order as a single new version of the book, CLEAR_BOOK emptying it on the way
+    void updateOrderBook(const MarketUpdate *updates, size_t count);
+
+    // empties both sides as of the update numbered sequence, returns every level removed
+    std::vector<LevelUpdate> clear(uint64_t sequence = 0);
+
+    // inspect is invoked on the latest version of the book, which stays pinned until it returns
+    template <typename F>
+    auto read(F&& inspect) const
+    {
+        auto state = bookState.read();
+        return inspect(*state);
+    }
 
     std::optional<BookState::Item> bestBid() const;
     std::optional<BookState::Item> bestAsk() const;
@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stream_vbyte.hpp"
+#include "tick_store.hpp"
+
+namespace CryptoTradingInfra {
+
+namespace {
+
+using Utils::StreamVByte::FitsZigZag;
+using Utils::StreamVByte::UnZigZag;
+using Utils::StreamVByte::ZigZag;
+
+constexpr std::array<double, TICK_STORE_MAX_DECIMALS + 1> POWERS { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+// integers beyond this are no longer exact as doubles
+constexpr double MAX_EXACT = 9007199254740992.0;
+
+size_t Slot(InstrumentId instrument)
+{
+    return instrument & (TICK_STORE_SLOTS - 1);
+}
+
+// value as an integer of decimals decimals, false if that does not give value back exactly
+bool Scale(double value, uint8_t decimals, int64_t& scaled)
+{
+    auto raised = value * POWERS[decimals];
+    if (!(std::fabs(raised) < MAX_EXACT)) {
+        return false;
+    }
+    scaled = std::llround(raised);
+    // dividing by an exact power of ten is correctly rounded, so it lands on value whenever value has that many
+    // decimals; -0.0 is told apart by its bits
+    auto back = static_cast<double>(scaled) / POWERS[decimals];
+    return std::memcmp(&back, &value, sizeof(value)) == 0;
+}
+
+// fewest decimals coding every price as deltas within its slot, TICK_STORE_RAW if there are none
+uint8_t PriceDecimals(const std::vector<MarketUpdate>& updates)
+{
+    for (uint8_t decimals = 0; decimals <= TICK_STORE_MAX_DECIMALS; ++decimals) {
+        std::array<int64_t, TICK_STORE_SLOTS> last {};
+        bool fits = true;
+        for (size_t i = 0; fits && i < updates.size(); ++i) {
+            int64_t scaled;
+            auto& previous = last[Slot(updates[i].instrument)];
+            fits = Scale(updates[i].price, decimals, scaled) && FitsZigZag(scaled - previous);
+            previous = scaled;
+        }
+        if (fits) {
+            return decimals;
+        }
+    }
+    return TICK_STORE_RAW;
+}
+
+uint8_t SizeDecimals(const std::vector<MarketUpdate>& updates)
+{
+    for (uint8_t decimals = 0; decimals <= TICK_STORE_MAX_DECIMALS; ++decimals) {
+        bool fits = true;
+        for (size_t i = 0; fits && i < updates.size(); ++i) {
+            int64_t scaled;
+            fits = Scale(updates[i].size, decimals, scaled) && FitsZigZag(scaled);
+        }
+        if (fits) {
+            return decimals;
+        }
+    }
+    return TICK_STORE_RAW;
+}
+
+template <typename T>
+void Append(std::vector<uint8_t>& buffer, const T& value)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+// codes values at the end of buffer, returns the bytes it took
+uint32_t AppendCoded(std::vector<uint8_t>& buffer, const std::vector<uint32_t>& values)
+{
+    auto start = buffer.size();
+    buffer.resize(start + Utils::StreamVByte::MaxEncodedSize(values.size()));
+    auto length = Utils::StreamVByte::Encode(values.data(), values.size(), buffer.data() + start);
+    buffer.resize(start + length);
+    return static_cast<uint32_t>(length);
+}
+
+} // namespace
+
+TickStoreWriter::TickStoreWriter(int fd) : fd(fd), offset(sizeof(TickStoreHeader))
+{
+    pending.reserve(TICK_CHUNK_SIZE);
+}
+
+std::unique_ptr<TickStoreWriter> TickStoreWriter::Create(const std::string& path)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return nullptr;
+    }
+
+    auto writer = std::unique_ptr<TickStoreWriter>(new TickStoreWriter(fd));
+    TickStoreHeader header { TICK_STORE_MAGIC, TICK_STORE_VERSION, static_cast<uint32_t>(TICK_CHUNK_SIZE) };
+    if (!writer->write(&header, sizeof(header))) {
+        return nullptr;
+    }
+    writer->offset = sizeof(header);
+    return writer;
+}
+
+TickStoreWriter::~TickStoreWriter()
+{
+    close();
+}
+
+bool TickStoreWriter::write(const void *data, size_t length)
+{
+    auto bytes = static_cast<const char *>(data);
+    while (!failed && length > 0) {
+        auto written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("write");
+            failed = true;
+            break;
+        }
+        bytes += written;
+        length -= written;
+    }
+    return !failed;
+}
+
+bool TickStoreWriter::append(const MarketUpdate& update)
+{
+    pending.push_back(update);
+    ++updates;
+    if (pending.size() == TICK_CHUNK_SIZE) {
+        return flushChunk();
+    }
+    return !failed;
+}
+
+bool TickStoreWriter::flushChunk()
+{
+    if (pending.empty()) {
+        return !failed;
+    }
+
+    auto count = pending.size();
+    TickChunkHeader header {};
+    header.count = static_cast<uint32_t>(count);
+    header.firstTime = pending[0].timestamp;
+    TickIndexEntry entry { offset, pending[0].timestamp, pending[0].timestamp, header.count, 0 };
+    for (const auto& update : pending) {
+        entry.minTime = std::min(entry.minTime, update.timestamp);
+        entry.maxTime = std::max(entry.maxTime, update.timestamp);
+    }
+
+    buffer.clear();
+    values.resize(count);
+    auto before = buffer.size();
+
+    // timestamps
+    bool narrow = true;
+    for (size_t i = 0; narrow && i < count; ++i) {
+        auto delta = static_cast<int64_t>(pending[i].timestamp - (i > 0 ? pending[i - 1].timestamp : header.firstTime));
+        narrow = FitsZigZag(delta);
+        values[i] = ZigZag(delta);
+    }
+    if (narrow) {
+        header.lengths[TickChunkHeader::TIMES] = AppendCoded(buffer, values);
+    } else {
+        header.encoding |= TickChunkHeader::WIDE_TIMES;
+        for (const auto& update : pending) {
+            Append(buffer, update.timestamp);
+        }
+        header.lengths[TickChunkHeader::TIMES] = static_cast<uint32_t>(buffer.size() - before);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = pending[i].instrument;
+    }
+    header.lengths[TickChunkHeader::INSTRUMENTS] = AppendCoded(buffer, values);
+
+    // sequences
+    before = buffer.size();
+    std::array<uint64_t, TICK_STORE_SLOTS> lastSequence {};
+    narrow = true;
+    for (size_t i = 0; narrow && i < count; ++i) {
+        auto& last = lastSequence[Slot(pending[i].instrument)];
+        auto delta = static_cast<int64_t>(pending[i].sequence - (last + 1));
+        narrow = FitsZigZag(delta);
+        values[i] = ZigZag(delta);
+        last = pending[i].sequence;
+    }
+    if (narrow) {
+        header.lengths[TickChunkHeader::SEQUENCES] = AppendCoded(buffer, values);
+    } else {
+        header.encoding |= TickChunkHeader::WIDE_SEQUENCES;
+        for (const auto& update : pending) {
+            Append(buffer, update.sequence);
+        }
+        header.lengths[TickChunkHeader::SEQUENCES] = static_cast<uint32_t>(buffer.size() - before);
+    }
+
+    // prices
+    before = buffer.size();
+    header.priceDecimals = PriceDecimals(pending);
+    if (header.priceDecimals != TICK_STORE_RAW) {
+        std::array<int64_t, TICK_STORE_SLOTS> lastPrice {};
+        for (size_t i = 0; i < count; ++i) {
+            int64_t scaled;
+            Scale(pending[i].price, header.priceDecimals, scaled);
+            auto& last = lastPrice[Slot(pending[i].instrument)];
+            values[i] = ZigZag(scaled - last);
+            last = scaled;
+        }
+        header.lengths[TickChunkHeader::PRICES] = AppendCoded(buffer, values);
+    } else {
+        for (const auto& update : pending) {
+            Append(buffer, update.price);
+        }
+        header.lengths[TickChunkHeader::PRICES] = static_cast<uint32_t>(buffer.size() - before);
+    }
+
+    // sizes
+    before = buffer.size();
+    header.sizeDecimals = SizeDecimals(pending);
+    if (header.sizeDecimals != TICK_STORE_RAW) {
+        for (size_t i = 0; i < count; ++i) {
+            int64_t scaled;
+            Scale(pending[i].size, header.sizeDecimals, scaled);
+            values[i] = ZigZag(scaled);
+        }
+        header.lengths[TickChunkHeader::SIZES] = AppendCoded(buffer, values);
+    } else {
+        for (const auto& update : pending) {
+            Append(buffer, update.size);
+        }
+        header.lengths[TickChunkHeader::SIZES] = static_cast<uint32_t>(buffer.size() - before);
+    }
+
+    // sides, then flags and accounts only if any
+    before = buffer.size();
+    buffer.resize(before + (count + 7) / 8, 0);
+    bool flagged = false;
+    bool accounted = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (pending[i].side == MarketUpdate::Side::BID) {
+            buffer[before + i / 8] |= 1 << (i % 8);
+        }
+        flagged = flagged || pending[i].flags != 0;
+        accounted = accounted || pending[i].account != NO_ACCOUNT;
+    }
+    header.lengths[TickChunkHeader::SIDES] = static_cast<uint32_t>((count + 7) / 8);
+    if (flagged) {
+        for (const auto& update : pending) {
+            buffer.push_back(update.flags);
+        }
+        header.lengths[TickChunkHeader::FLAGS] = static_cast<uint32_t>(count);
+    }
+    if (accounted) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = pending[i].account;
+        }
+        header.lengths[TickChunkHeader::ACCOUNTS] = AppendCoded(buffer, values);
+    }
+
+    pending.clear();
+    if (!write(&header, sizeof(header)) || !write(buffer.data(), buffer.size())) {
+        return false;
+    }
+    offset += sizeof(header) + buffer.size();
+    index.push_back(entry);
+    return true;
+}
+
+bool TickStoreWriter::close()
+{
+    if (fd < 0) {
+        return !failed;
+    }
+
+    flushChunk();
+    TickStoreFooter footer { offset, index.size(), updates, TICK_STORE_MAGIC };
+    write(index.data(), index.size() * sizeof(TickIndexEntry));
+    write(&footer, sizeof(footer));
+    ::close(fd);
+    fd = -1;
+    return !failed;
+}
+
+TickStoreReader::TickStoreReader(const uint8_t *mapped, size_t length, std::vector<TickIndexEntry> entries,
+                                 const TickStoreFooter& footer)
+    : mapped(mapped), length(length), entries(std::move(entries)), footer(footer), values(TICK_CHUNK_SIZE)
+{
+    batch.reserve(TICK_CHUNK_SIZE);
+}
+
+std::unique_ptr<TickStoreReader> TickStoreReader::Open(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open");
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(TickStoreHeader) + sizeof(TickStoreFooter)) {
+        std::fprintf(stderr, "%s: not a tick store\n", path.c_str());
+        ::close(fd);
+        return nullptr;
+    }
+    size_t length = info.st_size;
+    auto mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return nullptr;
+    }
+    // replays read the store front to back
+    madvise(mapped, length, MADV_SEQUENTIAL);
+
+    auto bytes = static_cast<const uint8_t *>(mapped);
+    TickStoreHeader header;
+    TickStoreFooter footer;
+    std::memcpy(&header, bytes, sizeof(header));
+    std::memcpy(&footer, bytes + length - sizeof(footer), sizeof(footer));
+    auto indexEnd = length - sizeof(footer);
+    auto indexBytes = indexEnd - footer.indexOffset;
+    bool valid = header.magic == TICK_STORE_MAGIC && header.version == TICK_STORE_VERSION &&
+                 header.chunkSize == TICK_CHUNK_SIZE && footer.magic == TICK_STORE_MAGIC &&
+                 footer.indexOffset <= indexEnd && indexBytes / sizeof(TickIndexEntry) == footer.chunks &&
+                 indexBytes % sizeof(TickIndexEntry) == 0;
+    std::vector<TickIndexEntry> entries(valid ? footer.chunks : 0);
+    if (valid) {
+        std::memcpy(entries.data(), bytes + footer.indexOffset, entries.size() * sizeof(TickIndexEntry));
+    }
+    for (size_t i = 0; valid && i < footer.chunks; ++i) {
+        valid = entries[i].offset + sizeof(TickChunkHeader) <= footer.indexOffset &&
+                entries[i].count <= TICK_CHUNK_SIZE;
+    }
+    if (!valid) {
+        std::fprintf(stderr, "%s: incomplete or damaged tick store\n", path.c_str());
+        munmap(mapped, length);
+        return nullptr;
+    }
+    return std::unique_ptr<TickStoreReader>(new TickStoreReader(bytes, length, std::move(entries), footer));
+}
+
+TickStoreReader::~TickStoreReader()
+{
+    munmap(const_cast<uint8_t *>(mapped), length);
+}
+
+const std::vector<MarketUpdate> *TickStoreReader::decode(size_t index)
+{
+    const auto& entry = entries[index];
+    TickChunkHeader header;
+    std::memcpy(&header, mapped + entry.offset, sizeof(header));
+    size_t total = 0;
+    for (auto columnLength : header.lengths) {
+        total += columnLength;
+    }
+    auto count = header.count;
+    if (count != entry.count || total > footer.indexOffset - entry.offset - sizeof(header) ||
+        header.lengths[TickChunkHeader::SIDES] != (count + 7) / 8 ||
+        (header.lengths[TickChunkHeader::FLAGS] != 0 && header.lengths[TickChunkHeader::FLAGS] != count)) {
+        return nullptr;
+    }
+
+    const uint8_t *columns[TickChunkHeader::COLUMNS];
+    auto at = mapped + entry.offset + sizeof(header);
+    for (size_t column = 0; column < TickChunkHeader::COLUMNS; ++column) {
+        columns[column] = at;
+        at += header.lengths[column];
+    }
+    auto decodeColumn = [&](TickChunkHeader::Column column) {
+        return Utils::StreamVByte::Decode(columns[column], header.lengths[column], count, values.data()) ==
+               header.lengths[column];
+    };
+    auto rawColumn = [&](TickChunkHeader::Column column, size_t size) {
+        return header.lengths[column] == count * size;
+    };
+
+    batch.resize(count);
+    auto updates = batch.data();
+
+    if (header.encoding & TickChunkHeader::WIDE_TIMES) {
+        if (!rawColumn(TickChunkHeader::TIMES, sizeof(uint64_t))) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            auto time = columns[TickChunkHeader::TIMES] + i * sizeof(uint64_t);
+            std::memcpy(&updates[i].timestamp, time, sizeof(uint64_t));
+        }
+    } else {
+        if (!decodeColumn(TickChunkHeader::TIMES)) {
+            return nullptr;
+        }
+        auto timestamp = header.firstTime;
+        for (size_t i = 0; i < count; ++i) {
+            timestamp += UnZigZag(values[i]);
+            updates[i].timestamp = timestamp;
+        }
+    }
+
+    if (!decodeColumn(TickChunkHeader::INSTRUMENTS)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        updates[i].instrument = values[i];
+    }
+
+    if (header.encoding & TickChunkHeader::WIDE_SEQUENCES) {
+        if (!rawColumn(TickChunkHeader::SEQUENCES, sizeof(uint64_t))) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(&updates[i].sequence, columns[TickChunkHeader::SEQUENCES] + i * sizeof(uint64_t),
+                        sizeof(uint64_t));
+        }
+    } else {
+        if (!decodeColumn(TickChunkHeader::SEQUENCES)) {
+            return nullptr;
+        }
+        std::array<uint64_t, TICK_STORE_SLOTS> lastSequence {};
+        for (size_t i = 0; i < count; ++i) {
+            auto& last = lastSequence[Slot(updates[i].instrument)];
+            last += 1 + UnZigZag(values[i]);
+            updates[i].sequence = last;
+        }
+    }
+
+    if (header.priceDecimals == TICK_STORE_RAW) {
+        if (!rawColumn(TickChunkHeader::PRICES, sizeof(Price))) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(&updates[i].price, columns[TickChunkHeader::PRICES] + i * sizeof(Price), sizeof(Price));
+        }
+    } else {
+        if (header.priceDecimals > TICK_STORE_MAX_DECIMALS || !decodeColumn(TickChunkHeader::PRICES)) {
+            return nullptr;
+        }
+        std::array<int64_t, TICK_STORE_SLOTS> lastPrice {};
+        auto power = POWERS[header.priceDecimals];
+        for (size_t i = 0; i < count; ++i) {
+            auto& last = lastPrice[Slot(updates[i].instrument)];
+            last += UnZigZag(values[i]);
+            updates[i].price = static_cast<double>(last) / power;
+        }
+    }
+
+    if (header.sizeDecimals == TICK_STORE_RAW) {
+        if (!rawColumn(TickChunkHeader::SIZES, sizeof(Size))) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(&updates[i].size, columns[TickChunkHeader::SIZES] + i * sizeof(Size), sizeof(Size));
+        }
+    } else {
+        if (header.sizeDecimals > TICK_STORE_MAX_DECIMALS || !decodeColumn(TickChunkHeader::SIZES)) {
+            return nullptr;
+        }
+        auto power = POWERS[header.sizeDecimals];
+        for (size_t i = 0; i < count; ++i) {
+            updates[i].size = static_cast<double>(UnZigZag(values[i])) / power;
+        }
+    }
+
+    auto accounted = header.lengths[TickChunkHeader::ACCOUNTS] != 0;
+    if (accounted && !decodeColumn(TickChunkHeader::ACCOUNTS)) {
+        return nullptr;
+    }
+    auto sides = columns[TickChunkHeader::SIDES];
+    auto flags = header.lengths[TickChunkHeader::FLAGS] != 0 ? columns[TickChunkHeader::FLAGS] : nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        updates[i].side = (sides[i / 8] >> (i % 8)) & 1 ? MarketUpdate::Side::BID : MarketUpdate::Side::ASK;
+        updates[i].flags = flags != nullptr ? flags[i] : 0;
+        updates[i].account = accounted ? static_cast<AccountId>(values[i]) : NO_ACCOUNT;
+    }
+    return &batch;
+}
+
+} // namespace CryptoTradingInfra
@@ -0,0 +1,214 @@
+#ifndef CRYPTO_TRADING_INFRA_TICK_STORE
+#define CRYPTO_TRADING_INFRA_TICK_STORE
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+
+constexpr uint64_t TICK_STORE_MAGIC = 0x524f54534b434954; // "TICKSTOR"
+constexpr uint32_t TICK_STORE_VERSION = 1;
+// updates encoded together, the unit the time index and decoding work on
+constexpr size_t TICK_CHUNK_SIZE = 4096;
+// prices and sequences are coded against the last ones of the same slot, instruments sharing slots by id
+constexpr size_t TICK_STORE_SLOTS = 256;
+// a price or size column holds raw doubles when no number of decimals up to this codes it exactly
+constexpr uint8_t TICK_STORE_MAX_DECIMALS = 9;
+constexpr uint8_t TICK_STORE_RAW = 0xff;
+
+/*
+ * A tick store is a file of MarketUpdates split into chunks of columns: a TickStoreHeader, the chunks one
+ * after another, the index of the chunks and a TickStoreFooter pointing at it. Numbers are in host order.
+ *
+ * Within a chunk, every column but the sides and flags is Stream VByte coded:
+ *  - timestamps, as zig-zag deltas from the previous one, the first one being in the chunk header
+ *  - instruments
+ *  - sequences, as zig-zag deltas from the one following the previous sequence of the same slot
+ *  - prices, as zig-zag deltas of integers of priceDecimals decimals from the previous price of the same slot
+ *  - sizes, as zig-zag integers of sizeDecimals decimals
+ *  - sides, one bit per update
+ *  - flags, one byte per update, only there when some update of the chunk has flags
+ *  - accounts, only there when some update of the chunk has one
+ * A column whose values do not fit that coding is stored raw instead: 64-bit timestamps or sequences, or
+ * doubles for prices and sizes, as told by the chunk header. Decoding always gives back the exact updates.
+ */
+struct TickStoreHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t chunkSize;
+};
+
+struct TickChunkHeader {
+    enum Column : uint8_t {
+        TIMES,
+        INSTRUMENTS,
+        SEQUENCES,
+        PRICES,
+        SIZES,
+        SIDES,
+        FLAGS,
+        ACCOUNTS,
+        COLUMNS,
+    };
+
+    enum Encoding : uint8_t {
+        WIDE_TIMES = 1 << 0,
+        WIDE_SEQUENCES = 1 << 1,
+    };
+
+    uint32_t count;
+    uint8_t encoding;
+    uint8_t priceDecimals;
+    uint8_t sizeDecimals;
+    uint8_t resv;
+    uint64_t firstTime;
+    // bytes of every column, following the header in this order, accounts taking what used to be padding
+    uint32_t lengths[COLUMNS];
+};
+
+struct TickIndexEntry {
+    uint64_t offset;
+    uint64_t minTime;
+    uint64_t maxTime;
+    uint32_t count;
+    uint32_t resv;
+};
+
+struct TickStoreFooter {
+    uint64_t indexOffset;
+    uint64_t chunks;
+    uint64_t updates;
+    uint64_t magic;
+};
+
+// appends updates to a new tick store, a chunk at a time
+class TickStoreWriter
+{
+    int fd;
+    uint64_t offset;
+    std::vector<MarketUpdate> pending;
+    std::vector<TickIndexEntry> index;
+    uint64_t updates = 0;
+    bool failed = false;
+
+    std::vector<uint32_t> values;
+    std::vector<uint8_t> buffer;
+
+    explicit TickStoreWriter(int fd);
+
+    bool write(const void *data, size_t length);
+    bool flushChunk();
+
+public:
+    // replaces whatever is at path, returns nullptr if it cannot be created
+    static std::unique_ptr<TickStoreWriter> Create(const std::string& path);
+    // closes the store if close() was not called
+    ~TickStoreWriter();
+
+    TickStoreWriter(const TickStoreWriter&) = delete;
+    TickStoreWriter& operator=(const TickStoreWriter&) = delete;
+
+    // returns false once writing the file failed
+    bool append(const MarketUpdate& update);
+    // writes the last chunk and the index, returns false if the store is incomplete
+    bool close();
+
+    uint64_t updatesWritten() const
+    {
+        return updates;
+    }
+};
+
+/*
+ * Reads a tick store through a read only mapping, so a store that was read before is served straight from
+ * the page cache. Chunks are decoded column by column into batches of MarketUpdates, reusing the same buffers
+ * from one chunk to the next.
+ */
+class TickStoreReader
+{
+    const uint8_t *mapped;
+    size_t length;
+    // copied out of the mapping, where the index follows chunks of any length and so may sit unaligned
+    std::vector<TickIndexEntry> entries;
+    TickStoreFooter footer;
+
+    std::vector<uint32_t> values;
+    std::vector<MarketUpdate> batch;
+
+    TickStoreReader(const uint8_t *mapped, size_t length, std::vector<TickIndexEntry> entries,
+                    const TickStoreFooter& footer);
+
+public:
+    // returns nullptr if path is no complete tick store
+    static std::unique_ptr<TickStoreReader> Open(const std::string& path);
+    ~TickStoreReader();
+
+    TickStoreReader(const TickStoreReader&) = delete;
+    TickStoreReader& operator=(const TickStoreReader&) = delete;
+
+    size_t chunks() const
+    {
+        return footer.chunks;
+    }
+
+    uint64_t updates() const
+    {
+        return footer.updates;
+    }
+
+    size_t bytes() const
+    {
+        return length;
+    }
+
+    const TickIndexEntry& chunk(size_t index) const
+    {
+        return entries[index];
+    }
+
+    // decodes a chunk into a batch valid until the next call, nullptr if the chunk is damaged
+    const std::vector<MarketUpdate> *decode(size_t index);
+
+    // hands deliver(updates, count) every update timestamped within [from, to] in the order they were written,
+    // skipping the chunks the index rules out; returns false if a chunk is damaged
+    template <typename F>
+    bool replay(F&& deliver, uint64_t from = 0, uint64_t to = std::numeric_limits<uint64_t>::max())
+    {
+        for (size_t i = 0; i < chunks(); ++i) {
+            if (entries[i].maxTime < from || entries[i].minTime > to) {
+                continue;
+            }
+            auto decoded = decode(i);
+            if (decoded == nullptr) {
+                return false;
+            }
+            if (entries[i].minTime >= from && entries[i].maxTime <= to) {
+                deliver(decoded->data(), decoded->size());
+                continue;
+            }
+
+            // runs of updates within the range, as timestamps need not be ordered
+            size_t begin = 0;
+            for (size_t j = 0; j <= decoded->size(); ++j) {
+                auto inside = j < decoded->size() && (*decoded)[j].timestamp >= from && (*decoded)[j].timestamp <= to;
+                if (!inside) {
+                    if (j > begin) {
+                        deliver(decoded->data() + begin, j - begin);
+                    }
+                    begin = j + 1;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,98 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "bar_aggregator.hpp"
+#include "execution_engine.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+constexpr uint64_t SECOND = 1000000000;
+
+TradeEvent TradeAt(uint64_t timestamp, Price price, Size size)
+{
+    return TradeEvent { 3, timestamp, MarketUpdate::Side::BID, price, size };
+}
+
+struct ToBars : EventHandler {
+    BarAggregator& bars;
+
+    void onTrade(const TradeEvent& trade)
+    {
+        assert(trade.instrument == 7);
+        bars.onTrade(trade);
+    }
+};
+
+} // namespace
+
+void TestBarAggregator()
+{
+    auto second = BarSpec::Parse("1s");
+    auto volume = BarSpec::Parse("10v");
+    assert(second && second->kind == BarSpec::Kind::TIME && second->interval == SECOND && second->name() == "1s");
+    assert(BarSpec::Parse("250ms")->interval == SECOND / 4 && BarSpec::Parse("1m")->name() == "1m");
+    assert(volume && volume->kind == BarSpec::Kind::VOLUME && volume->volume == 10);
+    assert(!BarSpec::Parse("1x") && !BarSpec::Parse("-1s") && !BarSpec::Parse("v"));
+
+    auto ring = std::make_unique<BarRing>();
+    BarAggregator bars(3, { *second, *volume }, ring.get());
+
+    // a 1s bar from 5s on, the third trade filling the first volume bar and starting the next one
+    bars.onTrade(TradeAt(5 * SECOND + 100, 100, 4));
+    bars.onTrade(TradeAt(5 * SECOND + 200, 102, 2));
+    bars.onTrade(TradeAt(5 * SECOND + 300, 99, 6));
+    assert(bars.barsCompleted() == 1);
+
+    Bar bar;
+    assert(ring->pop(bar) && bar.spec == 1 && bar.instrument == 3);
+    assert(bar.open == 100 && bar.high == 102 && bar.low == 99 && bar.close == 99);
+    assert(bar.volume == 10 && bar.trades == 3 && bar.vwap() == (100 * 4 + 102 * 2 + 99 * 4) / 10.0);
+
+    // the next second completes the time bar, timestamps alone are enough
+    bars.advance(6 * SECOND);
+    assert(ring->pop(bar) && bar.spec == 0 && bar.start == 5 * SECOND && bar.end == 5 * SECOND + 300);
+    assert(bar.open == 100 && bar.high == 102 && bar.low == 99 && bar.close == 99 && bar.volume == 12);
+    assert(bar.trades == 3 && bar.vwap() == (100 * 4 + 102 * 2 + 99 * 6) / 12.0);
+    assert(!ring->pop(bar));
+
+    // a single large trade fills several volume bars at once
+    bars.onTrade(TradeAt(6 * SECOND, 101, 25));
+    assert(bars.barsCompleted() == 4 && bars.last(0)->spec == 1 && bars.last(0)->volume == 10);
+    assert(bars.last(0)->trades == 1 && bars.last(1)->open == 99 && bars.last(1)->close == 101);
+    assert(bars.last(4) == nullptr);
+
+    // trades of TradingEngine reach the bars of their instrument with the time of the update they matched
+    TradingEngine engine;
+    BarAggregator engineBars(7, { *second }, nullptr);
+    ToBars handler { {}, engineBars };
+    engine.match(MarketUpdate(MarketUpdate::Side::ASK, 101, 5, SECOND, 7), handler);
+    engine.match(MarketUpdate(MarketUpdate::Side::ASK, 102, 5, SECOND, 7), handler);
+    engine.match(MarketUpdate(MarketUpdate::Side::BID, 102, 8, SECOND + 1, 7), handler);
+    engineBars.advance(2 * SECOND);
+    const Bar *traded = engineBars.last();
+    assert(traded != nullptr && traded->start == SECOND && traded->trades == 2);
+    assert(traded->open == 101 && traded->close == 102 && traded->volume == 8);
+
+    // nobody draining the ring costs bars, never blocks the aggregator
+    BarAggregator flood(1, { *BarSpec::Parse("1v") }, ring.get());
+    while (ring->pop(bar)) {
+    }
+    for (size_t i = 0; i < BarRing::capacity() + 10; ++i) {
+        flood.onTrade(TradeAt(i, 100, 1));
+    }
+    assert(flood.barsCompleted() == BarRing::capacity() + 10 && flood.barsDropped() == 10);
+
+    std::cout << "BarAggregator: " << flood.barsCompleted() << " bars built, " << flood.barsDropped()
+              << " dropped once the ring was full." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
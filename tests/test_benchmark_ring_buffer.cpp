@@ -1,5 +1,6 @@
 #include <benchmark/benchmark.h>
 #include <boost/circular_buffer.hpp>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <mutex>
@@ -9,6 +10,15 @@
 
 #include "test_entries.hpp"
 
+#include <random>
+
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "perf_counters.hpp"
+#include "risk_gate.hpp"
+#include "ticket_ring_buffer.hpp"
+#include "timing_wheel.hpp"
+
 namespace CryptoTradingInfra {
 namespace BenchMark {
 
@@ -104,6 +114,133 @@ static void BenchMarkBoostRingBuffer(benchmark::State& state)
 
 BENCHMARK(BenchMarkBoostRingBuffer);
 
+// the same number of items pushed by 1 to 16 producers into the lane of a single consumer, as receivers do,
+// where producers compare and swap the tail of ConcurrentRingBuffer and take a ticket of TicketRingBuffer
+template <typename Buffer>
+static void BenchMarkRingBufferProducers(benchmark::State& state)
+{
+    constexpr int ITEMS = 160000;
+    const int producersNum = state.range(0);
+    for (auto _ : state) {
+        auto buffer = std::make_unique<Buffer>();
+        std::vector<std::thread> producers;
+        for (auto id = 0; id < producersNum; ++id) {
+            producers.emplace_back([&, id]() {
+                for (auto i = id; i < ITEMS; i += producersNum) {
+                    while (!buffer->push(i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        int value;
+        for (auto popped = 0; popped < ITEMS;) {
+            if (buffer->pop(value)) {
+                ++popped;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ITEMS);
+}
+BENCHMARK_TEMPLATE(BenchMarkRingBufferProducers, Utils::ConcurrentRingBuffer<int, 8192>)
+    ->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BenchMarkRingBufferProducers, Utils::TicketRingBuffer<int, 8192>)
+    ->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+// what applying an update to a book costs, with the hardware counters of the thread per update when it has them
+static void BenchMarkOrderBookApply(benchmark::State& state)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<> randTicks(-200, 200);
+    std::uniform_int_distribution<> randSize(0, 100);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::vector<MarketUpdate> updates;
+    for (auto i = 0; i < 4096; ++i) {
+        updates.emplace_back(static_cast<MarketUpdate::Side>(randSide(rng)), 100 + randTicks(rng) * 0.01,
+                             randSize(rng));
+    }
+
+    OrderBook book;
+    Utils::PerfCounters counters;
+    uint64_t before[Utils::PERF_EVENTS];
+    uint64_t after[Utils::PERF_EVENTS];
+    auto counted = counters.read(before);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.updateOrderBook(updates[i++ % updates.size()]));
+    }
+    if (counted && counters.read(after)) {
+        for (size_t event = 0; event < Utils::PERF_EVENTS; ++event) {
+            if (counters.available(static_cast<Utils::PerfEvent>(event))) {
+                state.counters[Utils::PERF_EVENT_NAMES[event]] =
+                    benchmark::Counter(after[event] - before[event], benchmark::Counter::kAvgIterations);
+            }
+        }
+    }
+}
+BENCHMARK(BenchMarkOrderBookApply);
+
+// an update handed from one stage to the next on the same thread, as the cooperative pipeline does
+template <typename Queue>
+static void BenchMarkStageHandoff(benchmark::State& state)
+{
+    auto queue = std::make_unique<Queue>();
+    MarketUpdate update(MarketUpdate::Side::BID, 100, 1);
+    MarketUpdate handed;
+    for (auto _ : state) {
+        queue->push(update);
+        queue->pop(handed);
+        benchmark::DoNotOptimize(handed);
+    }
+}
+BENCHMARK_TEMPLATE(BenchMarkStageHandoff, Utils::ConcurrentRingBuffer<MarketUpdate, 8192>);
+BENCHMARK_TEMPLATE(BenchMarkStageHandoff, Utils::LocalRingBuffer<MarketUpdate, 8192>);
+
+// an order checked against every limit of its account, as shards do before applying it
+static void BenchMarkRiskCheck(benchmark::State& state)
+{
+    auto limits = RiskLimits::Parse("size=100,band=0.05,position=1e9,notional=1e12,rate=1e9");
+    RiskGate gate(1, *limits);
+    std::vector<MarketUpdate> orders;
+    for (AccountId account = 1; account < RISK_ACCOUNTS; ++account) {
+        orders.emplace_back(static_cast<MarketUpdate::Side>(account % 2), 100 + account % 10 * 0.01, account % 100,
+                            account);
+        orders.back().account = account;
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        auto& order = orders[i++ % orders.size()];
+        order.timestamp += 1000;
+        benchmark::DoNotOptimize(gate.check(order, { 100, 10 }, { 100.1, 10 }));
+    }
+}
+BENCHMARK(BenchMarkRiskCheck);
+
+// an order given a lifetime of up to a second of microsecond ticks, half of them filled and cancelled before
+// the wheel reaches them
+static void BenchMarkOrderExpiry(benchmark::State& state)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint64_t> randLifetime(1, 1000000);
+    Utils::TimingWheel<uint32_t> wheel;
+    uint32_t expired = 0;
+    uint32_t i = 0;
+    for (auto _ : state) {
+        auto handle = wheel.schedule(wheel.now() + randLifetime(rng), i);
+        if (++i % 2 == 0) {
+            wheel.cancel(handle);
+        }
+        wheel.advance(wheel.now() + 1, [&](uint32_t) { ++expired; });
+    }
+    benchmark::DoNotOptimize(expired);
+}
+BENCHMARK(BenchMarkOrderExpiry);
+
 BENCHMARK_MAIN();
 
 } // namespace BenchMark
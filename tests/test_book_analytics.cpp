@@ -0,0 +1,160 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "book_analytics.hpp"
+#include "crc32c.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+constexpr size_t LEVELS = 5;
+
+bool Close(double a, double b)
+{
+    return (std::isnan(a) && std::isnan(b)) || std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+template <MarketUpdate::Side Side>
+std::vector<BookState::Item> TopLevels(const OrderBook& book)
+{
+    return book.read([](const BookState& state) {
+        std::vector<BookState::Item> levels;
+        for (size_t i = 0; i < LEVELS; ++i) {
+            auto level = state.level<Side>(i);
+            if (!level) {
+                break;
+            }
+            levels.push_back(*level);
+        }
+        return levels;
+    });
+}
+
+// walks the levels the way strategies used to
+Price Vwap(const std::vector<BookState::Item>& levels, Size size)
+{
+    Size left = size;
+    double notional = 0;
+    for (const auto& [price, available] : levels) {
+        auto taken = std::min(left, available);
+        notional += taken * price;
+        left -= taken;
+        if (left == 0) {
+            return notional / size;
+        }
+    }
+    return std::nan("");
+}
+
+template <MarketUpdate::Side Side>
+bool Matches(const BookAnalytics<LEVELS>& analytics, const std::vector<BookState::Item>& levels)
+{
+    if (analytics.count<Side>() != levels.size()) {
+        return false;
+    }
+    Size depth = 0;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        depth += levels[i].second;
+        if (analytics.level<Side>(i) != levels[i] || !Close(analytics.depth<Side>(i), depth)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void TestBookAnalytics()
+{
+    constexpr int UPDATES = 20000;
+    constexpr Size VWAP_SIZE = 8;
+
+    // the check value of CRC-32C, and a checksum extended piece by piece is the one of the whole
+    const char *check = "123456789";
+    assert(Utils::Crc32c(check, 9) == 0xe3069283);
+    assert(Utils::Crc32c(check + 4, 5, Utils::Crc32c(check, 4)) == 0xe3069283);
+    uint8_t bytes[1000];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    assert(Utils::Crc32c(bytes, sizeof(bytes)) == ~Utils::Detail::Crc32cSoftware(~0u, bytes, sizeof(bytes)));
+
+    // a book small enough to check by hand
+    OrderBook book;
+    BookAnalytics<LEVELS> analytics(VWAP_SIZE);
+    for (const auto& update : { MarketUpdate(MarketUpdate::Side::BID, 99, 3),
+                                MarketUpdate(MarketUpdate::Side::BID, 98, 6),
+                                MarketUpdate(MarketUpdate::Side::ASK, 101, 1) }) {
+        analytics.apply(book.updateOrderBook(update), book);
+    }
+    const auto& features = analytics.features();
+    assert(features.microprice == (99 * 1 + 101 * 3) / 4.0);
+    assert(features.imbalance == (9 - 1) / 10.0);
+    assert(features.bidVwap == (99 * 3 + 98 * 5) / 8.0 && std::isnan(features.askVwap));
+    assert(analytics.vwap<MarketUpdate::Side::BID>(3) == 99);
+
+    // few prices so that top levels get removed and refilled from below all the time
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randPrice(90, 110);
+    std::uniform_int_distribution<> randSize(0, 5);
+    std::uniform_int_distribution<> randSide(0, 1);
+
+    uint64_t changed = 0;
+    for (auto i = 0; i < UPDATES; ++i) {
+        MarketUpdate update(static_cast<MarketUpdate::Side>(randSide(rng)), randPrice(rng), randSize(rng));
+        changed += analytics.apply(book.updateOrderBook(update), book).changed;
+
+        auto bids = TopLevels<MarketUpdate::Side::BID>(book);
+        auto asks = TopLevels<MarketUpdate::Side::ASK>(book);
+        assert(Matches<MarketUpdate::Side::BID>(analytics, bids));
+        assert(Matches<MarketUpdate::Side::ASK>(analytics, asks));
+
+        Size bidDepth = 0;
+        Size askDepth = 0;
+        for (const auto& level : bids) {
+            bidDepth += level.second;
+        }
+        for (const auto& level : asks) {
+            askDepth += level.second;
+        }
+        assert(Close(features.bidDepth, bidDepth) && Close(features.askDepth, askDepth));
+        assert(Close(features.imbalance, bidDepth + askDepth > 0 ? (bidDepth - askDepth) / (bidDepth + askDepth) : 0));
+        if (!bids.empty() && !asks.empty()) {
+            auto [bid, bidSize] = bids[0];
+            auto [ask, askSize] = asks[0];
+            assert(Close(features.microprice, (bid * askSize + ask * bidSize) / (bidSize + askSize)));
+        } else {
+            assert(std::isnan(features.microprice));
+        }
+        assert(Close(features.bidVwap, Vwap(bids, VWAP_SIZE)) && Close(features.askVwap, Vwap(asks, VWAP_SIZE)));
+        assert(Close(analytics.vwap<MarketUpdate::Side::ASK>(2.5), Vwap(asks, 2.5)));
+        // the checksum kept up from the changed slot down is the one of the whole book
+        assert(features.checksum ==
+               book.read([](const BookState& state) { return BookAnalytics<LEVELS>::Checksum(state); }));
+    }
+
+    // recomputing everything from the book lands where the incremental updates did
+    BookAnalytics<LEVELS> recomputed(VWAP_SIZE);
+    recomputed.reset(book);
+    assert(Close(recomputed.features().microprice, features.microprice));
+    assert(Close(recomputed.features().bidVwap, features.bidVwap));
+    assert(Close(recomputed.features().askVwap, features.askVwap));
+    assert(Matches<MarketUpdate::Side::BID>(recomputed, TopLevels<MarketUpdate::Side::BID>(book)));
+    assert(recomputed.features().checksum == features.checksum);
+    assert(BookAnalytics<LEVELS>().features().checksum == BookAnalytics<LEVELS>::Checksum(BookState {}));
+
+    std::cout << "BookAnalytics: " << UPDATES << " updates verified, " << changed << " of them changed the top "
+              << LEVELS << " levels." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,201 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "checkpoint.hpp"
+#include "conflating_router.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+bool SameBooks(const InstrumentState& a, const InstrumentState& b)
+{
+    return a.instrument == b.instrument && a.sequence == b.sequence && a.bids == b.bids && a.asks == b.asks &&
+           a.engineBids == b.engineBids && a.engineAsks == b.engineAsks;
+}
+
+} // namespace
+
+void TestCheckpoint()
+{
+    constexpr InstrumentId INSTRUMENTS = 12;
+    constexpr int UPDATES = 20000;
+    const std::string path = "/tmp/crypto_trading_infra_test_checkpoint";
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, INSTRUMENTS - 1);
+    // within the span of a tick ladder of a deep book, so the books restored keep the same levels
+    std::uniform_int_distribution<> randTicks(0, 15);
+    std::uniform_int_distribution<> randSize(1, 20);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::map<InstrumentId, uint64_t> sequences;
+    auto next = [&]() {
+        auto instrument = randInstrument(rng);
+        return MarketUpdate(static_cast<MarketUpdate::Side>(randSide(rng)), 90 + randTicks(rng) * 0.5,
+                            randSize(rng), 0, instrument, ++sequences[instrument]);
+    };
+
+    // checkpoints keep being taken while the shards apply updates
+    std::vector<InstrumentState> expected;
+    uint64_t taken;
+    {
+        std::atomic<bool> runFlag { true };
+        InstrumentRegistry registry(3);
+        auto checkpoints = Checkpointer::Create(registry, path, std::chrono::microseconds(200));
+        assert(checkpoints != nullptr);
+        registry.start(runFlag);
+        for (auto i = 0; i < UPDATES; ++i) {
+            auto update = next();
+            while (!registry.route(update)) {
+                std::this_thread::yield();
+            }
+        }
+        while (registry.updatesProcessed() < UPDATES) {
+            std::this_thread::yield();
+        }
+        runFlag.store(false);
+        registry.join();
+
+        // a checkpoint taken mid-flight holds every instrument at some sequence it went through
+        std::vector<InstrumentState> states;
+        uint64_t number;
+        assert(ReadCheckpoint(path, states, number) && number <= checkpoints->lastNumber());
+        for (const auto& state : states) {
+            assert(state.sequence <= sequences[state.instrument]);
+        }
+
+        expected = registry.states();
+        taken = checkpoints->checkpointsTaken();
+    }
+
+    // the last checkpoint is taken once the shards stopped, a registry restored from it has the same books
+    std::vector<InstrumentState> states;
+    uint64_t number;
+    assert(ReadCheckpoint(path, states, number) && number > taken);
+    assert(states.size() == INSTRUMENTS && expected.size() == INSTRUMENTS);
+
+    std::atomic<bool> runFlag { true };
+    InstrumentRegistry registry(2);
+    for (const auto& state : states) {
+        registry.restore(state);
+    }
+    std::map<InstrumentId, InstrumentState> restored;
+    for (auto& state : registry.states()) {
+        restored[state.instrument] = std::move(state);
+    }
+    for (const auto& state : expected) {
+        assert(state.sequence == sequences[state.instrument] && SameBooks(state, restored[state.instrument]));
+    }
+
+    // the feed goes on from the sequence of each book, updates the checkpoint already holds are skipped, unless
+    // the feed started over and numbers them from 1 again
+    ConflatingRouter router(registry);
+    for (const auto& state : states) {
+        router.resume(state.instrument, state.sequence);
+    }
+    registry.start(runFlag);
+    auto stale = MarketUpdate(MarketUpdate::Side::BID, 98.5, 1, 0, 0, sequences[0]);
+    auto fresh = MarketUpdate(MarketUpdate::Side::BID, 98, 1, 0, 0, sequences[0] + 1);
+    router.route(stale);
+    router.route(fresh);
+    router.route(MarketUpdate(MarketUpdate::Side::ASK, 99, 1, 0, 1, 1));
+    router.route(MarketUpdate(MarketUpdate::Side::ASK, 99, 1, 0, 1, 2));
+    while (registry.updatesProcessed() < 3) {
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    registry.join();
+    auto bestBid = registry.find(0)->orderBook.bestBid();
+    assert(registry.updatesProcessed() == 3 && bestBid && bestBid->first == 98);
+    assert(router.statistics().gaps == 0);
+
+    // a checkpoint taken while levels are staged holds the book only up to the first update still staged, so a
+    // warm start from it finds the others missing rather than skipping them
+    {
+        constexpr auto LANE = InstrumentShard::Lane::capacity();
+        const auto filler = MarketUpdate(MarketUpdate::Side::BID, 90, 1, 0, 1, 0);
+        InstrumentRegistry staging(1);
+        // a mark above the lane, so levels are only staged once it is full and flushed as long as it has room
+        ConflatingRouter stagingRouter(staging, 2 * LANE + 2);
+        auto process = [&](uint64_t updates) {
+            std::atomic<bool> running { true };
+            staging.start(running);
+            while (staging.updatesProcessed() < updates) {
+                std::this_thread::yield();
+            }
+            running.store(false);
+            staging.join();
+        };
+
+        for (size_t i = 0; i < LANE; ++i) {
+            assert(staging.route(filler));
+        }
+        stagingRouter.route(MarketUpdate(MarketUpdate::Side::ASK, 99, 1, 0, 0, 1));
+        stagingRouter.route(MarketUpdate(MarketUpdate::Side::ASK, 100, 1, 0, 0, 2));
+        stagingRouter.route(MarketUpdate(MarketUpdate::Side::ASK, 99, 1, 0, 0, 3));
+        assert(stagingRouter.backlog() == 2 && stagingRouter.statistics().conflated == 1);
+        process(LANE);
+
+        // the lane has room for the level at 99 only, which holds the update 3 while the update 2 is still staged
+        for (size_t i = 0; i + 1 < LANE; ++i) {
+            assert(staging.route(filler));
+        }
+        stagingRouter.drain();
+        assert(stagingRouter.backlog() == 1);
+        process(2 * LANE);
+        auto checkpointed = staging.find(0)->state(0);
+        assert(checkpointed && checkpointed->sequence == 1 && checkpointed->asks.size() == 1);
+
+        InstrumentRegistry warm(1);
+        warm.restore(*checkpointed);
+        ConflatingRouter warmRouter(warm);
+        warmRouter.resume(0, checkpointed->sequence);
+        warmRouter.route(MarketUpdate(MarketUpdate::Side::ASK, 101, 1, 0, 0, 4));
+        assert(warmRouter.statistics().gaps == 2);
+
+        // once the update 2 is flushed too the book holds every update, its sequence never going back
+        stagingRouter.drain();
+        process(2 * LANE + 1);
+        auto flushed = staging.find(0)->state(0);
+        assert(flushed && flushed->sequence == 3 && flushed->asks.size() == 2);
+    }
+
+    // the state of an instrument read while its books keep changing is given up on rather than retried forever
+    {
+        Instrument instrument;
+        EventHandler none;
+        instrument.apply(0, MarketUpdate(MarketUpdate::Side::ASK, 101, 2, 0, 0, 7), none);
+        instrument.lock.write([&]() { assert(!instrument.state(0)); });
+        auto state = instrument.state(0);
+        assert(state && state->sequence == 7 && state->asks.size() == 1);
+    }
+
+    // a checkpoint damaged in any byte is refused rather than restored
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(sizeof(CheckpointHeader) + 20);
+        auto byte = file.get();
+        file.seekp(sizeof(CheckpointHeader) + 20);
+        file.put(static_cast<char>(byte ^ 1));
+    }
+    assert(!ReadCheckpoint(path, states, number) && states.empty());
+    std::remove(path.c_str());
+
+    std::cout << "Checkpoint: " << number << " checkpoints of " << INSTRUMENTS << " instruments taken while "
+              << UPDATES << " updates were applied, the last one restored." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,177 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "conflating_router.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "risk_gate.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+template <MarketUpdate::Side Side>
+bool SameSide(const OrderBook& book, const OrderBook& expected)
+{
+    return book.read([&](const BookState& state) {
+        return expected.read([&](const BookState& reference) {
+            for (size_t i = 0;; ++i) {
+                auto level = state.level<Side>(i);
+                if (level != reference.level<Side>(i)) {
+                    return false;
+                }
+                if (!level) {
+                    return true;
+                }
+            }
+        });
+    });
+}
+
+MarketUpdate Order(AccountId account, MarketUpdate::Side side, Price price, Size size, InstrumentId instrument)
+{
+    MarketUpdate order(side, price, size, 0, instrument);
+    order.account = account;
+    return order;
+}
+
+// routes updates into a lane already past the mark, then runs the shard until all of them reached it
+void RouteOverloaded(InstrumentRegistry& registry, ConflatingRouter& router, const std::vector<MarketUpdate>& updates)
+{
+    for (const auto& update : updates) {
+        router.route(update);
+    }
+    assert(router.backlog() > 0);
+
+    std::atomic<bool> runFlag { true };
+    registry.start(runFlag);
+    while (router.backlog() > 0 || registry.updatesProcessed() < router.statistics().routed) {
+        router.drain();
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    registry.join();
+}
+
+} // namespace
+
+void TestConflatingRouter()
+{
+    constexpr size_t HIGH_WATER_MARK = 100;
+    constexpr int UPDATES = 5000;
+    constexpr InstrumentId INSTRUMENT = 3;
+
+    InstrumentRegistry registry(1);
+    ConflatingRouter router(registry, HIGH_WATER_MARK);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randPrice(100, 120);
+    std::uniform_int_distribution<> randSize(0, 10);
+    std::uniform_int_distribution<> randSide(0, 1);
+
+    // the shard is not running yet, so its lane crosses the mark and everything after gets staged
+    OrderBook expected;
+    for (auto i = 0; i < UPDATES; ++i) {
+        MarketUpdate update(static_cast<MarketUpdate::Side>(randSide(rng)), randPrice(rng), randSize(rng), i,
+                            INSTRUMENT);
+        router.route(update);
+        expected.updateOrderBook(update);
+    }
+
+    const auto& stats = router.statistics();
+    assert(stats.routed == HIGH_WATER_MARK);
+    assert(stats.staged == UPDATES - HIGH_WATER_MARK);
+    assert(stats.conflated == stats.staged - router.backlog());
+
+    std::atomic<bool> runFlag { true };
+    registry.start(runFlag);
+    while (router.backlog() > 0 || registry.updatesProcessed() < stats.routed) {
+        router.drain();
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    registry.join();
+
+    // the book reaches the same state, only through fewer updates
+    auto instrument = registry.find(INSTRUMENT);
+    assert(instrument != nullptr);
+    assert(SameSide<MarketUpdate::Side::BID>(instrument->orderBook, expected));
+    assert(SameSide<MarketUpdate::Side::ASK>(instrument->orderBook, expected));
+    assert(stats.routed < UPDATES);
+
+    // snapshot levels staged behind an overloaded lane still replace their level without being matched
+    {
+        constexpr auto BID = MarketUpdate::Side::BID;
+        constexpr auto ASK = MarketUpdate::Side::ASK;
+        InstrumentRegistry snapshotted(1);
+        ConflatingRouter overloaded(snapshotted, 2);
+        RouteOverloaded(snapshotted, overloaded,
+                        { MarketUpdate(ASK, 101, 20, 0, INSTRUMENT), MarketUpdate(ASK, 104, 1, 0, INSTRUMENT),
+                          MarketUpdate(BID, 102, 5, 0, INSTRUMENT, 0, MarketUpdate::SNAPSHOT),
+                          MarketUpdate(BID, 102, 7, 0, INSTRUMENT, 0, MarketUpdate::SNAPSHOT),
+                          MarketUpdate(ASK, 103, 4, 0, INSTRUMENT, 0, MarketUpdate::SNAPSHOT) });
+        const auto *instrument = snapshotted.find(INSTRUMENT);
+        assert(instrument->orderBook.bestBid() == std::make_pair(102.0, 7.0));
+        assert(instrument->tradingEngine.bestAsk() == std::make_pair(101.0, 20.0));
+        assert(!instrument->tradingEngine.bestBid());
+    }
+
+    // orders with a time in force staged behind an overloaded lane keep it, rather than resting until traded
+    {
+        constexpr auto BID = MarketUpdate::Side::BID;
+        constexpr auto ASK = MarketUpdate::Side::ASK;
+        ShardConfig config;
+        config.orderLifetime = 1000;
+        InstrumentRegistry timed(1, config);
+        ConflatingRouter overloaded(timed, 2);
+        RouteOverloaded(timed, overloaded,
+                        { MarketUpdate(ASK, 105, 1, 0, INSTRUMENT), MarketUpdate(ASK, 106, 1, 0, INSTRUMENT),
+                          MarketUpdate(BID, 100, 5, 10, INSTRUMENT, 0, MarketUpdate::IMMEDIATE_OR_CANCEL),
+                          MarketUpdate(BID, 99, 3, 20, INSTRUMENT, 0, MarketUpdate::TIMED),
+                          MarketUpdate(BID, 100, 2, 30, INSTRUMENT, 0, MarketUpdate::IMMEDIATE_OR_CANCEL),
+                          MarketUpdate(BID, 98, 2, 5000, INSTRUMENT) });
+        assert(overloaded.statistics().routed == 6);
+        // the IMMEDIATE_OR_CANCEL orders never rested, the TIMED one expired
+        assert(timed.find(INSTRUMENT)->tradingEngine.bestBid() == std::make_pair(98.0, 2.0));
+    }
+
+    // orders of accounts staged behind an overloaded lane are still checked and charged one by one, market data
+    // at their level merging around them
+    {
+        constexpr auto BID = MarketUpdate::Side::BID;
+        constexpr auto ASK = MarketUpdate::Side::ASK;
+        ShardConfig config;
+        config.risk = RiskLimits::Parse("size=10,band=0.05,position=15");
+        InstrumentRegistry risked(1, config);
+        ConflatingRouter overloaded(risked, 3);
+        RouteOverloaded(risked, overloaded,
+                        { MarketUpdate(ASK, 101, 20, 0, INSTRUMENT), MarketUpdate(BID, 100, 20, 0, INSTRUMENT),
+                          MarketUpdate(ASK, 102, 50, 0, INSTRUMENT), Order(7, BID, 101, 8, INSTRUMENT),
+                          MarketUpdate(BID, 101, 0, 0, INSTRUMENT), Order(7, BID, 101, 8, INSTRUMENT),
+                          Order(8, BID, 110, 1, INSTRUMENT), Order(7, ASK, 100, 10, INSTRUMENT) });
+        assert(overloaded.statistics().routed == 8);
+
+        const auto *gate = risked.find(INSTRUMENT)->risk.get();
+        assert(gate->position(7) == -2 && gate->accepted(7) == 2 && gate->rejected(7) == 1);
+        assert(gate->rejected(8) == 1);
+        RejectEvent reject;
+        assert(risked.shard(0).rejects()->pop(reject) && reject.account == 7 && reject.reason == RiskReject::POSITION);
+        assert(risked.shard(0).rejects()->pop(reject) && reject.account == 8 &&
+               reject.reason == RiskReject::PRICE_BAND);
+        assert(!risked.shard(0).rejects()->pop(reject));
+    }
+
+    std::cout << "ConflatingRouter: " << UPDATES << " updates reached the shard as " << stats.routed << ", "
+              << stats.conflated << " conflated." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
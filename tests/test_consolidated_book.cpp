@@ -0,0 +1,182 @@
+#include "test_entries.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "book_analytics.hpp"
+#include "consolidated_book.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "venue_consolidator.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+constexpr size_t LEVELS = 5;
+constexpr size_t VENUES = 3;
+
+struct Venue {
+    OrderBook orderBook;
+    BookAnalytics<LEVELS> analytics;
+};
+
+bool Apply(ConsolidatedBook<LEVELS>& consolidated, Venue& venue, VenueId id, const MarketUpdate& update)
+{
+    auto change = venue.analytics.apply(venue.orderBook.updateOrderBook(update), venue.orderBook);
+    return consolidated.apply(id, change);
+}
+
+// every top level of every venue, best first with the same ties as the consolidated book
+template <MarketUpdate::Side Side>
+std::vector<VenueLevel> Merged(const std::vector<Venue>& venues)
+{
+    std::vector<VenueLevel> levels;
+    for (size_t id = 0; id < venues.size(); ++id) {
+        for (size_t i = 0; i < venues[id].analytics.count<Side>(); ++i) {
+            auto [price, size] = venues[id].analytics.level<Side>(i);
+            levels.push_back({ price, size, static_cast<VenueId>(id) });
+        }
+    }
+    std::sort(levels.begin(), levels.end(), [](const VenueLevel& a, const VenueLevel& b) {
+        if (a.price != b.price) {
+            return Side == MarketUpdate::Side::BID ? a.price > b.price : a.price < b.price;
+        }
+        return a.size != b.size ? a.size > b.size : a.venue < b.venue;
+    });
+    levels.resize(std::min(levels.size(), LEVELS));
+    return levels;
+}
+
+template <MarketUpdate::Side Side>
+bool Matches(const ConsolidatedBook<LEVELS>& consolidated, const std::vector<Venue>& venues)
+{
+    auto merged = Merged<Side>(venues);
+    if (consolidated.count<Side>() != merged.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (!(consolidated.level<Side>(i) == merged[i])) {
+            return false;
+        }
+    }
+    auto best = consolidated.best<Side>();
+    return merged.empty() ? !best : best && *best == merged[0];
+}
+
+} // namespace
+
+void TestConsolidatedBook()
+{
+    constexpr size_t UPDATES = 20000;
+    constexpr InstrumentId INSTRUMENT = 3;
+
+    // ties on price go to the larger size, then to the lower venue
+    {
+        std::vector<Venue> venues(VENUES);
+        ConsolidatedBook<LEVELS> consolidated;
+        for (size_t id = 0; id < VENUES; ++id) {
+            consolidated.subscribe(static_cast<VenueId>(id), venues[id].analytics);
+        }
+        assert(!consolidated.bestBid() && !consolidated.bestAsk());
+
+        assert(Apply(consolidated, venues[2], 2, MarketUpdate(MarketUpdate::Side::BID, 100, 5, 0, INSTRUMENT)));
+        assert(Apply(consolidated, venues[1], 1, MarketUpdate(MarketUpdate::Side::BID, 100, 5, 0, INSTRUMENT)));
+        assert(consolidated.bestBid()->venue == 1);
+        assert(Apply(consolidated, venues[2], 2, MarketUpdate(MarketUpdate::Side::BID, 100, 1, 0, INSTRUMENT)));
+        assert(consolidated.bestBid()->venue == 2 && consolidated.bestBid()->size == 6);
+        // a level behind the best of another venue leaves the NBBO alone
+        assert(!Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::BID, 99, 10, 0, INSTRUMENT)));
+        assert(Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::ASK, 101, 10, 0, INSTRUMENT)));
+        assert(consolidated.bestAsk()->venue == 0 && consolidated.bestAsk()->price == 101);
+        assert(Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::ASK, 101, 0, 0, INSTRUMENT)));
+        assert(!consolidated.bestAsk());
+        assert(Matches<MarketUpdate::Side::BID>(consolidated, venues));
+    }
+
+    // changes below the levels a venue contributes to the depth leave it alone
+    {
+        std::vector<Venue> venues(2);
+        ConsolidatedBook<LEVELS> consolidated;
+        consolidated.subscribe(0, venues[0].analytics);
+        consolidated.subscribe(1, venues[1].analytics);
+        for (Price price = 100; price > 95; --price) {
+            Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::BID, price, 1, 0, INSTRUMENT));
+            Apply(consolidated, venues[1], 1, MarketUpdate(MarketUpdate::Side::BID, price + 10, 1, 0, INSTRUMENT));
+        }
+        assert(consolidated.level<MarketUpdate::Side::BID>(LEVELS - 1).venue == 1);
+        auto merges = consolidated.depthMerges();
+        assert(!Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::BID, 99, 1, 0, INSTRUMENT)));
+        assert(!Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::BID, 97, 0, 0, INSTRUMENT)));
+        assert(consolidated.depthMerges() == merges);
+        // the next level of the venue may enter the depth once it beats the worst level in it
+        Apply(consolidated, venues[0], 0, MarketUpdate(MarketUpdate::Side::BID, 100, 1, 0, INSTRUMENT));
+        assert(consolidated.depthMerges() == merges + 1);
+        assert(Matches<MarketUpdate::Side::BID>(consolidated, venues));
+    }
+
+    // random updates across venues, the consolidated book matching a merge of every venue after each of them
+    std::vector<Venue> venues(VENUES);
+    ConsolidatedBook<LEVELS> consolidated;
+    for (size_t id = 0; id < VENUES; ++id) {
+        consolidated.subscribe(static_cast<VenueId>(id), venues[id].analytics);
+    }
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<> randVenue(0, VENUES - 1);
+    std::uniform_int_distribution<> randTicks(-30, 30);
+    std::uniform_int_distribution<> randSize(1, 20);
+    uint64_t nbboChanges = 0;
+    for (size_t i = 0; i < UPDATES; ++i) {
+        auto id = static_cast<VenueId>(randVenue(rng));
+        auto side = rng() % 2 ? MarketUpdate::Side::BID : MarketUpdate::Side::ASK;
+        Price price = (side == MarketUpdate::Side::BID ? 99.0 : 101.0) + randTicks(rng) / 100.0;
+        // as many levels removed as added, so the best ones keep moving
+        auto size = rng() % 2 ? randSize(rng) : 0;
+        auto bid = consolidated.bestBid();
+        auto ask = consolidated.bestAsk();
+        auto nbbo = Apply(consolidated, venues[id], id, MarketUpdate(side, price, size, i, INSTRUMENT));
+        assert(nbbo == !(bid == consolidated.bestBid() && ask == consolidated.bestAsk()));
+        nbboChanges += nbbo;
+        assert(Matches<MarketUpdate::Side::BID>(consolidated, venues));
+        assert(Matches<MarketUpdate::Side::ASK>(consolidated, venues));
+    }
+    assert(consolidated.bboChanges() == nbboChanges);
+    assert(consolidated.depthMerges() < UPDATES);
+
+    // updates of two venues through their lanes, the consolidator following the NBBO as it applies them
+    std::vector<NbboEvent> events;
+    VenueConsolidator consolidator(2, [&](const NbboEvent& event) { events.push_back(event); });
+    consolidator.enqueue(0, MarketUpdate(MarketUpdate::Side::BID, 100, 5, 1, INSTRUMENT));
+    consolidator.enqueue(1, MarketUpdate(MarketUpdate::Side::BID, 100.5, 2, 2, INSTRUMENT));
+    consolidator.enqueue(1, MarketUpdate(MarketUpdate::Side::ASK, 101, 3, 3, INSTRUMENT));
+    consolidator.enqueue(0, MarketUpdate(MarketUpdate::Side::ASK, 101.5, 3, 4, INSTRUMENT));
+    consolidator.enqueue(1, MarketUpdate(MarketUpdate::Side::BID, 0, 0, 5, INSTRUMENT, 0, MarketUpdate::CLEAR_BOOK));
+    std::atomic<bool> runFlag { true };
+    std::thread consolidating([&]() { consolidator.run(runFlag); });
+    while (consolidator.updatesApplied(0) + consolidator.updatesApplied(1) < 5) {
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    consolidating.join();
+
+    const auto *instrument = consolidator.find(INSTRUMENT);
+    assert(instrument != nullptr && consolidator.find(INSTRUMENT + 1) == nullptr);
+    // venue 1 cleared its book, only the levels of venue 0 are left
+    assert(instrument->book.bestBid() == (VenueLevel { 100, 5, 0 }));
+    assert(instrument->book.bestAsk() == (VenueLevel { 101.5, 3, 0 }));
+    assert(!events.empty() && events.size() == consolidator.nbboChangesNum());
+    assert(events.back().bid == instrument->book.bestBid() && events.back().ask == instrument->book.bestAsk());
+    assert(consolidator.updatesDropped(0) == 0 && consolidator.updatesDropped(1) == 0);
+
+    std::cout << "ConsolidatedBook: " << UPDATES << " updates across " << VENUES << " venues verified, " << nbboChanges
+              << " NBBO changes, depth merged " << consolidated.depthMerges() << " times." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,164 @@
+#include "test_entries.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cooperative_pipeline.hpp"
+#include "coroutine.hpp"
+#include "engine_events.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+constexpr uint16_t PIPELINE_PORT = 49171;
+
+Utils::Coroutine Produce(Utils::LocalRingBuffer<int, 8>& queue, int count, bool& producing)
+{
+    for (auto i = 0; i < count;) {
+        if (!queue.push(i)) {
+            co_await Utils::Yield();
+            continue;
+        }
+        ++i;
+    }
+    producing = false;
+}
+
+Utils::Coroutine Consume(Utils::LocalRingBuffer<int, 8>& queue, const bool& producing, int& next, int& turns)
+{
+    while (producing || !queue.empty()) {
+        int value;
+        while (queue.pop(value)) {
+            assert(value == next);
+            ++next;
+        }
+        ++turns;
+        co_await Utils::Yield();
+    }
+}
+
+void Send(int sockfd, const std::vector<MarketUpdate>& updates, uint64_t sequence)
+{
+    alignas(MarketUpdate) char buffer[MAX_SIZE_BATCH_MARKET_UPDATE];
+    auto packet = reinterpret_cast<MarketUpdatePacket *>(buffer);
+    packet->header = { PROTOCOL_MARKET_UPDATE, static_cast<uint16_t>(updates.size()), sequence };
+    packet->header.hton();
+    for (size_t i = 0; i < updates.size(); ++i) {
+        packet->updates[i] = updates[i];
+        packet->updates[i].hton();
+    }
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(PIPELINE_PORT);
+    auto length = sizeof(MarketUpdateHeader) + updates.size() * sizeof(MarketUpdate);
+    auto sent = sendto(sockfd, buffer, length, 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    assert(sent == static_cast<ssize_t>(length));
+    (void)sent;
+}
+
+} // namespace
+
+void TestCooperativePipeline()
+{
+    // stages take turns on one thread, the producer yielding whenever the queue between them is full
+    {
+        Utils::LocalRingBuffer<int, 8> queue;
+        bool producing = true;
+        int next = 0;
+        int turns = 0;
+        Utils::CooperativeScheduler scheduler;
+        scheduler.spawn(Produce(queue, 1000, producing));
+        scheduler.spawn(Consume(queue, producing, next, turns));
+        scheduler.run();
+        assert(next == 1000 && queue.empty());
+        assert(turns >= 1000 / 8);
+    }
+
+    // updates received on a line are applied and matched as the books of a shard apply them
+    constexpr size_t PACKETS = 300;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<InstrumentId> randInstrument(1, 3);
+    std::uniform_int_distribution<> randCents(-300, 300);
+    std::uniform_int_distribution<> randSize(0, 20);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::uniform_int_distribution<> randCount(1, MAX_COUNT_MARKET_UPDATE);
+
+    auto pipeline = CooperativePipeline::Create({ PIPELINE_PORT });
+    assert(pipeline != nullptr);
+    std::atomic<bool> runFlag { true };
+    std::thread runner([&]() { pipeline->run(runFlag); });
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(sockfd >= 0);
+    std::vector<MarketUpdate> sent;
+    uint64_t timestamp = 1000;
+    for (size_t packet = 1; packet <= PACKETS; ++packet) {
+        std::vector<MarketUpdate> updates;
+        for (auto i = randCount(rng); i > 0; --i) {
+            timestamp += rng() % 10;
+            updates.emplace_back(static_cast<MarketUpdate::Side>(randSide(rng)), 100 + randCents(rng) / 100.0,
+                                 randSize(rng), timestamp, randInstrument(rng));
+        }
+        Send(sockfd, updates, packet);
+        // a packet left behind the first copy of the same sequence is dropped by the arbiter
+        if (packet % 50 == 0) {
+            Send(sockfd, updates, packet);
+        }
+        sent.insert(sent.end(), updates.begin(), updates.end());
+
+        // keeps the socket buffer from overflowing while the pipeline waits for the core
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pipeline->updatesProcessed() < sent.size() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+    close(sockfd);
+    runFlag.store(false);
+    runner.join();
+
+    assert(pipeline->updatesProcessed() == sent.size() && pipeline->updatesMatched() == sent.size());
+    assert(pipeline->packetStats().packetsRecv == PACKETS + PACKETS / 50);
+    assert(pipeline->feedArbiter().line(0).duplicates == PACKETS / 50);
+
+    std::unordered_map<InstrumentId, std::unique_ptr<Instrument>> expected;
+    EventHandler events;
+    for (const auto& update : sent) {
+        auto& instrument = expected[update.instrument];
+        if (!instrument) {
+            instrument = std::make_unique<Instrument>();
+        }
+        instrument->apply(update.instrument, update, events);
+    }
+    assert(pipeline->instrumentsNum() == expected.size());
+    for (const auto& [id, instrument] : expected) {
+        auto books = pipeline->find(id);
+        assert(books != nullptr);
+        auto state = *books->state(id);
+        auto expectedState = *instrument->state(id);
+        assert(state.bids == expectedState.bids && state.asks == expectedState.asks);
+        assert(state.engineBids == expectedState.engineBids && state.engineAsks == expectedState.engineAsks);
+        assert(books->analytics.features().checksum == instrument->analytics.features().checksum);
+    }
+
+    std::cout << "CooperativePipeline: " << sent.size() << " updates of " << PACKETS
+              << " packets received, applied and matched on one thread as shards do." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,111 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "delta_feed.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestDeltaFeed()
+{
+    constexpr int UPDATES = 5000;
+    constexpr int PRICES = 50;
+    constexpr InstrumentId INSTRUMENTS = 3;
+
+    // subscriber on an ephemeral local port
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(sockfd >= 0);
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(sockfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    socklen_t length = sizeof(addr);
+    assert(getsockname(sockfd, reinterpret_cast<sockaddr *>(&addr), &length) == 0);
+
+    auto feed = DeltaFeed::Create(addr, std::chrono::hours(1));
+    assert(feed != nullptr);
+    // the feed of another shard sending to the same subscriber, in a stream of its own
+    auto other = DeltaFeed::Create(addr, std::chrono::hours(1), 1);
+    assert(other != nullptr);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randPrice(100, 100 + PRICES - 1);
+    std::uniform_int_distribution<> randSize(0, 100);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, INSTRUMENTS - 1);
+
+    // latest size of every level, which is all a subscriber should get
+    using Level = std::tuple<InstrumentId, MarketUpdate::Side, Price>;
+    std::map<Level, Size> expected;
+    for (auto i = 0; i < UPDATES; ++i) {
+        LevelUpdate level { static_cast<MarketUpdate::Side>(randSide(rng)), static_cast<Price>(randPrice(rng)),
+                            static_cast<Size>(randSize(rng)) };
+        auto instrument = randInstrument(rng);
+        feed->stage(instrument, level, i);
+        expected[{ instrument, level.side, level.price }] = level.size;
+    }
+
+    assert(!feed->due(std::chrono::steady_clock::now()));
+    assert(feed->backlog() == expected.size());
+    for (auto i = 0; i < PRICES; ++i) {
+        LevelUpdate level { MarketUpdate::Side::ASK, static_cast<Price>(100 + i), 1 };
+        other->stage(INSTRUMENTS, level, i);
+        expected[{ INSTRUMENTS, level.side, level.price }] = level.size;
+    }
+    feed->flush();
+    other->flush();
+
+    std::map<Level, Size> received;
+    char buffer[MAX_SIZE_BATCH_MARKET_UPDATE];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    size_t deltas = 0;
+    uint64_t packets[2] = { 0, 0 };
+    while (deltas < expected.size() && std::chrono::steady_clock::now() < deadline) {
+        auto bytes = recv(sockfd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes < 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto packet = reinterpret_cast<MarketUpdatePacket *>(buffer);
+        packet->header.ntoh();
+        assert(packet->header.protocol == PROTOCOL_BOOK_DELTA);
+        auto stream = DeltaStream(packet->header.sequence);
+        assert(stream < 2 && DeltaPacket(packet->header.sequence) == packets[stream]++);
+        assert(bytes == static_cast<ssize_t>(sizeof(MarketUpdateHeader) + packet->header.count * sizeof(MarketUpdate)));
+        for (auto i = 0; i < packet->header.count; ++i) {
+            auto& delta = packet->updates[i];
+            delta.ntoh();
+            // a level only goes out once per flush; prices and sizes are copied, updates follow the header unaligned
+            Price price = delta.price;
+            Size size = delta.size;
+            assert(received.emplace(Level { delta.instrument, delta.side, price }, size).second);
+            ++deltas;
+        }
+    }
+    close(sockfd);
+
+    const auto& stats = feed->statistics();
+    assert(received == expected);
+    assert(feed->backlog() == 0);
+    assert(stats.deltas == UPDATES && stats.conflated == UPDATES - expected.size() + PRICES);
+    assert(stats.sent + other->statistics().sent == expected.size());
+    assert(packets[0] == stats.packets && packets[1] == other->statistics().packets);
+
+    std::cout << "DeltaFeed: " << UPDATES << " level changes conflated into " << stats.sent << " deltas sent in "
+              << stats.packets << " packets." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,113 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "book_analytics.hpp"
+#include "depth_publisher.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+constexpr size_t LEVELS = 5;
+
+template <MarketUpdate::Side Side>
+bool Matches(const OrderBook& book, const std::array<BookState::Item, LEVELS>& levels, size_t count)
+{
+    return book.read([&](const BookState& state) {
+        for (size_t i = 0; i <= count && i < LEVELS; ++i) {
+            auto level = state.level<Side>(i);
+            if (i == count) {
+                return !level;
+            }
+            if (!level || *level != levels[i]) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+// NaN included
+bool Same(double a, double b)
+{
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+} // namespace
+
+void TestDepthPublisher()
+{
+    constexpr int UPDATES = 20000;
+
+    auto name = DepthSegmentName("/crypto_trading_infra_test_depth", getpid());
+    OrderBook book;
+    BookAnalytics<LEVELS> analytics;
+    auto publisher = DepthPublisher<LEVELS>::Create(name, 7);
+    assert(publisher != nullptr);
+
+    auto reader = DepthReader<LEVELS>::Attach(name);
+    assert(reader != nullptr && reader->instrument() == 7);
+
+    // a concurrent reader must only ever see sorted sides and versions going forward
+    std::atomic<bool> stop { false };
+    std::thread concurrent([&]() {
+        auto other = DepthReader<LEVELS>::Attach(name);
+        DepthSnapshot<LEVELS> snapshot;
+        uint64_t version = 0;
+        while (!stop.load()) {
+            other->read(snapshot);
+            assert(snapshot.version >= version);
+            version = snapshot.version;
+            for (size_t i = 1; i < snapshot.bidCount; ++i) {
+                assert(snapshot.bids[i - 1].first > snapshot.bids[i].first);
+            }
+            for (size_t i = 1; i < snapshot.askCount; ++i) {
+                assert(snapshot.asks[i - 1].first < snapshot.asks[i].first);
+            }
+        }
+    });
+
+    // few prices so that top levels get removed and refilled from below all the time
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randPrice(90, 110);
+    std::uniform_int_distribution<> randSize(0, 5);
+    std::uniform_int_distribution<> randSide(0, 1);
+
+    DepthSnapshot<LEVELS> snapshot;
+    for (auto i = 0; i < UPDATES; ++i) {
+        MarketUpdate update(static_cast<MarketUpdate::Side>(randSide(rng)), randPrice(rng), randSize(rng));
+        publisher->publish(analytics, analytics.apply(book.updateOrderBook(update), book));
+
+        reader->read(snapshot);
+        assert(Matches<MarketUpdate::Side::BID>(book, snapshot.bids, snapshot.bidCount));
+        assert(Matches<MarketUpdate::Side::ASK>(book, snapshot.asks, snapshot.askCount));
+
+        // features are published along with the levels they were computed from
+        const auto& features = analytics.features();
+        assert(Same(snapshot.features.microprice, features.microprice));
+        assert(Same(snapshot.features.imbalance, features.imbalance));
+        assert(Same(snapshot.features.bidVwap, features.bidVwap) && Same(snapshot.features.askVwap, features.askVwap));
+        assert(snapshot.features.checksum == features.checksum);
+    }
+
+    stop.store(true);
+    concurrent.join();
+
+    std::cout << "DepthPublisher: " << UPDATES << " updates verified, " << snapshot.version << " changes published."
+              << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,144 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "engine_events.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+struct Counting : EventHandler {
+    size_t books = 0;
+    size_t trades = 0;
+    Size traded = 0;
+    size_t bbos = 0;
+    BboEvent lastBbo {};
+
+    void onBook(const BookEvent&)
+    {
+        ++books;
+    }
+
+    void onTrade(const TradeEvent& trade)
+    {
+        ++trades;
+        traded += trade.size;
+    }
+
+    void onBbo(const BboEvent& bbo)
+    {
+        ++bbos;
+        lastBbo = bbo;
+    }
+};
+
+// only subscribes to trades, the other events must still reach nothing
+struct TradesOnly : EventHandler {
+    size_t trades = 0;
+
+    void onTrade(const TradeEvent&)
+    {
+        ++trades;
+    }
+};
+
+} // namespace
+
+void TestEngineEvents()
+{
+    using Side = MarketUpdate::Side;
+
+    // a level behind the best changes the book but not the BBO
+    Instrument instrument;
+    Counting events;
+    instrument.apply(5, MarketUpdate(Side::BID, 100, 10, 1, 5), events);
+    assert(events.books == 1 && events.bbos == 1 && events.lastBbo.bid == BookState::Item(100, 10));
+    assert(events.lastBbo.ask.second == 0 && events.lastBbo.instrument == 5 && events.lastBbo.timestamp == 1);
+    instrument.apply(5, MarketUpdate(Side::BID, 99, 10, 2, 5), events);
+    assert(events.books == 2 && events.bbos == 1);
+    instrument.apply(5, MarketUpdate(Side::ASK, 101, 4, 3, 5), events);
+    assert(events.bbos == 2 && events.lastBbo.ask == BookState::Item(101, 4));
+
+    // the book of the engine crosses the ask against its resting bid
+    instrument.apply(5, MarketUpdate(Side::ASK, 100, 4, 4, 5), events);
+    assert(events.trades == 1 && events.traded == 4 && events.bbos == 3);
+    assert(events.lastBbo.ask == BookState::Item(100, 4));
+
+    // clearing the book is one book event per level, and empties the BBO
+    instrument.apply(5, MarketUpdate(Side::BID, 0, 0, 5, 5, 0, MarketUpdate::CLEAR_BOOK), events);
+    assert(events.books == 8 && events.lastBbo.bid.second == 0 && events.lastBbo.ask.second == 0);
+
+    TradingEngine engine;
+    TradesOnly trades;
+    engine.match(MarketUpdate(Side::ASK, 100, 5, 1, 5), trades);
+    engine.match(MarketUpdate(Side::BID, 101, 8, 2, 5), trades);
+    assert(trades.trades == 1);
+
+    // a subscriber to the registry gets the same events in batches
+    constexpr int UPDATES = 5000;
+    std::atomic<size_t> batches { 0 };
+    std::atomic<size_t> books { 0 };
+    std::atomic<size_t> bbos { 0 };
+    // sizes are whole numbers, so they add up exactly whatever the order of the batches
+    std::atomic<uint64_t> traded { 0 };
+    ShardConfig config;
+    config.events = [&](const EventBatch& batch) {
+        ++batches;
+        books += batch.books.size;
+        bbos += batch.bbos.size;
+        for (const auto& trade : batch.trades) {
+            traded += static_cast<uint64_t>(trade.size);
+        }
+    };
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<> randPrice(95, 105);
+    std::uniform_int_distribution<> randSize(1, 50);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, 7);
+
+    std::map<InstrumentId, std::unique_ptr<Instrument>> reference;
+    Counting expected;
+    {
+        std::atomic<bool> runFlag { true };
+        InstrumentRegistry registry(2, config);
+        registry.start(runFlag);
+        for (auto i = 0; i < UPDATES; ++i) {
+            MarketUpdate update(static_cast<Side>(randSide(rng)), randPrice(rng), randSize(rng), i,
+                                randInstrument(rng));
+            while (!registry.route(update)) {
+                std::this_thread::yield();
+            }
+            auto& instrument = reference[update.instrument];
+            if (!instrument) {
+                instrument = std::make_unique<Instrument>();
+            }
+            instrument->apply(update.instrument, update, expected);
+        }
+
+        while (registry.updatesProcessed() < UPDATES) {
+            std::this_thread::yield();
+        }
+        runFlag.store(false);
+        registry.join();
+    }
+
+    assert(books == expected.books && bbos == expected.bbos && traded == static_cast<uint64_t>(expected.traded));
+    assert(batches.load() <= expected.books);
+
+    std::cout << "EngineEvents: " << expected.books << " book, " << expected.trades << " trade and " << expected.bbos
+              << " BBO events delivered in " << batches.load() << " batches." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -6,10 +6,37 @@ namespace Test {
 
 void TestMarketUpdatesRecv();
 void TestRingBuffer();
+void TestTicketRingBuffer();
+void TestEpochSnapshot();
+void TestPersistentMap();
+void TestSharedRingBuffer();
+void TestSequenceArbiter();
+void TestFeedMessages();
+void TestEventLog();
 
 void TestOrderBook();
+void TestDeepBookState();
 void TestExecutionEngineBasic();
 void TestExecutionEngineCrossTrades();
+void TestExecutionEngineExpiry();
+void TestInstrumentRegistry();
+void TestConflatingRouter();
+void TestBarAggregator();
+void TestEngineEvents();
+void TestBookAnalytics();
+void TestDepthPublisher();
+void TestDeltaFeed();
+void TestSnapshotRecovery();
+void TestCheckpoint();
+void TestTickStore();
+void TestSessionReplay();
+void TestPerfCounters();
+void TestRiskGate();
+void TestTimingWheel();
+void TestConsolidatedBook();
+#ifdef CRYPTO_TRADING_INFRA_COOPERATIVE_MODE
+void TestCooperativePipeline();
+#endif
 
 }
 }
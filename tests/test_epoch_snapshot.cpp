@@ -0,0 +1,79 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "epoch_snapshot.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+// both halves are always written together, so any torn or recycled-under-the-reader version breaks the sum
+struct Counters {
+    uint64_t left = 0;
+    uint64_t right = 0;
+};
+
+} // namespace
+
+void TestEpochSnapshot()
+{
+    constexpr int NUM_WRITERS = 4;
+    constexpr int NUM_READERS = 4;
+    constexpr int UPDATES_PER_WRITER = 5000;
+
+    Utils::EpochSnapshot<Counters, 8> snapshot;
+    std::atomic<bool> stop { false };
+    std::atomic<uint64_t> reads { 0 };
+
+    auto writer = [&]() {
+        for (auto i = 0; i < UPDATES_PER_WRITER; ++i) {
+            snapshot.update([](Counters& counters) {
+                ++counters.left;
+                ++counters.right;
+            });
+        }
+    };
+
+    auto reader = [&]() {
+        while (!stop.load()) {
+            auto counters = snapshot.read();
+            assert(counters->left == counters->right);
+            reads.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (auto i = 0; i < NUM_READERS; ++i) {
+        readers.emplace_back(reader);
+    }
+
+    std::vector<std::thread> writers;
+    for (auto i = 0; i < NUM_WRITERS; ++i) {
+        writers.emplace_back(writer);
+    }
+
+    for (auto& t : writers) {
+        t.join();
+    }
+
+    stop.store(true);
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    auto counters = snapshot.read();
+    assert(counters->left == NUM_WRITERS * UPDATES_PER_WRITER);
+    assert(counters->right == NUM_WRITERS * UPDATES_PER_WRITER);
+    std::cout << "EpochSnapshot: " << counters->left << " versions published, " << reads.load() << " reads."
+              << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
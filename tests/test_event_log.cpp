@@ -0,0 +1,120 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_log.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestEventLog()
+{
+    using Utils::EventLog;
+    constexpr size_t THREADS = 4;
+    constexpr uint64_t EVENTS = 2000;
+    const std::string path = "/tmp/crypto_trading_infra_test_event_log";
+    std::remove(path.c_str());
+
+    double nanoseconds;
+    {
+        auto log = EventLog::Create(path, std::chrono::microseconds(100));
+        assert(log != nullptr);
+        auto event = log->format("thread {} event {} price {} delta {}");
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t]() {
+                for (uint64_t i = 0; i < EVENTS; ++i) {
+                    // the writer drains far faster than this, nothing is expected to be dropped
+                    while (!log->write(event, t, i, 100.5, -static_cast<int64_t>(i))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // a single thread logging as fast as it can, against a ring emptied often enough to keep up
+        auto burst = log->format("burst {}");
+        log->write(burst, 0);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 1; i <= Utils::LOG_CHANNEL_SIZE / 2; ++i) {
+            log->write(burst, i);
+        }
+        nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                      (Utils::LOG_CHANNEL_SIZE / 2);
+    }
+
+    std::ifstream lines(path);
+    std::string line;
+    std::vector<uint64_t> next(THREADS, 0);
+    size_t bursts = 0;
+    while (std::getline(lines, line)) {
+        if (line.find("burst ") != std::string::npos) {
+            ++bursts;
+            continue;
+        }
+
+        // lines of every thread come out in the order they were logged
+        size_t t;
+        unsigned long long i;
+        long long delta;
+        auto text = line.substr(line.find("] ") + 2);
+        assert(sscanf(text.c_str(), "thread %zu event %llu price 100.5 delta %lld", &t, &i, &delta) == 3);
+        assert(t < THREADS && i == next[t] && delta == -static_cast<long long>(i));
+        ++next[t];
+    }
+    for (auto count : next) {
+        assert(count == EVENTS);
+    }
+    assert(bursts == Utils::LOG_CHANNEL_SIZE / 2 + 1);
+
+    // a writer that never wakes up makes the ring overflow, records beyond it are dropped rather than waited for
+    {
+        auto log = EventLog::Create(path, std::chrono::hours(1));
+        auto flood = log->format("flood {}");
+        for (uint64_t i = 0; i < Utils::LOG_CHANNEL_SIZE + 10; ++i) {
+            log->write(flood, i);
+        }
+        assert(log->written() == Utils::LOG_CHANNEL_SIZE && log->dropped() == 10);
+    }
+    std::remove(path.c_str());
+
+    // a thread switching between logs keeps one channel in each, and enums print with the sign of their type
+    {
+        enum class Signed : int8_t { MINUS = -2 };
+        const std::string other = path + "_other";
+        {
+            auto first = EventLog::Create(path);
+            auto second = EventLog::Create(other);
+            auto ping = first->format("ping {}");
+            auto pong = second->format("pong {} {}");
+            for (uint64_t i = 0; i < EVENTS; ++i) {
+                first->write(ping, i);
+                second->write(pong, Signed::MINUS, MarketUpdate::Side::BID);
+            }
+            assert(first->threads() == 1 && second->threads() == 1);
+            assert(first->written() == EVENTS && second->written() == EVENTS);
+        }
+        std::ifstream pongs(other);
+        assert(std::getline(pongs, line) && line.substr(line.find("] ") + 2) == "pong -2 1");
+        std::remove(path.c_str());
+        std::remove(other.c_str());
+    }
+
+    std::cout << "EventLog: " << THREADS * EVENTS << " events of " << THREADS << " threads written in order, "
+              << nanoseconds << " ns per event logged." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
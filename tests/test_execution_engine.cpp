@@ -68,6 +68,69 @@ void TestExecutionEngineCrossTrades() {
     assert(bid == std::make_pair(106.0, 1.0));
 }
 
+void TestExecutionEngineExpiry() {
+    constexpr auto BID = MarketUpdate::Side::BID;
+    constexpr auto ASK = MarketUpdate::Side::ASK;
+    TradingEngine engine;
+    engine.setOrderLifetime(1000000);
+
+    // timed 101@5 queues behind 101@10, which trades first
+    engine.match(MarketUpdate{ASK, 101, 10, 0});
+    engine.match(MarketUpdate{ASK, 101, 5, 1000, 0, 0, MarketUpdate::TIMED});
+    engine.match(MarketUpdate{ASK, 102, 4, 2000, 0, 0, MarketUpdate::TIMED});
+    engine.match(MarketUpdate{BID, 101, 12, 3000});
+    assert(engine.bestAsk() == std::make_pair(101.0, 3.0));
+    assert(engine.pendingExpiries() == 2);
+
+    // filled before it expires, its expiry is cancelled
+    engine.match(MarketUpdate{BID, 101, 3, 5000});
+    assert(engine.pendingExpiries() == 1);
+    engine.match(MarketUpdate{ASK, 101, 6, 6000});
+
+    // 102@4 expires with the first update a millisecond after it rested, the book is never scanned for it
+    engine.match(MarketUpdate{BID, 99, 1, 1001999});
+    assert(engine.expiredOrders() == 0);
+    engine.match(MarketUpdate{BID, 98, 1, 1002000});
+    assert(engine.expiredOrders() == 1 && engine.expiredSize() == 4 && engine.pendingExpiries() == 0);
+    assert(engine.bestAsk() == std::make_pair(101.0, 6.0));
+
+    // partly filled, only what is left of it expires and the order queued behind it stays
+    engine.match(MarketUpdate{BID, 101, 6, 2000000});
+    engine.match(MarketUpdate{ASK, 103, 5, 2000000, 0, 0, MarketUpdate::TIMED});
+    engine.match(MarketUpdate{ASK, 103, 5, 2000001});
+    engine.match(MarketUpdate{BID, 103, 2, 2000002});
+    assert(engine.bestAsk() == std::make_pair(103.0, 8.0));
+    engine.match(MarketUpdate{BID, 94, 1, 3000000});
+    assert(engine.bestAsk() == std::make_pair(103.0, 5.0));
+    assert(engine.expiredOrders() == 2 && engine.expiredSize() == 7);
+
+    // immediate or cancel takes what it can and leaves nothing resting
+    engine.match(MarketUpdate{BID, 104, 10, 3000001, 0, 0, MarketUpdate::IMMEDIATE_OR_CANCEL});
+    assert(engine.bestAsk() == std::nullopt);
+    assert(engine.bestBid() == std::make_pair(99.0, 1.0));
+
+    // swept by a clock when no update comes
+    engine.match(MarketUpdate{ASK, 105, 1, 4000000, 0, 0, MarketUpdate::TIMED});
+    engine.expire(4999999);
+    assert(engine.bestAsk() == std::make_pair(105.0, 1.0));
+    engine.expire(5000000);
+    assert(engine.bestAsk() == std::nullopt && engine.expiredOrders() == 3);
+
+    // expiring between the updates of a batch
+    MarketUpdate batch[] = { MarketUpdate{ASK, 106, 1, 6000000, 0, 0, MarketUpdate::TIMED},
+                             MarketUpdate{ASK, 107, 1, 6500000}, MarketUpdate{BID, 106, 1, 7000000} };
+    engine.match(batch, 3);
+    assert(engine.bestAsk() == std::make_pair(107.0, 1.0) && engine.bestBid() == std::make_pair(106.0, 1.0));
+
+    // without a lifetime timed orders rest until traded
+    engine.setOrderLifetime(0);
+    engine.match(MarketUpdate{ASK, 108, 1, 8000000, 0, 0, MarketUpdate::TIMED});
+    engine.match(MarketUpdate{BID, 95, 1, 1000000000});
+    assert(engine.bestAsk() == std::make_pair(107.0, 1.0) && engine.pendingExpiries() == 0);
+
+    engine.print();
+}
+
 } // namespace Test
 
 } // namespace CryptoTradingInfra
@@ -0,0 +1,127 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "feed_messages.hpp"
+#include "market_update_feed.hpp"
+#include "order_book.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+using namespace FeedMessages;
+
+struct Collector {
+    std::vector<MarketUpdate> updates;
+
+    void operator()(const MarketUpdate& update)
+    {
+        updates.push_back(update);
+    }
+};
+
+// counts the messages of each type it is handed
+struct Counter {
+    int counts[6] = {};
+
+    template <typename Message>
+    void operator()(const Message&)
+    {
+        ++counts[Message::TYPE];
+    }
+};
+
+} // namespace
+
+void TestFeedMessages()
+{
+    // fields are laid out unpadded and big endian
+    AddOrder add { 7, 3, 41, Side::BID, -2, 1.5 };
+    char bytes[Utils::Wire::WireSize<AddOrder>()];
+    assert(Utils::Wire::Encode(add, bytes) == bytes + sizeof(bytes));
+    const unsigned char expected[] = { 0, 0, 0, 7, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 41, 1, 0xff, 0xff, 0xff, 0xfe };
+    assert(std::memcmp(bytes, expected, sizeof(expected)) == 0);
+
+    AddOrder decoded {};
+    assert(Utils::Wire::Decode(bytes, decoded) == bytes + sizeof(bytes));
+    assert(decoded.timeOffset == 7 && decoded.instrument == 3 && decoded.sequence == 41 &&
+           decoded.side == Side::BID && decoded.priceOffset == -2 && decoded.size == 1.5);
+
+    // a packet holding one message of each type
+    char buffer[MAX_SIZE_FEED_MESSAGES];
+    FeedMessagesWriter writer(buffer, 9, 1000, 100, 0.5);
+    assert(writer.append(Heartbeat { 1 }));
+    assert(writer.append(AddOrder { 2, 1, 1, Side::BID, -4, 10 }));
+    assert(writer.append(AddOrder { 3, 1, 2, Side::ASK, 4, 5 }));
+    assert(writer.append(CancelOrder { 4, 1, 3, Side::BID, -4, 3 }));
+    assert(writer.append(ModifyOrder { 5, 1, 4, Side::ASK, 4, 5, 8 }));
+    assert(writer.append(Trade { 6, 1, Side::BID, 4, 2 }));
+    assert(writer.append(SnapshotLevel { 7, 1, 5, Side::BID, 97.5, 6 }));
+    auto length = writer.finish();
+
+    Counter counter;
+    assert(Codec::DispatchAll(buffer + HEADER_SIZE, length - HEADER_SIZE, writer.count(), counter) == 7);
+    assert(counter.counts[Heartbeat::TYPE] == 1 && counter.counts[AddOrder::TYPE] == 2 &&
+           counter.counts[SnapshotLevel::TYPE] == 1);
+
+    // the receiver turns them into updates of the book, each copy of a packet delivered once
+    FeedArbiter arbiter;
+    PacketStats stats {};
+    Collector collector;
+    assert(DeliverPacket(buffer, length, 0, stats, arbiter, collector));
+    assert(DeliverPacket(buffer, length, 1, stats, arbiter, collector));
+    assert(stats.packetsRecv == 2 && stats.tradesRecv == 1 && arbiter.line(1).duplicates == 1);
+
+    const auto& updates = collector.updates;
+    assert(updates.size() == 5 && stats.packetsEnqued == updates.size());
+    assert(updates[0].price == 98 && updates[0].size == 10 && updates[0].timestamp == 1002);
+    assert(updates[1].price == 102 && updates[1].side == Side::ASK && updates[1].sequence == 2);
+    assert(updates[2].price == 98 && updates[2].size == -3);
+    assert(updates[3].price == 102 && updates[3].size == 3);
+    assert(updates[4].price == 97.5 && updates[4].flags == MarketUpdate::SNAPSHOT);
+
+    OrderBook book;
+    for (const auto& update : updates) {
+        book.updateOrderBook(update);
+    }
+    assert(book.bestBid() == BookState::Item(98, 7));
+    assert(book.bestAsk() == BookState::Item(102, 8));
+
+    // a snapshot level replaces the level, a cancel of more than it holds removes it
+    book.updateOrderBook(MarketUpdate(Side::BID, 98, 2, 0, 1, 6, MarketUpdate::SNAPSHOT));
+    assert(book.bestBid() == BookState::Item(98, 2));
+    book.updateOrderBook(MarketUpdate(Side::BID, 98, -5));
+    assert(book.bestBid() == BookState::Item(97.5, 6));
+
+    // decoding stops at a truncated message or an unknown type, keeping what came before
+    Counter truncated;
+    assert(Codec::DispatchAll(buffer + HEADER_SIZE, length - HEADER_SIZE - 1, writer.count(), truncated) == 6);
+    buffer[HEADER_SIZE] = 42;
+    Counter unknown;
+    assert(Codec::DispatchAll(buffer + HEADER_SIZE, length - HEADER_SIZE, writer.count(), unknown) == 0);
+
+    // a packet is either valid in one of the formats or discarded
+    FeedMessagesHeader header;
+    assert(!ParseFeedMessagesHeader(buffer, HEADER_SIZE - 1, header));
+    stats = {};
+    FeedMessagesWriter next(buffer, 10, 0, 100, 0.5);
+    next.append(AddOrder { 0, 1, 6, Side::BID, 0, 1 });
+    assert(!DeliverPacket(buffer, next.finish() - 1, 0, stats, arbiter, collector));
+
+    // as many messages as fit in a packet, which is what a MarketUpdate packet holds several times over
+    FeedMessagesWriter full(buffer, 11, 0, 100, 0.5);
+    while (full.append(AddOrder { 0, 1, 0, Side::ASK, 1, 1 })) {
+    }
+    assert(full.finish() <= MAX_SIZE_FEED_MESSAGES && full.count() > MAX_COUNT_MARKET_UPDATE);
+
+    std::cout << "FeedMessages: " << full.count() << " AddOrder messages fit a packet where "
+              << MAX_COUNT_MARKET_UPDATE << " MarketUpdates do." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,75 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestInstrumentRegistry()
+{
+    constexpr size_t SHARDS = 3;
+    constexpr InstrumentId INSTRUMENTS = 20;
+    constexpr int UPDATES = 5000;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, INSTRUMENTS - 1);
+    std::uniform_real_distribution<> randPrice(90, 110);
+    std::uniform_int_distribution<> randSize(1, 100);
+    std::uniform_int_distribution<> randSide(0, 1);
+
+    std::atomic<bool> runFlag { true };
+    InstrumentRegistry registry(SHARDS);
+    registry.start(runFlag);
+
+    // the same updates applied in order on a single thread, instrument by instrument
+    std::map<InstrumentId, std::unique_ptr<Instrument>> reference;
+    for (auto i = 0; i < UPDATES; ++i) {
+        MarketUpdate update(static_cast<MarketUpdate::Side>(randSide(rng)), randPrice(rng), randSize(rng), i,
+                            randInstrument(rng));
+        while (!registry.route(update)) {
+            std::this_thread::yield();
+        }
+
+        auto& instrument = reference[update.instrument];
+        if (!instrument) {
+            instrument = std::make_unique<Instrument>();
+        }
+        instrument->orderBook.updateOrderBook(update);
+        instrument->tradingEngine.match(update);
+    }
+
+    while (registry.updatesProcessed() < UPDATES) {
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    registry.join();
+
+    for (const auto& [id, expected] : reference) {
+        // an instrument only lives on the shard it is routed to
+        for (size_t i = 0; i < SHARDS; ++i) {
+            assert((registry.shard(i).find(id) != nullptr) == (i == registry.shardOf(id)));
+        }
+
+        auto instrument = registry.find(id);
+        assert(instrument != nullptr);
+        assert(instrument->orderBook.bestBid() == expected->orderBook.bestBid());
+        assert(instrument->orderBook.bestAsk() == expected->orderBook.bestAsk());
+        assert(instrument->tradingEngine.bestBid() == expected->tradingEngine.bestBid());
+        assert(instrument->tradingEngine.bestAsk() == expected->tradingEngine.bestAsk());
+    }
+
+    std::cout << "InstrumentRegistry: " << UPDATES << " updates of " << reference.size() << " instruments applied by "
+              << SHARDS << " shards." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -3,9 +3,36 @@
 int main()
 {
     CryptoTradingInfra::Test::TestRingBuffer();
+    CryptoTradingInfra::Test::TestTicketRingBuffer();
+    CryptoTradingInfra::Test::TestEpochSnapshot();
+    CryptoTradingInfra::Test::TestPersistentMap();
+    CryptoTradingInfra::Test::TestSharedRingBuffer();
+    CryptoTradingInfra::Test::TestSequenceArbiter();
+    CryptoTradingInfra::Test::TestFeedMessages();
+    CryptoTradingInfra::Test::TestEventLog();
     CryptoTradingInfra::Test::TestOrderBook();
+    CryptoTradingInfra::Test::TestDeepBookState();
     CryptoTradingInfra::Test::TestExecutionEngineBasic();
     CryptoTradingInfra::Test::TestExecutionEngineCrossTrades();
+    CryptoTradingInfra::Test::TestExecutionEngineExpiry();
+    CryptoTradingInfra::Test::TestInstrumentRegistry();
+    CryptoTradingInfra::Test::TestConflatingRouter();
+    CryptoTradingInfra::Test::TestBarAggregator();
+    CryptoTradingInfra::Test::TestEngineEvents();
+    CryptoTradingInfra::Test::TestBookAnalytics();
+    CryptoTradingInfra::Test::TestDepthPublisher();
+    CryptoTradingInfra::Test::TestDeltaFeed();
+    CryptoTradingInfra::Test::TestSnapshotRecovery();
+    CryptoTradingInfra::Test::TestCheckpoint();
+    CryptoTradingInfra::Test::TestTickStore();
+    CryptoTradingInfra::Test::TestSessionReplay();
+    CryptoTradingInfra::Test::TestPerfCounters();
+    CryptoTradingInfra::Test::TestRiskGate();
+    CryptoTradingInfra::Test::TestTimingWheel();
+    CryptoTradingInfra::Test::TestConsolidatedBook();
+#ifdef CRYPTO_TRADING_INFRA_COOPERATIVE_MODE
+    CryptoTradingInfra::Test::TestCooperativePipeline();
+#endif
 
     // Uncomment to test receiving udp pakcets containing MarketUpdates from port 49152
     // You may use the udp_market_client.py script to generate packets
@@ -4,7 +4,10 @@
 #include <thread>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 #include <atomic>
+#include <map>
+#include <optional>
 
 #include "market_update.hpp"
 #include "order_book.hpp"
@@ -71,6 +74,154 @@ void TestOrderBook()
     std::cout << "Final OrderBook:\n";
     book.print(10);
 }
+
+namespace {
+
+template <typename Levels>
+std::optional<BookState::Item> Front(const Levels& levels)
+{
+    if (levels.empty()) {
+        return std::nullopt;
+    }
+    return BookState::Item(*levels.begin());
+}
+
+template <typename Levels>
+std::optional<BookState::Item> Back(const Levels& levels)
+{
+    if (levels.empty()) {
+        return std::nullopt;
+    }
+    return BookState::Item(*levels.rbegin());
+}
+
+template <typename Lhs, typename Rhs>
+bool SameLevel(const Lhs& lhs, const Rhs& rhs)
+{
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+}
+
+} // namespace
+
+void TestDeepBookState()
+{
+    // shallow books evict the worst level beyond their depth, and count it
+    BasicBookState<2> shallow;
+    shallow.updateState<MarketUpdate::Side::ASK>(101, 1);
+    shallow.updateState<MarketUpdate::Side::ASK>(102, 1);
+    shallow.updateState<MarketUpdate::Side::ASK>(100, 1);
+    assert(shallow.bestAsk() == std::make_pair(100.0, 1.0));
+    assert(shallow.droppedLevels() == 1);
+
+    // deep books keep every level within the ladder, with whole ticks so prices compare exactly
+    constexpr size_t DEPTH = 16384;
+    constexpr Price TICK = 0.5;
+    BasicBookState<DEPTH> deep(TICK);
+    std::map<Price, Size, std::greater<>> bids;
+    std::map<Price, Size, std::less<>> asks;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<> randTick(-4000, 4000);
+    std::uniform_int_distribution<> randSize(0, 5);
+    std::uniform_int_distribution<> randSide(0, 1);
+
+    for (auto i = 0; i < 50000; ++i) {
+        Price price = 1000 + randTick(rng) * TICK;
+        Size size = randSize(rng);
+        if (randSide(rng) == 0) {
+            deep.updateState<MarketUpdate::Side::BID>(price, size);
+            size == 0 ? bids.erase(price) : (bids[price] += size, 0);
+        } else {
+            deep.updateState<MarketUpdate::Side::ASK>(price, size);
+            size == 0 ? asks.erase(price) : (asks[price] += size, 0);
+        }
+
+        assert(deep.bestBid() == Front(bids));
+        assert(deep.bestAsk() == Front(asks));
+    }
+
+    assert(std::equal(bids.begin(), bids.end(), deep.bidsNAsks.bids.begin(), deep.bidsNAsks.bids.end(),
+                      SameLevel<BookState::Item, BookState::Item>));
+    assert(std::equal(asks.begin(), asks.end(), deep.bidsNAsks.asks.begin(), deep.bidsNAsks.asks.end(),
+                      SameLevel<BookState::Item, BookState::Item>));
+    assert(deep.droppedLevels() == 0);
+
+    // a copy is unaffected by emptying the original
+    auto copy = deep;
+    for (const auto& level : bids) {
+        deep.updateState<MarketUpdate::Side::BID>(level.first, 0);
+    }
+    assert(deep.empty<MarketUpdate::Side::BID>() && !copy.empty<MarketUpdate::Side::BID>());
+    assert(copy.bestBid() == Front(bids));
+
+    // a book emptied in place keeps the tick it was made with
+    const BasicBookState<DEPTH> empty(copy.tickSize());
+    copy = empty;
+    assert(copy.empty<MarketUpdate::Side::BID>() && copy.tickSize() == TICK);
+
+    // prices beyond the ladder are kept beside it rather than dropped
+    deep.updateState<MarketUpdate::Side::ASK>(1000 + DEPTH * TICK, 1);
+    assert(deep.droppedLevels() == 0 && deep.bidsNAsks.asks.back()->first == 1000 + DEPTH * TICK);
+
+    // the ladder follows the market, prices come back as they were given
+    constexpr size_t LADDER = DEEP_BOOK_DEPTH;
+    BasicBookState<LADDER> drifting(0.01);
+    std::map<Price, Size, std::greater<>> drifted;
+    for (size_t tick = 0; tick <= 2 * LADDER; ++tick) {
+        drifting.updateState<MarketUpdate::Side::BID>(0.57 + tick * 0.01, 1);
+        drifted[0.57 + tick * 0.01] = 1;
+        drifting.updateState<MarketUpdate::Side::ASK>(0.57 + (tick + 1) * 0.01, 1);
+        drifting.updateState<MarketUpdate::Side::ASK>(0.57 + tick * 0.01, 0);
+        assert(drifting.bestBid() == Front(drifted));
+    }
+    assert(drifting.bestAsk() == std::make_pair(0.57 + (2 * LADDER + 1) * 0.01, 1.0));
+    // the bids the ladder left behind are all kept, in order, after those still in it
+    assert(std::equal(drifted.begin(), drifted.end(), drifting.bidsNAsks.bids.begin(), drifting.bidsNAsks.bids.end(),
+                      SameLevel<BookState::Item, BookState::Item>));
+    assert(drifting.bidsNAsks.bids.back() == std::make_pair(0.57, 1.0));
+    // emptying the ladder brings the levels behind it back in, best first
+    for (size_t tick = 2 * LADDER; tick > LADDER / 4; --tick) {
+        drifting.updateState<MarketUpdate::Side::BID>(0.57 + tick * 0.01, 0);
+    }
+    assert(drifting.bestBid() == std::make_pair(0.57 + LADDER / 4 * 0.01, 1.0));
+    assert(drifting.bidsNAsks.bids.size() == LADDER / 4 + 1 && drifting.droppedLevels() == 0);
+
+    // a market wandering across many windows, with prices off the grid and prices rounding to the tick of
+    // another level, comes back level by level as a map has it
+    BasicBookState<LADDER> wandering(0.01);
+    std::map<Price, Size, std::greater<>> wanderingBids;
+    std::map<Price, Size, std::less<>> wanderingAsks;
+    std::uniform_int_distribution<> randStep(-30, 30);
+    std::uniform_int_distribution<> randOffset(0, 60);
+    std::uniform_int_distribution<> randKind(0, 9);
+    int64_t centre = 100000;
+    for (auto i = 0; i < 100000; ++i) {
+        centre += randStep(rng);
+        auto kind = randKind(rng);
+        auto offset = randOffset(rng);
+        Size size = randSize(rng);
+        Price off = kind == 0 ? 0.004 : kind == 1 ? 1e-9 : 0;
+        if (randSide(rng) == 0) {
+            Price price = (centre - offset) * 0.01 + off;
+            wandering.updateState<MarketUpdate::Side::BID>(price, size);
+            size == 0 ? wanderingBids.erase(price) : (wanderingBids[price] += size, 0);
+        } else {
+            Price price = (centre + offset) * 0.01 + off;
+            wandering.updateState<MarketUpdate::Side::ASK>(price, size);
+            size == 0 ? wanderingAsks.erase(price) : (wanderingAsks[price] += size, 0);
+        }
+        assert(wandering.bestBid() == Front(wanderingBids) && wandering.bestAsk() == Front(wanderingAsks));
+    }
+    assert(std::equal(wanderingBids.begin(), wanderingBids.end(), wandering.bidsNAsks.bids.begin(),
+                      wandering.bidsNAsks.bids.end(), SameLevel<BookState::Item, BookState::Item>));
+    assert(std::equal(wanderingAsks.begin(), wanderingAsks.end(), wandering.bidsNAsks.asks.begin(),
+                      wandering.bidsNAsks.asks.end(), SameLevel<BookState::Item, BookState::Item>));
+    assert(wandering.bidsNAsks.bids.back() == Back(wanderingBids));
+    assert(wandering.bidsNAsks.asks.back() == Back(wanderingAsks));
+
+    std::cout << "Deep BookState: " << bids.size() << " bids and " << asks.size() << " asks verified."
+              << std::endl;
+}
 } // namespace Test
 
 } // namespace CryptoTradingInfra
@@ -0,0 +1,77 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+#include "perf_counters.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+void Spin(std::chrono::microseconds duration)
+{
+    auto until = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+} // namespace
+
+void TestPerfCounters()
+{
+    constexpr int REGIONS = 20;
+    auto& monitor = Utils::PerfMonitor::Global();
+
+    // regions do nothing until the monitor is enabled
+    auto before = monitor.stage(Utils::PERF_RECEIVE);
+    {
+        Utils::PerfRegion region(Utils::PERF_RECEIVE);
+    }
+    assert(monitor.stage(Utils::PERF_RECEIVE).regions == before.regions);
+
+    // an outer region is only charged what the region nested in it did not take
+    monitor.enable();
+    auto outerBefore = monitor.stage(Utils::PERF_RECEIVE);
+    auto innerBefore = monitor.stage(Utils::PERF_ENQUEUE);
+    for (auto i = 0; i < REGIONS; ++i) {
+        Utils::PerfRegion outer(Utils::PERF_RECEIVE);
+        Spin(std::chrono::microseconds(100));
+        Utils::PerfRegion inner(Utils::PERF_ENQUEUE);
+        Spin(std::chrono::microseconds(500));
+    }
+    monitor.enable(false);
+    auto outer = monitor.stage(Utils::PERF_RECEIVE);
+    auto inner = monitor.stage(Utils::PERF_ENQUEUE);
+
+    Utils::PerfCounters counters;
+    if (!counters.any()) {
+        // perf_event_open is not allowed here, regions must have carried on without counters
+        assert(outer.regions == outerBefore.regions && inner.regions == innerBefore.regions);
+        std::cout << "PerfCounters: unavailable, regions ran without them." << std::endl;
+        return;
+    }
+
+    assert(outer.regions - outerBefore.regions == REGIONS && inner.regions - innerBefore.regions == REGIONS);
+    for (auto event : { Utils::PERF_CYCLES, Utils::PERF_TASK_CLOCK }) {
+        if (counters.available(event)) {
+            auto outerTaken = outer.values[event] - outerBefore.values[event];
+            auto innerTaken = inner.values[event] - innerBefore.values[event];
+            assert(outerTaken > 0 && outerTaken < innerTaken);
+        }
+    }
+    uint64_t values[Utils::PERF_EVENTS];
+    assert(counters.read(values));
+
+    size_t available = 0;
+    for (size_t i = 0; i < Utils::PERF_EVENTS; ++i) {
+        available += counters.available(static_cast<Utils::PerfEvent>(i));
+    }
+    std::cout << "PerfCounters: " << available << " of " << static_cast<int>(Utils::PERF_EVENTS) << " events counted, "
+              << REGIONS << " nested regions charged to their own stages." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
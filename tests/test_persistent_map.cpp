@@ -0,0 +1,91 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "persistent_map.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+using Map = Utils::PersistentSortedMap<int, int, std::greater<>, 4>;
+using Reference = std::map<int, int, std::greater<>>;
+
+bool Matches(const Map& map, const Reference& reference)
+{
+    if (map.size() != reference.size()) {
+        return false;
+    }
+
+    auto it = map.begin();
+    for (const auto& [key, value] : reference) {
+        if (it == map.end() || it->first != key || it->second != value) {
+            return false;
+        }
+        ++it;
+    }
+    return it == map.end();
+}
+
+} // namespace
+
+void TestPersistentMap()
+{
+    constexpr int OPERATIONS = 20000;
+    constexpr int KEYS = 300;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randKey(0, KEYS);
+    std::uniform_int_distribution<> randOp(0, 2);
+
+    Map map;
+    Reference reference;
+
+    // every few operations keep a version aside, none of them may be affected by later modifications
+    std::vector<std::pair<Map, Reference>> versions;
+
+    for (auto i = 0; i < OPERATIONS; ++i) {
+        auto key = randKey(rng);
+        if (randOp(rng) == 0) {
+            assert(map.erase(key) == (reference.erase(key) == 1));
+        } else {
+            map.assign(key, i);
+            reference[key] = i;
+        }
+
+        auto found = map.find(key);
+        assert((found == nullptr) == (reference.count(key) == 0));
+        assert(found == nullptr || *found == reference[key]);
+
+        if (i % 1000 == 0) {
+            versions.emplace_back(map, reference);
+        }
+    }
+
+    assert(Matches(map, reference));
+    assert(map.front()->first == reference.begin()->first);
+    assert(map.back()->first == reference.rbegin()->first);
+    for (const auto& [version, expected] : versions) {
+        assert(Matches(version, expected));
+    }
+
+    // drain a copy completely while the original stays untouched
+    auto copy = map;
+    for (const auto& entry : reference) {
+        assert(copy.erase(entry.first));
+    }
+    assert(copy.empty() && copy.begin() == copy.end() && !copy.front());
+    assert(Matches(map, reference));
+
+    std::cout << "PersistentSortedMap: " << OPERATIONS << " operations verified over " << versions.size()
+              << " versions." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -6,6 +6,7 @@
 #include <cassert>
 
 #include "ring_buffer.hpp"
+#include "ticket_ring_buffer.hpp"
 
 namespace CryptoTradingInfra {
 namespace Test {
@@ -15,7 +16,8 @@ constexpr int NUM_CONSUMERS = 4;
 constexpr int ITEMS_PER_PRODUCER = 10000;
 constexpr int RING_CAPACITY = 10240;
 
-void Producer(Utils::ConcurrentRingBuffer<int, RING_CAPACITY>& buffer, std::mutex& resultsMutex, int id) {
+template <typename Buffer>
+void Producer(Buffer& buffer, std::mutex& resultsMutex, int id) {
     int base = id * ITEMS_PER_PRODUCER;
     for (auto i = 0; i < ITEMS_PER_PRODUCER; ++i) {
         int value = base + i;
@@ -31,7 +33,8 @@ void Producer(Utils::ConcurrentRingBuffer<int, RING_CAPACITY>& buffer, std::mute
     }
 }
 
-void Consumer(Utils::ConcurrentRingBuffer<int, RING_CAPACITY>& buffer, std::set<int>& results, std::mutex& resultsMutex) {
+template <typename Buffer>
+void Consumer(Buffer& buffer, std::set<int>& results, std::mutex& resultsMutex) {
     int value;
     while (true) {
         if (buffer.pop(value)) {
@@ -46,22 +49,23 @@ void Consumer(Utils::ConcurrentRingBuffer<int, RING_CAPACITY>& buffer, std::set<
     }
 }
 
-void TestRingBuffer() {
+template <typename Buffer>
+void RunRingBuffer() {
 #ifndef CRYPTO_TRADING_INFRA_BENCHMARK
     std::cout << "Test started. " << std::endl;
 #endif
     std::set<int> results;
     std::mutex resultsMutex;
-    Utils::ConcurrentRingBuffer<int, RING_CAPACITY> buffer;
+    Buffer buffer;
 
     std::vector<std::thread> producers;
     for (auto i = 0; i < NUM_PRODUCERS; ++i) {
-        producers.emplace_back(Producer, std::ref(buffer), std::ref(resultsMutex), i);
+        producers.emplace_back(Producer<Buffer>, std::ref(buffer), std::ref(resultsMutex), i);
     }
 
     std::vector<std::thread> consumers;
     for (auto i = 0; i < NUM_CONSUMERS; ++i) {
-        consumers.emplace_back(Consumer, std::ref(buffer), std::ref(results), std::ref(resultsMutex));
+        consumers.emplace_back(Consumer<Buffer>, std::ref(buffer), std::ref(results), std::ref(resultsMutex));
     }
 
     for (auto& t : producers) {
@@ -83,5 +87,29 @@ void TestRingBuffer() {
 #endif
 }
 
+void TestRingBuffer() {
+    RunRingBuffer<Utils::ConcurrentRingBuffer<int, RING_CAPACITY>>();
+}
+
+void TestTicketRingBuffer() {
+    RunRingBuffer<Utils::TicketRingBuffer<int, RING_CAPACITY>>();
+
+    // a full ring refuses pushes until something is popped, and gives items back in order to a single consumer
+    Utils::TicketRingBuffer<int, 4> small;
+    for (auto round = 0; round < 3; ++round) {
+        for (auto i = 0; i < 4; ++i) {
+            assert(small.push(round * 4 + i));
+        }
+        assert(!small.push(-1) && !small.emplace(-1));
+        int value;
+        for (auto i = 0; i < 4; ++i) {
+            assert(small.pop(value) && value == round * 4 + i);
+        }
+        assert(!small.pop(value) && small.empty());
+    }
+    std::cout << "TicketRingBuffer: " << NUM_PRODUCERS * ITEMS_PER_PRODUCER << " items passed from "
+              << NUM_PRODUCERS << " producers to " << NUM_CONSUMERS << " consumers." << std::endl;
+}
+
 }
 }
@@ -0,0 +1,121 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "engine_events.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "risk_gate.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+MarketUpdate Order(AccountId account, MarketUpdate::Side side, Price price, Size size, uint64_t timestamp = 0)
+{
+    MarketUpdate order(side, price, size, timestamp, 1);
+    order.account = account;
+    return order;
+}
+
+} // namespace
+
+void TestRiskGate()
+{
+    constexpr auto BID = MarketUpdate::Side::BID;
+    constexpr auto ASK = MarketUpdate::Side::ASK;
+    const BookState::Item bid { 100, 5 };
+    const BookState::Item ask { 101, 5 };
+
+    auto parsed = RiskLimits::Parse("size=10,band=0.05,position=15,notional=1e6,rate=2");
+    assert(parsed && parsed->maxOrderSize == 10 && parsed->priceBand == 0.05 && parsed->maxPosition == 15 &&
+           parsed->maxNotional == 1e6 && parsed->ordersPerSecond == 2);
+    for (auto text : { "", "size", "size=0", "size=-1", "size=1x", "depth=3", "size=1,,band=2" }) {
+        assert(!RiskLimits::Parse(text));
+    }
+
+    // every limit rejects what breaks it and nothing else
+    {
+        RiskGate gate(1, *parsed);
+        assert(gate.check(Order(300, BID, 100, 1), bid, ask) == RiskReject::ACCOUNT);
+        assert(gate.check(Order(1, BID, 100, 11), bid, ask) == RiskReject::ORDER_SIZE);
+        assert(gate.check(Order(1, BID, 106.1, 1), bid, ask) == RiskReject::PRICE_BAND);
+        assert(gate.check(Order(1, ASK, 94.9, 1), bid, ask) == RiskReject::PRICE_BAND);
+        // far from a side that is empty is fine
+        assert(gate.check(Order(1, BID, 200, 1), bid, { 0, 0 }) == RiskReject::NONE);
+
+        gate.onFill(1, BID, 10);
+        assert(gate.position(1) == 10 && gate.position(2) == 0);
+        assert(gate.check(Order(1, BID, 100, 6), bid, ask) == RiskReject::POSITION);
+        assert(gate.check(Order(1, ASK, 100, 10), bid, ask) == RiskReject::NONE);
+        assert(gate.accepted(1) == 2 && gate.rejected(1) == 4);
+    }
+    {
+        RiskLimits limits;
+        limits.maxNotional = 1000;
+        RiskGate gate(1, limits);
+        assert(gate.check(Order(1, BID, 100, 10), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 101, 10), bid, ask) == RiskReject::NOTIONAL);
+        gate.onFill(1, ASK, 5);
+        assert(gate.check(Order(1, BID, 101, 10), bid, ask) == RiskReject::NONE);
+    }
+
+    // two orders a second, the bucket refilling along the timestamps of the orders
+    {
+        RiskLimits limits;
+        limits.ordersPerSecond = 2;
+        RiskGate gate(1, limits);
+        uint64_t second = 1000000000;
+        assert(gate.check(Order(1, BID, 100, 1, second), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, second), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, second + 1000), bid, ask) == RiskReject::RATE);
+        // accounts have buckets of their own
+        assert(gate.check(Order(2, BID, 100, 1, second + 1000), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, second + second / 2), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, second + second / 2), bid, ask) == RiskReject::RATE);
+        // an idle account gets no more than a second of orders back
+        assert(gate.check(Order(1, BID, 100, 1, 10 * second), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, 10 * second), bid, ask) == RiskReject::NONE);
+        assert(gate.check(Order(1, BID, 100, 1, 10 * second), bid, ask) == RiskReject::RATE);
+
+        // nobody to hand rejects to, they are counted instead
+        gate.reject(Order(1, BID, 100, 1), RiskReject::RATE);
+        assert(gate.rejectsDropped() == 1);
+    }
+
+    // in front of the books of an instrument, positions following the trades of the engine
+    RejectRing rejects;
+    Instrument instrument;
+    instrument.risk = std::make_unique<RiskGate>(1, *RiskLimits::Parse("size=10,band=0.05,position=15"), &rejects);
+    EventHandler events;
+    instrument.apply(1, MarketUpdate(ASK, 101, 20, 1, 1), events);
+    instrument.apply(1, MarketUpdate(BID, 100, 20, 2, 1), events);
+    // market data carries no account and is never checked
+    instrument.apply(1, MarketUpdate(ASK, 102, 50, 3, 1), events);
+
+    instrument.apply(1, Order(7, BID, 101, 8, 4), events);
+    assert(instrument.risk->position(7) == 8);
+    instrument.apply(1, Order(7, BID, 101, 8, 5), events);
+    assert(instrument.risk->position(7) == 8 && instrument.risk->rejected(7) == 1);
+    instrument.apply(1, Order(8, BID, 110, 1, 6), events);
+    instrument.apply(1, Order(7, ASK, 100, 10, 7), events);
+    assert(instrument.risk->position(7) == -2);
+
+    // rejected orders reached neither book
+    assert(instrument.orderBook.bestBid() == std::make_pair(101.0, 8.0));
+    assert(instrument.tradingEngine.bestBid() == std::make_pair(100.0, 10.0));
+    RejectEvent reject;
+    assert(rejects.pop(reject) && reject.account == 7 && reject.reason == RiskReject::POSITION &&
+           reject.timestamp == 5);
+    assert(rejects.pop(reject) && reject.account == 8 && reject.reason == RiskReject::PRICE_BAND &&
+           reject.price == 110);
+    assert(!rejects.pop(reject));
+
+    std::cout << "RiskGate: every limit verified, positions followed " << instrument.risk->accepted(7)
+              << " orders through the engine." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,114 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "sequence_arbiter.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestSequenceArbiter()
+{
+    constexpr size_t WINDOW = 64;
+    constexpr size_t LINE_A = 0;
+    constexpr size_t LINE_B = 1;
+
+    {
+        Utils::SequenceArbiter<WINDOW> arbiter;
+
+        // the first packet starts the feed, whatever its sequence
+        assert(arbiter.accept(LINE_A, 100));
+        assert(!arbiter.accept(LINE_B, 100));
+        assert(arbiter.accept(LINE_B, 101));
+        assert(!arbiter.accept(LINE_A, 101));
+        assert(arbiter.gaps() == 0);
+
+        // 102 to 104 are lost on line A, B fills in 103 late
+        assert(arbiter.accept(LINE_A, 105));
+        assert(arbiter.gaps() == 3);
+        assert(arbiter.accept(LINE_B, 103));
+        assert(arbiter.gaps() == 2);
+        assert(!arbiter.accept(LINE_A, 103));
+
+        // a copy older than the window can no longer be told apart from a duplicate
+        assert(arbiter.accept(LINE_A, 105 + WINDOW));
+        assert(!arbiter.accept(LINE_B, 105));
+        assert(arbiter.gaps() == 2 + WINDOW - 1);
+
+        auto a = arbiter.line(LINE_A);
+        auto b = arbiter.line(LINE_B);
+        assert(a.won == 3 && a.duplicates == 2 && a.stale == 0);
+        assert(b.won == 2 && b.duplicates == 1 && b.stale == 1);
+    }
+
+    // a feed restarting from 0 is taken as it was the first time, the sequences missed before being kept
+    {
+        constexpr uint64_t STOPPED = 20 * WINDOW;
+        Utils::SequenceArbiter<WINDOW> arbiter;
+        for (uint64_t sequence = 0; sequence < STOPPED; ++sequence) {
+            if (sequence != 7) {
+                assert(arbiter.accept(LINE_A, sequence));
+            }
+        }
+        assert(arbiter.gaps() == 1 && arbiter.restarts() == 0);
+        for (uint64_t sequence = 0; sequence < 2 * WINDOW; ++sequence) {
+            assert(arbiter.accept(sequence % 2 == 0 ? LINE_A : LINE_B, sequence));
+            assert(!arbiter.accept(sequence % 2 == 0 ? LINE_B : LINE_A, sequence));
+        }
+        assert(arbiter.restarts() == 1 && arbiter.gaps() == 1);
+        // the next three are lost on both lines
+        assert(arbiter.accept(LINE_A, 2 * WINDOW + 3));
+        assert(arbiter.gaps() == 4);
+    }
+
+    // both lines deliver the same feed from their own thread, each losing some packets the other line has. The
+    // window covers the whole feed, however far apart the threads drift
+    constexpr uint64_t PACKETS = 500000;
+    constexpr uint64_t LOST_EVERY = 100000;
+    constexpr uint64_t LOST_ON_BOTH = PACKETS / LOST_EVERY;
+    auto arbiter = std::make_unique<Utils::SequenceArbiter<PACKETS>>();
+    std::atomic<uint64_t> accepted { 0 };
+    std::atomic<bool> start { false };
+
+    auto receive = [&](size_t line, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::bernoulli_distribution lost(0.01);
+        while (!start.load()) {
+            std::this_thread::yield();
+        }
+        for (uint64_t sequence = 0; sequence < PACKETS; ++sequence) {
+            bool onBoth = sequence % LOST_EVERY == 1;
+            // a packet lost on A always reaches B, so only the ones lost on both are missing
+            if (onBoth || (line == LINE_A && lost(rng))) {
+                continue;
+            }
+            if (arbiter->accept(line, sequence)) {
+                accepted.fetch_add(1);
+            }
+        }
+    };
+
+    std::thread lineA(receive, LINE_A, 1);
+    std::thread lineB(receive, LINE_B, 2);
+    start.store(true);
+    lineA.join();
+    lineB.join();
+
+    auto a = arbiter->line(LINE_A);
+    auto b = arbiter->line(LINE_B);
+    assert(accepted.load() == PACKETS - LOST_ON_BOTH);
+    assert(a.won + b.won == accepted.load());
+    assert(arbiter->gaps() == LOST_ON_BOTH);
+
+    std::cout << "SequenceArbiter: " << PACKETS << " packets on two lines, A first " << a.won << " times, B first "
+              << b.won << " times, " << arbiter->gaps() << " lost on both." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
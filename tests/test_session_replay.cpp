@@ -0,0 +1,150 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market_update.hpp"
+#include "session_replay.hpp"
+#include "tick_store.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+std::vector<MarketUpdate> Session(unsigned seed, size_t count)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, 5);
+    std::uniform_int_distribution<> randCents(-300, 300);
+    std::uniform_int_distribution<> randSize(1, 50);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::map<InstrumentId, uint64_t> sequences;
+    std::vector<MarketUpdate> updates;
+    uint64_t timestamp = 1000;
+    for (size_t i = 0; i < count; ++i) {
+        auto instrument = randInstrument(rng);
+        timestamp += rng() % 100;
+        updates.emplace_back(static_cast<MarketUpdate::Side>(randSide(rng)), 97 + randCents(rng) / 100.0,
+                             randSize(rng), timestamp, instrument, ++sequences[instrument]);
+    }
+    return updates;
+}
+
+bool SameResult(const ReplayResult& a, const ReplayResult& b)
+{
+    return a.complete && b.complete && a.updates == b.updates && a.instruments == b.instruments &&
+           a.trades == b.trades && a.volume == b.volume;
+}
+
+} // namespace
+
+void TestSessionReplay()
+{
+    // jobs of very uneven length, some of them submitting more jobs, each run exactly once
+    {
+        constexpr size_t JOBS = 200;
+        std::vector<std::atomic<int>> runs(2 * JOBS);
+        Utils::WorkStealingPool pool(4);
+        for (size_t i = 0; i < JOBS; ++i) {
+            pool.submit([&, i]() {
+                ++runs[i];
+                if (i % 10 == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+                if (i % 2 == 0) {
+                    pool.submit([&, i]() { ++runs[JOBS + i]; });
+                }
+            });
+        }
+        pool.wait();
+        for (size_t i = 0; i < 2 * JOBS; ++i) {
+            assert(runs[i].load() == (i < JOBS || i % 2 == 0 ? 1 : 0));
+        }
+    }
+
+    // sessions stored as captures and tick stores, replayed in parallel as they are one after another
+    constexpr size_t SESSIONS = 6;
+    std::vector<ReplayJob> jobs;
+    for (size_t i = 0; i < SESSIONS; ++i) {
+        auto updates = Session(i, 2000 + i * 3000);
+        auto path = "/tmp/crypto_trading_infra_test_session_" + std::to_string(i);
+        if (i % 2 == 0) {
+            std::ofstream capture(path, std::ios::binary | std::ios::trunc);
+            for (auto update : updates) {
+                update.hton();
+                capture.write(reinterpret_cast<const char *>(&update), sizeof(update));
+            }
+        } else {
+            auto store = TickStoreWriter::Create(path);
+            assert(store != nullptr);
+            for (const auto& update : updates) {
+                store->append(update);
+            }
+            assert(store->close());
+        }
+        jobs.push_back({ path });
+        jobs.push_back({ path, updates[updates.size() / 4].timestamp, updates[updates.size() / 2].timestamp });
+    }
+    jobs.push_back({ "/tmp/crypto_trading_infra_test_session_missing" });
+
+    std::vector<ReplayResult> sequential;
+    for (const auto& job : jobs) {
+        sequential.push_back(SessionReplay().run(job));
+    }
+    std::vector<ReplayResult> parallel(jobs.size());
+    uint64_t stolen;
+    {
+        Utils::WorkStealingPool pool(3);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            pool.submit([&, i]() { parallel[i] = SessionReplay().run(jobs[i]); });
+        }
+        pool.wait();
+        stolen = pool.stolen();
+    }
+
+    uint64_t updates = 0;
+    for (size_t i = 0; i + 1 < jobs.size(); ++i) {
+        assert(SameResult(sequential[i], parallel[i]));
+        assert(sequential[i].instruments == 6 && sequential[i].trades > 0);
+        updates += parallel[i].updates;
+    }
+    // a range replays fewer updates than its whole session
+    for (size_t i = 0; i < SESSIONS; ++i) {
+        assert(sequential[2 * i + 1].updates < sequential[2 * i].updates);
+    }
+    assert(!sequential.back().complete && !parallel.back().complete);
+
+    // a capture cut within its last update replays the ones before it, and is reported as incomplete
+    {
+        std::ifstream whole(jobs[0].path, std::ios::binary);
+        std::vector<char> bytes(3 * sizeof(MarketUpdate) + sizeof(MarketUpdate) / 2);
+        assert(whole.read(bytes.data(), bytes.size()));
+        auto path = jobs[0].path + "_truncated";
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+        auto truncated = SessionReplay().run({ path });
+        assert(!truncated.complete && truncated.updates == 3);
+        std::remove(path.c_str());
+    }
+
+    for (size_t i = 0; i < SESSIONS; ++i) {
+        std::remove(jobs[2 * i].path.c_str());
+    }
+
+    std::cout << "SessionReplay: " << jobs.size() - 1 << " sessions of " << updates
+              << " updates replayed on 3 threads as they are one after another, " << stolen << " jobs stolen."
+              << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
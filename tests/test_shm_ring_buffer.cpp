@@ -0,0 +1,82 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "market_update.hpp"
+#include "shm_ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestSharedRingBuffer()
+{
+    constexpr int ITEMS = 100000;
+    constexpr size_t RING_CAPACITY = 1024;
+
+    using Ring = Utils::SharedRingBuffer<MarketUpdate, RING_CAPACITY>;
+    auto name = "/crypto_trading_infra_test_" + std::to_string(getpid());
+
+    auto ring = Ring::Create(name);
+    assert(ring != nullptr);
+    assert(ring->empty() && !ring->full());
+
+    // a ring of another layout must refuse to attach to the segment
+    assert((Utils::SharedRingBuffer<MarketUpdate, RING_CAPACITY * 2>::Attach(name)) == nullptr);
+
+    // the producer is another process, attaching to the segment by name only
+    auto pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        auto producer = Ring::Attach(name);
+        if (!producer) {
+            _exit(1);
+        }
+        for (auto i = 0; i < ITEMS; ++i) {
+            while (!producer->emplace(MarketUpdate::Side::BID, i, 1, i, i % 7)) {
+                std::this_thread::yield();
+            }
+        }
+        _exit(0);
+    }
+
+    for (auto i = 0; i < ITEMS; ++i) {
+        MarketUpdate update;
+        while (!ring->pop(update)) {
+            std::this_thread::yield();
+        }
+        assert(update.timestamp == static_cast<uint64_t>(i) && update.price == i);
+        assert(update.instrument == static_cast<InstrumentId>(i % 7));
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(ring->empty());
+
+    // a creator restarting replaces the segment, a process attached to the old one finds out and attaches again
+    auto attached = Ring::Attach(name);
+    assert(attached != nullptr && !attached->replaced());
+    ring.reset();
+    assert(attached->replaced());
+    ring = Ring::Create(name);
+    assert(ring != nullptr && attached->replaced());
+    attached = Ring::Attach(name);
+    assert(attached != nullptr && !attached->replaced());
+    MarketUpdate update;
+    assert(ring->emplace(MarketUpdate::Side::ASK, 5, 1) && attached->pop(update) && update.price == 5);
+    attached.reset();
+
+    ring.reset();
+    assert(Ring::Attach(name) == nullptr);
+
+    std::cout << "SharedRingBuffer: " << ITEMS << " MarketUpdates passed between processes." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
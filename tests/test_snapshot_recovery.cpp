@@ -0,0 +1,115 @@
+#include "test_entries.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "conflating_router.hpp"
+#include "instrument_registry.hpp"
+#include "market_update.hpp"
+#include "snapshot_recovery.hpp"
+#include "snapshot_service.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+bool SameBook(const OrderBook& book, const BookSnapshot& expected)
+{
+    return book.read([&](const BookState& state) {
+        std::vector<BookState::Item> bids;
+        std::vector<BookState::Item> asks;
+        for (const auto& [price, size] : state.bidsNAsks.bids) {
+            bids.emplace_back(price, size);
+        }
+        for (const auto& [price, size] : state.bidsNAsks.asks) {
+            asks.emplace_back(price, size);
+        }
+        return bids == expected.bids && asks == expected.asks;
+    });
+}
+
+} // namespace
+
+void TestSnapshotRecovery()
+{
+    constexpr int UPDATES = 20000;
+    constexpr InstrumentId INSTRUMENTS = 6;
+    constexpr InstrumentId LOSSY = 1;
+    constexpr InstrumentId LATE = 4;
+    constexpr uint64_t LOST = 6;
+    constexpr uint64_t MISSED = 50;
+
+    auto endpoint = "/tmp/crypto_trading_infra_test_" + std::to_string(getpid()) + ".sock";
+    SnapshotCache cache;
+    auto server = SnapshotServer::Create(endpoint, [&](InstrumentId id) { return cache.snapshot(id); });
+    assert(server != nullptr);
+    auto recovery = SnapshotRecovery::Create(endpoint);
+    assert(recovery != nullptr);
+
+    // a stray snapshot of an instrument nobody updated is an empty book
+    auto client = SnapshotClient::Create(endpoint);
+    BookSnapshot empty;
+    assert(client->fetch(42, empty) && empty.sequence == 0 && empty.bids.empty() && empty.asks.empty());
+
+    InstrumentRegistry registry(2);
+    ConflatingRouter router(registry, DEFAULT_HIGH_WATER_MARK, recovery.get());
+    std::atomic<bool> runFlag { true };
+    registry.start(runFlag);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> randPrice(100, 130);
+    std::uniform_int_distribution<> randSize(0, 10);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, INSTRUMENTS - 1);
+
+    // the snapshot server sees every update, the engine loses a few of LOSSY's and joins LATE's feed late
+    std::vector<uint64_t> sequences(INSTRUMENTS, 0);
+    for (auto i = 0; i < UPDATES; ++i) {
+        auto id = randInstrument(rng);
+        MarketUpdate update(static_cast<MarketUpdate::Side>(randSide(rng)), randPrice(rng), randSize(rng), i, id,
+                            ++sequences[id]);
+        cache.apply(update);
+
+        bool lost = id == LOSSY && update.sequence > 1000 && update.sequence <= 1000 + LOST;
+        bool missed = id == LATE && update.sequence <= MISSED;
+        if (!lost && !missed) {
+            router.route(update);
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((router.recovering() > 0 || router.backlog() > 0 ||
+            registry.updatesProcessed() < router.statistics().routed) &&
+           std::chrono::steady_clock::now() < deadline) {
+        router.drain();
+        std::this_thread::yield();
+    }
+    runFlag.store(false);
+    registry.join();
+
+    const auto& stats = router.statistics();
+    assert(router.recovering() == 0);
+    assert(stats.gaps == LOST && stats.recoveries == 2);
+
+    // every book ends up where the server's is, the ones that never missed an update without any snapshot
+    for (InstrumentId id = 0; id < INSTRUMENTS; ++id) {
+        auto instrument = registry.find(id);
+        assert(instrument != nullptr);
+        assert(SameBook(instrument->orderBook, cache.snapshot(id)));
+    }
+    assert(recovery->statistics().fetched == stats.recoveries);
+
+    std::cout << "SnapshotRecovery: " << stats.recoveries << " books recovered from snapshots while "
+              << registry.updatesProcessed() << " updates were processed." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
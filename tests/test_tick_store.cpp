@@ -0,0 +1,184 @@
+#include "test_entries.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "execution_engine.hpp"
+#include "market_update.hpp"
+#include "order_book.hpp"
+#include "stream_vbyte.hpp"
+#include "tick_store.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+namespace {
+
+bool SameUpdate(const MarketUpdate& a, const MarketUpdate& b)
+{
+    return std::memcmp(&a, &b, sizeof(MarketUpdate)) == 0;
+}
+
+std::vector<BookState::Item> Levels(const BookState& state)
+{
+    std::vector<BookState::Item> levels;
+    for (const auto& level : state.bidsNAsks.bids) {
+        levels.push_back(level);
+    }
+    for (const auto& level : state.bidsNAsks.asks) {
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+} // namespace
+
+void TestTickStore()
+{
+    constexpr size_t UPDATES = 5 * TICK_CHUNK_SIZE + 123;
+    constexpr InstrumentId INSTRUMENTS = 300;
+    const std::string path = "/tmp/crypto_trading_infra_test_tick_store";
+
+    // values of every byte length, decoded the same with and without SSSE3
+    {
+        std::mt19937 rng(5);
+        std::vector<uint32_t> values(1001);
+        for (auto& value : values) {
+            value = rng() >> (rng() % 32);
+        }
+        std::vector<uint8_t> encoded(Utils::StreamVByte::MaxEncodedSize(values.size()));
+        auto length = Utils::StreamVByte::Encode(values.data(), values.size(), encoded.data());
+        std::vector<uint32_t> decoded(values.size());
+        assert(Utils::StreamVByte::Decode(encoded.data(), length, values.size(), decoded.data()) == length);
+        assert(decoded == values);
+        std::vector<uint32_t> scalar(values.size());
+        Utils::StreamVByte::Detail::DecodeScalar(encoded.data(), encoded.data() + (values.size() + 3) / 4, 0,
+                                                 values.size(), scalar.data());
+        assert(scalar == values);
+        assert(Utils::StreamVByte::Decode(encoded.data(), length - 1, values.size(), decoded.data()) == 0);
+        for (int64_t value : { 0L, -1L, 1L, static_cast<long>(INT32_MIN), static_cast<long>(INT32_MAX) }) {
+            assert(Utils::StreamVByte::UnZigZag(Utils::StreamVByte::ZigZag(value)) == value);
+        }
+    }
+
+    // prices in cents within the span of a tick ladder of a deep book, orders of a few accounts, then a chunk of
+    // prices no decimals code exactly, timestamps jumping too far for deltas and updates with flags
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<InstrumentId> randInstrument(0, INSTRUMENTS - 1);
+    std::uniform_int_distribution<> randCents(-500, 500);
+    std::uniform_int_distribution<> randSize(0, 40);
+    std::uniform_int_distribution<> randSide(0, 1);
+    std::map<InstrumentId, uint64_t> sequences;
+    std::vector<MarketUpdate> updates;
+    uint64_t timestamp = 1700000000000000000;
+    for (size_t i = 0; i < UPDATES; ++i) {
+        auto instrument = randInstrument(rng);
+        auto price = 97 + randCents(rng) / 100.0;
+        Size size = randSize(rng) / 4.0;
+        uint8_t flags = 0;
+        timestamp += rng() % 1000;
+        if (i / TICK_CHUNK_SIZE == 2) {
+            price = 97 + randCents(rng) / 300.0;
+        } else if (i / TICK_CHUNK_SIZE == 3 && i % 1000 == 0) {
+            timestamp += 1ULL << 40;
+        } else if (i / TICK_CHUNK_SIZE == 4 && i % 100 == 0) {
+            flags = i % 200 == 0 ? MarketUpdate::CLEAR_BOOK : MarketUpdate::SNAPSHOT;
+        }
+        updates.emplace_back(static_cast<MarketUpdate::Side>(randSide(rng)), price, size, timestamp, instrument,
+                             ++sequences[instrument], flags);
+        if (i / TICK_CHUNK_SIZE == 1 && i % 50 == 0) {
+            updates.back().account = static_cast<AccountId>(1 + i % 7 * 1000);
+        }
+    }
+
+    auto writer = TickStoreWriter::Create(path);
+    assert(writer != nullptr);
+    for (const auto& update : updates) {
+        assert(writer->append(update));
+    }
+    assert(writer->close() && writer->updatesWritten() == UPDATES);
+
+    auto reader = TickStoreReader::Open(path);
+    assert(reader != nullptr && reader->updates() == UPDATES && reader->chunks() == UPDATES / TICK_CHUNK_SIZE + 1);
+    std::vector<MarketUpdate> replayed;
+    assert(reader->replay([&](const MarketUpdate *batch, size_t count) {
+        replayed.insert(replayed.end(), batch, batch + count);
+    }));
+    assert(replayed.size() == UPDATES);
+    for (size_t i = 0; i < UPDATES; ++i) {
+        assert(SameUpdate(replayed[i], updates[i]));
+    }
+    auto bytes = reader->bytes();
+
+    // a time range only decodes the chunks that overlap it
+    auto from = updates[UPDATES / 2].timestamp;
+    auto to = updates[UPDATES / 2 + 100].timestamp;
+    replayed.clear();
+    assert(reader->replay([&](const MarketUpdate *batch, size_t count) {
+        replayed.insert(replayed.end(), batch, batch + count);
+    }, from, to));
+    std::vector<MarketUpdate> inRange;
+    for (const auto& update : updates) {
+        if (update.timestamp >= from && update.timestamp <= to) {
+            inRange.push_back(update);
+        }
+    }
+    assert(replayed.size() == inRange.size());
+    for (size_t i = 0; i < inRange.size(); ++i) {
+        assert(SameUpdate(replayed[i], inRange[i]));
+    }
+
+    // applied in batches, books and engines end up as they do applying updates one by one
+    {
+        OrderBook single;
+        OrderBook batched;
+        TradingEngine singleEngine;
+        TradingEngine batchedEngine;
+        std::vector<MarketUpdate> instrument;
+        for (const auto& update : updates) {
+            if (update.instrument == 7) {
+                instrument.push_back(update);
+            }
+        }
+        for (const auto& update : instrument) {
+            if (update.flags & MarketUpdate::CLEAR_BOOK) {
+                single.clear();
+                continue;
+            }
+            single.updateOrderBook(update);
+            if ((update.flags & MarketUpdate::SNAPSHOT) == 0) {
+                singleEngine.match(update);
+            }
+        }
+        for (size_t begin = 0; begin < instrument.size(); begin += 5) {
+            auto count = std::min<size_t>(5, instrument.size() - begin);
+            batched.updateOrderBook(instrument.data() + begin, count);
+            batchedEngine.match(instrument.data() + begin, count);
+        }
+        assert(single.read(Levels) == batched.read(Levels) && !batched.read(Levels).empty());
+        assert(singleEngine.read(Levels) == batchedEngine.read(Levels));
+    }
+
+    // a store with a damaged footer, as one cut short would have, is refused rather than read
+    reader.reset();
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put(0);
+    }
+    assert(TickStoreReader::Open(path) == nullptr);
+    std::remove(path.c_str());
+
+    std::cout << "TickStore: " << UPDATES << " MarketUpdates stored in " << bytes << " bytes instead of "
+              << UPDATES * sizeof(MarketUpdate) << " and replayed exactly." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
@@ -0,0 +1,78 @@
+#include "test_entries.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "timing_wheel.hpp"
+
+namespace CryptoTradingInfra {
+namespace Test {
+
+void TestTimingWheel()
+{
+    constexpr uint32_t VALUES = 20000;
+
+    // a value due in the past fires on the next tick
+    {
+        Utils::TimingWheel<int> wheel(100);
+        wheel.schedule(50, 1);
+        std::vector<int> fired;
+        wheel.advance(100, [&](int value) { fired.push_back(value); });
+        assert(fired.empty());
+        wheel.advance(101, [&](int value) { fired.push_back(value); });
+        assert(fired == std::vector<int> { 1 } && wheel.empty());
+    }
+
+    // values from a tick to beyond what the wheel spans ahead, some of them cancelled, advanced by steps from a
+    // tick to hours of them, every value expiring in the step reaching its tick and in the order of the ticks
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<> randRange(0, 4);
+    const uint64_t ranges[] = { 300, 70000, 20000000, uint64_t { 1 } << 33, uint64_t { 1 } << 40 };
+    Utils::TimingWheel<uint32_t> wheel;
+    std::vector<uint64_t> expiries(VALUES);
+    std::vector<Utils::TimingWheel<uint32_t>::Handle> handles(VALUES);
+    std::vector<bool> cancelled(VALUES, false);
+    std::vector<bool> fired(VALUES, false);
+    for (uint32_t i = 0; i < VALUES; ++i) {
+        expiries[i] = 1 + rng() % ranges[randRange(rng)];
+        handles[i] = wheel.schedule(expiries[i], i);
+    }
+    uint32_t pending = VALUES;
+    for (uint32_t i = 0; i < VALUES; i += 4) {
+        wheel.cancel(handles[i]);
+        cancelled[i] = true;
+        --pending;
+    }
+    assert(wheel.size() == pending);
+
+    uint64_t firedNum = 0;
+    uint64_t steps = 0;
+    while (!wheel.empty()) {
+        auto from = wheel.now();
+        auto to = from + 1 + rng() % ranges[randRange(rng) % 3];
+        uint64_t last = from;
+        wheel.advance(to, [&](uint32_t value) {
+            assert(!cancelled[value] && !fired[value]);
+            assert(expiries[value] > from && expiries[value] <= to && expiries[value] >= last);
+            last = expiries[value];
+            fired[value] = true;
+            ++firedNum;
+        });
+        assert(wheel.now() == to);
+        ++steps;
+    }
+    assert(firedNum == pending);
+
+    // handles of values gone are reused
+    auto handle = wheel.schedule(wheel.now() + 5, 0);
+    assert(handle < VALUES && wheel.size() == 1);
+
+    std::cout << "TimingWheel: " << firedNum << " of " << VALUES << " values expired on time in " << steps
+              << " steps, the others cancelled." << std::endl;
+}
+
+} // namespace Test
+} // namespace CryptoTradingInfra
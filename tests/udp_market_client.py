@@ -9,6 +9,11 @@ import numpy as np
 
 running = True
 total_packets_sent = 0
+next_sequence = 0
+# every instrument numbers its updates on its own, starting from the same base as packets
+instrument_sequences = {}
+# updates are tagged with a random account between 0 and accounts - 1, 0 being market data
+accounts = 1
 
 def signal_handler(sig, frame):
     global running
@@ -20,71 +25,89 @@ def signal_handler(sig, frame):
 signal.signal(signal.SIGINT, signal_handler)
 
 class MarketUpdateHeader:
-    STRUCT_FORMAT = '>HH'   # little-endian, uint16_t, uint16_t
+    STRUCT_FORMAT = '>HHQ'   # big-endian, uint16_t, uint16_t, uint64_t
     SIZE = struct.calcsize(STRUCT_FORMAT)
     PROTOCOL_MARKET_UPDATE = 0x6666
 
-    def __init__(self, count=1, protocol=PROTOCOL_MARKET_UPDATE):
+    def __init__(self, count=1, sequence=0, protocol=PROTOCOL_MARKET_UPDATE):
         self.count = count
+        self.sequence = sequence
         self.protocol = protocol
 
     def pack(self):
-        return struct.pack(self.STRUCT_FORMAT, self.protocol, self.count)
+        return struct.pack(self.STRUCT_FORMAT, self.protocol, self.count, self.sequence)
 
 class MarketUpdate:
     # MarketUpdate struct:
-    # uint64_t timestamp, double price, double size, uint8_t side
-    # Equivalent to C++: <QddB (little-endian, 8-byte uint, double, double, 1-byte uint)
-    STRUCT_FORMAT = '>QddB7x'
+    # uint64_t timestamp, double price, double size, uint8_t side, uint8_t flags, uint16_t account,
+    # uint32_t instrument, uint64_t sequence
+    # Equivalent to C++: >QddBBHIQ (big-endian, 8-byte uint, double, double, 1-byte uint, 1-byte uint,
+    # 2-byte uint, 4-byte uint, 8-byte uint)
+    STRUCT_FORMAT = '>QddBBHIQ'
     SIZE = struct.calcsize(STRUCT_FORMAT)
 
-    def __init__(self, timestamp, price, size, side):
+    def __init__(self, timestamp, price, size, side, instrument=0, sequence=0, flags=0, account=0):
         self.timestamp = timestamp
         self.price = price
         self.size = size
         self.side = side
+        self.flags = flags
+        self.account = account
+        self.instrument = instrument
+        self.sequence = sequence
 
     def pack(self):
-        """Pack the data into binary form."""
-        return struct.pack(self.STRUCT_FORMAT, self.timestamp, self.price, self.size, self.side)
+        """Pack the data into binary form, numbering it with the next sequence of its instrument."""
+        if self.sequence == 0:
+            self.sequence = instrument_sequences.get(self.instrument, next_sequence) + 1
+            instrument_sequences[self.instrument] = self.sequence
+        return struct.pack(self.STRUCT_FORMAT, self.timestamp, self.price, self.size, self.side, self.flags,
+                           self.account, self.instrument, self.sequence)
 
     @classmethod
-    def generate_batch(cls, count):
+    def generate_batch(cls, count, instruments=1):
         """Generate a batch of MarketUpdates using NumPy for vectorized random generation"""
         timestamps = np.full(count, time.perf_counter_ns()) + np.arange(count)
         prices = np.random.uniform(100.0, 200.0, size=count)
         sizes = np.random.randint(1, 100, size=count)
         sides = np.random.randint(0, 2, size=count, dtype=np.uint8)
+        ids = np.random.randint(0, instruments, size=count, dtype=np.uint32)
+        owners = np.random.randint(0, accounts, size=count, dtype=np.uint16)
 
-        return [cls(t, p, s, side) for t, p, s, side in zip(timestamps, prices, sizes, sides)]
+        return [cls(t, p, s, side, i, account=a) for t, p, s, side, i, a in
+                zip(timestamps, prices, sizes, sides, ids, owners)]
 
     @classmethod
     def unpack(cls, data):
         """Unpack bytes into a MarketUpdate instance."""
-        vals = struct.unpack(cls.STRUCT_FORMAT, data)
-        return cls(*vals[:4])   # Only use the first 4 unpacked values
+        timestamp, price, size, side, flags, account, instrument, sequence = struct.unpack(cls.STRUCT_FORMAT, data)
+        return cls(timestamp, price, size, side, instrument, sequence, flags, account)
 
     def __repr__(self):
-        return f"MarketUpdate(timestamp={self.timestamp}, price={self.price}, size={self.size}, side={'BID' if self.side else 'ASK'})"
-
-def make_marketupdate_packet(count):
-    """Pack a MarketUpdateHeader and `count` MarketUpdates, return bytes."""
-    header = MarketUpdateHeader(count)
-    updates = MarketUpdate.generate_batch(count)
-    return header.pack() + b''.join([u.pack() for u in updates]), updates
-
-def send_udp_packets(host, port, send_count, packets_per_second):
+        side = 'BID' if self.side else 'ASK'
+        return (f"MarketUpdate(timestamp={self.timestamp}, price={self.price}, size={self.size}, side={side}, "
+                f"account={self.account}, instrument={self.instrument}, sequence={self.sequence})")
+
+def send_packet(sock, destinations, updates):
+    """Number a packet of `updates` with the next sequence and send a copy of it to every destination."""
+    global next_sequence
+    packet = MarketUpdateHeader(len(updates), next_sequence).pack() + b''.join([u.pack() for u in updates])
+    next_sequence += 1
+    for destination in destinations:
+        sock.sendto(packet, destination)
+
+def send_udp_packets(destinations, send_count, packets_per_second, instruments):
     global total_packets_sent
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
 
     packets_sent = 0
-    batch_updates = MarketUpdate.generate_batch(send_count)
+    batch_updates = MarketUpdate.generate_batch(send_count, instruments)
     per_packet_send_interval = 1.0 / packets_per_second
 
     start_time = time.perf_counter()
     while packets_sent < send_count and running:
         per_packet_start_time = time.perf_counter()
-        sock.sendto(MarketUpdateHeader().pack() + batch_updates[packets_sent].pack(), (host, port))
+        send_packet(sock, destinations, [batch_updates[packets_sent]])
 
         if send_count <= 20:
             print(batch_updates[packets_sent])
@@ -100,7 +123,7 @@ def send_udp_packets(host, port, send_count, packets_per_second):
             print(f"Sent {packets_sent} packets in {time.perf_counter() - start_time}")
 
 
-def send_udp_packets_per_sec(host, port, send_count, packets_per_second):
+def send_udp_packets_per_sec(destinations, send_count, packets_per_second, instruments):
     global total_packets_sent
 
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
@@ -111,9 +134,9 @@ def send_udp_packets_per_sec(host, port, send_count, packets_per_second):
         batch_start_time = time.perf_counter()
         packets_to_send = min(packets_per_second, send_count - packets_sent)
 
-        batch_updates = MarketUpdate.generate_batch(packets_to_send)
+        batch_updates = MarketUpdate.generate_batch(packets_to_send, instruments)
         for update in batch_updates:
-            sock.sendto(MarketUpdateHeader().pack() + update.pack(), (host, port))
+            send_packet(sock, destinations, [update])
             total_packets_sent += 1
             if send_count <= 20:
                 print(update)
@@ -127,7 +150,7 @@ def send_udp_packets_per_sec(host, port, send_count, packets_per_second):
         if packets_sent % 100_000 == 0 or packets_sent == send_count:
             print(f"Sent {packets_sent} packets in {time.perf_counter() - start_time}")
 
-def send_udp_packets_random_number_of_market_updates(host, port, send_count, packets_per_second):
+def send_udp_packets_random_number_of_market_updates(destinations, send_count, packets_per_second, instruments):
     global total_packets_sent
 
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
@@ -140,8 +163,8 @@ def send_udp_packets_random_number_of_market_updates(host, port, send_count, pac
 
         per_packet_start_time = time.perf_counter()
         count = random.randint(1, 20)
-        packet, updates = make_marketupdate_packet(count)
-        sock.sendto(packet, (host, port))
+        updates = MarketUpdate.generate_batch(count, instruments)
+        send_packet(sock, destinations, updates)
 
         if send_count <= 20:
             print(f"Current packet has {count} MarketUpdates packed:")
@@ -161,6 +184,10 @@ def parse_args():
     parser = argparse.ArgumentParser(description="Send MarketUpdate UDP packets.")
     parser.add_argument('--host', type=str, default='127.0.0.1', help='Receiver IP address')
     parser.add_argument('--port', type=int, default=49152, help='Receiver UDP port')
+    parser.add_argument('--port-b', type=int, default=None, help='If set, every packet is sent to this port as '
+                        'well, emulating the B line of an A/B feed')
+    parser.add_argument('--sequence', type=int, default=0, help='Sequence number of the first packet, which '
+                        'every instrument numbers its updates from as well, so each run starts the feed over')
     parser.add_argument('--count', type=int, default=5_000_000, help='Number of packets to send')
     parser.add_argument('--pps', type=int, default=1_000_000, help='Number of packets to send per second')
     parser.add_argument('--batch', type=bool, default=False, help='If turned on, number of packets specified by pps '
@@ -168,16 +195,27 @@ def parse_args():
                         'sending rate(1.0s / pps)')
     parser.add_argument('--rnum-updates', type=bool, default=False, help='If turned on, random number of MarketUpdates'
                         '(1 - 20) will be packed into a single packet')
+    parser.add_argument('--instruments', type=int, default=1, help='Number of instruments, each MarketUpdate is '
+                        'tagged with a random instrument id between 0 and INSTRUMENTS - 1')
+    parser.add_argument('--accounts', type=int, default=1, help='Number of accounts, each MarketUpdate is tagged '
+                        'with a random account id between 0 and ACCOUNTS - 1, 0 meaning market data, for the '
+                        'engine to check the others with --risk')
     args = parser.parse_args()
     return args
 
 if __name__ == '__main__':
     args = parse_args()
-    print(f'Start sending packets to {args.host} on port {args.port}')
+    accounts = args.accounts
+    next_sequence = args.sequence
+    destinations = [(args.host, args.port)]
+    if args.port_b is not None:
+        destinations.append((args.host, args.port_b))
+    print(f'Start sending packets to {args.host} on port(s) {", ".join(str(port) for _, port in destinations)}')
     if args.batch:
-        send_udp_packets_per_sec(args.host, args.port, args.count, args.pps)
+        send_udp_packets_per_sec(destinations, args.count, args.pps, args.instruments)
     else:
         if args.rnum_updates:
-            send_udp_packets_random_number_of_market_updates(args.host, args.port, args.count, args.pps)
+            send_udp_packets_random_number_of_market_updates(destinations, args.count, args.pps,
+                                                             args.instruments)
         else:
-            send_udp_packets(args.host, args.port, args.count, args.pps)
+            send_udp_packets(destinations, args.count, args.pps, args.instruments)
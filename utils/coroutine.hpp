@@ -0,0 +1,137 @@
+#ifndef CRYPTO_TRADING_INFRA_COROUTINE
+#define CRYPTO_TRADING_INFRA_COROUTINE
+
+#if __cplusplus < 202002L
+#error "C++20 standard support required, configure with -DCOOPERATIVE_PIPELINE=ON."
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * A stage of a cooperative pipeline: a coroutine that does not start until a CooperativeScheduler resumes it,
+ * gives the thread back with co_await Yield() and returns when it has nothing left to do. It owns its frame,
+ * which lives until the Coroutine is destroyed.
+ */
+class Coroutine
+{
+public:
+    struct promise_type {
+        Coroutine get_return_object()
+        {
+            return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        // kept suspended at the end, so done() can be asked until the Coroutine is destroyed
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        // stages run on the thread of the whole pipeline, nothing could carry on without one of them
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Coroutine(std::coroutine_handle<promise_type> handle) : handle(handle)
+    {
+    }
+
+public:
+    Coroutine(Coroutine&& other) noexcept : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    Coroutine& operator=(Coroutine&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    ~Coroutine()
+    {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool done() const
+    {
+        return !handle || handle.done();
+    }
+
+    // runs the coroutine until its next co_await Yield() or its end
+    void resume()
+    {
+        handle.resume();
+    }
+};
+
+// what a stage awaits to let the next one run
+inline std::suspend_always Yield()
+{
+    return {};
+}
+
+/*
+ * Runs stages round robin on the calling thread, each until it yields, so a stage handing work to the next
+ * one through a LocalRingBuffer has it picked up right after it yields without any other thread involved.
+ */
+class CooperativeScheduler
+{
+    std::vector<Coroutine> stages;
+
+public:
+    void spawn(Coroutine stage)
+    {
+        stages.push_back(std::move(stage));
+    }
+
+    // returns once every stage has returned
+    void run()
+    {
+        size_t running = stages.size();
+        while (running > 0) {
+            running = 0;
+            for (auto& stage : stages) {
+                if (!stage.done()) {
+                    stage.resume();
+                    running += !stage.done();
+                }
+            }
+        }
+        stages.clear();
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef CRYPTO_TRADING_INFRA_CRC32C
+#define CRYPTO_TRADING_INFRA_CRC32C
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define CRYPTO_TRADING_INFRA_CRC32C_SSE42
+#endif
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * CRC-32C (Castagnoli), the checksum SSE4.2 computes in hardware 8 bytes per instruction. Machines without it
+ * go through a table a byte at a time instead, which gives the same checksums.
+ *
+ * Checksums chain: Crc32c(b, Crc32c(a)) is the checksum of a followed by b, so a checksum can be extended
+ * from any point it was kept at.
+ */
+namespace Detail {
+
+constexpr std::array<uint32_t, 256> MakeCrc32cTable()
+{
+    std::array<uint32_t, 256> table {};
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        auto crc = byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+        }
+        table[byte] = crc;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint32_t, 256> CRC32C_TABLE = MakeCrc32cTable();
+
+inline uint32_t Crc32cSoftware(uint32_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; ++i) {
+        crc = (crc >> 8) ^ CRC32C_TABLE[(crc ^ data[i]) & 0xff];
+    }
+    return crc;
+}
+
+#ifdef CRYPTO_TRADING_INFRA_CRC32C_SSE42
+__attribute__((target("sse4.2"))) inline uint32_t Crc32cSse42(uint32_t crc, const uint8_t *data, size_t length)
+{
+    uint64_t wide = crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<uint32_t>(wide);
+    for (; length > 0; ++data, --length) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+} // namespace Detail
+
+inline uint32_t Crc32c(const void *data, size_t length, uint32_t crc = 0)
+{
+    auto bytes = static_cast<const uint8_t *>(data);
+#ifdef CRYPTO_TRADING_INFRA_CRC32C_SSE42
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) {
+        return ~Detail::Crc32cSse42(~crc, bytes, length);
+    }
+#endif
+    return ~Detail::Crc32cSoftware(~crc, bytes, length);
+}
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
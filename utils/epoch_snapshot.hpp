@@ -0,0 +1,251 @@
+#ifndef CRYPTO_TRADING_INFRA_EPOCH_SNAPSHOT
+#define CRYPTO_TRADING_INFRA_EPOCH_SNAPSHOT
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#include "math.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+constexpr size_t DEFAULT_EPOCH_SLOTS = 128;
+
+/*
+ * Epoch based reclamation domain. A thread announces the global epoch in one of the slots before it
+ * dereferences any pointer published under this domain, and clears the slot once it is done. A pointer
+ * unlinked while the global epoch was E can be reused as soon as every announced epoch is greater than E.
+ * The global epoch only advances during reclamation, so readers mostly hit a clean cache line for it.
+ */
+class EpochDomain
+{
+    static constexpr uint64_t IDLE = 0;
+
+    struct Slot {
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> epoch { IDLE };
+    };
+
+    CACHE_LINE_ALIGNED std::atomic<uint64_t> globalEpoch { 1 };
+    Slot slots[DEFAULT_EPOCH_SLOTS];
+
+    std::atomic<uint64_t>& enter()
+    {
+        // every thread starts probing from its own slot, so the announcement is an uncontended CAS in practice
+        static thread_local size_t hint = std::hash<std::thread::id> {}(std::this_thread::get_id());
+
+        auto epoch = globalEpoch.load(std::memory_order_seq_cst);
+        for (auto i = hint;; ++i) {
+            auto& slot = slots[i % DEFAULT_EPOCH_SLOTS].epoch;
+            uint64_t expected = IDLE;
+            if (slot.load(std::memory_order_relaxed) == IDLE && slot.compare_exchange_strong(expected, epoch)) {
+                hint = i;
+                return slot;
+            }
+        }
+    }
+
+public:
+    EpochDomain() = default;
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    static EpochDomain& Global()
+    {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    class Guard
+    {
+        std::atomic<uint64_t>& slot;
+
+    public:
+        explicit Guard(EpochDomain& domain) : slot(domain.enter()) {}
+        ~Guard()
+        {
+            slot.store(IDLE, std::memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // must be called after the pointer to retire has been unlinked
+    uint64_t retireEpoch() const
+    {
+        return globalEpoch.load(std::memory_order_seq_cst);
+    }
+
+    // returns the epoch below which retired pointers are no longer reachable by any reader, advancing the
+    // global epoch when every active reader has caught up with it. Pointers retired while the slots are
+    // being scanned carry an epoch no less than the one loaded up front, so they are never judged by it.
+    uint64_t safeEpoch()
+    {
+        auto epoch = globalEpoch.load(std::memory_order_seq_cst);
+
+        auto oldest = std::numeric_limits<uint64_t>::max();
+        for (auto& slot : slots) {
+            auto announced = slot.epoch.load(std::memory_order_seq_cst);
+            if (announced != IDLE && announced < oldest) {
+                oldest = announced;
+            }
+        }
+
+        if (oldest >= epoch) {
+            globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+            return epoch;
+        }
+        return oldest;
+    }
+};
+
+constexpr size_t DEFAULT_SNAPSHOT_CAPACITY = 64;
+
+/*
+ * Copy-on-write publication of T through a raw atomic pointer. Every version lives in a fixed pool of
+ * nodes allocated up front: a writer copies the current version into a free node, mutates it and
+ * publishes it with a CAS, and the replaced version is retired and later recycled through the free list
+ * once no reader can observe it. Readers only pay for the epoch announcement.
+ */
+template <typename T, size_t Capacity = DEFAULT_SNAPSHOT_CAPACITY>
+class EpochSnapshot
+{
+    struct Node {
+        T value;
+        uint64_t retiredAt;
+    };
+
+    static constexpr auto CAP = Math::NextPowerOf2<Capacity>();
+    static_assert(CAP >= 2, "EpochSnapshot needs room for at least one version besides the published one");
+
+    using NodeRing = ConcurrentRingBuffer<Node *, CAP>;
+
+    EpochDomain& domain;
+    std::unique_ptr<Node[]> nodes;
+    NodeRing freeNodes;
+    NodeRing retiredNodes;
+    CACHE_LINE_ALIGNED std::atomic<Node *> current;
+
+    // both rings can hold every node, so a failed push only means a concurrent pop has not released its slot yet
+    static void Put(NodeRing& ring, Node *node)
+    {
+        while (!ring.push(node)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void reclaim()
+    {
+        auto safe = domain.safeEpoch();
+        Node *node;
+        while (retiredNodes.pop(node)) {
+            if (node->retiredAt >= safe) {
+                Put(retiredNodes, node);
+                break;
+            }
+            Put(freeNodes, node);
+        }
+    }
+
+    Node *acquire()
+    {
+        Node *node;
+        while (!freeNodes.pop(node)) {
+            reclaim();
+            if (freeNodes.pop(node)) {
+                break;
+            }
+            // some reader is still holding an old epoch
+            std::this_thread::yield();
+        }
+        return node;
+    }
+
+    void retire(Node *node)
+    {
+        node->retiredAt = domain.retireEpoch();
+        Put(retiredNodes, node);
+    }
+
+public:
+    class Reader
+    {
+        EpochDomain::Guard guard;
+        const T *value;
+
+    public:
+        Reader(EpochDomain& domain, const std::atomic<Node *>& current)
+            : guard(domain), value(&current.load(std::memory_order_seq_cst)->value)
+        {
+        }
+
+        const T& operator*() const
+        {
+            return *value;
+        }
+
+        const T *operator->() const
+        {
+            return value;
+        }
+    };
+
+    explicit EpochSnapshot(EpochDomain& domain = EpochDomain::Global())
+        : domain(domain), nodes(new Node[CAP]), current(&nodes[0])
+    {
+        for (size_t i = 1; i < CAP; ++i) {
+            Put(freeNodes, &nodes[i]);
+        }
+    }
+
+    EpochSnapshot(const EpochSnapshot&) = delete;
+    EpochSnapshot& operator=(const EpochSnapshot&) = delete;
+
+    EpochSnapshot(EpochSnapshot&&) = delete;
+    EpochSnapshot& operator=(EpochSnapshot&&) = delete;
+
+    // the returned reader pins the version it observed until it goes out of scope
+    Reader read() const
+    {
+        return Reader(domain, current);
+    }
+
+    // mutate is invoked on a private copy of the latest version and may run more than once under contention
+    template <typename F>
+    void update(F&& mutate)
+    {
+        auto next = acquire();
+        while (true) {
+            {
+                EpochDomain::Guard guard(domain);
+                auto prev = current.load(std::memory_order_seq_cst);
+                next->value = prev->value;
+                mutate(next->value);
+
+                if (current.compare_exchange_weak(prev, next, std::memory_order_seq_cst)) {
+                    retire(prev);
+                    return;
+                }
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    void store(const T& value)
+    {
+        update([&](T& next) { next = value; });
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef CRYPTO_TRADING_INFRA_EVENT_LOG
+#define CRYPTO_TRADING_INFRA_EVENT_LOG
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+// arguments a single record carries at most
+constexpr size_t MAX_LOG_ARGS = 6;
+// records a thread can have waiting for the writer before further ones are dropped
+constexpr size_t LOG_CHANNEL_SIZE = 4096;
+// records the writer takes from a thread at once
+constexpr size_t LOG_BATCH_SIZE = 512;
+constexpr auto DEFAULT_LOG_INTERVAL = std::chrono::milliseconds(10);
+// logs a thread finds its channel of without locking, it locks once to find the channel of any further one
+constexpr size_t LOG_CACHED_CHANNELS = 4;
+
+// what a thread logging an event writes, the text is only made out of it by the writer thread
+struct LogRecord {
+    uint64_t timestamp; // nanoseconds since the epoch
+    uint32_t format;
+    // 2 bits per argument telling how to print its raw bits
+    uint32_t kinds;
+    uint64_t args[MAX_LOG_ARGS];
+};
+
+/*
+ * Event log whose writing costs a hot thread a clock read and a push of a 64 bytes record into a ring of its
+ * own. Formats are registered up front, and records only hold the id of their format along with the raw bits
+ * of numeric arguments, so no string is built and no lock or system call is ever hit on the way. A background
+ * thread drains the rings every interval, formats the records and appends them to the file with a single
+ * writev per round. A thread whose ring is full drops the record and counts it instead of waiting.
+ *
+ * Formats are plain text with "{}" where arguments go. Lines are ordered per thread, each one starting with
+ * its timestamp and the index of the thread that wrote it.
+ */
+class EventLog
+{
+    enum Kind : uint32_t {
+        UNSIGNED,
+        SIGNED,
+        FLOATING,
+        // the value of an enumerator, sign extended from its underlying type
+        ENUM,
+    };
+
+    struct Channel {
+        ConcurrentRingBuffer<LogRecord, LOG_CHANNEL_SIZE> ring;
+        // only written by the thread owning the channel
+        std::atomic<uint64_t> dropped { 0 };
+        std::atomic<uint64_t> written { 0 };
+        // only touched by the writer thread
+        std::string text;
+    };
+
+    int fd;
+    uint64_t serial;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    std::vector<std::string> formats;
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::unordered_map<std::thread::id, Channel *> owners;
+    // copies of the formats the writer thread reads without locking
+    std::vector<std::string> known;
+    std::chrono::nanoseconds interval;
+    std::thread writer;
+
+    EventLog(int fd, std::chrono::nanoseconds interval) : fd(fd), serial(NextSerial()), interval(interval)
+    {
+    }
+
+    static uint64_t NextSerial()
+    {
+        static std::atomic<uint64_t> serials { 0 };
+        return ++serials;
+    }
+
+    template <typename T>
+    static constexpr uint32_t KindOf()
+    {
+        if constexpr (std::is_floating_point_v<T>) {
+            return FLOATING;
+        } else if constexpr (std::is_enum_v<T>) {
+            return ENUM;
+        } else if constexpr (std::is_signed_v<T>) {
+            return SIGNED;
+        } else {
+            return UNSIGNED;
+        }
+    }
+
+    template <typename T>
+    static uint64_t Raw(T value)
+    {
+        if constexpr (std::is_floating_point_v<T>) {
+            double converted = value;
+            uint64_t raw;
+            std::memcpy(&raw, &converted, sizeof(raw));
+            return raw;
+        } else if constexpr (std::is_enum_v<T>) {
+            return Raw(static_cast<std::underlying_type_t<T>>(value));
+        } else {
+            using Wide = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+            return static_cast<uint64_t>(static_cast<Wide>(value));
+        }
+    }
+
+    // the channel of the calling thread, created the first time it logs; the thread remembers those of the last
+    // few logs it wrote to, and the log those of every thread, so switching logs never makes a new one
+    Channel& channel()
+    {
+        struct Cached {
+            uint64_t serial;
+            Channel *channel;
+        };
+        thread_local Cached cached[LOG_CACHED_CHANNELS] {};
+        thread_local size_t next = 0;
+        for (const auto& entry : cached) {
+            if (entry.serial == serial) {
+                return *entry.channel;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& own = owners[std::this_thread::get_id()];
+        if (own == nullptr) {
+            channels.push_back(std::make_unique<Channel>());
+            own = channels.back().get();
+        }
+        cached[next] = { serial, own };
+        next = (next + 1) % LOG_CACHED_CHANNELS;
+        return *own;
+    }
+
+    static void Append(std::string& text, const LogRecord& record, const std::string& format, size_t thread)
+    {
+        char number[32];
+        auto length = snprintf(number, sizeof(number), "%" PRIu64 ".%09" PRIu64 " [%zu] ",
+                               record.timestamp / 1000000000, record.timestamp % 1000000000, thread);
+        text.append(number, length);
+
+        size_t arg = 0;
+        size_t from = 0;
+        for (auto at = format.find("{}"); at != std::string::npos; at = format.find("{}", from)) {
+            text.append(format, from, at - from);
+            from = at + 2;
+            if (arg == MAX_LOG_ARGS) {
+                continue;
+            }
+
+            auto raw = record.args[arg];
+            switch ((record.kinds >> (2 * arg)) & 3) {
+            case FLOATING: {
+                double value;
+                std::memcpy(&value, &raw, sizeof(value));
+                length = snprintf(number, sizeof(number), "%.10g", value);
+                break;
+            }
+            case SIGNED:
+            case ENUM:
+                length = snprintf(number, sizeof(number), "%" PRId64, static_cast<int64_t>(raw));
+                break;
+            default:
+                length = snprintf(number, sizeof(number), "%" PRIu64, raw);
+                break;
+            }
+            text.append(number, length);
+            ++arg;
+        }
+        text.append(format, from, std::string::npos);
+        text.push_back('\n');
+    }
+
+    const std::string& formatOf(uint32_t id)
+    {
+        static const std::string unknown = "unknown format {}";
+        if (id >= known.size()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            known.insert(known.end(), formats.begin() + known.size(), formats.end());
+        }
+        return id < known.size() ? known[id] : unknown;
+    }
+
+    // formats what every channel holds and appends it to the file, returns false once nothing was left
+    bool drain()
+    {
+        // threads logging for the first time only wait for this copy, never for the formatting or the write
+        std::vector<Channel *> current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& channel : channels) {
+                current.push_back(channel.get());
+            }
+        }
+
+        std::vector<iovec> chunks;
+        bool drained = true;
+        for (size_t thread = 0; thread < current.size(); ++thread) {
+            auto& channel = *current[thread];
+            channel.text.clear();
+            LogRecord record;
+            size_t taken = 0;
+            while (taken < LOG_BATCH_SIZE && channel.ring.pop(record)) {
+                Append(channel.text, record, formatOf(record.format), thread);
+                ++taken;
+            }
+            drained = drained && taken < LOG_BATCH_SIZE;
+            if (!channel.text.empty()) {
+                chunks.push_back({ channel.text.data(), channel.text.size() });
+            }
+        }
+
+        for (size_t done = 0; done < chunks.size();) {
+            auto count = std::min(chunks.size() - done, static_cast<size_t>(IOV_MAX));
+            auto written = writev(fd, chunks.data() + done, count);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written < 0) {
+                // the records are lost, later rounds still try to write theirs
+                perror("writev");
+                break;
+            }
+
+            // a partial write leaves the rest of the chunk it stopped in for the next call
+            for (auto left = static_cast<size_t>(written); left > 0 && done < chunks.size();) {
+                auto part = std::min(left, chunks[done].iov_len);
+                chunks[done].iov_base = static_cast<char *>(chunks[done].iov_base) + part;
+                chunks[done].iov_len -= part;
+                left -= part;
+                if (chunks[done].iov_len == 0) {
+                    ++done;
+                }
+            }
+        }
+        return !drained;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wakeup.wait_for(lock, interval, [this]() { return stopping; });
+            lock.unlock();
+            while (drain()) {
+            }
+            lock.lock();
+        }
+    }
+
+public:
+    // appends to the file at path, returns nullptr if it cannot be opened
+    static std::unique_ptr<EventLog> Create(const std::string& path,
+                                            std::chrono::nanoseconds interval = DEFAULT_LOG_INTERVAL)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror("open");
+            return nullptr;
+        }
+
+        auto log = std::unique_ptr<EventLog>(new EventLog(fd, interval));
+        log->writer = std::thread(&EventLog::run, log.get());
+        return log;
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    // writes whatever was logged before returning, threads must not log anymore
+    ~EventLog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        writer.join();
+        while (drain()) {
+        }
+        close(fd);
+    }
+
+    // registers format and returns the id to log it with, meant to be called before the hot threads start
+    uint32_t format(const std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        formats.push_back(text);
+        return static_cast<uint32_t>(formats.size() - 1);
+    }
+
+    // numeric arguments only, returns false if the record was dropped
+    template <typename... Args>
+    bool write(uint32_t format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_LOG_ARGS, "Too many arguments for a log record.");
+        static_assert(((std::is_arithmetic_v<Args> || std::is_enum_v<Args>) && ...), "Only numbers can be logged.");
+
+        LogRecord record;
+        record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+        record.format = format;
+        record.kinds = 0;
+        size_t arg = 0;
+        ((record.kinds |= KindOf<Args>() << (2 * arg), record.args[arg++] = Raw(args)), ...);
+
+        auto& own = channel();
+        if (!own.ring.push(record)) {
+            own.dropped.store(own.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        own.written.store(own.written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // threads that logged so far
+    size_t threads()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return channels.size();
+    }
+
+    // records handed to the writer so far, by every thread
+    uint64_t written()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const auto& channel : channels) {
+            total += channel->written.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // records dropped so far because the ring of their thread was full
+    uint64_t dropped()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const auto& channel : channels) {
+            total += channel->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
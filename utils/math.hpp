@@ -23,6 +23,17 @@ constexpr uint64_t NextPowerOf2()
     return n + 1;
 }
 
+// N must be a power of 2
+template <uint64_t N>
+constexpr uint64_t Log2()
+{
+    uint64_t bits = 0;
+    while ((uint64_t { 1 } << bits) < N) {
+        ++bits;
+    }
+    return bits;
+}
+
 } // namespace Math
 } // namespace Utils
 } // namespace CryptoTradingInfra
@@ -2,9 +2,14 @@
 #define CRYPTO_TRADING_INFRA_UTILS_NETWORK
 
 #include <cstdint>
+#include <cstdlib>
+#include <string>
 #include <type_traits>
 #include <cstring>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace CryptoTradingInfra {
 namespace Utils {
@@ -52,6 +57,45 @@ T Ntoh64(T value)
 #endif
 }
 
+// parses "IPv4:PORT", returns false if text is not of that form
+inline bool ParseAddress(const std::string& text, sockaddr_in& addr)
+{
+    auto colon = text.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+
+    char *end = nullptr;
+    auto port = std::strtoul(text.c_str() + colon + 1, &end, 10);
+    if (colon + 1 == text.size() || *end != '\0' || port == 0 || port > UINT16_MAX) {
+        return false;
+    }
+
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    return inet_pton(AF_INET, text.substr(0, colon).c_str(), &addr.sin_addr) == 1;
+}
+
+// parses either "IPv4:PORT" or the path of a unix domain socket, which must start with '/'
+inline bool ParseEndpoint(const std::string& text, sockaddr_storage& storage, socklen_t& length)
+{
+    storage = {};
+    if (!text.empty() && text[0] == '/') {
+        auto addr = reinterpret_cast<sockaddr_un *>(&storage);
+        if (text.size() >= sizeof(addr->sun_path)) {
+            return false;
+        }
+        addr->sun_family = AF_UNIX;
+        std::memcpy(addr->sun_path, text.c_str(), text.size() + 1);
+        length = sizeof(sockaddr_un);
+        return true;
+    }
+
+    length = sizeof(sockaddr_in);
+    return ParseAddress(text, *reinterpret_cast<sockaddr_in *>(&storage));
+}
+
 } // namespace Network
 } // namespace Utils
 } // namespace CryptoTradingInfra
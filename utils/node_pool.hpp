@@ -0,0 +1,96 @@
+#ifndef CRYPTO_TRADING_INFRA_NODE_POOL
+#define CRYPTO_TRADING_INFRA_NODE_POOL
+
+#include <cstddef>
+#include <new>
+
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+constexpr size_t DEFAULT_POOL_CAPACITY = 65536;
+
+/*
+ * Fixed-size block pool for node based containers. Each thread keeps a small cache of blocks and only
+ * exchanges batches with the shared lock-free ring when its cache runs dry or overflows, so the steady
+ * state of allocate/deallocate never reaches the allocator nor a shared cache line. Blocks beyond the
+ * shared capacity are handed back to the allocator.
+ */
+template <typename Node, size_t Capacity = DEFAULT_POOL_CAPACITY>
+class NodePool
+{
+    static constexpr size_t LOCAL_CAPACITY = 64;
+    static constexpr size_t BATCH = LOCAL_CAPACITY / 2;
+
+    ConcurrentRingBuffer<void *, Capacity> shared;
+
+    struct LocalCache {
+        void *blocks[LOCAL_CAPACITY];
+        size_t count = 0;
+
+        ~LocalCache()
+        {
+            // give the blocks back so that other threads can still use them after this one exits
+            while (count > 0) {
+                Instance().release(blocks[--count]);
+            }
+        }
+    };
+
+    static LocalCache& Local()
+    {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    void release(void *block)
+    {
+        if (!shared.push(block)) {
+            ::operator delete(block);
+        }
+    }
+
+    NodePool() = default;
+
+public:
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    // never destroyed on purpose: containers living in static storage may still return blocks during exit
+    static NodePool& Instance()
+    {
+        static auto pool = new NodePool;
+        return *pool;
+    }
+
+    void *allocate()
+    {
+        auto& cache = Local();
+        if (cache.count == 0) {
+            while (cache.count < BATCH && shared.pop(cache.blocks[cache.count])) {
+                ++cache.count;
+            }
+            if (cache.count == 0) {
+                return ::operator new(sizeof(Node));
+            }
+        }
+        return cache.blocks[--cache.count];
+    }
+
+    void deallocate(void *block)
+    {
+        auto& cache = Local();
+        if (cache.count == LOCAL_CAPACITY) {
+            while (cache.count > LOCAL_CAPACITY - BATCH) {
+                release(cache.blocks[--cache.count]);
+            }
+        }
+        cache.blocks[cache.count++] = block;
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef CRYPTO_TRADING_INFRA_PERF_COUNTERS
+#define CRYPTO_TRADING_INFRA_PERF_COUNTERS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+enum PerfEvent : uint8_t {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    // nanoseconds the thread ran, which unlike the hardware events is there in virtual machines too
+    PERF_TASK_CLOCK,
+    PERF_EVENTS,
+};
+
+constexpr const char *PERF_EVENT_NAMES[PERF_EVENTS] = { "cycles", "instructions", "LLC misses", "branch misses",
+                                                       "context switches", "task clock ns" };
+
+enum PerfStage : uint8_t {
+    PERF_RECEIVE,
+    PERF_ENQUEUE,
+    PERF_RISK_CHECK,
+    PERF_BOOK_APPLY,
+    PERF_MATCH,
+    PERF_STAGES,
+};
+
+constexpr const char *PERF_STAGE_NAMES[PERF_STAGES] = { "receive", "enqueue", "risk check", "book apply", "match" };
+
+/*
+ * Hardware counters of the calling thread, opened with perf_event_open as one group so they are read together
+ * with a single system call. Hardware events only count user space, which is what a stage costs the thread,
+ * while context switches happen in the kernel and are counted there. Any event the kernel or the machine does
+ * not provide, like hardware events in most virtual machines, is left out and reads as 0, and reading fails
+ * when no event could be opened at all.
+ */
+class PerfCounters
+{
+    int leader = -1;
+    int fds[PERF_EVENTS];
+    // position of every event in what reading the group returns
+    uint8_t slots[PERF_EVENTS];
+    uint8_t opened = 0;
+
+    static int Open(uint32_t type, uint64_t config, bool kernel, int group)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = !kernel;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+public:
+    PerfCounters()
+    {
+        struct {
+            uint32_t type;
+            uint64_t config;
+            bool kernel;
+        } events[PERF_EVENTS] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false },
+            { PERF_TYPE_HW_CACHE,
+              PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+              false },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, false },
+            { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, true },
+            { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false },
+        };
+        for (size_t i = 0; i < PERF_EVENTS; ++i) {
+            fds[i] = Open(events[i].type, events[i].config, events[i].kernel, leader);
+            if (fds[i] < 0) {
+                continue;
+            }
+            if (leader < 0) {
+                leader = fds[i];
+            }
+            slots[i] = opened++;
+        }
+    }
+
+    ~PerfCounters()
+    {
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available(PerfEvent event) const
+    {
+        return fds[event] >= 0;
+    }
+
+    bool any() const
+    {
+        return leader >= 0;
+    }
+
+    // running totals of every event since the counters were opened
+    bool read(uint64_t (&values)[PERF_EVENTS]) const
+    {
+        uint64_t group[1 + PERF_EVENTS];
+        auto expected = static_cast<ssize_t>((1 + opened) * sizeof(uint64_t));
+        if (leader < 0 || ::read(leader, group, sizeof(group)) != expected) {
+            return false;
+        }
+        for (size_t i = 0; i < PERF_EVENTS; ++i) {
+            values[i] = fds[i] >= 0 ? group[1 + slots[i]] : 0;
+        }
+        return true;
+    }
+};
+
+struct PerfReading {
+    uint64_t regions;
+    uint64_t values[PERF_EVENTS];
+};
+
+/*
+ * Collects what the regions of every stage cost the threads running them. Nothing is measured until enable()
+ * is called, a region costing a relaxed load until then. Regions then open counters for their thread the
+ * first time one of them runs, and each region costs two reads of the counters. Stages nest, a region only
+ * being charged what its nested regions did not take, so the stages add up to what the threads spent in them.
+ */
+class PerfMonitor
+{
+    struct Thread {
+        PerfCounters counters;
+        // only written by the thread owning them
+        std::atomic<uint64_t> regions[PERF_STAGES] {};
+        std::atomic<uint64_t> values[PERF_STAGES][PERF_EVENTS] {};
+    };
+
+    std::atomic<bool> active { false };
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Thread>> threads;
+
+    PerfMonitor() = default;
+
+    friend class PerfRegion;
+
+    // counters of the calling thread, nullptr if none of them could be opened; they are kept until exit, so
+    // what threads gone already measured is still reported
+    Thread *thread()
+    {
+        thread_local Thread *current = nullptr;
+        thread_local bool tried = false;
+        if (!tried) {
+            tried = true;
+            auto opened = std::make_unique<Thread>();
+            if (opened->counters.any()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.push_back(std::move(opened));
+                current = threads.back().get();
+            }
+        }
+        return current;
+    }
+
+public:
+    PerfMonitor(const PerfMonitor&) = delete;
+    PerfMonitor& operator=(const PerfMonitor&) = delete;
+
+    static PerfMonitor& Global()
+    {
+        static PerfMonitor monitor;
+        return monitor;
+    }
+
+    void enable(bool on = true)
+    {
+        active.store(on, std::memory_order_relaxed);
+    }
+
+    bool enabled() const
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // whether some thread could count event
+    bool available(PerfEvent event) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& thread : threads) {
+            if (thread->counters.available(event)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // totals of every thread that ran regions of stage
+    PerfReading stage(PerfStage stage) const
+    {
+        PerfReading reading {};
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& thread : threads) {
+            reading.regions += thread->regions[stage].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < PERF_EVENTS; ++i) {
+                reading.values[i] += thread->values[stage][i].load(std::memory_order_relaxed);
+            }
+        }
+        return reading;
+    }
+
+    // events per region of every stage that ran, n/a for events no thread could count
+    void print(std::ostream& out) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (threads.empty()) {
+                out << "Perf counters unavailable, perf_event_open failed or no region ran" << std::endl;
+                return;
+            }
+        }
+        bool counted[PERF_EVENTS];
+        for (size_t i = 0; i < PERF_EVENTS; ++i) {
+            counted[i] = available(static_cast<PerfEvent>(i));
+        }
+        for (size_t stage = 0; stage < PERF_STAGES; ++stage) {
+            auto reading = this->stage(static_cast<PerfStage>(stage));
+            if (reading.regions == 0) {
+                continue;
+            }
+            out << "Perf " << PERF_STAGE_NAMES[stage] << ": " << reading.regions << " regions, per region";
+            for (size_t i = 0; i < PERF_EVENTS; ++i) {
+                out << (i == 0 ? " " : ", ") << PERF_EVENT_NAMES[i] << " ";
+                if (counted[i]) {
+                    auto perRegion = static_cast<double>(reading.values[i]) / reading.regions;
+                    out << std::fixed << std::setprecision(2) << perRegion << std::defaultfloat;
+                } else {
+                    out << "n/a";
+                }
+            }
+            out << "\n";
+        }
+        out << std::flush;
+    }
+};
+
+// charges what runs within its scope to stage, when the monitor is enabled
+class PerfRegion
+{
+    PerfMonitor::Thread *thread = nullptr;
+    PerfStage stage;
+    uint64_t start[PERF_EVENTS];
+    // what the regions nested in this one took
+    uint64_t nested[PERF_EVENTS] {};
+    PerfRegion *parent;
+
+    static PerfRegion *&Innermost()
+    {
+        thread_local PerfRegion *innermost = nullptr;
+        return innermost;
+    }
+
+public:
+    explicit PerfRegion(PerfStage stage) : stage(stage)
+    {
+        auto& monitor = PerfMonitor::Global();
+        if (!monitor.enabled()) {
+            return;
+        }
+        thread = monitor.thread();
+        if (thread == nullptr || !thread->counters.read(start)) {
+            thread = nullptr;
+            return;
+        }
+        parent = Innermost();
+        Innermost() = this;
+    }
+
+    ~PerfRegion()
+    {
+        if (thread == nullptr) {
+            return;
+        }
+        Innermost() = parent;
+        uint64_t end[PERF_EVENTS];
+        if (!thread->counters.read(end)) {
+            return;
+        }
+
+        thread->regions[stage].store(thread->regions[stage].load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+        for (size_t i = 0; i < PERF_EVENTS; ++i) {
+            auto taken = end[i] - start[i];
+            auto& total = thread->values[stage][i];
+            total.store(total.load(std::memory_order_relaxed) + taken - std::min(nested[i], taken),
+                        std::memory_order_relaxed);
+            if (parent != nullptr) {
+                parent->nested[i] += taken;
+            }
+        }
+    }
+
+    PerfRegion(const PerfRegion&) = delete;
+    PerfRegion& operator=(const PerfRegion&) = delete;
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,548 @@
+#ifndef CRYPTO_TRADING_INFRA_PERSISTENT_MAP
+#define CRYPTO_TRADING_INFRA_PERSISTENT_MAP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "node_pool.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+constexpr size_t DEFAULT_FANOUT = 8;
+
+/*
+ * Immutable sorted map implemented as a path-copying B+tree with pooled, reference counted nodes.
+ *
+ * Copying a map only shares its root, so every copy is O(1). A modification copies the nodes on the
+ * path from the root to the affected leaf (plus at most one sibling when rebalancing) and shares the
+ * rest with every other version, so its cost depends on the height of the tree rather than on the
+ * number of entries. Nodes that are already exclusively owned by this map are modified in place, which
+ * keeps consecutive modifications of an unpublished copy cheap.
+ *
+ * Different maps sharing nodes may be modified and destroyed concurrently, a single map may not.
+ */
+template <typename K, typename V, typename Compare = std::less<>, size_t Fanout = DEFAULT_FANOUT>
+class PersistentSortedMap
+{
+public:
+    using Item = std::pair<K, V>;
+
+private:
+    static_assert(Fanout >= 4, "Fanout is too small to keep the tree balanced");
+
+    static constexpr size_t MIN_FILL = Fanout / 2;
+    static constexpr size_t MAX_HEIGHT = 32;
+
+    // in an inner node, items[i].first is the smallest key found under children[i]
+    struct Node {
+        std::atomic<uint32_t> refs;
+        uint16_t count;
+        bool leaf;
+        Item items[Fanout];
+        Node *children[Fanout];
+    };
+
+    using Pool = NodePool<Node>;
+
+    struct Split {
+        Node *node;
+        Node *sibling;
+    };
+
+    Node *root = nullptr;
+    size_t entries = 0;
+
+    static bool Less(const K& lhs, const K& rhs)
+    {
+        return Compare {}(lhs, rhs);
+    }
+
+    static Node *Allocate(bool leaf)
+    {
+        auto node = new (Pool::Instance().allocate()) Node;
+        node->refs.store(1, std::memory_order_relaxed);
+        node->count = 0;
+        node->leaf = leaf;
+        return node;
+    }
+
+    static void Retain(Node *node)
+    {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Release(Node *node)
+    {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        if (!node->leaf) {
+            for (size_t i = 0; i < node->count; ++i) {
+                Release(node->children[i]);
+            }
+        }
+        node->~Node();
+        Pool::Instance().deallocate(node);
+    }
+
+    static Node *Clone(const Node *node)
+    {
+        auto copy = Allocate(node->leaf);
+        copy->count = node->count;
+        std::copy(node->items, node->items + node->count, copy->items);
+        if (!node->leaf) {
+            std::copy(node->children, node->children + node->count, copy->children);
+            for (size_t i = 0; i < node->count; ++i) {
+                Retain(node->children[i]);
+            }
+        }
+        return copy;
+    }
+
+    // a node reached through writable ancestors is exclusively ours when nobody else holds a reference
+    static Node *Writable(Node *node)
+    {
+        return node->refs.load(std::memory_order_acquire) == 1 ? node : Clone(node);
+    }
+
+    // replaces children[i] of a writable node, dropping the reference to the previous child
+    static void Replace(Node *parent, size_t i, Node *child)
+    {
+        if (parent->children[i] != child) {
+            Release(parent->children[i]);
+            parent->children[i] = child;
+        }
+        parent->items[i].first = child->items[0].first;
+    }
+
+    static size_t LowerBound(const Node *leaf, const K& key)
+    {
+        size_t i = 0;
+        while (i < leaf->count && Less(leaf->items[i].first, key)) {
+            ++i;
+        }
+        return i;
+    }
+
+    static size_t ChildIndex(const Node *inner, const K& key)
+    {
+        size_t i = 1;
+        while (i < inner->count && !Less(key, inner->items[i].first)) {
+            ++i;
+        }
+        return i - 1;
+    }
+
+    // inserts item at position i of a writable node, splitting it when it is already full
+    static Node *InsertAt(Node *node, size_t i, const Item& item, Node *child)
+    {
+        if (node->count < Fanout) {
+            std::copy_backward(node->items + i, node->items + node->count, node->items + node->count + 1);
+            node->items[i] = item;
+            if (!node->leaf) {
+                std::copy_backward(node->children + i, node->children + node->count,
+                                   node->children + node->count + 1);
+                node->children[i] = child;
+            }
+            ++node->count;
+            return nullptr;
+        }
+
+        Item items[Fanout + 1];
+        Node *children[Fanout + 1];
+        std::copy(node->items, node->items + i, items);
+        items[i] = item;
+        std::copy(node->items + i, node->items + Fanout, items + i + 1);
+        if (!node->leaf) {
+            std::copy(node->children, node->children + i, children);
+            children[i] = child;
+            std::copy(node->children + i, node->children + Fanout, children + i + 1);
+        }
+
+        constexpr size_t LEFT = (Fanout + 1) / 2;
+        auto sibling = Allocate(node->leaf);
+        node->count = LEFT;
+        sibling->count = Fanout + 1 - LEFT;
+        std::copy(items, items + LEFT, node->items);
+        std::copy(items + LEFT, items + Fanout + 1, sibling->items);
+        if (!node->leaf) {
+            std::copy(children, children + LEFT, node->children);
+            std::copy(children + LEFT, children + Fanout + 1, sibling->children);
+        }
+        return sibling;
+    }
+
+    static void RemoveAt(Node *node, size_t i)
+    {
+        std::copy(node->items + i + 1, node->items + node->count, node->items + i);
+        if (!node->leaf) {
+            std::copy(node->children + i + 1, node->children + node->count, node->children + i);
+        }
+        --node->count;
+    }
+
+    static Split Assign(Node *node, const K& key, const V& value, bool& inserted)
+    {
+        auto writable = Writable(node);
+
+        if (writable->leaf) {
+            auto i = LowerBound(writable, key);
+            if (i < writable->count && !Less(key, writable->items[i].first)) {
+                writable->items[i].second = value;
+                return { writable, nullptr };
+            }
+            inserted = true;
+            return { writable, InsertAt(writable, i, Item(key, value), nullptr) };
+        }
+
+        auto i = ChildIndex(writable, key);
+        auto split = Assign(writable->children[i], key, value, inserted);
+        Replace(writable, i, split.node);
+        if (split.sibling == nullptr) {
+            return { writable, nullptr };
+        }
+
+        Item separator(split.sibling->items[0].first, V {});
+        return { writable, InsertAt(writable, i + 1, separator, split.sibling) };
+    }
+
+    // moves entries between two adjacent writable children so that neither of them is under-filled,
+    // merging them when they fit in a single node
+    static void Rebalance(Node *parent, size_t i)
+    {
+        auto left = i + 1 < parent->count ? i : i - 1;
+        auto right = left + 1;
+        Replace(parent, left, Writable(parent->children[left]));
+        Replace(parent, right, Writable(parent->children[right]));
+
+        auto l = parent->children[left];
+        auto r = parent->children[right];
+
+        if (l->count + r->count <= Fanout) {
+            std::copy(r->items, r->items + r->count, l->items + l->count);
+            if (!l->leaf) {
+                std::copy(r->children, r->children + r->count, l->children + l->count);
+            }
+            l->count += r->count;
+            // the children now belong to the left node, only the shell of the right one goes away
+            r->count = 0;
+            Release(r);
+            RemoveAt(parent, right);
+            return;
+        }
+
+        size_t target = (l->count + r->count) / 2;
+        if (l->count > target) {
+            size_t moved = l->count - target;
+            std::copy_backward(r->items, r->items + r->count, r->items + r->count + moved);
+            std::copy(l->items + target, l->items + l->count, r->items);
+            if (!l->leaf) {
+                std::copy_backward(r->children, r->children + r->count, r->children + r->count + moved);
+                std::copy(l->children + target, l->children + l->count, r->children);
+            }
+            l->count -= moved;
+            r->count += moved;
+        } else {
+            size_t moved = target - l->count;
+            std::copy(r->items, r->items + moved, l->items + l->count);
+            std::copy(r->items + moved, r->items + r->count, r->items);
+            if (!l->leaf) {
+                std::copy(r->children, r->children + moved, l->children + l->count);
+                std::copy(r->children + moved, r->children + r->count, r->children);
+            }
+            l->count += moved;
+            r->count -= moved;
+        }
+        parent->items[right].first = r->items[0].first;
+    }
+
+    // the key must be present
+    static Node *Erase(Node *node, const K& key)
+    {
+        auto writable = Writable(node);
+
+        if (writable->leaf) {
+            RemoveAt(writable, LowerBound(writable, key));
+            return writable;
+        }
+
+        auto i = ChildIndex(writable, key);
+        auto child = Erase(writable->children[i], key);
+        Replace(writable, i, child);
+        if (child->count < MIN_FILL) {
+            Rebalance(writable, i);
+        }
+        return writable;
+    }
+
+    static const Node *Leftmost(const Node *node)
+    {
+        while (!node->leaf) {
+            node = node->children[0];
+        }
+        return node;
+    }
+
+    static const Node *Rightmost(const Node *node)
+    {
+        while (!node->leaf) {
+            node = node->children[node->count - 1];
+        }
+        return node;
+    }
+
+public:
+    class const_iterator
+    {
+        const Node *path[MAX_HEIGHT];
+        uint16_t index[MAX_HEIGHT];
+        int depth = -1;
+
+        void descend(const Node *node)
+        {
+            while (true) {
+                ++depth;
+                path[depth] = node;
+                index[depth] = 0;
+                if (node->leaf) {
+                    return;
+                }
+                node = node->children[0];
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Item *;
+        using reference = const Item&;
+
+        const_iterator() = default;
+
+        explicit const_iterator(const Node *root)
+        {
+            if (root != nullptr && root->count > 0) {
+                descend(root);
+            }
+        }
+
+        reference operator*() const
+        {
+            return path[depth]->items[index[depth]];
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        const_iterator& operator++()
+        {
+            if (++index[depth] < path[depth]->count) {
+                return *this;
+            }
+
+            while (--depth >= 0) {
+                if (++index[depth] < path[depth]->count) {
+                    descend(path[depth]->children[index[depth]]);
+                    return *this;
+                }
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            if (depth < 0 || other.depth < 0) {
+                return depth < 0 && other.depth < 0;
+            }
+            return path[depth] == other.path[other.depth] && index[depth] == other.index[other.depth];
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    PersistentSortedMap() = default;
+
+    PersistentSortedMap(const PersistentSortedMap& other) : root(other.root), entries(other.entries)
+    {
+        if (root != nullptr) {
+            Retain(root);
+        }
+    }
+
+    PersistentSortedMap& operator=(const PersistentSortedMap& other)
+    {
+        if (other.root != nullptr) {
+            Retain(other.root);
+        }
+        if (root != nullptr) {
+            Release(root);
+        }
+        root = other.root;
+        entries = other.entries;
+        return *this;
+    }
+
+    PersistentSortedMap(PersistentSortedMap&& other) noexcept : root(other.root), entries(other.entries)
+    {
+        other.root = nullptr;
+        other.entries = 0;
+    }
+
+    PersistentSortedMap& operator=(PersistentSortedMap&& other) noexcept
+    {
+        std::swap(root, other.root);
+        std::swap(entries, other.entries);
+        return *this;
+    }
+
+    ~PersistentSortedMap()
+    {
+        if (root != nullptr) {
+            Release(root);
+        }
+    }
+
+    bool empty() const
+    {
+        return entries == 0;
+    }
+
+    size_t size() const
+    {
+        return entries;
+    }
+
+    const V *find(const K& key) const
+    {
+        auto node = root;
+        if (node == nullptr) {
+            return nullptr;
+        }
+
+        while (!node->leaf) {
+            node = node->children[ChildIndex(node, key)];
+        }
+        auto i = LowerBound(node, key);
+        if (i < node->count && !Less(key, node->items[i].first)) {
+            return &node->items[i].second;
+        }
+        return nullptr;
+    }
+
+    void assign(const K& key, const V& value)
+    {
+        if (root == nullptr) {
+            root = Allocate(true);
+        }
+
+        bool inserted = false;
+        auto split = Assign(root, key, value, inserted);
+        if (split.node != root) {
+            Release(root);
+            root = split.node;
+        }
+
+        if (split.sibling != nullptr) {
+            auto grown = Allocate(false);
+            grown->count = 2;
+            grown->items[0].first = split.node->items[0].first;
+            grown->items[1].first = split.sibling->items[0].first;
+            grown->children[0] = split.node;
+            grown->children[1] = split.sibling;
+            root = grown;
+        }
+
+        if (inserted) {
+            ++entries;
+        }
+    }
+
+    bool erase(const K& key)
+    {
+        if (find(key) == nullptr) {
+            return false;
+        }
+
+        auto node = Erase(root, key);
+        if (node != root) {
+            Release(root);
+            root = node;
+        }
+
+        if (root->count == 0) {
+            Release(root);
+            root = nullptr;
+        } else if (!root->leaf && root->count == 1) {
+            auto child = root->children[0];
+            Retain(child);
+            Release(root);
+            root = child;
+        }
+
+        --entries;
+        return true;
+    }
+
+    void clear()
+    {
+        if (root != nullptr) {
+            Release(root);
+        }
+        root = nullptr;
+        entries = 0;
+    }
+
+    std::optional<Item> front() const
+    {
+        if (empty()) {
+            return std::nullopt;
+        }
+        return Leftmost(root)->items[0];
+    }
+
+    std::optional<Item> back() const
+    {
+        if (empty()) {
+            return std::nullopt;
+        }
+        auto leaf = Rightmost(root);
+        return leaf->items[leaf->count - 1];
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(root);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <new>
+#include <utility>
 #include <vector>
 
 #include "math.hpp"
@@ -21,7 +22,7 @@ constexpr std::size_t hardware_constructive_interference_size = 64;
 constexpr std::size_t hardware_destructive_interference_size = 64;
 #endif
 
-#define CACHE_LINE_ALIGNED alignas(hardware_destructive_interference_size)
+#define CACHE_LINE_ALIGNED alignas(::CryptoTradingInfra::Utils::hardware_destructive_interference_size)
 
 constexpr size_t DEFAULT_CAPACITY = 1024;
 template <typename T, size_t Capacity = DEFAULT_CAPACITY>
@@ -132,11 +133,102 @@ public:
         return (t - h) >= CAP;
     }
 
+    // number of slots claimed by producers and not yet released by consumers
+    size_t occupancy() const
+    {
+        auto t = tail.load(std::memory_order_acquire);
+        auto h = head.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return CAP;
+    }
+
     size_t size() const
     {
         return buffer.size() * sizeof(typename Container::value_type) + sizeof(head) + sizeof(tail);
     }
 };
+/*
+ * Ring buffer for a producer and a consumer running on the same thread, like stages of a cooperative pipeline.
+ * It has the interface of ConcurrentRingBuffer without any atomic or fence, and head and tail sharing a cache
+ * line is what the thread wants here.
+ */
+template <typename T, size_t Capacity = DEFAULT_CAPACITY>
+class LocalRingBuffer
+{
+    static constexpr auto CAP = Math::NextPowerOf2<Capacity>();
+
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    std::vector<T> buffer;
+
+public:
+    LocalRingBuffer() : buffer(CAP)
+    {
+    }
+
+    LocalRingBuffer(const LocalRingBuffer&) = delete;
+    LocalRingBuffer& operator=(const LocalRingBuffer&) = delete;
+
+    template <typename U = T>
+    bool push(U&& item)
+    {
+        if (tail - head == CAP) {
+            return false;
+        }
+        buffer[tail++ & (CAP - 1)] = std::forward<U>(item);
+        return true;
+    }
+
+    template <typename... Args>
+    bool emplace(Args&&...args)
+    {
+        if (tail - head == CAP) {
+            return false;
+        }
+        auto& data = buffer[tail++ & (CAP - 1)];
+        data.~T();
+        new (&data) T(std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        if (head == tail) {
+            return false;
+        }
+        item = std::move(buffer[head++ & (CAP - 1)]);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head == tail;
+    }
+
+    bool full() const
+    {
+        return tail - head == CAP;
+    }
+
+    size_t occupancy() const
+    {
+        return tail - head;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return CAP;
+    }
+
+    size_t size() const
+    {
+        return buffer.size() * sizeof(T) + sizeof(head) + sizeof(tail);
+    }
+};
 } // namespace Utils
 } // namespace CryptoTradingInfra
 
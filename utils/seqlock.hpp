@@ -0,0 +1,84 @@
+#ifndef CRYPTO_TRADING_INFRA_SEQLOCK
+#define CRYPTO_TRADING_INFRA_SEQLOCK
+
+#include <atomic>
+#include <cstdint>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * Sequence lock for a single writer and any number of readers, which never block the writer. The sequence is
+ * odd while a write is in progress, a reader retries whenever it changed during its read. Data protected by
+ * it must be made of atomics accessed with relaxed ordering, so a torn read is discarded rather than being
+ * undefined behaviour.
+ *
+ * It holds a single lock free word and can be placed in shared memory.
+ */
+class SeqLock
+{
+    std::atomic<uint64_t> seq { 0 };
+
+public:
+    template <typename F>
+    void write(F&& mutate)
+    {
+        auto begin = seq.load(std::memory_order_relaxed);
+        seq.store(begin + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        mutate();
+
+        seq.store(begin + 2, std::memory_order_release);
+    }
+
+    // read is invoked until it observes no concurrent write, returns the version it observed
+    template <typename F>
+    uint64_t read(F&& read) const
+    {
+        while (true) {
+            auto begin = seq.load(std::memory_order_acquire);
+            if (begin & 1) {
+                continue;
+            }
+
+            read();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == begin) {
+                return begin >> 1;
+            }
+        }
+    }
+
+    // like read, but gives up after attempts reads that saw a write, returns whether read observed none
+    template <typename F>
+    bool tryRead(F&& read, uint64_t attempts) const
+    {
+        for (uint64_t attempt = 0; attempt < attempts; ++attempt) {
+            auto begin = seq.load(std::memory_order_acquire);
+            if (begin & 1) {
+                continue;
+            }
+
+            read();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == begin) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // number of writes completed so far
+    uint64_t version() const
+    {
+        return seq.load(std::memory_order_acquire) >> 1;
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef CRYPTO_TRADING_INFRA_SEQUENCE_ARBITER
+#define CRYPTO_TRADING_INFRA_SEQUENCE_ARBITER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "math.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+constexpr size_t DEFAULT_ARBITRATION_WINDOW = 4096;
+constexpr size_t MAX_ARBITRATED_LINES = 2;
+// a sequence this many windows behind the highest accepted one means the feed started over
+constexpr size_t ARBITER_RESTART_WINDOWS = 16;
+
+/*
+ * First arrival arbitration of sequenced packets delivered by redundant lines. The first copy of a sequence
+ * number to arrive on any line is accepted, later copies are rejected. Sequence numbers seen recently are kept
+ * in a window of atomic slots indexed by sequence, so lines may be handled by different threads without any
+ * lock. A packet older than the window is rejected as stale.
+ *
+ * A feed restarting numbers its packets from the start again. A sequence ARBITER_RESTART_WINDOWS windows or
+ * more behind the highest one accepted is far beyond what a late copy could be, so it is taken as the feed
+ * having started over: it is accepted and becomes the highest sequence, and slots holding sequences above it
+ * are left over from before and no longer reject anything. A feed restarting closer than that to where it
+ * stopped has its first packets taken for copies of old ones.
+ *
+ * Sequences between the lowest and the highest accepted ones that were not accepted are counted as missing,
+ * so gaps() is the number of packets lost on every line so far, across restarts.
+ */
+template <size_t Window = DEFAULT_ARBITRATION_WINDOW>
+class SequenceArbiter
+{
+    static constexpr auto CAP = Math::NextPowerOf2<Window>();
+    static constexpr uint64_t RESTART_DISTANCE = CAP * ARBITER_RESTART_WINDOWS;
+
+public:
+    struct LineStats {
+        uint64_t won;
+        uint64_t duplicates;
+        uint64_t stale;
+    };
+
+private:
+    struct Line {
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> won { 0 };
+        std::atomic<uint64_t> duplicates { 0 };
+        std::atomic<uint64_t> stale { 0 };
+    };
+
+    // a slot holds the latest sequence accepted in it plus one, so 0 means never used, and never more than next
+    // until the feed starts over
+    std::atomic<uint64_t> window[CAP] {};
+    Line lines[MAX_ARBITRATED_LINES];
+
+    // range of sequences accepted since the feed last started over, every sequence in it not accepted is missing
+    CACHE_LINE_ALIGNED std::atomic<uint64_t> lowest { UINT64_MAX };
+    std::atomic<uint64_t> next { 0 };
+    // missing before the feed last started over, and accepted by then
+    std::atomic<uint64_t> missed { 0 };
+    std::atomic<uint64_t> acceptedBefore { 0 };
+    std::atomic<uint64_t> restartsNum { 0 };
+
+    static void Increment(std::atomic<uint64_t>& counter)
+    {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t accepted() const
+    {
+        uint64_t total = 0;
+        for (const auto& stats : lines) {
+            total += stats.won.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t missing(uint64_t high) const
+    {
+        auto low = lowest.load(std::memory_order_relaxed);
+        auto since = accepted() - acceptedBefore.load(std::memory_order_relaxed);
+        if (high == 0 || low > high) {
+            return 0;
+        }
+        return high - low > since ? high - low - since : 0;
+    }
+
+    void extend(uint64_t sequence)
+    {
+        auto low = lowest.load(std::memory_order_relaxed);
+        while (sequence < low && !lowest.compare_exchange_weak(low, sequence, std::memory_order_relaxed)) {
+        }
+        auto high = next.load(std::memory_order_relaxed);
+        while (sequence >= high && !next.compare_exchange_weak(high, sequence + 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    // the feed started over from sequence, the copy of it on the other line being a duplicate once this one is
+    // in its slot
+    bool restart(size_t line, uint64_t sequence)
+    {
+        auto& slot = window[sequence & (CAP - 1)];
+        auto seen = slot.load(std::memory_order_acquire);
+        do {
+            if (seen == sequence + 1) {
+                Increment(lines[line].duplicates);
+                return false;
+            }
+        } while (!slot.compare_exchange_weak(seen, sequence + 1, std::memory_order_acq_rel));
+
+        // both lines may be starting over with packets of their own, only one of them lowers the range
+        auto high = next.load(std::memory_order_acquire);
+        while (sequence + RESTART_DISTANCE < high) {
+            auto before = missing(high);
+            if (next.compare_exchange_weak(high, sequence + 1, std::memory_order_acq_rel)) {
+                missed.fetch_add(before, std::memory_order_relaxed);
+                acceptedBefore.store(accepted(), std::memory_order_relaxed);
+                lowest.store(sequence, std::memory_order_relaxed);
+                Increment(restartsNum);
+                break;
+            }
+        }
+        Increment(lines[line].won);
+        extend(sequence);
+        return true;
+    }
+
+public:
+    // returns true if sequence is seen for the first time, the caller should then process the packet
+    bool accept(size_t line, uint64_t sequence)
+    {
+        auto& slot = window[sequence & (CAP - 1)];
+        auto seen = slot.load(std::memory_order_acquire);
+        while (true) {
+            if (seen == sequence + 1) {
+                Increment(lines[line].duplicates);
+                return false;
+            }
+            auto high = next.load(std::memory_order_acquire);
+            if (sequence + RESTART_DISTANCE < high) {
+                return restart(line, sequence);
+            }
+            if (seen > sequence + 1 && seen <= high) {
+                Increment(lines[line].stale);
+                return false;
+            }
+            // next covers sequence before its slot does, so a slot above next was left from before a restart
+            extend(sequence);
+            if (slot.compare_exchange_weak(seen, sequence + 1, std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+
+        Increment(lines[line].won);
+        return true;
+    }
+
+    LineStats line(size_t line) const
+    {
+        const auto& stats = lines[line];
+        return { stats.won.load(std::memory_order_relaxed), stats.duplicates.load(std::memory_order_relaxed),
+                 stats.stale.load(std::memory_order_relaxed) };
+    }
+
+    // sequences no line has delivered so far, a late packet may still fill one in while it is in the window.
+    // Only exact once every line is done
+    uint64_t gaps() const
+    {
+        return missed.load(std::memory_order_relaxed) + missing(next.load(std::memory_order_relaxed));
+    }
+
+    // times the feed started over
+    uint64_t restarts() const
+    {
+        return restartsNum.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
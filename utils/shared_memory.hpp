@@ -0,0 +1,147 @@
+#ifndef CRYPTO_TRADING_INFRA_SHARED_MEMORY
+#define CRYPTO_TRADING_INFRA_SHARED_MEMORY
+
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * Mapping of a named POSIX shared memory segment. The creator owns the segment: it replaces whatever segment
+ * was left under the same name and unlinks it when destroyed, while processes attaching to it can come and go.
+ * A process attached to a segment whose creator went away keeps the mapping it has, replaced() telling it the
+ * name no longer leads there so it can attach again. Names follow shm_open rules, a leading slash and no other
+ * one.
+ */
+class SharedMemory
+{
+    std::string name;
+    void *segment;
+    size_t length;
+    bool owner;
+    // tells the segment apart from any other created under the same name
+    dev_t device;
+    ino_t inode;
+
+    SharedMemory(const std::string& name, void *segment, size_t length, bool owner, const struct stat& st)
+        : name(name), segment(segment), length(length), owner(owner), device(st.st_dev), inode(st.st_ino)
+    {
+    }
+
+    static void *Map(int fd, size_t length)
+    {
+        auto segment = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (segment == MAP_FAILED) {
+            perror("mmap");
+            return nullptr;
+        }
+        return segment;
+    }
+
+public:
+    // the segment is zero filled, returns nullptr on failure
+    static std::unique_ptr<SharedMemory> Create(const std::string& name, size_t length)
+    {
+        // a segment left behind by a crashed creator is replaced, processes still attached to it keep the old one
+        shm_unlink(name.c_str());
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            perror("shm_open");
+            return nullptr;
+        }
+
+        if (ftruncate(fd, length) < 0) {
+            perror("ftruncate");
+            close(fd);
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            perror("fstat");
+            close(fd);
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        auto segment = Map(fd, length);
+        if (segment == nullptr) {
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+        return std::unique_ptr<SharedMemory>(new SharedMemory(name, segment, length, true, st));
+    }
+
+    // returns nullptr if the segment does not exist or its length differs
+    static std::unique_ptr<SharedMemory> Attach(const std::string& name, size_t length)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            perror("shm_open");
+            return nullptr;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) != length) {
+            std::cerr << "Shared memory segment " << name << " does not match the expected size " << length << "\n"
+                      << std::flush;
+            close(fd);
+            return nullptr;
+        }
+
+        auto segment = Map(fd, length);
+        if (segment == nullptr) {
+            return nullptr;
+        }
+        return std::unique_ptr<SharedMemory>(new SharedMemory(name, segment, length, false, st));
+    }
+
+    ~SharedMemory()
+    {
+        munmap(segment, length);
+        if (owner) {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // true once the name leads to another segment or to none, a system call every time
+    bool replaced() const
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return true;
+        }
+        struct stat st;
+        auto same = fstat(fd, &st) == 0 && st.st_dev == device && st.st_ino == inode;
+        close(fd);
+        return !same;
+    }
+
+    void *data() const
+    {
+        return segment;
+    }
+
+    const std::string& segmentName() const
+    {
+        return name;
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef CRYPTO_TRADING_INFRA_SHM_RING_BUFFER
+#define CRYPTO_TRADING_INFRA_SHM_RING_BUFFER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "math.hpp"
+#include "ring_buffer.hpp"
+#include "shared_memory.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+constexpr uint64_t SHM_RING_MAGIC = 0x474e495249544343; // "CCTIRING"
+constexpr uint32_t SHM_RING_VERSION = 1;
+
+/*
+ * ConcurrentRingBuffer whose head, tail and slots live in a named POSIX shared memory segment, so producers
+ * and consumers may run in different processes. The segment starts with a versioned header describing its
+ * layout, which every process attaching to it checks against its own view of T and Capacity. Other processes
+ * can attach and detach at any time without disturbing the creator, see SharedMemory. A creator restarting
+ * makes a new segment, which processes attached to the old one find out through replaced() and attach to.
+ */
+template <typename T, size_t Capacity = DEFAULT_CAPACITY>
+class SharedRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can cross the process boundary");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock free");
+
+    static constexpr auto CAP = Math::NextPowerOf2<Capacity>();
+
+    struct Node {
+        std::atomic<uint64_t> seq;
+        T data;
+    };
+
+    // any change to this layout or the Node layout must come with a new SHM_RING_VERSION
+    struct Header {
+        std::atomic<uint64_t> magic; // stored last by the creator, the segment is not usable before
+        uint32_t version;
+        uint32_t nodeSize;
+        uint64_t capacity;
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> head;
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> tail;
+    };
+
+    static constexpr size_t SEGMENT_SIZE = sizeof(Header) + CAP * sizeof(Node);
+
+    std::unique_ptr<SharedMemory> segment;
+    Header *header;
+    Node *buffer;
+
+    explicit SharedRingBuffer(std::unique_ptr<SharedMemory> segment)
+        : segment(std::move(segment)), header(static_cast<Header *>(this->segment->data())),
+          buffer(reinterpret_cast<Node *>(static_cast<char *>(this->segment->data()) + sizeof(Header)))
+    {
+    }
+
+    bool compatible() const
+    {
+        return header->magic.load(std::memory_order_acquire) == SHM_RING_MAGIC &&
+               header->version == SHM_RING_VERSION && header->nodeSize == sizeof(Node) && header->capacity == CAP;
+    }
+
+    template <typename F>
+    bool acquireAndSet(F&& setNodeData)
+    {
+        auto& tail = header->tail;
+        auto pos = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto& node = buffer[pos & (CAP - 1)];
+            auto seq = node.seq.load(std::memory_order_acquire);
+            int64_t dif = seq - pos;
+
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    setNodeData(node.data);
+                    node.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+
+            if (dif < 0) {
+                return false; // buffer is full
+            }
+
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+public:
+    // returns nullptr on failure
+    static std::unique_ptr<SharedRingBuffer> Create(const std::string& name)
+    {
+        auto segment = SharedMemory::Create(name, SEGMENT_SIZE);
+        if (!segment) {
+            return nullptr;
+        }
+
+        auto ring = std::unique_ptr<SharedRingBuffer>(new SharedRingBuffer(std::move(segment)));
+        auto header = new (ring->header) Header {};
+        header->version = SHM_RING_VERSION;
+        header->nodeSize = sizeof(Node);
+        header->capacity = CAP;
+        for (uint64_t i = 0; i < CAP; ++i) {
+            new (&ring->buffer[i].seq) std::atomic<uint64_t>(i);
+        }
+        header->magic.store(SHM_RING_MAGIC, std::memory_order_release);
+        return ring;
+    }
+
+    // returns nullptr if the segment does not exist or was created with another layout
+    static std::unique_ptr<SharedRingBuffer> Attach(const std::string& name)
+    {
+        auto segment = SharedMemory::Attach(name, SEGMENT_SIZE);
+        if (!segment) {
+            return nullptr;
+        }
+
+        auto ring = std::unique_ptr<SharedRingBuffer>(new SharedRingBuffer(std::move(segment)));
+        if (!ring->compatible()) {
+            std::cerr << "Shared memory segment " << name << " is not ready or has an incompatible layout\n"
+                      << std::flush;
+            return nullptr;
+        }
+        return ring;
+    }
+
+    SharedRingBuffer(const SharedRingBuffer&) = delete;
+    SharedRingBuffer& operator=(const SharedRingBuffer&) = delete;
+
+    SharedRingBuffer(SharedRingBuffer&&) = delete;
+    SharedRingBuffer& operator=(SharedRingBuffer&&) = delete;
+
+    bool push(const T& item)
+    {
+        return acquireAndSet([&](T& data) { data = item; });
+    }
+
+    template <typename... Args>
+    bool emplace(Args&&...args)
+    {
+        return acquireAndSet([&](T& data) { new (&data) T(std::forward<Args>(args)...); });
+    }
+
+    bool pop(T& item)
+    {
+        auto& head = header->head;
+        auto pos = head.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto& node = buffer[pos & (CAP - 1)];
+            auto seq = node.seq.load(std::memory_order_acquire);
+            int64_t dif = seq - (pos + 1);
+
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = node.data;
+                    node.seq.store(pos + CAP, std::memory_order_release);
+                    return true;
+                }
+            }
+
+            if (dif < 0) {
+                return false; // buffer is empty
+            }
+
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // same as ConcurrentRingBuffer, only a snapshot which may expire right away
+    bool empty() const
+    {
+        return header->head.load(std::memory_order_acquire) == header->tail.load(std::memory_order_acquire);
+    }
+
+    bool full() const
+    {
+        auto t = header->tail.load(std::memory_order_acquire);
+        auto h = header->head.load(std::memory_order_acquire);
+        return (t - h) >= CAP;
+    }
+
+    // true once the creator went away or made a new segment under the same name, whatever the old one still
+    // holds can be popped before attaching again
+    bool replaced() const
+    {
+        return segment->replaced();
+    }
+
+    const std::string& segmentName() const
+    {
+        return segment->segmentName();
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef CRYPTO_TRADING_INFRA_STREAM_VBYTE
+#define CRYPTO_TRADING_INFRA_STREAM_VBYTE
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define CRYPTO_TRADING_INFRA_STREAM_VBYTE_SSSE3
+#endif
+
+namespace CryptoTradingInfra {
+namespace Utils {
+namespace StreamVByte {
+
+/*
+ * Stream VByte coding of 32-bit integers: a control byte holds the byte lengths (1 to 4) of four values in
+ * 2 bits each, and all control bytes come before the value bytes. Since the length of four values is known
+ * from one byte, decoding them is a single shuffle of 16 bytes, done with SSSE3 when the CPU has it.
+ */
+
+// control bytes followed by value bytes, at most
+constexpr size_t MaxEncodedSize(size_t count)
+{
+    return (count + 3) / 4 + count * 4;
+}
+
+inline uint32_t ZigZag(int64_t value)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline int64_t UnZigZag(uint32_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// whether value survives ZigZag, which only keeps 32 bits
+inline bool FitsZigZag(int64_t value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+// returns the number of bytes written
+inline size_t Encode(const uint32_t *in, size_t count, uint8_t *out)
+{
+    auto control = out;
+    auto data = out + (count + 3) / 4;
+    std::memset(control, 0, (count + 3) / 4);
+    for (size_t i = 0; i < count; ++i) {
+        auto value = in[i];
+        uint8_t code = value < (1u << 8) ? 0 : value < (1u << 16) ? 1 : value < (1u << 24) ? 2 : 3;
+        control[i / 4] |= code << (2 * (i % 4));
+        // little endian, so the low bytes of the value are the ones kept
+        std::memcpy(data, &value, code + 1);
+        data += code + 1;
+    }
+    return data - out;
+}
+
+namespace Detail {
+
+struct Tables {
+    std::array<std::array<uint8_t, 16>, 256> shuffles {};
+    std::array<uint8_t, 256> lengths {};
+};
+
+constexpr Tables MakeTables()
+{
+    Tables tables;
+    for (size_t control = 0; control < 256; ++control) {
+        uint8_t offset = 0;
+        for (size_t value = 0; value < 4; ++value) {
+            auto length = ((control >> (2 * value)) & 3) + 1;
+            for (size_t byte = 0; byte < 4; ++byte) {
+                // 0x80 has pshufb zero the byte
+                tables.shuffles[control][value * 4 + byte] = byte < length ? offset + byte : 0x80;
+            }
+            offset += length;
+        }
+        tables.lengths[control] = offset;
+    }
+    return tables;
+}
+
+inline constexpr Tables TABLES = MakeTables();
+
+inline const uint8_t *DecodeScalar(const uint8_t *control, const uint8_t *data, size_t from, size_t count,
+                                   uint32_t *out)
+{
+    for (size_t i = from; i < count; ++i) {
+        auto length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        std::memcpy(&value, data, length);
+        out[i] = value;
+        data += length;
+    }
+    return data;
+}
+
+#ifdef CRYPTO_TRADING_INFRA_STREAM_VBYTE_SSSE3
+// decodes groups of four values as long as 16 bytes can be loaded before end, returns how many were decoded
+__attribute__((target("ssse3"))) inline size_t DecodeSsse3(const uint8_t *control, const uint8_t *&data,
+                                                             const uint8_t *end, size_t count, uint32_t *out)
+{
+    size_t i = 0;
+    for (; i + 4 <= count && end - data >= 16; i += 4) {
+        auto code = control[i / 4];
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(TABLES.shuffles[code].data()));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_shuffle_epi8(bytes, shuffle));
+        data += TABLES.lengths[code];
+    }
+    return i;
+}
+#endif
+
+} // namespace Detail
+
+// length bounds the bytes read from in, returns the number of bytes decoded or 0 if they do not fit in it
+inline size_t Decode(const uint8_t *in, size_t length, size_t count, uint32_t *out)
+{
+    auto controls = (count + 3) / 4;
+    if (length < controls) {
+        return 0;
+    }
+    size_t needed = controls;
+    for (size_t i = 0; i < controls; ++i) {
+        needed += Detail::TABLES.lengths[in[i]];
+    }
+    // the control byte of a partial group counts lengths for values that are not there
+    if (count % 4 != 0) {
+        needed -= 4 - count % 4;
+    }
+    if (length < needed) {
+        return 0;
+    }
+
+    auto data = in + controls;
+    size_t decoded = 0;
+#ifdef CRYPTO_TRADING_INFRA_STREAM_VBYTE_SSSE3
+    static const bool ssse3 = __builtin_cpu_supports("ssse3");
+    if (ssse3) {
+        decoded = Detail::DecodeSsse3(in, data, in + length, count, out);
+    }
+#endif
+    Detail::DecodeScalar(in, data, decoded, count, out);
+    return needed;
+}
+
+} // namespace StreamVByte
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
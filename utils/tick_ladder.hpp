@@ -0,0 +1,727 @@
+#ifndef CRYPTO_TRADING_INFRA_TICK_LADDER
+#define CRYPTO_TRADING_INFRA_TICK_LADDER
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "node_pool.hpp"
+#include "persistent_map.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+namespace Bits {
+
+constexpr size_t WORD = 64;
+constexpr size_t WORD_SHIFT = 6;
+
+inline size_t Lowest(uint64_t word)
+{
+    return __builtin_ctzll(word);
+}
+
+inline size_t Highest(uint64_t word)
+{
+    return WORD - 1 - __builtin_clzll(word);
+}
+
+// bits strictly above / below position i
+inline uint64_t Above(uint64_t word, size_t i)
+{
+    return i + 1 >= WORD ? 0 : word & (~uint64_t { 0 } << (i + 1));
+}
+
+inline uint64_t Below(uint64_t word, size_t i)
+{
+    return word & ((uint64_t { 1 } << i) - 1);
+}
+
+} // namespace Bits
+
+/*
+ * Price ladder covering a window of Ticks consecutive ticks, centred on the first level inserted. A level on
+ * the grid of the tick size and within the window sits in the slot of its tick. Levels outside of the window
+ * are kept in a persistent sorted map by price instead, along with prices off the grid and any other price
+ * rounding to a tick whose slot is taken, so no two prices are ever merged. Each level keeps the price it was
+ * assigned with, and iterating merges both in price order, giving back the very prices put in.
+ *
+ * Slots are indexed by tick modulo the span of the tree, so the window is a ring over them that moves without
+ * moving the levels staying in it. It is centred on a new best level on the grid that would be ahead of it,
+ * only the levels it leaves behind going to the map, and on the best level of the map once it runs empty, only
+ * the levels it takes in coming back from the map. Moving it costs in proportion to the levels crossing its
+ * edges, never to the size of the ladder.
+ *
+ * Levels live in a radix tree of 64-wide nodes, each carrying a 64-bit occupancy word for its children, so
+ * the words form a hierarchical bitmap: the best level, or the next one after a level empties, is found
+ * with one ctz/clz per tree level no matter how many levels are in use. Like PersistentSortedMap, nodes
+ * are pooled and reference counted and a modification only copies the path to the affected tick, so
+ * copying a ladder is O(1).
+ *
+ * Descending ladders iterate from the highest price (bids), ascending ones from the lowest (asks).
+ */
+template <size_t Ticks, bool Descending, typename V = double>
+class TickLadder
+{
+public:
+    using Item = std::pair<double, V>;
+
+private:
+    using Overflow = PersistentSortedMap<double, V, std::conditional_t<Descending, std::greater<>, std::less<>>>;
+
+    static constexpr size_t Height()
+    {
+        size_t height = 1;
+        for (size_t span = Bits::WORD; span < Ticks; span *= Bits::WORD) {
+            ++height;
+        }
+        return height;
+    }
+
+    static constexpr size_t HEIGHT = Height();
+    static constexpr size_t SPAN = size_t { 1 } << (Bits::WORD_SHIFT * HEIGHT);
+    // in ticks, how far a price may be from a multiple of the tick size and still be on the grid
+    static constexpr double GRID_TOLERANCE = 1e-6;
+
+    struct Node {
+        std::atomic<uint32_t> refs;
+        uint64_t occupancy;
+    };
+
+    struct Leaf : Node {
+        double prices[Bits::WORD];
+        V values[Bits::WORD];
+    };
+
+    struct Inner : Node {
+        Node *children[Bits::WORD];
+    };
+
+    Node *root = nullptr;
+    size_t entries = 0;
+    // levels outside of the window, off the grid or sharing the tick of a level in it
+    Overflow overflow;
+    int64_t baseTick = 0;
+    double tickSize;
+
+    static size_t Digit(size_t slot, size_t level)
+    {
+        return (slot >> (Bits::WORD_SHIFT * (HEIGHT - 1 - level))) & (Bits::WORD - 1);
+    }
+
+    static bool IsLeaf(size_t level)
+    {
+        return level == HEIGHT - 1;
+    }
+
+    static size_t Slot(int64_t tick)
+    {
+        return static_cast<uint64_t>(tick) & (SPAN - 1);
+    }
+
+    static bool Ahead(double price, double than)
+    {
+        return Descending ? price > than : price < than;
+    }
+
+    static size_t Best(uint64_t occupancy)
+    {
+        return Descending ? Bits::Highest(occupancy) : Bits::Lowest(occupancy);
+    }
+
+    static uint64_t After(uint64_t occupancy, size_t i)
+    {
+        return Descending ? Bits::Below(occupancy, i) : Bits::Above(occupancy, i);
+    }
+
+    static Node *Allocate(size_t level)
+    {
+        Node *node;
+        if (IsLeaf(level)) {
+            node = new (NodePool<Leaf>::Instance().allocate()) Leaf;
+        } else {
+            node = new (NodePool<Inner>::Instance().allocate()) Inner;
+        }
+        node->refs.store(1, std::memory_order_relaxed);
+        node->occupancy = 0;
+        return node;
+    }
+
+    static void Retain(Node *node)
+    {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Release(Node *node, size_t level)
+    {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        if (IsLeaf(level)) {
+            auto leaf = static_cast<Leaf *>(node);
+            leaf->~Leaf();
+            NodePool<Leaf>::Instance().deallocate(leaf);
+            return;
+        }
+
+        auto inner = static_cast<Inner *>(node);
+        for (auto occupancy = inner->occupancy; occupancy != 0; occupancy &= occupancy - 1) {
+            Release(inner->children[Bits::Lowest(occupancy)], level + 1);
+        }
+        inner->~Inner();
+        NodePool<Inner>::Instance().deallocate(inner);
+    }
+
+    static Node *Writable(Node *node, size_t level)
+    {
+        if (node == nullptr) {
+            return Allocate(level);
+        }
+        if (node->refs.load(std::memory_order_acquire) == 1) {
+            return node;
+        }
+
+        auto copy = Allocate(level);
+        copy->occupancy = node->occupancy;
+        if (IsLeaf(level)) {
+            auto from = static_cast<const Leaf *>(node);
+            auto to = static_cast<Leaf *>(copy);
+            std::copy(from->prices, from->prices + Bits::WORD, to->prices);
+            std::copy(from->values, from->values + Bits::WORD, to->values);
+        } else {
+            auto from = static_cast<const Inner *>(node);
+            auto to = static_cast<Inner *>(copy);
+            for (auto occupancy = from->occupancy; occupancy != 0; occupancy &= occupancy - 1) {
+                auto i = Bits::Lowest(occupancy);
+                to->children[i] = from->children[i];
+                Retain(to->children[i]);
+            }
+        }
+        return copy;
+    }
+
+    static Node *Assign(Node *node, size_t level, size_t slot, double price, const V& value, bool& inserted)
+    {
+        auto writable = Writable(node, level);
+        auto digit = Digit(slot, level);
+        auto bit = uint64_t { 1 } << digit;
+
+        if (IsLeaf(level)) {
+            inserted = (writable->occupancy & bit) == 0;
+            writable->occupancy |= bit;
+            static_cast<Leaf *>(writable)->prices[digit] = price;
+            static_cast<Leaf *>(writable)->values[digit] = value;
+            return writable;
+        }
+
+        auto inner = static_cast<Inner *>(writable);
+        auto child = (inner->occupancy & bit) != 0 ? inner->children[digit] : nullptr;
+        auto updated = Assign(child, level + 1, slot, price, value, inserted);
+        if (child != updated) {
+            if (child != nullptr) {
+                Release(child, level + 1);
+            }
+            inner->children[digit] = updated;
+        }
+        inner->occupancy |= bit;
+        return writable;
+    }
+
+    // the slot must be occupied; the returned node has no occupancy left when the subtree ran empty, and
+    // it is up to the caller to release it
+    static Node *Erase(Node *node, size_t level, size_t slot)
+    {
+        auto writable = Writable(node, level);
+        auto digit = Digit(slot, level);
+        auto bit = uint64_t { 1 } << digit;
+
+        if (!IsLeaf(level)) {
+            auto inner = static_cast<Inner *>(writable);
+            auto child = inner->children[digit];
+            auto updated = Erase(child, level + 1, slot);
+            if (child != updated) {
+                Release(child, level + 1);
+                inner->children[digit] = updated;
+            }
+            if (updated->occupancy != 0) {
+                return writable;
+            }
+            Release(updated, level + 1);
+        }
+
+        writable->occupancy &= ~bit;
+        return writable;
+    }
+
+    // the leaf holding slot if the slot is occupied, nullptr otherwise
+    static const Leaf *LeafOf(const Node *node, size_t slot)
+    {
+        for (size_t level = 0; node != nullptr; ++level) {
+            auto digit = Digit(slot, level);
+            if ((node->occupancy & (uint64_t { 1 } << digit)) == 0) {
+                return nullptr;
+            }
+            if (IsLeaf(level)) {
+                return static_cast<const Leaf *>(node);
+            }
+            node = static_cast<const Inner *>(node)->children[digit];
+        }
+        return nullptr;
+    }
+
+    // nearest occupied slot from from on, upwards or downwards and without wrapping around, within the subtree
+    // of node; slot holds the digits of the levels above and gets the slot found
+    static bool Nearest(const Node *node, size_t level, size_t from, bool up, bool bounded, size_t& slot)
+    {
+        auto digit = Digit(from, level);
+        auto occupancy = node->occupancy;
+        if (bounded) {
+            occupancy &= up ? ~uint64_t { 0 } << digit : ~Bits::Above(~uint64_t { 0 }, digit);
+        }
+        for (; occupancy != 0;) {
+            auto i = up ? Bits::Lowest(occupancy) : Bits::Highest(occupancy);
+            auto found = slot | (i << (Bits::WORD_SHIFT * (HEIGHT - 1 - level)));
+            if (IsLeaf(level) || Nearest(static_cast<const Inner *>(node)->children[i], level + 1, from, up,
+                                         bounded && i == digit, found)) {
+                slot = found;
+                return true;
+            }
+            occupancy &= ~(uint64_t { 1 } << i);
+        }
+        return false;
+    }
+
+    // tick of price if it is on the grid
+    std::optional<int64_t> gridTick(double price) const
+    {
+        auto ticks = price / tickSize;
+        auto tick = std::llround(ticks);
+        if (!(std::fabs(ticks - static_cast<double>(tick)) <= GRID_TOLERANCE)) {
+            return std::nullopt;
+        }
+        return tick;
+    }
+
+    bool inWindow(int64_t tick) const
+    {
+        return tick >= baseTick && tick - baseTick < static_cast<int64_t>(Ticks);
+    }
+
+    // the slot of the window where price sits, if it sits in the window rather than in the overflow
+    std::optional<size_t> slotOf(double price) const
+    {
+        auto tick = gridTick(price);
+        if (!tick || !inWindow(*tick)) {
+            return std::nullopt;
+        }
+        auto leaf = LeafOf(root, Slot(*tick));
+        auto digit = Digit(Slot(*tick), HEIGHT - 1);
+        if (leaf == nullptr || leaf->prices[digit] != price) {
+            return std::nullopt;
+        }
+        return Slot(*tick);
+    }
+
+    void place(size_t slot, double price, const V& value)
+    {
+        bool inserted = false;
+        auto updated = Assign(root, 0, slot, price, value, inserted);
+        if (updated != root) {
+            if (root != nullptr) {
+                Release(root, 0);
+            }
+            root = updated;
+        }
+        if (inserted) {
+            ++entries;
+        }
+    }
+
+    void remove(size_t slot)
+    {
+        auto updated = Erase(root, 0, slot);
+        if (updated != root) {
+            Release(root, 0);
+        }
+        root = updated;
+        if (root->occupancy == 0) {
+            Release(root, 0);
+            root = nullptr;
+        }
+        --entries;
+    }
+
+    // the slot of the window holding the worst level, the window must not be empty
+    size_t worstSlot() const
+    {
+        // walking from the worst edge of the window towards the best one, around the end of the tree if need be
+        auto edge = Slot(Descending ? baseTick : baseTick + static_cast<int64_t>(Ticks) - 1);
+        size_t slot = 0;
+        if (!Nearest(root, 0, edge, Descending, true, slot)) {
+            slot = 0;
+            Nearest(root, 0, Descending ? 0 : SPAN - 1, Descending, false, slot);
+        }
+        return slot;
+    }
+
+    int64_t tickOf(size_t slot) const
+    {
+        return baseTick + static_cast<int64_t>((slot - Slot(baseTick)) & (SPAN - 1));
+    }
+
+    // moves the window so that it is centred on tick, ahead of it; the levels it leaves behind go to the overflow
+    void advance(int64_t tick)
+    {
+        auto base = tick - static_cast<int64_t>(Ticks / 2);
+        while (entries > 0) {
+            auto slot = worstSlot();
+            auto worst = tickOf(slot);
+            if (worst >= base && worst - base < static_cast<int64_t>(Ticks)) {
+                break;
+            }
+            auto leaf = LeafOf(root, slot);
+            auto digit = Digit(slot, HEIGHT - 1);
+            overflow.assign(leaf->prices[digit], leaf->values[digit]);
+            remove(slot);
+        }
+        baseTick = base;
+    }
+
+    // centres the window, which ran empty, on the best level of the overflow on the grid, and takes in from the
+    // overflow the levels on the grid within it
+    void refill()
+    {
+        // a copy to walk, the overflow itself changing on the way
+        auto levels = overflow;
+        bool centred = false;
+        for (const auto& [price, value] : levels) {
+            auto tick = gridTick(price);
+            if (!centred && tick) {
+                baseTick = *tick - static_cast<int64_t>(Ticks / 2);
+                centred = true;
+            }
+            if (!centred) {
+                continue;
+            }
+            auto rounded = std::llround(price / tickSize);
+            if (Descending ? rounded < baseTick : rounded - baseTick >= static_cast<int64_t>(Ticks)) {
+                break;
+            }
+            if (tick && inWindow(*tick) && LeafOf(root, Slot(*tick)) == nullptr) {
+                place(Slot(*tick), price, value);
+                overflow.erase(price);
+            }
+        }
+    }
+
+public:
+    class const_iterator
+    {
+        const Node *path[HEIGHT];
+        size_t digits[HEIGHT];
+        int depth = -1;
+        const Node *root = nullptr;
+        // slots are walked from start to the end of the tree, then from its other end back up to start
+        size_t start = 0;
+        bool wrapped = false;
+        typename Overflow::const_iterator overflow;
+        bool inOverflow = false;
+        Item item;
+
+        void descend(const Node *node)
+        {
+            while (true) {
+                ++depth;
+                path[depth] = node;
+                digits[depth] = Best(node->occupancy);
+                if (IsLeaf(depth)) {
+                    break;
+                }
+                node = static_cast<const Inner *>(node)->children[digits[depth]];
+            }
+        }
+
+        void descendTo(const Node *node, size_t slot)
+        {
+            for (depth = 0;; ++depth) {
+                path[depth] = node;
+                digits[depth] = Digit(slot, depth);
+                if (IsLeaf(depth)) {
+                    break;
+                }
+                node = static_cast<const Inner *>(node)->children[digits[depth]];
+            }
+        }
+
+        size_t slot() const
+        {
+            size_t slot = 0;
+            for (size_t level = 0; level < HEIGHT; ++level) {
+                slot = (slot << Bits::WORD_SHIFT) | digits[level];
+            }
+            return slot;
+        }
+
+        // whether the slot walked onto was walked already, before wrapping around
+        bool past() const
+        {
+            return wrapped && (Descending ? slot() <= start : slot() >= start);
+        }
+
+        void seek(size_t from)
+        {
+            size_t found = 0;
+            depth = -1;
+            if (Nearest(root, 0, from, !Descending, true, found)) {
+                descendTo(root, found);
+            }
+        }
+
+        void next()
+        {
+            while (depth >= 0) {
+                auto after = After(path[depth]->occupancy, digits[depth]);
+                if (after != 0) {
+                    digits[depth] = Best(after);
+                    if (!IsLeaf(depth)) {
+                        descend(static_cast<const Inner *>(path[depth])->children[digits[depth]]);
+                    }
+                    return;
+                }
+                --depth;
+            }
+        }
+
+        void wrap()
+        {
+            if (depth < 0 && !wrapped) {
+                wrapped = true;
+                seek(Descending ? SPAN - 1 : 0);
+            }
+            if (depth >= 0 && past()) {
+                depth = -1;
+            }
+        }
+
+        // the better of the levels both walks are at
+        void load()
+        {
+            auto more = overflow != typename Overflow::const_iterator();
+            if (depth < 0) {
+                inOverflow = more;
+                if (more) {
+                    item = *overflow;
+                }
+                return;
+            }
+            auto leaf = static_cast<const Leaf *>(path[depth]);
+            auto price = leaf->prices[digits[depth]];
+            inOverflow = more && Ahead(overflow->first, price);
+            item = inOverflow ? *overflow : Item(price, leaf->values[digits[depth]]);
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Item *;
+        using reference = const Item&;
+
+        const_iterator() = default;
+
+        explicit const_iterator(const TickLadder *ladder) : root(ladder->root), overflow(ladder->overflow.begin())
+        {
+            if (root != nullptr) {
+                start = Slot(Descending ? ladder->baseTick + static_cast<int64_t>(Ticks) - 1 : ladder->baseTick);
+                seek(start);
+                wrap();
+            }
+            load();
+        }
+
+        reference operator*() const
+        {
+            return item;
+        }
+
+        pointer operator->() const
+        {
+            return &item;
+        }
+
+        const_iterator& operator++()
+        {
+            if (inOverflow) {
+                ++overflow;
+            } else if (depth >= 0) {
+                next();
+                wrap();
+            }
+            load();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            if (overflow != other.overflow) {
+                return false;
+            }
+            if (depth < 0 || other.depth < 0) {
+                return depth < 0 && other.depth < 0;
+            }
+            return path[depth] == other.path[other.depth] && digits[depth] == other.digits[other.depth];
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    explicit TickLadder(double tickSize) : tickSize(tickSize) {}
+
+    TickLadder(const TickLadder& other)
+        : root(other.root), entries(other.entries), overflow(other.overflow), baseTick(other.baseTick),
+          tickSize(other.tickSize)
+    {
+        if (root != nullptr) {
+            Retain(root);
+        }
+    }
+
+    TickLadder& operator=(const TickLadder& other)
+    {
+        if (other.root != nullptr) {
+            Retain(other.root);
+        }
+        if (root != nullptr) {
+            Release(root, 0);
+        }
+        root = other.root;
+        entries = other.entries;
+        overflow = other.overflow;
+        baseTick = other.baseTick;
+        tickSize = other.tickSize;
+        return *this;
+    }
+
+    ~TickLadder()
+    {
+        if (root != nullptr) {
+            Release(root, 0);
+        }
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t size() const
+    {
+        return entries + overflow.size();
+    }
+
+    double tick() const
+    {
+        return tickSize;
+    }
+
+    const V *find(double price) const
+    {
+        auto slot = slotOf(price);
+        if (!slot) {
+            return overflow.empty() ? nullptr : overflow.find(price);
+        }
+        return &LeafOf(root, *slot)->values[Digit(*slot, HEIGHT - 1)];
+    }
+
+    void assign(double price, const V& value)
+    {
+        auto tick = gridTick(price);
+        if (!tick) {
+            overflow.assign(price, value);
+            return;
+        }
+
+        // an empty window is centred around the first price it sees, a level ahead of it is a new best one
+        auto offset = *tick - baseTick;
+        if (entries == 0) {
+            baseTick = *tick - static_cast<int64_t>(Ticks / 2);
+        } else if (Descending ? offset >= static_cast<int64_t>(Ticks) : offset < 0) {
+            advance(*tick);
+        }
+
+        auto slot = Slot(*tick);
+        auto leaf = inWindow(*tick) ? LeafOf(root, slot) : nullptr;
+        auto digit = Digit(slot, HEIGHT - 1);
+        if (!inWindow(*tick) || (leaf != nullptr && leaf->prices[digit] != price) ||
+            (leaf == nullptr && !overflow.empty() && overflow.find(price) != nullptr)) {
+            overflow.assign(price, value);
+            return;
+        }
+        place(slot, price, value);
+    }
+
+    bool erase(double price)
+    {
+        auto slot = slotOf(price);
+        if (!slot) {
+            return overflow.erase(price);
+        }
+
+        remove(*slot);
+        if (entries == 0 && !overflow.empty()) {
+            refill();
+        }
+        return true;
+    }
+
+    std::optional<Item> front() const
+    {
+        if (empty()) {
+            return std::nullopt;
+        }
+        return *begin();
+    }
+
+    std::optional<Item> back() const
+    {
+        auto last = overflow.back();
+        if (entries == 0) {
+            return last;
+        }
+
+        auto slot = worstSlot();
+        auto leaf = LeafOf(root, slot);
+        auto digit = Digit(slot, HEIGHT - 1);
+        if (last && !Ahead(last->first, leaf->prices[digit])) {
+            return last;
+        }
+        return Item(leaf->prices[digit], leaf->values[digit]);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
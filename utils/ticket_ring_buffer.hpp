@@ -0,0 +1,265 @@
+#ifndef CRYPTO_TRADING_INFRA_TICKET_RING_BUFFER
+#define CRYPTO_TRADING_INFRA_TICKET_RING_BUFFER
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "math.hpp"
+#include "ring_buffer.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * MPMC ring buffer with the interface of ConcurrentRingBuffer for rings many threads push into at once, like
+ * the lane of a consumer fed by several receivers. ConcurrentRingBuffer has producers compare and swap the
+ * tail until one of them wins, which turns into a storm of retries on a single cache line as producers are
+ * added. Here every push and pop takes a ticket from its end of the ring with fetch_add, which always
+ * succeeds, so no thread retries on a counter shared with the others.
+ *
+ * It follows SCQ, Nikolaev's scalable circular queue: items sit in an array of slots, and the indices of the
+ * slots are passed around by two rings of indices, one of the free slots and one of the slots holding an
+ * item. A push takes a free slot, writes the item in it and enqueues its index as used, a pop does the
+ * opposite. Each ring of indices has twice as many entries as there are slots, so a ticket finding its entry
+ * still taken moves on to the next ticket rather than waiting, and a threshold bounds how far a pop on an
+ * empty ring goes before it gives up, so popping nothing costs a load.
+ */
+template <typename T, size_t Capacity = DEFAULT_CAPACITY>
+class TicketRingBuffer
+{
+    static constexpr auto CAP = Math::NextPowerOf2<Capacity>();
+    static_assert(CAP >= 2, "A ticket ring buffer holds at least 2 items");
+
+    static constexpr uint64_t NONE = ~uint64_t { 0 };
+
+    // queue of indices below CAP, every operation on it is sequentially consistent as SCQ assumes
+    class IndexRing
+    {
+        static constexpr uint64_t ENTRIES = 2 * CAP;
+        static constexpr uint64_t ORDER = Math::Log2<ENTRIES>();
+        // an entry is a cycle, whether it is safe to enqueue into and an index, or one of 2 indices marking
+        // it empty, the one a pop leaves being OR-ed over the index it took
+        static constexpr uint64_t EMPTY = ENTRIES - 1;
+        static constexpr uint64_t CONSUMED = ENTRIES - 2;
+        static constexpr uint64_t SAFE = ENTRIES;
+        static constexpr uint64_t CYCLE_SHIFT = ORDER + 1;
+        static constexpr int64_t THRESHOLD = 3 * CAP - 1;
+        // log2 of the entries on a cache line, consecutive tickets go to entries on different lines
+        static constexpr uint64_t LINE_ORDER =
+            std::min<uint64_t>(Math::Log2<hardware_destructive_interference_size / sizeof(uint64_t)>(), ORDER);
+
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> head { ENTRIES };
+        CACHE_LINE_ALIGNED std::atomic<uint64_t> tail { ENTRIES };
+        CACHE_LINE_ALIGNED std::atomic<int64_t> threshold { -1 };
+        std::vector<std::atomic<uint64_t>> entries;
+
+        static uint64_t Cycle(uint64_t ticket)
+        {
+            return ticket >> ORDER;
+        }
+
+        static uint64_t EntryCycle(uint64_t entry)
+        {
+            return entry >> CYCLE_SHIFT;
+        }
+
+        static uint64_t EntryIndex(uint64_t entry)
+        {
+            return entry & (ENTRIES - 1);
+        }
+
+        static size_t Remap(uint64_t ticket)
+        {
+            auto entry = ticket & (ENTRIES - 1);
+            return (entry >> (ORDER - LINE_ORDER)) | ((entry << LINE_ORDER) & (ENTRIES - 1));
+        }
+
+        // brings tail up to head after pops ran past it on an empty ring
+        void catchUp(uint64_t t, uint64_t h)
+        {
+            while (!tail.compare_exchange_weak(t, h, std::memory_order_seq_cst)) {
+                h = head.load(std::memory_order_seq_cst);
+                t = tail.load(std::memory_order_seq_cst);
+                if (t >= h) {
+                    break;
+                }
+            }
+        }
+
+    public:
+        IndexRing() : entries(ENTRIES)
+        {
+            for (auto& entry : entries) {
+                entry.store(SAFE | EMPTY, std::memory_order_relaxed);
+            }
+        }
+
+        // never fails, the ring has room for every index twice over
+        void enqueue(uint64_t index)
+        {
+            while (true) {
+                auto t = tail.fetch_add(1, std::memory_order_seq_cst);
+                auto& entry = entries[Remap(t)];
+                auto e = entry.load(std::memory_order_seq_cst);
+                while (EntryCycle(e) < Cycle(t) && (EntryIndex(e) == EMPTY || EntryIndex(e) == CONSUMED) &&
+                       ((e & SAFE) || head.load(std::memory_order_seq_cst) <= t)) {
+                    if (entry.compare_exchange_weak(e, (Cycle(t) << CYCLE_SHIFT) | SAFE | index,
+                                                    std::memory_order_seq_cst)) {
+                        if (threshold.load(std::memory_order_seq_cst) != THRESHOLD) {
+                            threshold.store(THRESHOLD, std::memory_order_seq_cst);
+                        }
+                        return;
+                    }
+                }
+                // the entry is still taken by an earlier cycle, on to the next ticket
+            }
+        }
+
+        // NONE when the ring is empty
+        uint64_t dequeue()
+        {
+            if (threshold.load(std::memory_order_seq_cst) < 0) {
+                return NONE;
+            }
+
+            while (true) {
+                auto h = head.fetch_add(1, std::memory_order_seq_cst);
+                auto& entry = entries[Remap(h)];
+                auto e = entry.load(std::memory_order_seq_cst);
+                while (true) {
+                    if (EntryCycle(e) == Cycle(h)) {
+                        entry.fetch_or(CONSUMED, std::memory_order_seq_cst);
+                        return EntryIndex(e);
+                    }
+                    if (EntryCycle(e) >= Cycle(h)) {
+                        break;
+                    }
+                    // an entry of an earlier cycle is moved to this one if empty, marked unsafe otherwise, so
+                    // the push of this cycle that is late to it does not enqueue an index no pop would find
+                    auto next = EntryIndex(e) == EMPTY || EntryIndex(e) == CONSUMED
+                                    ? (Cycle(h) << CYCLE_SHIFT) | (e & SAFE) | EMPTY
+                                    : e & ~SAFE;
+                    if (entry.compare_exchange_weak(e, next, std::memory_order_seq_cst)) {
+                        break;
+                    }
+                }
+
+                auto t = tail.load(std::memory_order_seq_cst);
+                if (t <= h + 1) {
+                    catchUp(t, h + 1);
+                    threshold.fetch_sub(1, std::memory_order_seq_cst);
+                    return NONE;
+                }
+                if (threshold.fetch_sub(1, std::memory_order_seq_cst) <= 0) {
+                    return NONE;
+                }
+            }
+        }
+
+        // tickets taken by pushes and not by pops, only a snapshot
+        size_t occupancy() const
+        {
+            auto t = tail.load(std::memory_order_acquire);
+            auto h = head.load(std::memory_order_acquire);
+            return t > h ? t - h : 0;
+        }
+
+        size_t size() const
+        {
+            return entries.size() * sizeof(uint64_t) + sizeof(head) + sizeof(tail) + sizeof(threshold);
+        }
+    };
+
+    IndexRing freeSlots;
+    IndexRing usedSlots;
+    std::vector<T> buffer;
+
+    template <typename F>
+    bool acquireAndSet(F&& setData)
+    {
+        auto index = freeSlots.dequeue();
+        if (index == NONE) {
+            return false; // buffer is full
+        }
+        setData(buffer[index]);
+        usedSlots.enqueue(index);
+        return true;
+    }
+
+public:
+    TicketRingBuffer() : buffer(CAP)
+    {
+        for (uint64_t i = 0; i < CAP; ++i) {
+            freeSlots.enqueue(i);
+        }
+    }
+
+    TicketRingBuffer(const TicketRingBuffer&) = delete;
+    TicketRingBuffer& operator=(const TicketRingBuffer&) = delete;
+
+    TicketRingBuffer(TicketRingBuffer&&) = delete;
+    TicketRingBuffer& operator=(TicketRingBuffer&&) = delete;
+
+    template <typename U = T>
+    bool push(U&& item)
+    {
+        return acquireAndSet([&](T& data) { data = std::forward<U>(item); });
+    }
+
+    template <typename... Args>
+    bool emplace(Args&&...args)
+    {
+        return acquireAndSet([&](T& data) {
+            data.~T();
+            new (&data) T(std::forward<Args>(args)...);
+        });
+    }
+
+    bool pop(T& item)
+    {
+        auto index = usedSlots.dequeue();
+        if (index == NONE) {
+            return false; // buffer is empty
+        }
+        item = std::move(buffer[index]);
+        freeSlots.enqueue(index);
+        return true;
+    }
+
+    // like those of ConcurrentRingBuffer, empty, full and occupancy only offer a quick snapshot, which also
+    // counts the tickets pushes skipped over entries still taken
+    bool empty() const
+    {
+        return usedSlots.occupancy() == 0;
+    }
+
+    bool full() const
+    {
+        return usedSlots.occupancy() >= CAP;
+    }
+
+    size_t occupancy() const
+    {
+        return usedSlots.occupancy();
+    }
+
+    static constexpr size_t capacity()
+    {
+        return CAP;
+    }
+
+    size_t size() const
+    {
+        return buffer.size() * sizeof(T) + freeSlots.size() + usedSlots.size();
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
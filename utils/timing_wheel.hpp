@@ -0,0 +1,259 @@
+#ifndef CRYPTO_TRADING_INFRA_TIMING_WHEEL
+#define CRYPTO_TRADING_INFRA_TIMING_WHEEL
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * Hierarchical timing wheel of values of type T expiring at a tick, 4 levels of 256 slots each spanning 256
+ * times the ticks of the level below, so expiries up to 2^32 ticks ahead are kept without ever looking at the
+ * ones not due yet. Every slot is a doubly linked list of nodes pooled in a vector and addressed by index,
+ * scheduling and cancelling are O(1) and allocate nothing once the pool has grown to the most values pending
+ * at once.
+ *
+ * Time only moves with advance, which goes straight to the next tick a slot holding anything is visited at,
+ * found with a 256-bit occupancy map per level, so empty stretches of time cost nothing however long. The
+ * slot of a higher level is cascaded into the lower ones as the level below wraps around. Values further ahead
+ * than the wheel spans wait in the top level and are cascaded again until they fit. Not thread-safe, it belongs
+ * to the thread that owns what expires.
+ */
+template <typename T>
+class TimingWheel
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle NONE = std::numeric_limits<Handle>::max();
+
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+
+private:
+    static constexpr size_t WORD = 64;
+    static constexpr uint32_t FREE = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        uint64_t expiry;
+        T value;
+        Handle prev;
+        Handle next;
+        // level * SLOTS + slot the node is linked in, FREE once back in the pool
+        uint32_t bucket;
+    };
+
+    std::vector<Node> nodes;
+    Handle freeNodes = NONE;
+    Handle heads[LEVELS * SLOTS];
+    uint64_t occupancy[LEVELS][SLOTS / WORD] = {};
+    uint64_t current = 0;
+    size_t count = 0;
+
+    static size_t Slot(uint64_t tick, size_t level)
+    {
+        return (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+    }
+
+    void link(Handle handle)
+    {
+        auto& node = nodes[handle];
+        auto delta = node.expiry - current;
+        size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t { 1 } << ((level + 1) * SLOT_BITS))) {
+            ++level;
+        }
+        auto slot = Slot(node.expiry, level);
+        node.bucket = level * SLOTS + slot;
+        node.prev = NONE;
+        node.next = heads[node.bucket];
+        if (node.next != NONE) {
+            nodes[node.next].prev = handle;
+        }
+        heads[node.bucket] = handle;
+        occupancy[level][slot / WORD] |= uint64_t { 1 } << (slot % WORD);
+    }
+
+    void unlink(Handle handle)
+    {
+        auto& node = nodes[handle];
+        if (node.prev != NONE) {
+            nodes[node.prev].next = node.next;
+        } else {
+            heads[node.bucket] = node.next;
+            if (node.next == NONE) {
+                auto level = node.bucket / SLOTS;
+                auto slot = node.bucket % SLOTS;
+                occupancy[level][slot / WORD] &= ~(uint64_t { 1 } << (slot % WORD));
+            }
+        }
+        if (node.next != NONE) {
+            nodes[node.next].prev = node.prev;
+        }
+    }
+
+    void release(Handle handle)
+    {
+        nodes[handle].bucket = FREE;
+        nodes[handle].next = freeNodes;
+        freeNodes = handle;
+        --count;
+    }
+
+    // first slot of level at or after from holding anything, SLOTS if none does
+    size_t nextSlot(size_t level, size_t from) const
+    {
+        for (auto word = from / WORD; word < SLOTS / WORD; ++word) {
+            auto bits = occupancy[level][word];
+            if (word == from / WORD) {
+                bits &= ~uint64_t { 0 } << (from % WORD);
+            }
+            if (bits != 0) {
+                return word * WORD + __builtin_ctzll(bits);
+            }
+        }
+        return SLOTS;
+    }
+
+    // first tick after current the wheel visits a slot of level holding anything at, ~0 if none does
+    uint64_t nextVisit(size_t level) const
+    {
+        auto shift = level * SLOT_BITS;
+        auto slot = Slot(current, level);
+        auto next = slot + 1 < SLOTS ? nextSlot(level, slot + 1) : SLOTS;
+        uint64_t turns;
+        if (next < SLOTS) {
+            turns = next - slot;
+        } else if ((next = nextSlot(level, 0)) < SLOTS) {
+            // around the level, up to the slot current is in again
+            turns = next + SLOTS - slot;
+        } else {
+            return ~uint64_t { 0 };
+        }
+        return ((current >> shift) + turns) << shift;
+    }
+
+    // moves what waits in the slots of the higher levels current just entered down the wheel
+    void cascade()
+    {
+        for (size_t level = 1; level < LEVELS; ++level) {
+            auto slot = Slot(current, level);
+            // detached first, values too far ahead for the wheel land in the same slot again
+            auto handle = heads[level * SLOTS + slot];
+            heads[level * SLOTS + slot] = NONE;
+            occupancy[level][slot / WORD] &= ~(uint64_t { 1 } << (slot % WORD));
+            while (handle != NONE) {
+                auto next = nodes[handle].next;
+                link(handle);
+                handle = next;
+            }
+            if (slot != 0) {
+                break;
+            }
+        }
+    }
+
+    template <typename F>
+    void fire(F& expire)
+    {
+        auto& head = heads[Slot(current, 0)];
+        // one at a time, so expire may cancel or schedule others
+        while (head != NONE) {
+            auto handle = head;
+            unlink(handle);
+            T value = nodes[handle].value;
+            release(handle);
+            expire(value);
+        }
+    }
+
+public:
+    // tick is the last tick advanced to
+    explicit TimingWheel(uint64_t tick = 0) : current(tick)
+    {
+        std::fill(std::begin(heads), std::end(heads), NONE);
+    }
+
+    // value expires once advanced to tick, or on the next tick if that one already passed
+    Handle schedule(uint64_t tick, const T& value)
+    {
+        Handle handle;
+        if (freeNodes != NONE) {
+            handle = freeNodes;
+            freeNodes = nodes[handle].next;
+        } else {
+            handle = static_cast<Handle>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[handle].expiry = std::max(tick, current + 1);
+        nodes[handle].value = value;
+        link(handle);
+        ++count;
+        return handle;
+    }
+
+    // handle must be pending, that is neither expired nor cancelled yet
+    void cancel(Handle handle)
+    {
+        unlink(handle);
+        release(handle);
+    }
+
+    // expire is invoked with every value due by tick, in the order of the ticks they expire at
+    template <typename F>
+    void advance(uint64_t tick, F&& expire)
+    {
+        while (current < tick) {
+            // straight to the next slot holding anything, whatever level it is in
+            auto next = ~uint64_t { 0 };
+            for (size_t level = 0; level < LEVELS; ++level) {
+                next = std::min(next, nextVisit(level));
+            }
+            if (next > tick) {
+                current = tick;
+                break;
+            }
+            current = next;
+            if (Slot(current, 0) == 0) {
+                cascade();
+            }
+            fire(expire);
+        }
+    }
+
+    uint64_t now() const
+    {
+        return current;
+    }
+
+    // values pending
+    size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    // forgets every value pending, leaving the wheel at tick
+    void clear(uint64_t tick)
+    {
+        nodes.clear();
+        freeNodes = NONE;
+        std::fill(std::begin(heads), std::end(heads), NONE);
+        std::fill(&occupancy[0][0], &occupancy[0][0] + LEVELS * SLOTS / WORD, 0);
+        current = tick;
+        count = 0;
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
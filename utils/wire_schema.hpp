@@ -0,0 +1,261 @@
+#ifndef CRYPTO_TRADING_INFRA_WIRE_SCHEMA
+#define CRYPTO_TRADING_INFRA_WIRE_SCHEMA
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "network.hpp"
+
+namespace CryptoTradingInfra {
+namespace Utils {
+namespace Wire {
+
+/*
+ * Declarative layout of a wire message. A message is a plain struct listing its fields once, in wire order:
+ *
+ *     struct Ping {
+ *         static constexpr uint8_t TYPE = 7;
+ *         uint32_t id;
+ *         uint64_t timestamp;
+ *         using Schema = Wire::Fields<&Ping::id, &Ping::timestamp>;
+ *     };
+ *
+ * Everything else is generated from Schema: the packed size, big endian encoding and decoding done field by
+ * field with fixed size copies, and the dispatch of a message to its handler by TYPE. Fields may be any
+ * trivially copyable type of 1, 2, 4 or 8 bytes, enums and floating point included.
+ */
+template <auto... Members>
+struct Fields {
+};
+
+namespace Detail {
+
+template <typename T>
+struct MemberOf;
+
+template <typename Class, typename Member>
+struct MemberOf<Member Class::*> {
+    using Type = Member;
+};
+
+template <auto Member>
+using MemberType = typename MemberOf<decltype(Member)>::Type;
+
+template <size_t Size>
+struct Unsigned;
+
+template <>
+struct Unsigned<1> {
+    using Type = uint8_t;
+};
+
+template <>
+struct Unsigned<2> {
+    using Type = uint16_t;
+};
+
+template <>
+struct Unsigned<4> {
+    using Type = uint32_t;
+};
+
+template <>
+struct Unsigned<8> {
+    using Type = uint64_t;
+};
+
+template <typename T>
+constexpr bool Encodable = std::is_trivially_copyable_v<T> &&
+                           (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+template <typename U>
+U Swap(U value)
+{
+    if constexpr (sizeof(U) == 1) {
+        return value;
+    } else if constexpr (sizeof(U) == 2) {
+        return htons(value);
+    } else if constexpr (sizeof(U) == 4) {
+        return htonl(value);
+    } else {
+        return Network::Hton64(value);
+    }
+}
+
+template <typename T>
+char *Put(char *out, const T& value)
+{
+    using U = typename Unsigned<sizeof(T)>::Type;
+    U raw;
+    std::memcpy(&raw, &value, sizeof(T));
+    raw = Swap(raw);
+    std::memcpy(out, &raw, sizeof(T));
+    return out + sizeof(T);
+}
+
+template <typename T>
+const char *Get(const char *in, T& value)
+{
+    using U = typename Unsigned<sizeof(T)>::Type;
+    U raw;
+    std::memcpy(&raw, in, sizeof(T));
+    // byte swapping is its own inverse
+    raw = Swap(raw);
+    std::memcpy(&value, &raw, sizeof(T));
+    return in + sizeof(T);
+}
+
+template <auto... Members>
+constexpr size_t SizeOf(Fields<Members...>)
+{
+    static_assert(sizeof...(Members) > 0, "A message needs at least one field");
+    static_assert((Encodable<MemberType<Members>> && ...), "Fields must be trivially copyable of 1, 2, 4 or 8 bytes");
+    return (sizeof(MemberType<Members>) + ...);
+}
+
+template <typename Message, auto... Members>
+char *EncodeFields(const Message& message, char *out, Fields<Members...>)
+{
+    ((out = Put(out, message.*Members)), ...);
+    return out;
+}
+
+template <typename Message, auto... Members>
+const char *DecodeFields(const char *in, Message& message, Fields<Members...>)
+{
+    ((in = Get(in, message.*Members)), ...);
+    return in;
+}
+
+template <typename... Messages>
+constexpr bool DistinctTypes()
+{
+    constexpr std::array<uint8_t, sizeof...(Messages)> types { Messages::TYPE... };
+    for (size_t i = 0; i < types.size(); ++i) {
+        for (size_t j = i + 1; j < types.size(); ++j) {
+            if (types[i] == types[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace Detail
+
+// bytes Message takes on the wire, not counting its type
+template <typename Message>
+constexpr size_t WireSize()
+{
+    return Detail::SizeOf(typename Message::Schema {});
+}
+
+// writes message at out, which must have WireSize<Message>() bytes, returns the end of what was written
+template <typename Message>
+char *Encode(const Message& message, char *out)
+{
+    return Detail::EncodeFields(message, out, typename Message::Schema {});
+}
+
+// reads message from in, which must have WireSize<Message>() bytes, returns the end of what was read
+template <typename Message>
+const char *Decode(const char *in, Message& message)
+{
+    return Detail::DecodeFields(in, message, typename Message::Schema {});
+}
+
+// writes the type of message followed by message, returns the end of what was written
+template <typename Message>
+char *EncodeTagged(const Message& message, char *out)
+{
+    *out++ = static_cast<char>(Message::TYPE);
+    return Encode(message, out);
+}
+
+// largest of the messages, type included
+template <typename... Messages>
+constexpr size_t MaxTaggedSize()
+{
+    size_t size = 0;
+    ((size = WireSize<Messages>() > size ? WireSize<Messages>() : size), ...);
+    return 1 + size;
+}
+
+/*
+ * Decodes a sequence of messages, each prefixed with its one byte type, and hands every one to the overload
+ * of handler taking it. Types index a table of decoders built at compile time, so a message costs one
+ * indirect call whatever the number of types. Nothing is allocated, messages are decoded on the stack.
+ */
+template <typename... Messages>
+class Dispatcher
+{
+    static_assert(Detail::DistinctTypes<Messages...>(), "Message types must be distinct");
+
+    // returns the bytes taken by the message, 0 if it is truncated or of an unknown type
+    template <typename Handler>
+    using Entry = size_t (*)(const char *, size_t, Handler&);
+
+    template <typename Handler>
+    static size_t Unknown(const char *, size_t, Handler&)
+    {
+        return 0;
+    }
+
+    template <typename Handler, typename Message>
+    static size_t Dispatch(const char *in, size_t length, Handler& handler)
+    {
+        constexpr auto size = WireSize<Message>();
+        if (length < size) {
+            return 0;
+        }
+        Message message;
+        Decode(in, message);
+        handler(message);
+        return size;
+    }
+
+    template <typename Handler>
+    static constexpr std::array<Entry<Handler>, 256> MakeTable()
+    {
+        std::array<Entry<Handler>, 256> table {};
+        for (auto& entry : table) {
+            entry = &Unknown<Handler>;
+        }
+        ((table[Messages::TYPE] = &Dispatch<Handler, Messages>), ...);
+        return table;
+    }
+
+    template <typename Handler>
+    static constexpr std::array<Entry<Handler>, 256> TABLE = MakeTable<Handler>();
+
+public:
+    static constexpr size_t MAX_TAGGED_SIZE = MaxTaggedSize<Messages...>();
+
+    // decodes up to count messages from in, returns how many were handled before an unknown type or the end
+    // of the buffer was hit
+    template <typename Handler>
+    static size_t DispatchAll(const char *in, size_t length, size_t count, Handler& handler)
+    {
+        size_t handled = 0;
+        while (handled < count && length > 0) {
+            auto type = static_cast<uint8_t>(*in);
+            auto taken = TABLE<Handler>[type](in + 1, length - 1, handler);
+            if (taken == 0) {
+                break;
+            }
+            in += 1 + taken;
+            length -= 1 + taken;
+            ++handled;
+        }
+        return handled;
+    }
+};
+
+} // namespace Wire
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif
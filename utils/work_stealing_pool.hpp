@@ -0,0 +1,182 @@
+#ifndef CRYPTO_TRADING_INFRA_WORK_STEALING_POOL
+#define CRYPTO_TRADING_INFRA_WORK_STEALING_POOL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CryptoTradingInfra {
+namespace Utils {
+
+/*
+ * Thread pool for coarse jobs of uneven length, such as replaying whole sessions. Every worker has a deque of
+ * its own: it takes its jobs from the back, most recently submitted first, and once it runs out it steals from
+ * the front of the others, so workers done early take over the backlog of those stuck on long jobs. Jobs
+ * submitted from outside are spread over the deques in turn, and jobs submitted by a job go to the deque of
+ * its worker. Workers with nothing to run or steal sleep rather than spin, and the pool is sized to the
+ * machine by default, so it never has more threads running than cores.
+ *
+ * Deques are guarded by a mutex each, which is only contended by thieves and costs nothing next to a job.
+ */
+class WorkStealingPool
+{
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    // jobs waiting in the deques, and jobs submitted but not done yet
+    std::atomic<size_t> queued { 0 };
+    std::atomic<size_t> unfinished { 0 };
+    std::atomic<size_t> next { 0 };
+    std::atomic<uint64_t> steals { 0 };
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable done;
+    bool stopping = false;
+
+    // the pool and worker index of the calling thread, if it is a worker
+    static std::pair<const WorkStealingPool *, size_t>& Current()
+    {
+        thread_local std::pair<const WorkStealingPool *, size_t> current { nullptr, 0 };
+        return current;
+    }
+
+    bool take(size_t index, std::function<void()>& job)
+    {
+        {
+            auto& own = *workers[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < workers.size(); ++i) {
+            auto& victim = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                queued.fetch_sub(1);
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t index)
+    {
+        Current() = { this, index };
+        std::function<void()> job;
+        while (true) {
+            if (take(index, job)) {
+                job();
+                job = nullptr;
+                if (unfinished.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [&]() { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    static size_t DefaultThreads()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    explicit WorkStealingPool(size_t threadCount = DefaultThreads())
+    {
+        threadCount = std::max<size_t>(threadCount, 1);
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            threads.emplace_back(&WorkStealingPool::run, this, i);
+        }
+    }
+
+    // runs the jobs left before joining the workers
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(std::function<void()> job)
+    {
+        auto [pool, index] = Current();
+        if (pool != this) {
+            index = next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        }
+
+        unfinished.fetch_add(1);
+        {
+            auto& worker = *workers[index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(std::move(job));
+        }
+        queued.fetch_add(1);
+        {
+            // taken so a worker checking for jobs right before going to sleep cannot miss this one
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        wakeup.notify_one();
+    }
+
+    // returns once every job submitted so far is done, including those they submitted
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return unfinished.load() == 0; });
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+    // jobs a worker took from the deque of another
+    uint64_t stolen() const
+    {
+        return steals.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace Utils
+} // namespace CryptoTradingInfra
+
+#endif